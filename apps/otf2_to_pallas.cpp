@@ -0,0 +1,833 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Converts an OTF2 archive into a Pallas trace, without the OTF2 library.
+ * The OTF2 files are decoded by a minimal reader of the OTF2 file format: only the definitions and the events that
+ * have a Pallas counterpart are converted, the other records are skipped and reported at the end.
+ * The attribute lists that precede the events are converted into the AttributeLists of the Pallas events.
+ * Each location is converted by its own ThreadWriter, and the locations are converted concurrently.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "pallas/pallas.h"
+#include "pallas/pallas_archive.h"
+#include "pallas/pallas_record.h"
+#include "pallas/pallas_write.h"
+#include "pallas/utils/pallas_parallel.h"
+
+using namespace pallas;
+
+/** Identifiers of the records of the OTF2 file format. */
+namespace otf2_format {
+/* Records that structure the files. */
+constexpr uint8_t END_OF_CHUNK = 0;
+constexpr uint8_t END_OF_FILE = 1;
+constexpr uint8_t TIMESTAMP = 2;
+constexpr uint8_t ATTRIBUTE_LIST = 3;
+constexpr uint8_t CHUNK_HEADER = 4;
+/* Byte following CHUNK_HEADER, that gives the endianness of the chunk. */
+constexpr uint8_t BIG_ENDIAN_CHUNK = 'B';
+constexpr uint8_t LITTLE_ENDIAN_CHUNK = 'L';
+/* Length byte announcing a record longer than 254 bytes, whose length follows on 8 bytes. */
+constexpr uint8_t LONG_RECORD = 0xff;
+/* Compressed integers: a byte giving the number of significant bytes that follow, or this marker for UNDEFINED. */
+constexpr uint8_t UNDEFINED_INTEGER = 0xff;
+/* Largest chunk OTF2 writes (OTF2_CHUNK_SIZE_MAX). */
+constexpr uint64_t MAX_CHUNK_SIZE = 16 * 1024 * 1024;
+/* File substrate and compression of the archive, as given by the anchor file. */
+constexpr uint8_t SUBSTRATE_POSIX = 1;
+constexpr uint8_t COMPRESSION_NONE = 1;
+
+/* Global definitions. */
+constexpr uint8_t DEF_CLOCK_PROPERTIES = 5;
+constexpr uint8_t DEF_STRING = 10;
+constexpr uint8_t DEF_ATTRIBUTE = 11;
+constexpr uint8_t DEF_LOCATION_GROUP = 13;
+constexpr uint8_t DEF_LOCATION = 14;
+constexpr uint8_t DEF_REGION = 15;
+constexpr uint8_t DEF_GROUP = 18;
+constexpr uint8_t DEF_COMM = 22;
+
+/* Local definitions. */
+constexpr uint8_t DEF_MAPPING_TABLE = 5;
+constexpr uint8_t MAPPING_ATTRIBUTE = 1;
+constexpr uint8_t MAPPING_REGION = 3;
+constexpr uint8_t MAPPING_COMM = 6;
+constexpr uint8_t ID_MAP_DENSE = 0;
+
+/* Events. */
+constexpr uint8_t EVENT_BUFFER_FLUSH = 10;
+constexpr uint8_t EVENT_MEASUREMENT_ON_OFF = 11;
+constexpr uint8_t EVENT_ENTER = 12;
+constexpr uint8_t EVENT_LEAVE = 13;
+constexpr uint8_t EVENT_MPI_SEND = 14;
+constexpr uint8_t EVENT_MPI_ISEND = 15;
+constexpr uint8_t EVENT_MPI_ISEND_COMPLETE = 16;
+constexpr uint8_t EVENT_MPI_IRECV_REQUEST = 17;
+constexpr uint8_t EVENT_MPI_RECV = 18;
+constexpr uint8_t EVENT_MPI_IRECV = 19;
+constexpr uint8_t EVENT_MPI_COLLECTIVE_BEGIN = 22;
+constexpr uint8_t EVENT_MPI_COLLECTIVE_END = 23;
+constexpr uint8_t EVENT_OMP_FORK = 24;
+constexpr uint8_t EVENT_OMP_JOIN = 25;
+constexpr uint8_t EVENT_OMP_ACQUIRE_LOCK = 26;
+constexpr uint8_t EVENT_OMP_RELEASE_LOCK = 27;
+constexpr uint8_t EVENT_OMP_TASK_CREATE = 28;
+constexpr uint8_t EVENT_OMP_TASK_SWITCH = 29;
+constexpr uint8_t EVENT_OMP_TASK_COMPLETE = 30;
+constexpr uint8_t EVENT_THREAD_FORK = 53;
+constexpr uint8_t EVENT_THREAD_JOIN = 54;
+constexpr uint8_t EVENT_THREAD_TEAM_BEGIN = 55;
+constexpr uint8_t EVENT_THREAD_TEAM_END = 56;
+constexpr uint8_t EVENT_THREAD_ACQUIRE_LOCK = 57;
+constexpr uint8_t EVENT_THREAD_RELEASE_LOCK = 58;
+constexpr uint8_t EVENT_THREAD_BEGIN = 63;
+constexpr uint8_t EVENT_THREAD_END = 65;
+}  // namespace otf2_format
+
+/**
+ * Reads the records of an OTF2 file one after the other.
+ * The file is made of chunks of a fixed size, given by the anchor file, that all start with a CHUNK_HEADER
+ * and end with an END_OF_CHUNK. Records never cross a chunk boundary, so the file is read one chunk at a time:
+ * whatever the size of the file, a reader only holds a chunk in memory.
+ * Records are a byte giving their type, their length, and their fields. Integers are compressed.
+ * TIMESTAMP records are consumed by the reader: the timestamp applies to the next events.
+ */
+class Otf2File {
+   public:
+    /** Timestamp of the current event. */
+    uint64_t timestamp = 0;
+
+    /** Opens the file, made of chunks of chunk_size bytes, and loads its first chunk. Returns false if it can't be read. */
+    bool open(const std::string& path, size_t chunk_size) {
+        file.open(path, std::ios::binary | std::ios::ate);
+        if (!file)
+            return false;
+        file_size = file.tellg();
+        file.seekg(0);
+        this->chunk_size = chunk_size;
+        return nextChunk();
+    }
+
+    /** Size of the file, in bytes. */
+    size_t size() const {
+        return file_size;
+    }
+
+    /**
+     * Moves to the next record, skipping whatever was left of the current one.
+     * @returns false at the end of the file.
+     */
+    bool nextRecord(uint8_t& type) {
+        if (record_end != 0) {
+            pos = record_end;
+            record_end = 0;
+        }
+        while (pos < chunk.size()) {
+            uint8_t t = chunk[pos++];
+            switch (t) {
+            case otf2_format::END_OF_FILE:
+                return false;
+            case otf2_format::END_OF_CHUNK:
+                if (!nextChunk())
+                    return false;
+                break;
+            case otf2_format::TIMESTAMP:
+                timestamp = readFullUint64();
+                break;
+            default: {
+                uint64_t length = readByte();
+                if (length == otf2_format::LONG_RECORD)
+                    length = readFullUint64();
+                if (pos + length > chunk.size()) {
+                    pallas_warn("Truncated record %u at offset %zu\n", t, chunk_offset + pos);
+                    return false;
+                }
+                record_end = pos + length;
+                type = t;
+                return true;
+            }
+            }
+        }
+        return false;
+    }
+
+    uint8_t readUint8() {
+        return inRecord() ? chunk[pos++] : 0;
+    }
+
+    uint32_t readUint32() {
+        uint64_t value = readCompressed(sizeof(uint32_t));
+        return value == UINT64_MAX ? UINT32_MAX : value;
+    }
+
+    uint64_t readUint64() {
+        return readCompressed(sizeof(uint64_t));
+    }
+
+    /** Reads a field that isn't compressed, stored on size bytes: 16-bit integers, floats and doubles. */
+    uint64_t readFixed(size_t size) {
+        return inRecord() ? readBytes(size) : 0;
+    }
+
+    std::string readString() {
+        size_t end = pos;
+        while (end < record_end && chunk[end] != 0)
+            end++;
+        std::string s(reinterpret_cast<const char*>(&chunk[pos]), end - pos);
+        pos = end < record_end ? end + 1 : end;
+        return s;
+    }
+
+    /** Returns true if the fields of the current record haven't all been read: newer versions of OTF2 append some. */
+    bool inRecord() const {
+        return pos < record_end;
+    }
+
+   private:
+    std::ifstream file;
+    size_t file_size = 0;
+    /** Current chunk, and its offset in the file. */
+    std::vector<uint8_t> chunk;
+    size_t chunk_offset = 0;
+    size_t pos = 0;
+    size_t record_end = 0;
+    size_t chunk_size = 0;
+    bool big_endian = false;
+
+    uint8_t readByte() {
+        return pos < chunk.size() ? chunk[pos++] : 0;
+    }
+
+    uint64_t readBytes(size_t n) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < n; i++) {
+            uint64_t b = readByte();
+            value = big_endian ? (value << 8) | b : value | (b << (8 * i));
+        }
+        return value;
+    }
+
+    uint64_t readFullUint64() {
+        return readBytes(sizeof(uint64_t));
+    }
+
+    uint64_t readCompressed(size_t max_size) {
+        if (!inRecord())
+            return 0;
+        uint8_t n = readByte();
+        if (n == otf2_format::UNDEFINED_INTEGER)
+            return UINT64_MAX;
+        if (n > max_size) {
+            pallas_warn("Invalid compressed integer at offset %zu\n", chunk_offset + pos);
+            n = max_size;
+        }
+        return readBytes(n);
+    }
+
+    /** Loads the next chunk of the file, the last one may be shorter, and reads its header. */
+    bool nextChunk() {
+        chunk_offset += chunk.size();
+        chunk.resize(chunk_size);
+        file.read(reinterpret_cast<char*>(chunk.data()), chunk.size());
+        chunk.resize(file.gcount());
+        pos = 0;
+        if (chunk.size() < 2 || chunk[0] != otf2_format::CHUNK_HEADER)
+            return false;
+        pos = 1;
+        big_endian = chunk[pos++] == otf2_format::BIG_ENDIAN_CHUNK;
+        // Numbers of the first and last events of the chunk.
+        readFullUint64();
+        readFullUint64();
+        return true;
+    }
+};
+
+/** What the anchor file tells about the archive. */
+struct Otf2Anchor {
+    /** Size of the chunks of the event files and of the definition files. */
+    uint64_t event_chunk_size = 0;
+    uint64_t definition_chunk_size = 0;
+};
+
+/**
+ * Reads the anchor file of an archive. It isn't split in chunks, so its header is only a CHUNK_HEADER and the endianness.
+ * Then come the version of OTF2 that wrote it (3 bytes), the trace format, the sizes of the event and definition chunks
+ * (8 bytes each), the file substrate and the compression. The other properties that follow are ignored.
+ * @returns false if the file can't be read, or if it describes an archive that can't be converted.
+ */
+static bool read_anchor(const std::string& path, Otf2Anchor& anchor) {
+    std::ifstream file(path, std::ios::binary);
+    uint8_t header[2 + 4 + 2 * sizeof(uint64_t) + 2];
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header))) {
+        pallas_warn("Cannot read the anchor file %s\n", path.c_str());
+        return false;
+    }
+    bool big_endian = header[1] == otf2_format::BIG_ENDIAN_CHUNK;
+    if (header[0] != otf2_format::CHUNK_HEADER || (!big_endian && header[1] != otf2_format::LITTLE_ENDIAN_CHUNK)) {
+        pallas_warn("%s isn't an OTF2 anchor file\n", path.c_str());
+        return false;
+    }
+    uint8_t major_version = header[2];
+    auto read_uint64 = [&](size_t offset) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < sizeof(uint64_t); i++) {
+            uint64_t b = header[offset + i];
+            value = big_endian ? (value << 8) | b : value | (b << (8 * i));
+        }
+        return value;
+    };
+    anchor.event_chunk_size = read_uint64(6);
+    anchor.definition_chunk_size = read_uint64(6 + sizeof(uint64_t));
+    uint8_t substrate = header[6 + 2 * sizeof(uint64_t)];
+    uint8_t compression = header[7 + 2 * sizeof(uint64_t)];
+    if (major_version == 0 || major_version > 3) {
+        pallas_warn("%s was written by an unknown version of OTF2 (%u.%u.%u)\n", path.c_str(), header[2], header[3], header[4]);
+        return false;
+    }
+    for (uint64_t chunk_size : {anchor.event_chunk_size, anchor.definition_chunk_size}) {
+        if (chunk_size == 0 || chunk_size > otf2_format::MAX_CHUNK_SIZE) {
+            pallas_warn("Invalid chunk size in %s: %lu\n", path.c_str(), chunk_size);
+            return false;
+        }
+    }
+    if (substrate != otf2_format::SUBSTRATE_POSIX || compression != otf2_format::COMPRESSION_NONE) {
+        pallas_warn("%s uses a file substrate (%u) or a compression (%u) that isn't supported: only plain POSIX files are\n",
+                    path.c_str(), substrate, compression);
+        return false;
+    }
+    return true;
+}
+
+/** What is known about a location from the global definitions. */
+struct Otf2Location {
+    uint64_t otf2_id;
+    ThreadId thread_id;
+    LocationGroupId location_group;
+    StringRef name;
+};
+
+/** Global definitions that are needed to convert the events. */
+struct Otf2Definitions {
+    uint64_t timer_resolution = 1000000000;
+    uint64_t global_offset = 0;
+    std::vector<Otf2Location> locations;
+    std::map<LocationGroupId, StringRef> location_groups;
+
+    /** Converts an OTF2 timestamp to nanoseconds since the beginning of the trace. */
+    pallas_timestamp_t convert(uint64_t ts) const {
+        ts = ts > global_offset ? ts - global_offset : 0;
+        if (timer_resolution == 1000000000)
+            return ts;
+        return static_cast<unsigned __int128>(ts) * 1000000000 / timer_resolution;
+    }
+};
+
+/** Reads the global definition file, and defines the strings, regions, groups and comms of the trace. */
+static bool read_global_definitions(const std::string& path, const Otf2Anchor& anchor, GlobalArchive& trace, Otf2Definitions& defs, size_t& nb_bytes) {
+    Otf2File file;
+    if (!file.open(path, anchor.definition_chunk_size)) {
+        pallas_warn("Cannot read the global definitions %s\n", path.c_str());
+        return false;
+    }
+    nb_bytes += file.size();
+    uint8_t type;
+    while (file.nextRecord(type)) {
+        switch (type) {
+        case otf2_format::DEF_CLOCK_PROPERTIES:
+            defs.timer_resolution = file.readUint64();
+            defs.global_offset = file.readUint64();
+            if (defs.timer_resolution == 0)
+                defs.timer_resolution = 1000000000;
+            break;
+        case otf2_format::DEF_STRING: {
+            StringRef ref = file.readUint32();
+            std::string s = file.readString();
+            trace.addString(ref, s.c_str());
+            break;
+        }
+        case otf2_format::DEF_ATTRIBUTE: {
+            // OTF2_Type and pallas_type_t number the types the same way.
+            AttributeRef ref = file.readUint32();
+            StringRef name = file.readUint32();
+            auto attribute_type = static_cast<pallas_type_t>(file.readUint8());
+            // The description was appended by OTF2 1.4.
+            StringRef description = file.inRecord() ? file.readUint32() : name;
+            trace.addAttribute(ref, name, description, attribute_type);
+            break;
+        }
+        case otf2_format::DEF_LOCATION_GROUP: {
+            LocationGroupId id = file.readUint32();
+            defs.location_groups[id] = file.readUint32();
+            break;
+        }
+        case otf2_format::DEF_LOCATION: {
+            Otf2Location loc;
+            loc.otf2_id = file.readUint64();
+            loc.name = file.readUint32();
+            file.readUint8();   // Location type.
+            file.readUint64();  // Number of events.
+            loc.location_group = file.readUint32();
+            loc.thread_id = loc.otf2_id;
+            defs.locations.push_back(loc);
+            break;
+        }
+        case otf2_format::DEF_REGION: {
+            RegionRef ref = file.readUint32();
+            trace.addRegion(ref, file.readUint32());
+            break;
+        }
+        case otf2_format::DEF_GROUP: {
+            GroupRef ref = file.readUint32();
+            StringRef name = file.readUint32();
+            auto group_type = static_cast<GroupType>(file.readUint8());
+            auto paradigm = static_cast<Paradigm>(file.readUint8());
+            file.readUint32();  // Group flags.
+            uint32_t nb_members = file.readUint32();
+            std::vector<uint64_t> members;
+            members.reserve(nb_members);
+            for (uint32_t i = 0; i < nb_members && file.inRecord(); i++) {
+                members.push_back(file.readUint64());
+            }
+            trace.addGroup(ref, name, group_type, paradigm, members.size(), members.data());
+            break;
+        }
+        case otf2_format::DEF_COMM: {
+            CommRef ref = file.readUint32();
+            StringRef name = file.readUint32();
+            GroupRef group = file.readUint32();
+            trace.addComm(ref, name, group, file.readUint32());
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    // Pallas thread ids are 32 bits wide: renumber the locations if the OTF2 ids don't fit.
+    for (auto& loc : defs.locations) {
+        if (loc.otf2_id >= PALLAS_THREAD_ID_INVALID) {
+            for (size_t i = 0; i < defs.locations.size(); i++) {
+                defs.locations[i].thread_id = i;
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+/** Local ids of a location, mapped to global ones. */
+struct IdMaps {
+    std::unordered_map<uint64_t, uint64_t> attributes;
+    std::unordered_map<uint64_t, uint64_t> regions;
+    std::unordered_map<uint64_t, uint64_t> comms;
+
+    static uint32_t translate(const std::unordered_map<uint64_t, uint64_t>& map, uint32_t id) {
+        if (map.empty())
+            return id;
+        auto it = map.find(id);
+        return it == map.end() ? id : it->second;
+    }
+};
+
+/** Reads the mapping tables of the local definition file of a location, if there is one. */
+static void read_local_definitions(const std::string& path, const Otf2Anchor& anchor, IdMaps& maps, size_t& nb_bytes) {
+    Otf2File file;
+    if (!file.open(path, anchor.definition_chunk_size))
+        return;
+    nb_bytes += file.size();
+    uint8_t type;
+    while (file.nextRecord(type)) {
+        if (type != otf2_format::DEF_MAPPING_TABLE)
+            continue;
+        uint8_t mapping_type = file.readUint8();
+        std::unordered_map<uint64_t, uint64_t>* map = nullptr;
+        if (mapping_type == otf2_format::MAPPING_ATTRIBUTE)
+            map = &maps.attributes;
+        else if (mapping_type == otf2_format::MAPPING_REGION)
+            map = &maps.regions;
+        else if (mapping_type == otf2_format::MAPPING_COMM)
+            map = &maps.comms;
+        else
+            continue;
+        uint8_t mode = file.readUint8();
+        uint64_t size = file.readUint64();
+        if (mode == otf2_format::ID_MAP_DENSE) {
+            for (uint64_t i = 0; i < size && file.inRecord(); i++) {
+                (*map)[i] = file.readUint64();
+            }
+        } else {
+            // Sparse maps store (local id, global id) pairs.
+            for (uint64_t i = 0; i + 1 < size && file.inRecord(); i += 2) {
+                uint64_t local = file.readUint64();
+                (*map)[local] = file.readUint64();
+            }
+        }
+    }
+}
+
+/**
+ * Reads an ATTRIBUTE_LIST record, that gives the attributes of the next event: their number, then the id, the type
+ * and the value of each attribute. 8-bit and 16-bit integers, floats and doubles are stored as they are,
+ * the other values are compressed. The ids, and the values that reference attributes, regions or comms, are local
+ * to the location: they are mapped to the global ones.
+ * @returns false if the list uses a type that isn't known, whose values can't be read.
+ */
+static bool read_attribute_list(Otf2File& file, const IdMaps& maps, AttributeList& list) {
+    pallas_attribute_list_init(&list);
+    uint32_t nb_attributes = file.readUint32();
+    for (uint32_t i = 0; i < nb_attributes && file.inRecord(); i++) {
+        AttributeRef ref = IdMaps::translate(maps.attributes, file.readUint32());
+        auto type = static_cast<pallas_type_t>(file.readUint8());
+        AttributeValue value;
+        value.uint64 = 0;
+        switch (type) {
+        case PALLAS_TYPE_UINT8:
+        case PALLAS_TYPE_INT8:
+            value.uint8 = file.readUint8();
+            break;
+        case PALLAS_TYPE_UINT16:
+        case PALLAS_TYPE_INT16:
+            value.uint16 = file.readFixed(sizeof(uint16_t));
+            break;
+        case PALLAS_TYPE_UINT32:
+        case PALLAS_TYPE_INT32:
+            value.uint32 = file.readUint32();
+            break;
+        case PALLAS_TYPE_UINT64:
+        case PALLAS_TYPE_INT64:
+            value.uint64 = file.readUint64();
+            break;
+        case PALLAS_TYPE_FLOAT: {
+            uint32_t bits = file.readFixed(sizeof(float));
+            memcpy(&value.float32, &bits, sizeof(float));
+            break;
+        }
+        case PALLAS_TYPE_DOUBLE: {
+            uint64_t bits = file.readFixed(sizeof(double));
+            memcpy(&value.float64, &bits, sizeof(double));
+            break;
+        }
+        case PALLAS_TYPE_LOCATION:
+            value.location_ref = file.readUint64();
+            break;
+        case PALLAS_TYPE_ATTRIBUTE:
+            value.attribute_ref = IdMaps::translate(maps.attributes, file.readUint32());
+            break;
+        case PALLAS_TYPE_REGION:
+            value.region_ref = IdMaps::translate(maps.regions, file.readUint32());
+            break;
+        case PALLAS_TYPE_COMM:
+            value.comm_ref = IdMaps::translate(maps.comms, file.readUint32());
+            break;
+        default:
+            if (type == PALLAS_TYPE_NONE || type > PALLAS_TYPE_LOCATION_GROUP) {
+                pallas_warn("Attribute %u has an unknown type (%u)\n", ref, type);
+                return false;
+            }
+            // The other references.
+            value.uint32 = file.readUint32();
+            break;
+        }
+        pallas_attribute_list_add_attribute(&list, ref, get_value_size(type), value);
+    }
+    return true;
+}
+
+/** Statistics about the conversion of a location. */
+struct ConversionStats {
+    size_t nb_bytes = 0;
+    size_t nb_events = 0;
+    std::map<uint8_t, size_t> skipped;
+};
+
+/** Converts the events of a location through a ThreadWriter. */
+static ConversionStats convert_location(const std::string& archive_dir,
+                                        const Otf2Anchor& anchor,
+                                        const Otf2Location& loc,
+                                        const Otf2Definitions& defs,
+                                        Archive& archive) {
+    ConversionStats stats;
+    std::string path = archive_dir + "/" + std::to_string(loc.otf2_id);
+    IdMaps maps;
+    read_local_definitions(path + ".def", anchor, maps, stats.nb_bytes);
+
+    Otf2File file;
+    if (!file.open(path + ".evt", anchor.event_chunk_size)) {
+        pallas_warn("Cannot read the events of location %lu (%s.evt)\n", loc.otf2_id, path.c_str());
+        return stats;
+    }
+    stats.nb_bytes += file.size();
+
+    ThreadWriter writer(archive, loc.thread_id);
+    AttributeList attribute_list;
+    bool has_attributes = false;
+    uint8_t type;
+    while (file.nextRecord(type)) {
+        if (type == otf2_format::ATTRIBUTE_LIST) {
+            has_attributes = read_attribute_list(file, maps, attribute_list);
+            continue;
+        }
+        // The attributes only belong to the event that follows them.
+        AttributeList* attributes = has_attributes ? &attribute_list : nullptr;
+        has_attributes = false;
+        pallas_timestamp_t ts = defs.convert(file.timestamp);
+        stats.nb_events++;
+        switch (type) {
+        case otf2_format::EVENT_BUFFER_FLUSH:
+            pallas_record_buffer_flush(&writer, attributes, ts, defs.convert(file.readUint64()));
+            break;
+        case otf2_format::EVENT_MEASUREMENT_ON_OFF:
+            // OTF2_MEASUREMENT_ON is 1, OTF2_MEASUREMENT_OFF is 2.
+            pallas_record_measurement_on_off(&writer, attributes, ts, file.readUint8() == 1);
+            break;
+        case otf2_format::EVENT_ENTER:
+            pallas_record_enter(&writer, attributes, ts, IdMaps::translate(maps.regions, file.readUint32()));
+            break;
+        case otf2_format::EVENT_LEAVE:
+            pallas_record_leave(&writer, attributes, ts, IdMaps::translate(maps.regions, file.readUint32()));
+            break;
+        case otf2_format::EVENT_MPI_SEND:
+        case otf2_format::EVENT_MPI_ISEND:
+        case otf2_format::EVENT_MPI_RECV:
+        case otf2_format::EVENT_MPI_IRECV: {
+            uint32_t peer = file.readUint32();
+            uint32_t comm = IdMaps::translate(maps.comms, file.readUint32());
+            uint32_t tag = file.readUint32();
+            uint64_t length = file.readUint64();
+            if (type == otf2_format::EVENT_MPI_SEND)
+                pallas_record_mpi_send(&writer, attributes, ts, peer, comm, tag, length);
+            else if (type == otf2_format::EVENT_MPI_RECV)
+                pallas_record_mpi_recv(&writer, attributes, ts, peer, comm, tag, length);
+            else if (type == otf2_format::EVENT_MPI_ISEND)
+                pallas_record_mpi_isend(&writer, attributes, ts, peer, comm, tag, length, file.readUint64());
+            else
+                pallas_record_mpi_irecv(&writer, attributes, ts, peer, comm, tag, length, file.readUint64());
+            break;
+        }
+        case otf2_format::EVENT_MPI_ISEND_COMPLETE:
+            pallas_record_mpi_isend_complete(&writer, attributes, ts, file.readUint64());
+            break;
+        case otf2_format::EVENT_MPI_IRECV_REQUEST:
+            pallas_record_mpi_irecv_request(&writer, attributes, ts, file.readUint64());
+            break;
+        case otf2_format::EVENT_MPI_COLLECTIVE_BEGIN:
+            pallas_record_mpi_collective_begin(&writer, attributes, ts);
+            break;
+        case otf2_format::EVENT_MPI_COLLECTIVE_END: {
+            uint32_t op = file.readUint8();
+            uint32_t comm = IdMaps::translate(maps.comms, file.readUint32());
+            uint32_t root = file.readUint32();
+            uint64_t sent = file.readUint64();
+            uint64_t received = file.readUint64();
+            pallas_record_mpi_collective_end(&writer, attributes, ts, op, comm, root, sent, received);
+            break;
+        }
+        case otf2_format::EVENT_OMP_FORK:
+            pallas_record_omp_fork(&writer, attributes, ts, file.readUint32());
+            break;
+        case otf2_format::EVENT_OMP_JOIN:
+            pallas_record_omp_join(&writer, attributes, ts);
+            break;
+        case otf2_format::EVENT_OMP_ACQUIRE_LOCK:
+        case otf2_format::EVENT_OMP_RELEASE_LOCK: {
+            uint32_t lock = file.readUint32();
+            uint32_t order = file.readUint32();
+            if (type == otf2_format::EVENT_OMP_ACQUIRE_LOCK)
+                pallas_record_omp_acquire_lock(&writer, attributes, ts, lock, order);
+            else
+                pallas_record_omp_release_lock(&writer, attributes, ts, lock, order);
+            break;
+        }
+        case otf2_format::EVENT_OMP_TASK_CREATE:
+            pallas_record_omp_task_create(&writer, attributes, ts, file.readUint64());
+            break;
+        case otf2_format::EVENT_OMP_TASK_SWITCH:
+            pallas_record_omp_task_switch(&writer, attributes, ts, file.readUint64());
+            break;
+        case otf2_format::EVENT_OMP_TASK_COMPLETE:
+            pallas_record_omp_task_complete(&writer, attributes, ts, file.readUint64());
+            break;
+        case otf2_format::EVENT_THREAD_FORK:
+            file.readUint8();  // Paradigm.
+            pallas_record_thread_fork(&writer, attributes, ts, file.readUint32());
+            break;
+        case otf2_format::EVENT_THREAD_JOIN:
+            pallas_record_thread_join(&writer, attributes, ts);
+            break;
+        case otf2_format::EVENT_THREAD_TEAM_BEGIN:
+            pallas_record_thread_team_begin(&writer, attributes, ts);
+            break;
+        case otf2_format::EVENT_THREAD_TEAM_END:
+            pallas_record_thread_team_end(&writer, attributes, ts);
+            break;
+        case otf2_format::EVENT_THREAD_ACQUIRE_LOCK:
+        case otf2_format::EVENT_THREAD_RELEASE_LOCK: {
+            file.readUint8();  // Paradigm.
+            uint32_t lock = file.readUint32();
+            uint32_t order = file.readUint32();
+            if (type == otf2_format::EVENT_THREAD_ACQUIRE_LOCK)
+                pallas_record_thread_acquire_lock(&writer, attributes, ts, lock, order);
+            else
+                pallas_record_thread_release_lock(&writer, attributes, ts, lock, order);
+            break;
+        }
+        case otf2_format::EVENT_THREAD_BEGIN:
+            pallas_record_thread_begin(&writer, attributes, ts);
+            break;
+        case otf2_format::EVENT_THREAD_END:
+            pallas_record_thread_end(&writer, attributes, ts);
+            break;
+        default:
+            stats.nb_events--;
+            stats.skipped[type]++;
+            break;
+        }
+    }
+    writer.threadClose();
+    return stats;
+}
+
+/** Returns the size of all the files in dir. */
+static size_t directory_size(const std::string& dir) {
+    size_t size = 0;
+    std::error_code error;
+    for (auto& entry : std::filesystem::recursive_directory_iterator(dir, error)) {
+        if (entry.is_regular_file(error))
+            size += entry.file_size(error);
+    }
+    return size;
+}
+
+void usage() {
+    std::cout << "Usage: otf2_to_pallas [OPTION] archive.otf2" << std::endl;
+    std::cout << "\t-o, --output dir: Directory of the Pallas trace (default: the one of the archive, suffixed with _pallas)." << std::endl;
+    std::cout << "\t-j, --jobs n: Number of locations converted concurrently (default: one per hardware thread)." << std::endl;
+    std::cout << "\t-c, --chunk-size n: Size of the chunks of the OTF2 files (default: the ones of the anchor file)." << std::endl;
+    std::cout << "\t-h, -?: Show this help and exit." << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::string anchor_name;
+    std::string output_dir;
+    size_t nb_workers = 0;
+    size_t forced_chunk_size = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "-?")) {
+            usage();
+            return EXIT_SUCCESS;
+        } else if ((!strcmp(argv[i], "-o") || !strcmp(argv[i], "--output")) && i + 1 < argc) {
+            output_dir = argv[++i];
+        } else if ((!strcmp(argv[i], "-j") || !strcmp(argv[i], "--jobs")) && i + 1 < argc) {
+            nb_workers = std::stoul(argv[++i]);
+        } else if ((!strcmp(argv[i], "-c") || !strcmp(argv[i], "--chunk-size")) && i + 1 < argc) {
+            forced_chunk_size = std::stoul(argv[++i]);
+        } else {
+            anchor_name = argv[i];
+        }
+    }
+    if (anchor_name.empty()) {
+        std::cout << "ERROR: Missing OTF2 archive" << std::endl;
+        usage();
+        return EXIT_FAILURE;
+    }
+    // archive.otf2 is next to archive.def and to the archive/ directory that holds the files of each location.
+    std::string archive_dir = anchor_name;
+    if (archive_dir.size() > 5 && archive_dir.compare(archive_dir.size() - 5, 5, ".otf2") == 0)
+        archive_dir.resize(archive_dir.size() - 5);
+    if (output_dir.empty()) {
+        output_dir = archive_dir + "_pallas";
+    }
+
+    // The chunk sizes can't be guessed from the files reliably: without them, nothing is converted.
+    Otf2Anchor anchor;
+    if (forced_chunk_size != 0) {
+        anchor.event_chunk_size = forced_chunk_size;
+        anchor.definition_chunk_size = forced_chunk_size;
+    } else if (!read_anchor(anchor_name, anchor)) {
+        std::cout << "ERROR: Cannot find the size of the chunks of " << anchor_name << ": give it with --chunk-size" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    GlobalArchive trace(output_dir.c_str(), "main");
+    Otf2Definitions defs;
+    size_t nb_otf2_bytes = 0;
+    std::error_code error;
+    nb_otf2_bytes += std::filesystem::file_size(anchor_name, error);
+    if (!read_global_definitions(archive_dir + ".def", anchor, trace, defs, nb_otf2_bytes)) {
+        return EXIT_FAILURE;
+    }
+
+    // One Archive per location group, that owns the ThreadWriters of its locations.
+    std::map<LocationGroupId, Archive*> archives;
+    for (const auto& [id, name] : defs.location_groups) {
+        trace.defineLocationGroup(id, name, PALLAS_LOCATION_GROUP_ID_INVALID);
+    }
+    for (const auto& loc : defs.locations) {
+        auto& archive = archives[loc.location_group];
+        if (archive == nullptr) {
+            archive = new Archive(trace, loc.location_group);
+            archive->global_archive = &trace;
+        }
+        archive->defineLocation(loc.thread_id, loc.name, loc.location_group);
+    }
+
+    std::vector<ConversionStats> stats(defs.locations.size());
+    parallelFor(defs.locations.size(), nb_workers, [&](size_t i) {
+        const auto& loc = defs.locations[i];
+        stats[i] = convert_location(archive_dir, anchor, loc, defs, *archives[loc.location_group]);
+    });
+    for (auto& [id, archive] : archives) {
+        archive->store();
+    }
+    trace.store();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    size_t nb_events = 0;
+    std::map<uint8_t, size_t> skipped;
+    for (const auto& s : stats) {
+        nb_otf2_bytes += s.nb_bytes;
+        nb_events += s.nb_events;
+        for (const auto& [type, n] : s.skipped) {
+            skipped[type] += n;
+        }
+    }
+    size_t nb_pallas_bytes = directory_size(output_dir);
+    std::cout << "Converted " << anchor_name << " into " << output_dir << " in " << elapsed.count() << "s: "
+              << archives.size() << " archives, " << defs.locations.size() << " threads, " << nb_events << " events" << std::endl;
+    std::cout << "\tThroughput: " << nb_events / elapsed.count() << " events/s, "
+              << nb_otf2_bytes / elapsed.count() / (1024 * 1024) << " MB/s of OTF2" << std::endl;
+    std::cout << "\tSize: " << nb_otf2_bytes << " bytes of OTF2, " << nb_pallas_bytes << " bytes of Pallas, compression ratio: "
+              << (nb_pallas_bytes ? static_cast<double>(nb_otf2_bytes) / nb_pallas_bytes : 0) << std::endl;
+    for (const auto& [type, n] : skipped) {
+        std::cout << "\tSkipped " << n << " records of unsupported type " << static_cast<int>(type) << std::endl;
+    }
+    for (auto& [id, archive] : archives) {
+        delete archive;
+    }
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
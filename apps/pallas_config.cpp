@@ -14,6 +14,11 @@ int main() {
             << "\tMAP_SIZE = " << MAP_SIZE << std::endl
             << "\tUNO_MAP_SIZE = " << UNO_MAP_SIZE << std::endl
             << "\tTIMEPOINT_SIZE = " << TIMEPOINT_SIZE << std::endl
+#ifdef PALLAS_WRITER_STATS
+            << "\tPALLAS_WRITER_STATS = ON" << std::endl
+#else
+            << "\tPALLAS_WRITER_STATS = OFF" << std::endl
+#endif
             << "\tNB_EVENT_DEFAULT = " << NB_EVENT_DEFAULT << std::endl
             << "\tNB_SEQUENCE_DEFAULT = " << NB_SEQUENCE_DEFAULT << std::endl
             << "\tNB_LOOP_DEFAULT = " << NB_LOOP_DEFAULT << std::endl
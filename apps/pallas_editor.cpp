@@ -2,12 +2,16 @@
 // Created by khatharsis on 17/04/24.
 //
 
+#include <chrono>
+#include <iomanip>
 #include <iostream>
+#include <mutex>
 
 #include "pallas/pallas.h"
 #include "pallas/pallas_archive.h"
 
 #include "pallas/utils/pallas_dbg.h"
+#include "pallas/utils/pallas_parallel.h"
 #include "pallas/utils/pallas_parameter_handler.h"
 #include "pallas/utils/pallas_storage.h"
 
@@ -31,6 +35,26 @@ void usage() {
     for (auto v : compressionValues) {
         std::cout << "\t\t - " << toString(v) << std::endl;
     }
+    std::cout << "\t-j, --jobs n: Number of threads re-compressed concurrently (default: one per hardware thread)." << std::endl;
+}
+
+/** Returns the number of values stored in the LinkedVectors of a Thread. */
+static size_t getNbValues(const Thread* t) {
+    size_t nb_values = 0;
+    for (size_t i = 0; i < t->nb_events; i++) {
+        if (t->events[i].timestamps)
+            nb_values += t->events[i].timestamps->size;
+    }
+    for (size_t i = 0; i < t->nb_sequences; i++) {
+        const Sequence* s = &t->sequences[i];
+        if (s->durations)
+            nb_values += s->durations->size;
+        if (s->exclusive_durations)
+            nb_values += s->exclusive_durations->size;
+        if (s->timestamps)
+            nb_values += s->timestamps->size;
+    }
+    return nb_values;
 }
 
 int main(int argc, char** argv) {
@@ -38,6 +62,7 @@ int main(int argc, char** argv) {
     char* trace_name = nullptr;
     auto compressionAlgorithm = CompressionAlgorithm::Invalid;
     auto encodingAlgorithm = EncodingAlgorithm::Invalid;
+    size_t nb_jobs = 0;
 
     for (int i = 1; i < argc; i++) {
         if (!strcmp(argv[i], "-v")) {
@@ -49,7 +74,9 @@ int main(int argc, char** argv) {
         } else if (!strcmp(argv[i], "-c") || !strcmp(argv[i], "--compression")) {
             nb_opts += 2;
             compressionAlgorithm = compressionAlgorithmFromString(argv[++i]);
-            break;
+        } else if (!strcmp(argv[i], "-j") || !strcmp(argv[i], "--jobs")) {
+            nb_opts += 2;
+            nb_jobs = std::stoul(argv[++i]);
         } else {
             /* Unknown parameter name. It's probably the program name. We can stop
              * parsing the parameter list.
@@ -73,17 +100,46 @@ int main(int argc, char** argv) {
         ParameterHandler new_parameter_handler = *parameter_handler;
         new_parameter_handler.compressionAlgorithm = compressionAlgorithm;
         auto newDirName = strdup((std::string(trace->dir_name) + "_" + toString(compressionAlgorithm)).c_str());
+        // Threads are independent: they are re-compressed on a pool of workers.
+        // Each of them is streamed one subvector at a time, so the memory footprint doesn't depend on the size of the trace.
+        std::vector<std::pair<Archive*, ThreadId>> tasks;
         for (auto& lg : trace->location_groups) {
             std::cout << "Reading archive " << lg.id << " @ " << trace->dir_name << std::endl;
             auto* a = trace->getArchive(lg.id);
             for (auto& loc : a->locations) {
-                std::cout << "\tReading thread " << loc.id << " @ " << a->dir_name << std::endl;
-                auto* t = a->getThread(loc.id);
-                std::cout << "\tCompressing thread " << t->id << " @ " << a->dir_name << std::endl;
-                t->store(newDirName, &new_parameter_handler, true);
-                a->freeThread(loc.id);
+                tasks.emplace_back(a, loc.id);
             }
+        }
+
+        std::mutex output_lock;
+        size_t nb_done = 0;
+        size_t total_nb_values = 0;
+        auto start = std::chrono::steady_clock::now();
+        nb_jobs = getNbWorkers(nb_jobs, tasks.size());
+        parallelFor(tasks.size(), nb_jobs, [&](size_t i) {
+            auto [a, thread_id] = tasks[i];
+            auto thread_start = std::chrono::steady_clock::now();
+            auto* t = a->getThread(thread_id);
+            t->loadAll();
+            size_t nb_values = getNbValues(t);
+            t->store(newDirName, &new_parameter_handler, true);
+            a->freeThread(thread_id);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - thread_start;
+
+            std::lock_guard lock(output_lock);
+            nb_done++;
+            total_nb_values += nb_values;
+            std::cout << "\t[" << nb_done << "/" << tasks.size() << "] Compressed thread " << thread_id << " @ " << a->dir_name << ": "
+                      << nb_values << " values in " << std::fixed << std::setprecision(3) << elapsed.count() << "s" << std::endl;
+        });
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        double nb_megabytes = total_nb_values * sizeof(uint64_t) / (1024. * 1024.);
+        std::cout << "Compressed " << tasks.size() << " threads (" << std::fixed << std::setprecision(2) << nb_megabytes << " MB of durations and timestamps) in "
+                  << elapsed.count() << "s with " << nb_jobs << " worker(s): " << nb_megabytes / elapsed.count() << " MB/s" << std::endl;
+
+        for (auto& lg : trace->location_groups) {
             std::cout << "Writing archive " << lg.id << " @ " << trace->dir_name << std::endl;
+            auto* a = trace->getArchive(lg.id);
             a->store(newDirName, &new_parameter_handler);
             a->dir_name = nullptr;
             trace->freeArchive(lg.id);
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/** @file
+ * Keys that identify the Events, Sequences and Loops of a Thread by their content, and the order in which to
+ * compute them. pallas_sync and pallas_merge use them to find the definitions that several Threads share.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "pallas/pallas.h"
+
+namespace pallas {
+
+/** Returns the bytes identifying an Event: its record and its payload. */
+inline std::string event_key(const Event& event) {
+    return std::string(reinterpret_cast<const char*>(&event.data), event.data.event_size);
+}
+
+/** Returns the bytes identifying a Sequence: its tokens. */
+inline std::string sequence_key(const std::vector<Token>& tokens) {
+    return std::string(reinterpret_cast<const char*>(tokens.data()), tokens.size() * sizeof(Token));
+}
+
+/** Returns the key identifying a Loop: its repeated token and its number of iterations. */
+inline uint64_t loop_key(Token repeated_token, unsigned int nb_iterations) {
+    uint32_t token_bits;
+    std::memcpy(&token_bits, &repeated_token, sizeof(token_bits));
+    return (static_cast<uint64_t>(token_bits) << 32) | nb_iterations;
+}
+
+/** Appends token and everything it contains to postorder, children first. */
+inline void visit(const Thread* t, Token token, std::vector<bool>& seq_visited, std::vector<bool>& loop_visited, std::vector<Token>& postorder) {
+    if (token.type == TypeSequence) {
+        if (token.id >= t->sequence_id_map.size() || t->sequence_id_map[token.id] == PALLAS_INDEX_INVALID || seq_visited[token.id])
+            return;
+        seq_visited[token.id] = true;
+        for (const auto& child : t->sequences[t->sequence_id_map[token.id]].tokens) {
+            visit(t, child, seq_visited, loop_visited, postorder);
+        }
+    } else if (token.type == TypeLoop) {
+        if (token.id >= t->loop_id_map.size() || t->loop_id_map[token.id] == PALLAS_INDEX_INVALID || loop_visited[token.id])
+            return;
+        loop_visited[token.id] = true;
+        visit(t, t->loops[t->loop_id_map[token.id]].repeated_token, seq_visited, loop_visited, postorder);
+    } else {
+        return;
+    }
+    postorder.push_back(token);
+}
+
+/**
+ * Returns the Sequences and Loops of a Thread, ordered so that each of them comes after the Sequences and Loops it
+ * contains. The keys of their children are then known when their own key is computed.
+ */
+inline std::vector<Token> grammar_postorder(const Thread* t) {
+    std::vector<bool> seq_visited(t->sequence_id_map.size(), false);
+    std::vector<bool> loop_visited(t->loop_id_map.size(), false);
+    std::vector<Token> postorder;
+    for (uint32_t logi_id = 0; logi_id < t->sequence_id_map.size(); logi_id++) {
+        visit(t, PALLAS_SEQUENCE_ID(logi_id), seq_visited, loop_visited, postorder);
+    }
+    for (uint32_t logi_id = 0; logi_id < t->loop_id_map.size(); logi_id++) {
+        visit(t, PALLAS_LOOP_ID(logi_id), seq_visited, loop_visited, postorder);
+    }
+    return postorder;
+}
+
+}  // namespace pallas
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
@@ -6,6 +6,7 @@
 #include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <string>
 #if __GNUC__ >= 13 || __clang__ >= 14 || _MSC_VER >= 1929
 #include <format>
 #define HAS_FORMAT
@@ -33,6 +34,9 @@ enum command {
   list_archives = 1 << 5,
   show_archive_details = 1 << 6,
   list_threads = 1 << 7,
+  show_memory = 1 << 8,
+  show_statistics = 1 << 9,
+  verify_checksums = 1 << 10,
 };
 
 int cmd = none;
@@ -99,6 +103,7 @@ void info_event_header() {
 }
 
 void info_event(Thread* t, int index) {
+  t->loadEvent(index);
   Event* e = &t->events[index];
 
   std::cout << std::left << "E" << std::setw(14) << std::left << index;
@@ -134,6 +139,7 @@ float contention_score(Thread* t, Sequence& s) {
 }
 
 void info_sequence(Thread* t, int index, bool details = false) {
+  t->loadSequence(index);
   Sequence& s = t->sequences[index];
 
   std::string sequence_name = s.guessName(t);
@@ -433,6 +439,85 @@ void info_threads(Archive *archive) {
     }
 }
 
+void info_memory_header() {
+  std::cout << std::left << "#";
+  std::cout << std::setw(19) << std::left << "Thread_name";
+  std::cout << std::setw(15) << std::left << "Thread_id";
+  for (int category = 0; category < PALLAS_MEMORY_CATEGORY_COUNT; category++) {
+    std::cout << std::setw(15) << std::right << toString(static_cast<MemoryCategory>(category));
+  }
+  std::cout << std::setw(15) << std::right << "total";
+  std::cout << std::endl;
+}
+
+void info_memory_usage(const char* name, const std::string& id, const MemoryUsage& usage) {
+  std::cout << std::setw(20) << std::left << name;
+  std::cout << std::setw(15) << std::left << id;
+  for (int category = 0; category < PALLAS_MEMORY_CATEGORY_COUNT; category++) {
+    std::cout << std::setw(15) << std::right << usage.bytes[category];
+  }
+  std::cout << std::setw(15) << std::right << usage.total();
+  std::cout << std::endl;
+}
+
+/** Prints the memory used by each thread once it is loaded, and by the whole trace. */
+void info_memory(GlobalArchive *trace) {
+  info_memory_header();
+  MemoryUsage total;
+  for (auto &lg: trace->location_groups) {
+    auto *archive = trace->getArchive(lg.id);
+    if (!archive)
+      continue;
+    for (int i = 0; i < archive->nb_threads; i++) {
+      auto thread = archive->getThreadAt(i);
+      if (thread && _should_print_thread(thread->id))
+        info_memory_usage(thread->getName(), std::to_string(thread->id), thread->getMemoryUsage());
+    }
+    // Counts the definitions of the archive and all its threads, even those that aren't printed.
+    total += archive->getMemoryUsage();
+    trace->freeArchive(lg.id);
+  }
+  // The archives have been freed, so only the global definitions are left.
+  total += trace->getMemoryUsage();
+  info_memory_usage("Total", "", total);
+
+  auto *parameter_handler = trace->parameter_handler;
+  std::cout << "Loaded durations: " << parameter_handler->loaded_durations_size << " / "
+            << parameter_handler->max_memory_durations << " bytes" << std::endl;
+}
+
+void info_statistics_header() {
+  std::cout << std::setw(15) << std::left << "Sequence_id";
+  std::cout << std::setw(35) << std::left << "Name";
+  for (const char* column : {"Count", "Min(s)", "Max(s)", "Mean(s)", "Stddev(s)", "P50(s)", "P90(s)", "P99(s)"}) {
+    std::cout << std::setw(18) << std::right << column;
+  }
+  std::cout << std::endl;
+}
+
+/** Prints the statistics of the durations of the Sequences. They are read from the trace if they were stored there. */
+void info_statistics(Thread* t) {
+  t->buildStatistics();
+  std::cout << "Thread " << t->id << " (" << t->getName() << ")" << std::endl;
+  info_statistics_header();
+  for (size_t i = 0; i < t->nb_sequences; i++) {
+    const auto& stats = t->sequence_statistics[i];
+    if (stats.count == 0)
+      continue;
+    std::cout << std::left << "S" << std::setw(14) << std::left << t->sequences[i].id.id;
+    std::cout << std::setw(35) << std::left << t->sequences[i].guessName(t);
+    std::cout << std::setw(18) << std::right << stats.count;
+    std::cout << std::setw(18) << std::right << ns2s(stats.min);
+    std::cout << std::setw(18) << std::right << ns2s(stats.max);
+    std::cout << std::setw(18) << std::right << stats.mean / 1e9;
+    std::cout << std::setw(18) << std::right << stats.stddev() / 1e9;
+    std::cout << std::setw(18) << std::right << ns2s(stats.quantile(.5));
+    std::cout << std::setw(18) << std::right << ns2s(stats.quantile(.9));
+    std::cout << std::setw(18) << std::right << ns2s(stats.quantile(.99));
+    std::cout << std::endl;
+  }
+}
+
 void info_trace(GlobalArchive *trace) {
     info_global_archive(trace);
 
@@ -465,6 +550,37 @@ void info_trace(GlobalArchive *trace) {
             trace->freeArchive(lg.id);
         }
     }
+
+    if (cmd & show_memory) {
+        info_memory(trace);
+    }
+
+    if (cmd & show_statistics) {
+        for (auto &lg: trace->location_groups) {
+            auto* archive = trace->getArchive(lg.id);
+            for (auto& l: archive->locations) {
+                auto* thread = archive->getThread(l.id);
+                if (thread && _should_print_thread(thread->id))
+                    info_statistics(thread);
+            }
+            trace->freeArchive(lg.id);
+        }
+    }
+}
+
+/** Verifies the checksums of the whole trace, and prints the corrupted files and blocks. Returns whether it is intact. */
+static bool verify_trace(const char* trace_name, size_t nb_workers) {
+  auto report = pallasVerifyTrace(trace_name, nb_workers);
+  for (const auto& error : report.errors) {
+    std::cout << error << std::endl;
+  }
+  std::cout << "Verified " << report.nb_files << " files and " << report.nb_blocks << " blocks: ";
+  if (report.errors.empty()) {
+    std::cout << "OK" << std::endl;
+  } else {
+    std::cout << report.errors.size() << " errors" << std::endl;
+  }
+  return report.errors.empty();
 }
 
 void usage(const char* prog_name) {
@@ -481,6 +597,10 @@ void usage(const char* prog_name) {
   printf("\t--timestamps   show sequence timestamps\n");
   printf("\n");
   printf("\t-da            show archive details\n");
+  printf("\t-m --memory    show the memory used by each thread once loaded\n");
+  printf("\t--stats        show statistics of the sequence durations\n");
+  printf("\t--verify       verify the checksums of the whole trace, and exit\n");
+  printf("\t-j --jobs n    number of threads verified concurrently (default: one per hardware thread)\n");
   printf("\n");
   printf("\t--archive id   Only print archive <id>\n");
   printf("\t--thread id    Only print thread <id>\n");
@@ -491,6 +611,7 @@ void usage(const char* prog_name) {
 int main(int argc, char** argv) {
   int nb_opts = 0;
   char* trace_name = nullptr;
+  size_t nb_workers = 0;
 
   for (nb_opts = 1; nb_opts < argc; nb_opts++) {
     if (!strcmp(argv[nb_opts], "-v")) {
@@ -511,6 +632,15 @@ int main(int argc, char** argv) {
       cmd |= show_sequence_timestamps;
     } else if (!strcmp(argv[nb_opts], "-da")) {
       cmd |= show_archive_details;
+    } else if (!strcmp(argv[nb_opts], "-m") || !strcmp(argv[nb_opts], "--memory")) {
+      cmd |= show_memory;
+    } else if (!strcmp(argv[nb_opts], "--stats")) {
+      cmd |= show_statistics;
+    } else if (!strcmp(argv[nb_opts], "--verify")) {
+      cmd |= verify_checksums;
+    } else if ((!strcmp(argv[nb_opts], "-j") || !strcmp(argv[nb_opts], "--jobs")) && nb_opts + 1 < argc) {
+      nb_workers = std::stoul(argv[nb_opts + 1]);
+      nb_opts++;
     } else if (!strcmp(argv[nb_opts], "--archive")) {
       archive_to_print = atoi(argv[nb_opts + 1]);
       nb_opts++;
@@ -536,6 +666,10 @@ int main(int argc, char** argv) {
     return EXIT_SUCCESS;
   }
 
+  if (cmd & verify_checksums) {
+    return verify_trace(trace_name, nb_workers) ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
   auto trace = pallas_open_trace(trace_name);
   if (trace == nullptr) {
     return EXIT_FAILURE;
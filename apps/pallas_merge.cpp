@@ -0,0 +1,641 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Merges several traces into one.
+ * Threads that only exist in one of the traces ( eg. disjoint sets of ranks ) are copied as is.
+ * Threads that exist in several traces ( same LocationGroup and Thread ids ) are concatenated in time:
+ * their Events, Sequences and Loops are matched by content, and their main Sequences are played one after the other.
+ * The durations and timestamps are never decompressed when the traces use the same storage parameters.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "pallas/pallas.h"
+#include "pallas/pallas_archive.h"
+#include "pallas/pallas_attribute.h"
+#include "pallas/utils/pallas_hash.h"
+#include "pallas/utils/pallas_parallel.h"
+#include "pallas/utils/pallas_storage.h"
+#include "pallas_grammar_keys.h"
+
+using namespace pallas;
+
+/** Merged id of each definition of a Definition table. */
+struct RefMap {
+    std::unordered_map<Ref, Ref> strings;
+    std::unordered_map<Ref, Ref> regions;
+    std::unordered_map<Ref, Ref> attributes;
+    std::unordered_map<Ref, Ref> groups;
+    std::unordered_map<Ref, Ref> comms;
+};
+
+/** Returns the merged id of ref, or ref itself if it isn't defined. */
+static Ref translate(const std::unordered_map<Ref, Ref>& map, Ref ref) {
+    auto it = map.find(ref);
+    return it == map.end() ? ref : it->second;
+}
+
+/** Appends the bytes of value to key. */
+template <typename T>
+static void append_key(std::string& key, const T& value) {
+    key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/** Builds a single Definition out of the ones of all the traces, where each definition only appears once. */
+class DefinitionMerger {
+   public:
+    Definition merged;
+
+    /**
+     * Adds the definitions of d to the merged Definition.
+     * @param base Merged ids of the definitions d can refer to without defining them ( ie. the global ones for an Archive ).
+     * @returns The merged id of each definition of d, and of base.
+     */
+    RefMap add(const Definition& d, const RefMap* base) {
+        RefMap map = base ? *base : RefMap();
+        for (const auto& [ref, s] : d.strings) {
+            auto [it, inserted] = string_ids.try_emplace(s.str, next_string);
+            if (inserted) {
+                merged.addString(next_string++, s.str);
+            }
+            map.strings[ref] = it->second;
+        }
+        for (const auto& [ref, r] : d.regions) {
+            StringRef name = translate(map.strings, r.string_ref);
+            auto [it, inserted] = region_ids.try_emplace(name, next_region);
+            if (inserted) {
+                merged.addRegion(next_region++, name);
+            }
+            map.regions[ref] = it->second;
+        }
+        for (const auto& [ref, a] : d.attributes) {
+            StringRef name = translate(map.strings, a.name);
+            StringRef description = translate(map.strings, a.description);
+            std::string key;
+            append_key(key, name);
+            append_key(key, description);
+            append_key(key, a.type);
+            auto [it, inserted] = attribute_ids.try_emplace(key, next_attribute);
+            if (inserted) {
+                merged.addAttribute(next_attribute++, name, description, a.type);
+            }
+            map.attributes[ref] = it->second;
+        }
+        for (const auto& [ref, g] : d.groups) {
+            StringRef name = translate(map.strings, g.name);
+            std::vector<uint64_t> members(g.members, g.members + g.numberOfMembers);
+            std::string key;
+            append_key(key, name);
+            append_key(key, g.group_type);
+            append_key(key, g.paradigm);
+            key.append(reinterpret_cast<const char*>(members.data()), members.size() * sizeof(uint64_t));
+            auto [it, inserted] = group_ids.try_emplace(key, next_group);
+            if (inserted) {
+                merged.addGroup(next_group++, name, g.group_type, g.paradigm, g.numberOfMembers, members.data());
+            }
+            map.groups[ref] = it->second;
+        }
+        std::unordered_set<CommRef> done;
+        for (const auto& [ref, c] : d.comms) {
+            add_comm(d, ref, map, done);
+        }
+        return map;
+    }
+
+   private:
+    std::unordered_map<std::string, StringRef> string_ids;
+    std::unordered_map<StringRef, RegionRef> region_ids;
+    std::unordered_map<std::string, AttributeRef> attribute_ids;
+    std::unordered_map<std::string, GroupRef> group_ids;
+    std::unordered_map<std::string, CommRef> comm_ids;
+    StringRef next_string = 0;
+    RegionRef next_region = 0;
+    AttributeRef next_attribute = 0;
+    GroupRef next_group = 0;
+    CommRef next_comm = 0;
+
+    /** Adds a Comm of d, after its parent since Comms are identified by their parent's merged id. */
+    void add_comm(const Definition& d, CommRef ref, RefMap& map, std::unordered_set<CommRef>& done) {
+        if (!done.insert(ref).second)
+            return;
+        const Comm& c = d.comms.at(ref);
+        if (c.parent != PALLAS_COMMREF_INVALID && d.comms.count(c.parent)) {
+            add_comm(d, c.parent, map, done);
+        }
+        StringRef name = translate(map.strings, c.name);
+        GroupRef group = translate(map.groups, c.group);
+        CommRef parent = c.parent == PALLAS_COMMREF_INVALID ? c.parent : translate(map.comms, c.parent);
+        std::string key;
+        append_key(key, name);
+        append_key(key, group);
+        append_key(key, parent);
+        auto [it, inserted] = comm_ids.try_emplace(key, next_comm);
+        if (inserted) {
+            merged.addComm(next_comm++, name, group, parent);
+        }
+        map.comms[ref] = it->second;
+    }
+};
+
+/** Rewrites the reference stored at the given offset of an Event's payload. */
+static void remap_payload(EventData& data, size_t offset, const std::unordered_map<Ref, Ref>& map) {
+    Ref ref;
+    memcpy(&ref, &data.event_data[offset], sizeof(ref));
+    ref = translate(map, ref);
+    memcpy(&data.event_data[offset], &ref, sizeof(ref));
+}
+
+/** Calls f on each AttributeList of an Event. */
+template <typename F>
+static void for_each_attribute_list(Event& e, F f) {
+    size_t pos = 0;
+    while (pos + ATTRIBUTE_LIST_HEADER_SIZE <= e.attribute_pos) {
+        auto* l = reinterpret_cast<AttributeList*>(&e.attribute_buffer[pos]);
+        if (l->struct_size == 0)
+            break;
+        f(l);
+        pos += l->struct_size;
+    }
+}
+
+/** Rewrites the references to definitions in the payload and in the attributes of an Event. */
+static void remap_event(Event& e, const RefMap& map, const Definition& merged) {
+    switch (e.data.record) {
+    case PALLAS_EVENT_ENTER:
+    case PALLAS_EVENT_LEAVE:
+        remap_payload(e.data, 0, map.regions);
+        break;
+    case PALLAS_EVENT_GENERIC:
+        remap_payload(e.data, 0, map.strings);
+        break;
+    case PALLAS_EVENT_MPI_SEND:
+    case PALLAS_EVENT_MPI_ISEND:
+    case PALLAS_EVENT_MPI_RECV:
+    case PALLAS_EVENT_MPI_IRECV:
+    case PALLAS_EVENT_MPI_COLLECTIVE_END:
+        // The communicator comes after the rank / the collective operation.
+        remap_payload(e.data, sizeof(uint32_t), map.comms);
+        break;
+    default:
+        break;
+    }
+
+    for_each_attribute_list(e, [&](AttributeList* l) {
+        size_t offset = ATTRIBUTE_LIST_HEADER_SIZE;
+        for (int i = 0; i < l->nb_values; i++) {
+            auto* data = reinterpret_cast<AttributeData*>(reinterpret_cast<byte*>(l) + offset);
+            offset += data->struct_size;
+            data->ref = translate(map.attributes, data->ref);
+            const Attribute* attribute = merged.getAttribute(data->ref);
+            if (attribute == nullptr)
+                continue;
+            switch (attribute->type) {
+            case PALLAS_TYPE_STRING:
+                data->value.string_ref = translate(map.strings, data->value.string_ref);
+                break;
+            case PALLAS_TYPE_ATTRIBUTE:
+                data->value.attribute_ref = translate(map.attributes, data->value.attribute_ref);
+                break;
+            case PALLAS_TYPE_REGION:
+                data->value.region_ref = translate(map.regions, data->value.region_ref);
+                break;
+            case PALLAS_TYPE_GROUP:
+                data->value.group_ref = translate(map.groups, data->value.group_ref);
+                break;
+            case PALLAS_TYPE_COMM:
+                data->value.comm_ref = translate(map.comms, data->value.comm_ref);
+                break;
+            default:
+                break;
+            }
+        }
+    });
+}
+
+/** Returns a new element at the end of array, growing it the way the ThreadWriter does. */
+template <typename T>
+static T& append(T*& array, size_t& nb, size_t& nb_allocated) {
+    if (nb >= nb_allocated) {
+        if (nb_allocated == 0) {
+            delete[] array;
+            nb_allocated = 1;
+            array = new T[nb_allocated]();
+        } else {
+            doubleMemorySpaceConstructor(array, nb_allocated);
+        }
+    }
+    return array[nb++];
+}
+
+/** Returns a new logical id mapped to the given physical one. */
+static uint32_t new_logical_id(std::vector<uint32_t>& id_map, uint32_t phys_id) {
+    id_map.push_back(phys_id);
+    return id_map.size() - 1;
+}
+
+/**
+ * Finds the id of m matching a key of b. Each id of m is matched at most once, so that two definitions of b
+ * that happen to be identical keep two distinct ids.
+ * @returns The matched id, or PALLAS_INDEX_INVALID.
+ */
+template <typename Key>
+static uint32_t match(const std::unordered_map<Key, uint32_t>& ids, const Key& key, std::vector<bool>& used) {
+    auto it = ids.find(key);
+    if (it == ids.end() || used[it->second])
+        return PALLAS_INDEX_INVALID;
+    used[it->second] = true;
+    return it->second;
+}
+
+/** Appends the attributes of b to the ones of m, shifting their occurrence index after the ones of m. */
+static void append_attributes(Event& m, Event& b) {
+    if (b.attribute_pos == 0)
+        return;
+    size_t size = m.attribute_pos + b.attribute_pos;
+    auto* buffer = new byte[size];
+    if (m.attribute_pos > 0) {
+        memcpy(buffer, m.attribute_buffer, m.attribute_pos);
+    }
+    memcpy(&buffer[m.attribute_pos], b.attribute_buffer, b.attribute_pos);
+    Event appended = b;
+    appended.attribute_buffer = &buffer[m.attribute_pos];
+    for_each_attribute_list(appended, [&](AttributeList* l) { l->index += static_cast<int>(m.nb_occurrences); });
+    delete[] m.attribute_buffer;
+    m.attribute_buffer = buffer;
+    m.attribute_buffer_size = size;
+    m.attribute_pos = size;
+    m.clearAttributeIndex();
+}
+
+/**
+ * Appends b to m: the Events, Sequences and Loops of b are matched with the ones of m, or added to m,
+ * and the main Sequence of m becomes [ main Sequence of m, main Sequence of b ].
+ * The vectors of b are referenced by m: b must not be deleted.
+ */
+static void append_thread(Thread* m, Thread* b, ParameterHandler& parameter_handler) {
+    std::unordered_map<std::string, uint32_t> m_events;
+    std::unordered_map<std::string, uint32_t> m_sequences;
+    std::unordered_map<uint64_t, uint32_t> m_loops;
+    for (uint32_t logi_id = 0; logi_id < m->event_id_map.size(); logi_id++) {
+        if (m->event_id_map[logi_id] != PALLAS_INDEX_INVALID)
+            m_events.try_emplace(event_key(m->events[m->event_id_map[logi_id]]), logi_id);
+    }
+    for (uint32_t logi_id = 0; logi_id < m->sequence_id_map.size(); logi_id++) {
+        if (m->sequence_id_map[logi_id] != PALLAS_INDEX_INVALID)
+            m_sequences.try_emplace(sequence_key(m->sequences[m->sequence_id_map[logi_id]].tokens), logi_id);
+    }
+    for (uint32_t logi_id = 0; logi_id < m->loop_id_map.size(); logi_id++) {
+        if (m->loop_id_map[logi_id] != PALLAS_INDEX_INVALID) {
+            const Loop& loop = m->loops[m->loop_id_map[logi_id]];
+            m_loops.try_emplace(loop_key(loop.repeated_token, loop.nb_iterations), logi_id);
+        }
+    }
+    std::vector<bool> used_events(m->event_id_map.size(), false);
+    std::vector<bool> used_sequences(m->sequence_id_map.size(), false);
+    std::vector<bool> used_loops(m->loop_id_map.size(), false);
+
+    // Ids in m of the definitions of b, indexed by their logical id in b.
+    std::vector<uint32_t> events(b->event_id_map.size(), PALLAS_INDEX_INVALID);
+    std::vector<uint32_t> sequences(b->sequence_id_map.size(), PALLAS_INDEX_INVALID);
+    std::vector<uint32_t> loops(b->loop_id_map.size(), PALLAS_INDEX_INVALID);
+    auto to_m = [&](Token token) {
+        const auto& map = token.type == TypeEvent ? events : token.type == TypeSequence ? sequences : loops;
+        if (token.id >= map.size() || map[token.id] == PALLAS_INDEX_INVALID) {
+            pallas_error("Thread %u references token {.type=%d, .id=%u}, which it doesn't define\n", b->id, token.type, token.id);
+        }
+        return Token(token.type, map[token.id]);
+    };
+
+    for (uint32_t logi_id = 0; logi_id < b->event_id_map.size(); logi_id++) {
+        uint32_t phys_id = b->event_id_map[logi_id];
+        if (phys_id == PALLAS_INDEX_INVALID)
+            continue;
+        Event& b_event = b->events[phys_id];
+        uint32_t m_id = match(m_events, event_key(b_event), used_events);
+        if (m_id != PALLAS_INDEX_INVALID) {
+            Event& m_event = m->events[m->event_id_map[m_id]];
+            m_event.timestamps = new LinkedVector(parameter_handler, {m_event.timestamps, b_event.timestamps});
+            append_attributes(m_event, b_event);
+            m_event.nb_occurrences += b_event.nb_occurrences;
+        } else {
+            uint32_t m_phys_id = m->nb_events;
+            Event& e = append(m->events, m->nb_events, m->nb_allocated_events);
+            e = b_event;
+            m_id = new_logical_id(m->event_id_map, m_phys_id);
+            e.id = m_id;
+        }
+        events[logi_id] = m_id;
+    }
+
+    std::vector<Token> tokens;
+    for (auto token : grammar_postorder(b)) {
+        if (token.type == TypeSequence) {
+            Sequence& b_seq = b->sequences[b->sequence_id_map[token.id]];
+            tokens.clear();
+            for (auto child : b_seq.tokens) {
+                tokens.push_back(to_m(child));
+            }
+            uint32_t m_id = match(m_sequences, sequence_key(tokens), used_sequences);
+            if (m_id != PALLAS_INDEX_INVALID) {
+                Sequence& m_seq = m->sequences[m->sequence_id_map[m_id]];
+                m_seq.durations = new LinkedDurationVector(parameter_handler, {m_seq.durations, b_seq.durations});
+                m_seq.exclusive_durations = new LinkedDurationVector(parameter_handler, {m_seq.exclusive_durations, b_seq.exclusive_durations});
+                m_seq.timestamps = new LinkedVector(parameter_handler, {m_seq.timestamps, b_seq.timestamps});
+            } else {
+                uint32_t m_phys_id = m->nb_sequences;
+                Sequence& s = append(m->sequences, m->nb_sequences, m->nb_allocated_sequences);
+                m_id = new_logical_id(m->sequence_id_map, m_phys_id);
+                s.id = PALLAS_SEQUENCE_ID(m_id);
+                s.type = b_seq.type;
+                s.tokens = tokens;
+                s.hash = hash32_Token(tokens.data(), tokens.size(), SEED);
+                s.durations = b_seq.durations;
+                s.exclusive_durations = b_seq.exclusive_durations;
+                s.timestamps = b_seq.timestamps;
+            }
+            sequences[token.id] = m_id;
+        } else {
+            const Loop& b_loop = b->loops[b->loop_id_map[token.id]];
+            Token repeated_token = to_m(b_loop.repeated_token);
+            uint32_t m_id = match(m_loops, loop_key(repeated_token, b_loop.nb_iterations), used_loops);
+            if (m_id != PALLAS_INDEX_INVALID) {
+                m->loops[m->loop_id_map[m_id]].nb_occurrences += b_loop.nb_occurrences;
+            } else {
+                uint32_t m_phys_id = m->nb_loops;
+                Loop& l = append(m->loops, m->nb_loops, m->nb_allocated_loops);
+                m_id = new_logical_id(m->loop_id_map, m_phys_id);
+                l.repeated_token = repeated_token;
+                l.self_id = PALLAS_LOOP_ID(m_id);
+                l.nb_iterations = b_loop.nb_iterations;
+                l.nb_occurrences = b_loop.nb_occurrences;
+            }
+            loops[token.id] = m_id;
+        }
+    }
+
+    // The new main Sequence plays the one of m, then the one of b.
+    Token m_root = PALLAS_SEQUENCE_ID(m->sequence_root);
+    Token b_root = to_m(PALLAS_SEQUENCE_ID(b->sequence_root));
+    Sequence* m_root_seq = m->getSequence(m_root);
+    pallas_timestamp_t start = m_root_seq->timestamps->at(0);
+    pallas_timestamp_t m_end = start + m_root_seq->durations->at(0);
+    Sequence* b_root_seq = m->getSequence(b_root);
+    pallas_timestamp_t b_start = b_root_seq->timestamps->at(b_root_seq->timestamps->size - 1);
+    pallas_timestamp_t end = b_start + b_root_seq->durations->at(b_root_seq->durations->size - 1);
+    if (b_start < m_end) {
+        pallas_warn("Thread %u: the second part starts (%" PRIu64 ") before the end of the first one (%" PRIu64 ")\n", m->id, b_start, m_end);
+    }
+    auto type = m_root_seq->type;
+
+    uint32_t root_phys_id = m->nb_sequences;
+    Sequence& root = append(m->sequences, m->nb_sequences, m->nb_allocated_sequences);
+    uint32_t root_id = new_logical_id(m->sequence_id_map, root_phys_id);
+    root.id = PALLAS_SEQUENCE_ID(root_id);
+    root.type = type;
+    root.tokens = {m_root, b_root};
+    root.hash = hash32_Token(root.tokens.data(), root.tokens.size(), SEED);
+    root.durations = new LinkedDurationVector(parameter_handler);
+    root.exclusive_durations = new LinkedDurationVector(parameter_handler);
+    root.timestamps = new LinkedVector(parameter_handler);
+    root.durations->add(end > start ? end - start : 0);
+    root.durations->final_update_mean();
+    root.exclusive_durations->add(0);
+    root.exclusive_durations->final_update_mean();
+    root.timestamps->add(start);
+    m->sequence_root = root_id;
+
+    m->first_timestamp = std::min(m->first_timestamp, b->first_timestamp);
+    m->sequence_labels.clear();
+    m->sequence_label_ids.clear();
+}
+
+/** An Archive of one of the traces, with its Threads. */
+struct ArchiveEntry {
+    size_t trace_index;
+    Archive* archive;
+    RefMap refs;
+    std::vector<Thread*> threads;
+};
+
+void usage() {
+    std::cout << "Usage: pallas_merge [OPTION] trace_file trace_file [trace_file...]" << std::endl;
+    std::cout << "\t-o, --output dir: Directory of the merged trace (default: the one of the first trace, suffixed with _merged)." << std::endl;
+    std::cout << "\t-r, --ranks: Only merge disjoint sets of ranks: fail if two traces share a LocationGroup." << std::endl;
+    std::cout << "\t-j, --jobs n: Number of threads processed concurrently (default: one per hardware thread)." << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::string output_dir;
+    bool ranks_only = false;
+    size_t nb_workers = 0;
+    std::vector<const char*> trace_names;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "-?")) {
+            usage();
+            return EXIT_SUCCESS;
+        } else if ((!strcmp(argv[i], "-o") || !strcmp(argv[i], "--output")) && i + 1 < argc) {
+            output_dir = argv[++i];
+        } else if (!strcmp(argv[i], "-r") || !strcmp(argv[i], "--ranks")) {
+            ranks_only = true;
+        } else if ((!strcmp(argv[i], "-j") || !strcmp(argv[i], "--jobs")) && i + 1 < argc) {
+            nb_workers = std::stoul(argv[++i]);
+        } else {
+            trace_names.push_back(argv[i]);
+        }
+    }
+    if (trace_names.size() < 2) {
+        std::cout << "ERROR: Missing trace file" << std::endl;
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    std::vector<GlobalArchive*> traces;
+    for (auto* name : trace_names) {
+        auto* trace = pallas_open_trace(name);
+        if (trace == nullptr) {
+            return EXIT_FAILURE;
+        }
+        traces.push_back(trace);
+    }
+    GlobalArchive* output = traces[0];
+    if (output_dir.empty()) {
+        output_dir = std::string(output->dir_name) + "_merged";
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Merge the definitions. Each Archive may redefine some of them: it gets its own map.
+    DefinitionMerger merger;
+    std::vector<RefMap> global_refs;
+    std::vector<ArchiveEntry> entries;
+    std::vector<std::pair<size_t, ThreadId>> thread_list;
+    for (size_t i = 0; i < traces.size(); i++) {
+        global_refs.push_back(merger.add(traces[i]->definitions, nullptr));
+    }
+    for (size_t i = 0; i < traces.size(); i++) {
+        for (auto& lg : traces[i]->location_groups) {
+            auto* a = traces[i]->getArchive(lg.id, false);
+            if (a == nullptr)
+                continue;
+            entries.push_back({i, a, merger.add(a->definitions, &global_refs[i]), {}});
+            for (auto& loc : a->locations) {
+                thread_list.emplace_back(entries.size() - 1, loc.id);
+            }
+        }
+    }
+
+    // Load every Thread and rewrite its Events with the merged definitions.
+    std::vector<Thread*> threads(thread_list.size());
+    parallelFor(thread_list.size(), nb_workers, [&](size_t i) {
+        auto& entry = entries[thread_list[i].first];
+        auto* t = entry.archive->getThread(thread_list[i].second);
+        threads[i] = t;
+        if (t == nullptr)
+            return;
+        t->loadAll();
+        // The merged vectors combine the statistics of the ones of t: take the stored ones rather than decoding them.
+        t->updateStatistics();
+        for (size_t j = 0; j < t->nb_events; j++) {
+            remap_event(t->events[j], entry.refs, merger.merged);
+        }
+    });
+    for (size_t i = 0; i < thread_list.size(); i++) {
+        if (threads[i])
+            entries[thread_list[i].first].threads.push_back(threads[i]);
+    }
+
+    for (size_t i = 0; i < traces.size(); i++) {
+        for (auto& lg : traces[i]->location_groups) {
+            lg.name = translate(global_refs[i].strings, lg.name);
+        }
+    }
+    for (auto& entry : entries) {
+        for (auto& loc : entry.archive->locations) {
+            loc.name = translate(entry.refs.strings, loc.name);
+        }
+        for (auto& lg : entry.archive->location_groups) {
+            lg.name = translate(entry.refs.strings, lg.name);
+        }
+        entry.archive->definitions = Definition();
+    }
+    output->definitions = std::move(merger.merged);
+
+    // Add the Archives and Threads of the other traces to the ones of the first trace.
+    std::unordered_map<LocationGroupId, ArchiveEntry*> output_archives;
+    std::unordered_set<ThreadId> output_thread_ids;
+    for (auto& entry : entries) {
+        if (entry.trace_index == 0) {
+            output_archives[entry.archive->id] = &entry;
+            for (auto* t : entry.threads)
+                output_thread_ids.insert(t->id);
+        }
+    }
+    size_t nb_appended = 0;
+    for (size_t i = 1; i < traces.size(); i++) {
+        std::vector<std::pair<Thread*, Thread*>> to_append;
+        for (auto& entry : entries) {
+            if (entry.trace_index != i)
+                continue;
+            auto it = output_archives.find(entry.archive->id);
+            if (it == output_archives.end()) {
+                if (ranks_only) {
+                    for (auto* t : entry.threads) {
+                        if (!output_thread_ids.insert(t->id).second) {
+                            pallas_error("Thread %u of %s is already defined by another trace\n", t->id, trace_names[i]);
+                        }
+                    }
+                }
+                entry.archive->global_archive = output;
+                for (auto& lg : traces[i]->location_groups) {
+                    if (lg.id == entry.archive->id)
+                        output->location_groups.push_back(lg);
+                }
+                output_archives[entry.archive->id] = &entry;
+                continue;
+            }
+            if (ranks_only) {
+                pallas_error("LocationGroup %u of %s is already defined by another trace\n", entry.archive->id, trace_names[i]);
+            }
+            ArchiveEntry& out = *it->second;
+            for (auto* t : entry.threads) {
+                Thread* m = nullptr;
+                for (auto* candidate : out.threads) {
+                    if (candidate->id == t->id)
+                        m = candidate;
+                }
+                if (m) {
+                    to_append.emplace_back(m, t);
+                    continue;
+                }
+                // The Thread moves to the Archive of out, which owns it from now on.
+                for (int k = 0; k < entry.archive->nb_threads; k++) {
+                    if (entry.archive->threads[k] == t)
+                        entry.archive->threads[k] = nullptr;
+                }
+                t->archive = out.archive;
+                out.threads.push_back(t);
+                for (auto& loc : entry.archive->locations) {
+                    if (loc.id == t->id)
+                        out.archive->locations.push_back(loc);
+                }
+                if (out.archive->nb_allocated_threads == 0) {
+                    delete[] out.archive->threads;
+                    out.archive->threads = new Thread*[1]();
+                    out.archive->nb_allocated_threads = 1;
+                }
+                while (out.archive->nb_threads >= out.archive->nb_allocated_threads) {
+                    doubleMemorySpaceConstructor(out.archive->threads, out.archive->nb_allocated_threads);
+                }
+                out.archive->threads[out.archive->nb_threads++] = t;
+            }
+        }
+        parallelFor(to_append.size(), nb_workers, [&](size_t j) {
+            append_thread(to_append[j].first, to_append[j].second, *output->parameter_handler);
+        });
+        nb_appended += to_append.size();
+    }
+
+    std::vector<Thread*> output_threads;
+    std::vector<Archive*> output_archive_list;
+    for (auto& lg : output->location_groups) {
+        auto it = output_archives.find(lg.id);
+        if (it == output_archives.end())
+            continue;
+        output_archive_list.push_back(it->second->archive);
+        output_threads.insert(output_threads.end(), it->second->threads.begin(), it->second->threads.end());
+    }
+
+    parallelFor(output_threads.size(), nb_workers, [&](size_t i) {
+        output_threads[i]->store(output_dir.c_str(), output->parameter_handler, true);
+    });
+    for (auto* a : output_archive_list) {
+        a->store(output_dir.c_str(), output->parameter_handler);
+    }
+    output->store(output_dir.c_str(), output->parameter_handler);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Merged " << traces.size() << " traces into " << output_dir << " in " << elapsed.count() << "s: "
+              << output_archive_list.size() << " archives, " << output_threads.size() << " threads ("
+              << nb_appended << " concatenated in time)" << std::endl;
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
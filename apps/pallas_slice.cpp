@@ -0,0 +1,614 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Extracts a time window and/or a subset of the ranks and threads of a trace into a new trace.
+ * The grammar of each thread is reused: the Sequences and Loops that are inside the window are kept as is,
+ * the ones before it are skipped without being visited, and only the ones that overlap an edge of the window
+ * are clipped, into new Sequences and Loops with fewer iterations.
+ * Slicing a window thus takes a time proportional to the slice, not to the whole trace.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+#include "pallas/pallas.h"
+#include "pallas/pallas_archive.h"
+#include "pallas/pallas_attribute.h"
+#include "pallas/utils/pallas_hash.h"
+#include "pallas/utils/pallas_parallel.h"
+#include "pallas/utils/pallas_storage.h"
+
+using namespace pallas;
+
+/** A Token of the slice, with the first and last timestamps of its occurrence. */
+struct Piece {
+    Token token;
+    pallas_timestamp_t first;
+    pallas_timestamp_t last;
+};
+
+/** A Sequence made of a clipped occurrence, which only occurs once in the slice. */
+struct ClippedSequence {
+    enum SequenceType type;
+    std::vector<Token> tokens;
+    pallas_timestamp_t timestamp;
+    pallas_duration_t duration;
+    pallas_duration_t exclusive_duration;
+};
+
+/** Calls f on each AttributeList of an Event. */
+template <typename F>
+static void for_each_attribute_list(Event& e, F f) {
+    size_t pos = 0;
+    while (pos + ATTRIBUTE_LIST_HEADER_SIZE <= e.attribute_pos) {
+        auto* l = reinterpret_cast<AttributeList*>(&e.attribute_buffer[pos]);
+        if (l->struct_size == 0)
+            break;
+        f(l);
+        pos += l->struct_size;
+    }
+}
+
+/** Returns a new vector holding the values [first, first + n) of v. */
+static LinkedVector* slice_vector(LinkedVector* v, size_t first, size_t n, ParameterHandler& parameter_handler) {
+    auto* sliced = new LinkedVector(parameter_handler);
+    for (size_t i = first; i < first + n; i++) {
+        sliced->add(v->at(i));
+    }
+    return sliced;
+}
+
+/** Returns a new vector holding the values [first, first + n) of v. */
+static LinkedDurationVector* slice_vector(LinkedDurationVector* v, size_t first, size_t n, ParameterHandler& parameter_handler) {
+    auto* sliced = new LinkedDurationVector(parameter_handler);
+    for (size_t i = first; i < first + n; i++) {
+        sliced->add(v->at(i));
+    }
+    sliced->final_update_mean();
+    return sliced;
+}
+
+/** Returns a new vector holding the given value. */
+template <typename Vector>
+static Vector* single_value(uint64_t value, ParameterHandler& parameter_handler) {
+    auto* v = new Vector(parameter_handler);
+    v->add(value);
+    if constexpr (std::is_same_v<Vector, LinkedDurationVector>) {
+        v->final_update_mean();
+    }
+    return v;
+}
+
+/** Slices one Thread in place. */
+class ThreadSlicer {
+   public:
+    ThreadSlicer(Thread* thread, pallas_timestamp_t start, pallas_timestamp_t end, ParameterHandler& parameter_handler)
+        : thread(thread), start(start), end(end), parameter_handler(parameter_handler) {}
+
+    /**
+     * Replaces the Events, Sequences and Loops of the Thread with the ones of the slice.
+     * @returns false if nothing happens in the window.
+     */
+    bool slice() {
+        Token root = PALLAS_SEQUENCE_ID(thread->sequence_root);
+        auto [first, last] = bounds(root);
+        if (first >= start && last <= end) {
+            // The whole Thread is in the window: nothing to change.
+            return true;
+        }
+        std::vector<Piece> top;
+        visit(root, top);
+        if (top.empty())
+            return false;
+
+        Token new_root = top[0].token;
+        if (top.size() > 1 || new_root.type != TypeSequence || kept_count.get_value(new_root) > 0) {
+            // A kept Sequence may occur several times in the slice: the root needs a Sequence of its own.
+            new_root = add_clipped(thread->getSequence(root)->type, top);
+        }
+        rebuild(new_root, top.front().first);
+        return true;
+    }
+
+   private:
+    Thread* thread;
+    pallas_timestamp_t start;
+    pallas_timestamp_t end;
+    ParameterHandler& parameter_handler;
+
+    /** Number of occurrences of each Token visited or skipped so far. */
+    TokenCountMap count;
+    /** Index of the first occurrence of each Token kept in the slice. */
+    TokenCountMap kept_first;
+    /** Number of occurrences of each Token kept in the slice. They are contiguous. */
+    TokenCountMap kept_count;
+    /** The end of the window was reached. */
+    bool done = false;
+
+    /** Clipped Sequences, whose logical ids follow the ones of the Thread. */
+    std::vector<ClippedSequence> clipped;
+    /** Loops with fewer iterations, as (repeated token, number of iterations). Their logical ids follow the ones of the Thread. */
+    std::vector<std::pair<Token, unsigned int>> new_loops;
+
+    /** Returns the first and last timestamps of the next occurrence of token. */
+    std::pair<pallas_timestamp_t, pallas_timestamp_t> bounds(Token token) {
+        switch (token.type) {
+        case TypeEvent: {
+            pallas_timestamp_t ts = thread->getEvent(token)->timestamps->at(count.get_value(token));
+            return {ts, ts};
+        }
+        case TypeSequence: {
+            auto* s = thread->getSequence(token);
+            size_t i = count.get_value(token);
+            pallas_timestamp_t ts = s->timestamps->at(i);
+            return {ts, ts + s->durations->at(i)};
+        }
+        case TypeLoop: {
+            auto* l = thread->getLoop(token);
+            auto* s = thread->getSequence(l->repeated_token);
+            size_t i = count.get_value(l->repeated_token);
+            size_t last = i + l->nb_iterations - 1;
+            return {s->timestamps->at(i), s->timestamps->at(last) + s->durations->at(last)};
+        }
+        default:
+            pallas_error("Token is Invalid\n");
+        }
+    }
+
+    /** Returns the number of occurrences of each Token in one occurrence of token, token excluded. */
+    TokenCountMap contents(Token token) {
+        if (token.type == TypeSequence) {
+            return thread->getSequence(token)->getTokenCountReading(thread);
+        }
+        if (token.type == TypeLoop) {
+            auto* l = thread->getLoop(token);
+            TokenCountMap inner = thread->getSequence(l->repeated_token)->getTokenCountReading(thread) * l->nb_iterations;
+            inner[l->repeated_token] += l->nb_iterations;
+            return inner;
+        }
+        return TokenCountMap();
+    }
+
+    /** Moves past the next occurrence of token, without keeping it. */
+    void skip(Token token) {
+        if (token.type != TypeEvent) {
+            count += contents(token);
+        }
+        count[token]++;
+    }
+
+    /** Keeps the next occurrence of token, and everything it contains. */
+    void keep(Token token) {
+        TokenCountMap inner = contents(token);
+        inner[token]++;
+        for (const auto& [t, n] : inner) {
+            if (kept_first.find(t) == kept_first.end()) {
+                kept_first[t] = count.get_value(t);
+            }
+            kept_count[t] += n;
+        }
+        count += inner;
+    }
+
+    /** Appends to out the Tokens of the slice that stand for the next occurrence of token. */
+    void visit(Token token, std::vector<Piece>& out) {
+        auto [first, last] = bounds(token);
+        if (last < start) {
+            skip(token);
+        } else if (first > end) {
+            done = true;
+        } else if (first >= start && last <= end) {
+            keep(token);
+            out.push_back({token, first, last});
+        } else if (token.type == TypeSequence) {
+            clip_sequence(token, out);
+        } else if (token.type == TypeLoop) {
+            clip_loop(token, out);
+        }
+    }
+
+    /** Clips the next occurrence of a Sequence that overlaps an edge of the window. */
+    void clip_sequence(Token token, std::vector<Piece>& out) {
+        auto* s = thread->getSequence(token);
+        std::vector<Piece> pieces;
+        for (size_t i = 0; i < s->tokens.size() && !done; i++) {
+            visit(s->tokens[i], pieces);
+        }
+        count[token]++;
+        if (pieces.empty())
+            return;
+        out.push_back({add_clipped(s->type, pieces), pieces.front().first, pieces.back().last});
+    }
+
+    /** Clips the next occurrence of a Loop that overlaps an edge of the window. */
+    void clip_loop(Token token, std::vector<Piece>& out) {
+        auto* l = thread->getLoop(token);
+        Token repeated = l->repeated_token;
+        auto* s = thread->getSequence(repeated);
+        size_t base = count.get_value(repeated);
+
+        // Skip the iterations that end before the window at once.
+        size_t lo = 0, hi = l->nb_iterations;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (s->timestamps->at(base + mid) + s->durations->at(base + mid) < start)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        if (lo > 0) {
+            count += s->getTokenCountReading(thread) * lo;
+            count[repeated] += lo;
+        }
+
+        // Consecutive iterations in the window become a shorter Loop.
+        size_t run = 0;
+        Piece run_piece{};
+        auto flush = [&]() {
+            if (run == 1) {
+                out.push_back(run_piece);
+            } else if (run > 1) {
+                new_loops.emplace_back(repeated, run);
+                out.push_back({PALLAS_LOOP_ID(thread->loop_id_map.size() + new_loops.size() - 1), run_piece.first, run_piece.last});
+            }
+            run = 0;
+        };
+        for (size_t i = lo; i < l->nb_iterations && !done; i++) {
+            auto [first, last] = bounds(repeated);
+            if (first > end) {
+                done = true;
+            } else if (first >= start && last <= end) {
+                keep(repeated);
+                if (run++ == 0)
+                    run_piece = {repeated, first, last};
+                run_piece.last = last;
+            } else {
+                flush();
+                clip_sequence(repeated, out);
+            }
+        }
+        flush();
+        count[token]++;
+    }
+
+    /** Adds a Sequence made of the given pieces. @returns Its Token. */
+    Token add_clipped(enum SequenceType type, const std::vector<Piece>& pieces) {
+        ClippedSequence c;
+        c.type = type;
+        c.timestamp = pieces.front().first;
+        c.duration = pieces.back().last - pieces.front().first;
+        pallas_duration_t nested = 0;
+        for (const auto& p : pieces) {
+            c.tokens.push_back(p.token);
+            if (p.token.type != TypeEvent)
+                nested += p.last - p.first;
+        }
+        c.exclusive_duration = c.duration > nested ? c.duration - nested : 0;
+        clipped.push_back(std::move(c));
+        return PALLAS_SEQUENCE_ID(thread->sequence_id_map.size() + clipped.size() - 1);
+    }
+
+    /** Copies the attributes of the occurrences [first, first + n) of old into e. */
+    static void slice_attributes(Event& e, Event& old, size_t first, size_t n) {
+        e.attribute_buffer = nullptr;
+        e.attribute_buffer_size = 0;
+        e.attribute_pos = 0;
+        size_t size = 0;
+        for_each_attribute_list(old, [&](AttributeList* l) {
+            if (l->index >= static_cast<int>(first) && l->index < static_cast<int>(first + n))
+                size += l->struct_size;
+        });
+        if (size == 0)
+            return;
+        e.attribute_buffer = new byte[size];
+        e.attribute_buffer_size = size;
+        for_each_attribute_list(old, [&](AttributeList* l) {
+            if (l->index < static_cast<int>(first) || l->index >= static_cast<int>(first + n))
+                return;
+            auto* copy = reinterpret_cast<AttributeList*>(&e.attribute_buffer[e.attribute_pos]);
+            memcpy(copy, l, l->struct_size);
+            copy->index -= static_cast<int>(first);
+            e.attribute_pos += l->struct_size;
+        });
+    }
+
+    /** Replaces the definitions of the Thread with the kept and clipped ones, with contiguous ids. */
+    void rebuild(Token root, pallas_timestamp_t first_timestamp) {
+        std::vector<uint32_t> events(thread->event_id_map.size(), PALLAS_INDEX_INVALID);
+        std::vector<uint32_t> sequences(thread->sequence_id_map.size() + clipped.size(), PALLAS_INDEX_INVALID);
+        std::vector<uint32_t> loops(thread->loop_id_map.size() + new_loops.size(), PALLAS_INDEX_INVALID);
+        uint32_t nb_events = 0, nb_sequences = 0, nb_loops = 0;
+        for (uint32_t id = 0; id < thread->event_id_map.size(); id++) {
+            if (kept_count.get_value(PALLAS_EVENT_ID(id)) > 0)
+                events[id] = nb_events++;
+        }
+        for (uint32_t id = 0; id < thread->sequence_id_map.size(); id++) {
+            if (kept_count.get_value(PALLAS_SEQUENCE_ID(id)) > 0)
+                sequences[id] = nb_sequences++;
+        }
+        for (size_t i = 0; i < clipped.size(); i++) {
+            sequences[thread->sequence_id_map.size() + i] = nb_sequences++;
+        }
+        for (uint32_t id = 0; id < thread->loop_id_map.size(); id++) {
+            if (kept_count.get_value(PALLAS_LOOP_ID(id)) > 0)
+                loops[id] = nb_loops++;
+        }
+        for (size_t i = 0; i < new_loops.size(); i++) {
+            loops[thread->loop_id_map.size() + i] = nb_loops++;
+        }
+        auto renamed = [&](Token t) {
+            const auto& map = t.type == TypeEvent ? events : t.type == TypeSequence ? sequences : loops;
+            return Token(t.type, map[t.id]);
+        };
+        auto renamed_tokens = [&](const std::vector<Token>& tokens) {
+            std::vector<Token> result;
+            result.reserve(tokens.size());
+            for (auto t : tokens)
+                result.push_back(renamed(t));
+            return result;
+        };
+
+        auto* new_events = new Event[std::max<uint32_t>(nb_events, 1)];
+        for (uint32_t id = 0; id < events.size(); id++) {
+            if (events[id] == PALLAS_INDEX_INVALID)
+                continue;
+            Token t = PALLAS_EVENT_ID(id);
+            Event& old = *thread->getEvent(t);
+            Event& e = new_events[events[id]];
+            size_t first = kept_first.get_value(t);
+            size_t n = kept_count.get_value(t);
+            e = Event(events[id], old.data);
+            e.timestamps = slice_vector(old.timestamps, first, n, parameter_handler);
+            e.nb_occurrences = n;
+            slice_attributes(e, old, first, n);
+        }
+
+        auto* new_sequences = new Sequence[std::max<uint32_t>(nb_sequences, 1)];
+        for (uint32_t id = 0; id < thread->sequence_id_map.size(); id++) {
+            if (sequences[id] == PALLAS_INDEX_INVALID)
+                continue;
+            Token t = PALLAS_SEQUENCE_ID(id);
+            Sequence& old = *thread->getSequence(t);
+            Sequence& s = new_sequences[sequences[id]];
+            size_t first = kept_first.get_value(t);
+            size_t n = kept_count.get_value(t);
+            s.id = PALLAS_SEQUENCE_ID(sequences[id]);
+            s.type = old.type;
+            s.tokens = renamed_tokens(old.tokens);
+            s.durations = slice_vector(old.durations, first, n, parameter_handler);
+            s.exclusive_durations = slice_vector(old.exclusive_durations, first, n, parameter_handler);
+            s.timestamps = slice_vector(old.timestamps, first, n, parameter_handler);
+        }
+        for (size_t i = 0; i < clipped.size(); i++) {
+            uint32_t new_id = sequences[thread->sequence_id_map.size() + i];
+            Sequence& s = new_sequences[new_id];
+            s.id = PALLAS_SEQUENCE_ID(new_id);
+            s.type = clipped[i].type;
+            s.tokens = renamed_tokens(clipped[i].tokens);
+            s.durations = single_value<LinkedDurationVector>(clipped[i].duration, parameter_handler);
+            s.exclusive_durations = single_value<LinkedDurationVector>(clipped[i].exclusive_duration, parameter_handler);
+            s.timestamps = single_value<LinkedVector>(clipped[i].timestamp, parameter_handler);
+        }
+        for (uint32_t i = 0; i < nb_sequences; i++) {
+            Sequence& s = new_sequences[i];
+            s.hash = hash32_Token(s.tokens.data(), s.tokens.size(), SEED);
+        }
+
+        auto* new_loop_array = new Loop[std::max<uint32_t>(nb_loops, 1)];
+        for (uint32_t id = 0; id < thread->loop_id_map.size(); id++) {
+            if (loops[id] == PALLAS_INDEX_INVALID)
+                continue;
+            Token t = PALLAS_LOOP_ID(id);
+            const Loop& old = *thread->getLoop(t);
+            Loop& l = new_loop_array[loops[id]];
+            l.repeated_token = renamed(old.repeated_token);
+            l.self_id = PALLAS_LOOP_ID(loops[id]);
+            l.nb_iterations = old.nb_iterations;
+            l.nb_occurrences = kept_count.get_value(t);
+        }
+        for (size_t i = 0; i < new_loops.size(); i++) {
+            uint32_t new_id = loops[thread->loop_id_map.size() + i];
+            Loop& l = new_loop_array[new_id];
+            l.repeated_token = renamed(new_loops[i].first);
+            l.self_id = PALLAS_LOOP_ID(new_id);
+            l.nb_iterations = new_loops[i].second;
+            l.nb_occurrences = 1;
+        }
+
+        for (size_t i = 0; i < thread->nb_events; i++) {
+            thread->events[i].cleanEvent();
+        }
+        delete[] thread->events;
+        delete[] thread->sequences;
+        delete[] thread->loops;
+
+        thread->events = new_events;
+        thread->nb_events = thread->nb_allocated_events = nb_events;
+        thread->sequences = new_sequences;
+        thread->nb_sequences = thread->nb_allocated_sequences = nb_sequences;
+        thread->loops = new_loop_array;
+        thread->nb_loops = thread->nb_allocated_loops = nb_loops;
+        auto identity = [](std::vector<uint32_t>& map, uint32_t n) {
+            map.resize(n);
+            for (uint32_t i = 0; i < n; i++)
+                map[i] = i;
+        };
+        identity(thread->event_id_map, nb_events);
+        identity(thread->sequence_id_map, nb_sequences);
+        identity(thread->loop_id_map, nb_loops);
+        thread->sequence_root = renamed(root).id;
+        thread->first_timestamp = first_timestamp;
+        thread->hashToSequence.clear();
+        thread->hashToEvent.clear();
+        thread->sequence_labels.clear();
+        thread->sequence_label_ids.clear();
+    }
+};
+
+/** Parses a comma-separated list of ids. */
+static std::unordered_set<uint32_t> parse_id_list(const char* list) {
+    std::unordered_set<uint32_t> ids;
+    std::stringstream stream(list);
+    std::string id;
+    while (std::getline(stream, id, ',')) {
+        if (!id.empty())
+            ids.insert(std::stoul(id));
+    }
+    return ids;
+}
+
+void usage() {
+    std::cout << "Usage: pallas_slice [OPTION] trace_file" << std::endl;
+    std::cout << "\t-s, --start ts: Beginning of the window (default: the beginning of the trace)." << std::endl;
+    std::cout << "\t-e, --end ts: End of the window (default: the end of the trace)." << std::endl;
+    std::cout << "\t-r, --ranks list: Comma-separated ids of the LocationGroups to keep (default: all of them)." << std::endl;
+    std::cout << "\t-t, --threads list: Comma-separated ids of the Threads to keep (default: all of them)." << std::endl;
+    std::cout << "\t-o, --output dir: Directory of the slice (default: the one of the trace, suffixed with _slice)." << std::endl;
+    std::cout << "\t-j, --jobs n: Number of threads processed concurrently (default: one per hardware thread)." << std::endl;
+}
+
+int main(int argc, char** argv) {
+    pallas_timestamp_t window_start = 0;
+    pallas_timestamp_t window_end = std::numeric_limits<pallas_timestamp_t>::max();
+    std::unordered_set<uint32_t> ranks;
+    std::unordered_set<uint32_t> thread_ids;
+    std::string output_dir;
+    size_t nb_workers = 0;
+    const char* trace_name = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "-?")) {
+            usage();
+            return EXIT_SUCCESS;
+        } else if ((!strcmp(argv[i], "-s") || !strcmp(argv[i], "--start")) && i + 1 < argc) {
+            window_start = std::stoull(argv[++i]);
+        } else if ((!strcmp(argv[i], "-e") || !strcmp(argv[i], "--end")) && i + 1 < argc) {
+            window_end = std::stoull(argv[++i]);
+        } else if ((!strcmp(argv[i], "-r") || !strcmp(argv[i], "--ranks")) && i + 1 < argc) {
+            ranks = parse_id_list(argv[++i]);
+        } else if ((!strcmp(argv[i], "-t") || !strcmp(argv[i], "--threads")) && i + 1 < argc) {
+            thread_ids = parse_id_list(argv[++i]);
+        } else if ((!strcmp(argv[i], "-o") || !strcmp(argv[i], "--output")) && i + 1 < argc) {
+            output_dir = argv[++i];
+        } else if ((!strcmp(argv[i], "-j") || !strcmp(argv[i], "--jobs")) && i + 1 < argc) {
+            nb_workers = std::stoul(argv[++i]);
+        } else {
+            trace_name = argv[i];
+        }
+    }
+    if (trace_name == nullptr) {
+        std::cout << "ERROR: Missing trace file" << std::endl;
+        usage();
+        return EXIT_FAILURE;
+    }
+    if (window_end < window_start) {
+        std::cout << "ERROR: The window ends before it starts" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto* trace = pallas_open_trace(trace_name);
+    if (trace == nullptr) {
+        return EXIT_FAILURE;
+    }
+    if (output_dir.empty()) {
+        output_dir = std::string(trace->dir_name) + "_slice";
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Select the Archives and Threads to keep.
+    std::vector<Archive*> archives;
+    std::vector<Thread*> threads;
+    for (auto& lg : trace->location_groups) {
+        if (!ranks.empty() && !ranks.count(lg.id))
+            continue;
+        auto* a = trace->getArchive(lg.id, false);
+        if (a == nullptr)
+            continue;
+        archives.push_back(a);
+        for (auto& loc : a->locations) {
+            if (thread_ids.empty() || thread_ids.count(loc.id))
+                threads.push_back(a->getThread(loc.id));
+        }
+    }
+
+    std::vector<char> kept(threads.size(), false);
+    parallelFor(threads.size(), nb_workers, [&](size_t i) {
+        if (threads[i] == nullptr)
+            return;
+        threads[i]->loadAll();
+        ThreadSlicer slicer(threads[i], window_start, window_end, *trace->parameter_handler);
+        kept[i] = slicer.slice();
+    });
+
+    // Only reference the Threads that made it into the slice.
+    std::unordered_set<ThreadId> kept_ids;
+    std::vector<Thread*> output_threads;
+    for (size_t i = 0; i < threads.size(); i++) {
+        if (kept[i]) {
+            kept_ids.insert(threads[i]->id);
+            output_threads.push_back(threads[i]);
+        }
+    }
+    std::vector<Archive*> output_archives;
+    std::unordered_set<LocationGroupId> kept_groups;
+    for (auto* a : archives) {
+        std::vector<Location> locations;
+        for (auto& loc : a->locations) {
+            if (kept_ids.count(loc.id))
+                locations.push_back(loc);
+        }
+        if (locations.empty())
+            continue;
+        a->locations = std::move(locations);
+        a->nb_threads = a->locations.size();
+        output_archives.push_back(a);
+        kept_groups.insert(a->id);
+    }
+    std::vector<LocationGroup> location_groups;
+    for (auto& lg : trace->location_groups) {
+        if (kept_groups.count(lg.id))
+            location_groups.push_back(lg);
+    }
+    trace->location_groups = std::move(location_groups);
+    std::vector<Location> locations;
+    for (auto& loc : trace->locations) {
+        if (kept_ids.count(loc.id))
+            locations.push_back(loc);
+    }
+    trace->locations = std::move(locations);
+
+    parallelFor(output_threads.size(), nb_workers, [&](size_t i) {
+        output_threads[i]->store(output_dir.c_str(), trace->parameter_handler, true);
+    });
+    for (auto* a : output_archives) {
+        a->store(output_dir.c_str(), trace->parameter_handler);
+    }
+    trace->store(output_dir.c_str(), trace->parameter_handler);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Sliced " << trace_name << " into " << output_dir << " in " << elapsed.count() << "s: "
+              << output_archives.size() << " archives, " << output_threads.size() << " threads" << std::endl;
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
@@ -231,6 +231,10 @@ struct OTF2_Reader_struct {
   struct OTF2_DefReader_struct *def_readers;
   PALLAS(ThreadReader) **thread_readers;
 
+  /* Set by OTF2_HINT_GLOBAL_READER (or PALLAS_OTF2_PREFETCH): decode the locations
+   * on background threads while the global event reader merges them. */
+  int prefetch;
+  struct GlobalEvtPrefetcher* prefetcher;
 };
 
 #endif /* !OTF2_H */
@@ -23,21 +23,34 @@ OTF2_ErrorCode OTF2_EvtWriter_SetLocationID(OTF2_EvtWriter* writer, OTF2_Locatio
 }
 
 OTF2_ErrorCode OTF2_EvtWriter_GetNumberOfEvents(OTF2_EvtWriter* writer, uint64_t* numberOfEvents) {
-  NOT_IMPLEMENTED;
+  *numberOfEvents = get_event_count(writer->thread_writer->thread);
+  return OTF2_SUCCESS;
 }
 
 OTF2_ErrorCode OTF2_EvtWriter_BufferFlush(OTF2_EvtWriter* writer,
                                           OTF2_AttributeList* attributeList,
                                           OTF2_TimeStamp time,
                                           OTF2_TimeStamp stopTime) {
-  NOT_IMPLEMENTED;
+  /* The events stay in the memory of the ThreadWriter until the thread is closed:
+   * only the flush is recorded. */
+  pallas_record_buffer_flush(writer->thread_writer, attributeList, time, stopTime);
+  return OTF2_SUCCESS;
 }
 
 OTF2_ErrorCode OTF2_EvtWriter_MeasurementOnOff(OTF2_EvtWriter* writer,
                                                OTF2_AttributeList* attributeList,
                                                OTF2_TimeStamp time,
                                                OTF2_MeasurementMode measurementMode) {
-  NOT_IMPLEMENTED;
+  switch (measurementMode) {
+  case OTF2_MEASUREMENT_ON:
+  case OTF2_MEASUREMENT_OFF:
+    /* While the measurement is off, the events of this location are dropped before being stored. */
+    pallas_record_measurement_on_off(writer->thread_writer, attributeList, time,
+				     measurementMode == OTF2_MEASUREMENT_ON);
+    return OTF2_SUCCESS;
+  default:
+    return OTF2_ERROR_INVALID_ARGUMENT;
+  }
 }
 
 OTF2_ErrorCode OTF2_EvtWriter_Enter(OTF2_EvtWriter* writer,
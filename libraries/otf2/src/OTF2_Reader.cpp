@@ -1,13 +1,22 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
 
 #include "pallas/pallas.h"
 #include "pallas/utils/pallas_log.h"
+#include "pallas/utils/pallas_parallel.h"
 #include "pallas/utils/pallas_storage.h"
 #include "pallas/pallas_record.h"
 #include "otf2/OTF2_Reader.h"
 #include "otf2/otf2.h"
 
+static void _stop_prefetcher(OTF2_Reader* reader);
+
 static void init_OTF2_GlobalDefReader(OTF2_Reader* reader, OTF2_GlobalDefReader* global_def_reader) {
   memset(global_def_reader, 0, sizeof(OTF2_GlobalDefReader));
   global_def_reader->archive = reader->archive;
@@ -24,22 +33,22 @@ OTF2_Reader* OTF2_Reader_Open(const char* anchorFilePath) {
   memset(reader, 0, sizeof(OTF2_Reader));
 
   pallas::GlobalArchive* archive = pallas_open_trace(anchorFilePath);
+  if (archive == nullptr) {
+    free(reader);
+    return NULL;
+  }
   reader->archive = reinterpret_cast<struct GlobalArchive*>(archive);
 
-  for (int i = 0; i < archive->nb_archives; i++) {
-    reader->nb_locations += archive->archive_list[i]->nb_threads;
-    int nb_threads = archive->archive_list[i]->nb_threads;
-    for(int j = 0; j<nb_threads; j++) {
-      pallas::Thread* t = archive->archive_list[i]->threads[i];
-    }
-  }
+  // The archives are not loaded by pallas_open_trace, so their locations are listed through the location groups.
+  auto location_list = archive->getLocationList();
+  reader->nb_locations = location_list.size();
   reader->locations = new PALLAS(ThreadId)[reader->nb_locations];
   reader->evt_readers = (struct OTF2_EvtReader_struct*) calloc(reader->nb_locations, sizeof(struct OTF2_EvtReader_struct));
   reader->def_readers = (struct OTF2_DefReader_struct*) calloc(reader->nb_locations, sizeof(struct OTF2_DefReader_struct));
   reader->thread_readers = (pallas::ThreadReader**) calloc(reader->nb_locations, sizeof(pallas::ThreadReader*));
 
   for(int i = 0; i< reader->nb_locations; i++) {
-    // reader->locations[i] =   archive->locations[i].id;
+    reader->locations[i] = location_list[i].id;
     reader->evt_readers[i].location = OTF2_UNDEFINED_LOCATION;
     reader->def_readers[i].location = OTF2_UNDEFINED_LOCATION;
   }
@@ -51,16 +60,27 @@ OTF2_Reader* OTF2_Reader_Open(const char* anchorFilePath) {
   reader->global_evt_reader = (OTF2_GlobalEvtReader*)malloc(sizeof(OTF2_GlobalEvtReader));
   init_OTF2_GlobalEvtReader(reader, reader->global_evt_reader);
 
+  // PALLAS_OTF2_PREFETCH=n enables prefetching with n decoding threads (0: one per hardware thread).
+  reader->prefetch = getenv("PALLAS_OTF2_PREFETCH") != nullptr;
+
   return reader;
 }
 
 OTF2_ErrorCode OTF2_Reader_Close(OTF2_Reader* reader) {
+  _stop_prefetcher(reader);
   // TODO: free memory
   return OTF2_SUCCESS;
 }
 
 OTF2_ErrorCode OTF2_Reader_SetHint(OTF2_Reader* reader, OTF2_Hint hint, void* value) {
-  NOT_IMPLEMENTED;
+  switch (hint) {
+  case OTF2_HINT_GLOBAL_READER:
+    // Only the global event reader will be used: the locations can be decoded in advance.
+    reader->prefetch = *(OTF2_Boolean*)value == OTF2_TRUE;
+    return OTF2_SUCCESS;
+  default:
+    return OTF2_ERROR_INVALID_ARGUMENT;
+  }
 }
 
 OTF2_ErrorCode OTF2_Reader_SetCollectiveCallbacks(OTF2_Reader* reader,
@@ -178,17 +198,240 @@ pallas::ThreadReader* _get_next_global_event(OTF2_Reader* reader, OTF2_GlobalEvt
   return retval;
 }
 
+/* Prefetching global event reader.
+ *
+ * When the OTF2_HINT_GLOBAL_READER hint is set, the locations are decoded in advance by a pool of
+ * background threads: each worker owns a subset of the locations, and fills one bounded queue per
+ * location with chunks of decoded events. The global event reader then merges the queues with a
+ * heap keyed on (timestamp, location index). Ties are broken on the location index, like in
+ * _get_next_global_event, so the callbacks are called in the same order as without prefetching.
+ */
+
+/** Number of tokens decoded at once for a location. */
+#define PREFETCH_CHUNK_SIZE 256
+/** Maximum number of decoded chunks waiting in the queue of a location. */
+#define PREFETCH_MAX_CHUNKS 4
+
+/** A token decoded in advance. */
+struct PrefetchedToken {
+  /** Timestamp of the thread reader before reading the token, used to order the locations. */
+  pallas_timestamp_t timestamp;
+  /** Whether the token is an event. Other tokens are counted as read, but don't trigger any callback. */
+  bool is_event;
+  /** The decoded event. Its pointers point into the Thread, so they stay valid after decoding. */
+  pallas::EventOccurrence occurrence;
+};
+
+/** The tokens of a location decoded in advance. */
+struct PrefetchQueue {
+  pallas::ThreadReader* thread_reader;
+  /** Chunks decoded by the worker and not yet taken by the global reader. Protected by the lock. */
+  std::deque<std::vector<PrefetchedToken>> chunks;
+  /** Set by the worker when the whole location has been decoded. Protected by the lock. */
+  bool finished = false;
+  /** Chunk being merged by the global reader, and the position of its next token. */
+  std::vector<PrefetchedToken> current;
+  size_t current_pos = 0;
+};
+
+struct GlobalEvtPrefetcher {
+  std::vector<PrefetchQueue> queues;
+  std::mutex lock;
+  /** Signaled when a worker pushes a chunk or finishes a location. */
+  std::condition_variable chunk_ready;
+  /** Signaled when the global reader takes a chunk, or when the workers are stopped. */
+  std::condition_variable chunk_taken;
+  bool stop = false;
+  std::vector<std::thread> workers;
+
+  /** Next token of each location that has one, as (timestamp, location index). */
+  std::priority_queue<std::pair<pallas_timestamp_t, size_t>,
+                      std::vector<std::pair<pallas_timestamp_t, size_t>>,
+                      std::greater<>> heap;
+
+  /** Decodes the locations i such that i % nb_workers == worker_id. */
+  void work(size_t worker_id, size_t nb_workers) {
+    while (true) {
+      bool all_finished = true;
+      bool progress = false;
+      for (size_t i = worker_id; i < queues.size(); i += nb_workers) {
+        PrefetchQueue& queue = queues[i];
+        {
+          std::lock_guard<std::mutex> guard(lock);
+          if (stop)
+            return;
+          if (queue.finished)
+            continue;
+          all_finished = false;
+          if (queue.chunks.size() >= PREFETCH_MAX_CHUNKS)
+            continue;
+        }
+
+        // Decode a chunk outside of the lock: only this worker touches this thread reader.
+        pallas::ThreadReader* tr = queue.thread_reader;
+        std::vector<PrefetchedToken> chunk;
+        chunk.reserve(PREFETCH_CHUNK_SIZE);
+        while (chunk.size() < PREFETCH_CHUNK_SIZE && !tr->isEndOfTrace()) {
+          PrefetchedToken& t = chunk.emplace_back();
+          t.timestamp = tr->currentState.currentFrame->current_timestamp;
+          auto token = tr->pollCurToken();
+          t.is_event = token.type == pallas::TypeEvent;
+          if (t.is_event)
+            t.occurrence = tr->getEventOccurrence(token, tr->getCurrentTokenCount(token));
+          if (!tr->getNextToken(PALLAS_READ_FLAG_UNROLL_ALL).isValid()) {
+            pallas_assert(tr->isEndOfTrace());
+          }
+        }
+
+        {
+          std::lock_guard<std::mutex> guard(lock);
+          if (!chunk.empty())
+            queue.chunks.push_back(std::move(chunk));
+          queue.finished = tr->isEndOfTrace();
+        }
+        chunk_ready.notify_all();
+        progress = true;
+      }
+
+      if (all_finished)
+        return;
+      if (!progress) {
+        // All the queues of this worker are full: wait until the global reader takes a chunk.
+        std::unique_lock<std::mutex> guard(lock);
+        chunk_taken.wait(guard, [&] {
+          if (stop)
+            return true;
+          for (size_t i = worker_id; i < queues.size(); i += nb_workers) {
+            if (!queues[i].finished && queues[i].chunks.size() < PREFETCH_MAX_CHUNKS)
+              return true;
+          }
+          return false;
+        });
+      }
+    }
+  }
+
+  /** Returns the next token of location i, waiting for it to be decoded. Nullptr at the end of the location. */
+  const PrefetchedToken* peek(size_t i) {
+    PrefetchQueue& queue = queues[i];
+    if (queue.current_pos < queue.current.size())
+      return &queue.current[queue.current_pos];
+
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      chunk_ready.wait(guard, [&] { return !queue.chunks.empty() || queue.finished; });
+      if (queue.chunks.empty())
+        return nullptr;
+      queue.current = std::move(queue.chunks.front());
+      queue.chunks.pop_front();
+      queue.current_pos = 0;
+    }
+    chunk_taken.notify_all();
+    return &queue.current[0];
+  }
+
+  GlobalEvtPrefetcher(OTF2_Reader* reader, size_t nb_workers) {
+    for (int i = 0; i < reader->nb_locations; i++) {
+      pallas::ThreadReader* tr = reader->thread_readers[i];
+      if (tr && !tr->isEndOfTrace())
+        queues.emplace_back().thread_reader = tr;
+    }
+    nb_workers = pallas::getNbWorkers(nb_workers, queues.size());
+    for (size_t w = 0; w < nb_workers; w++) {
+      workers.emplace_back([this, w, nb_workers] { work(w, nb_workers); });
+    }
+    for (size_t i = 0; i < queues.size(); i++) {
+      if (const PrefetchedToken* t = peek(i))
+        heap.emplace(t->timestamp, i);
+    }
+  }
+
+  /** Pops the next token in the global order. Returns false if all the locations have been read. */
+  bool next(PrefetchedToken& token, pallas::ThreadReader*& thread_reader) {
+    if (heap.empty())
+      return false;
+    size_t i = heap.top().second;
+    heap.pop();
+    PrefetchQueue& queue = queues[i];
+    token = queue.current[queue.current_pos++];
+    thread_reader = queue.thread_reader;
+    if (const PrefetchedToken* t = peek(i))
+      heap.emplace(t->timestamp, i);
+    return true;
+  }
+
+  ~GlobalEvtPrefetcher() {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      stop = true;
+    }
+    chunk_taken.notify_all();
+    for (auto& worker : workers)
+      worker.join();
+  }
+};
+
+/* Start the prefetching workers on the thread readers that are opened so far. */
+static GlobalEvtPrefetcher* _get_prefetcher(OTF2_Reader* reader) {
+  if (reader->prefetch && !reader->prefetcher) {
+    size_t nb_workers = 0;
+    if (const char* env = getenv("PALLAS_OTF2_PREFETCH"))
+      nb_workers = strtoul(env, nullptr, 10);
+    reader->prefetcher = new GlobalEvtPrefetcher(reader, nb_workers);
+  }
+  return reader->prefetcher;
+}
+
+static void _stop_prefetcher(OTF2_Reader* reader) {
+  delete reader->prefetcher;
+  reader->prefetcher = nullptr;
+}
+
 OTF2_ErrorCode OTF2_Reader_ReadGlobalEvent(OTF2_Reader *reader, OTF2_GlobalEvtReader *evtReader) {
-    pallas::ThreadReader *thread_reader = _get_next_global_event(reader, evtReader);
+    GlobalEvtPrefetcher* prefetcher = _get_prefetcher(reader);
+    pallas::ThreadReader *thread_reader;
+    PrefetchedToken next;
+    if (prefetcher) {
+        // The token was decoded in advance by a prefetching worker.
+        if (!prefetcher->next(next, thread_reader))
+            return OTF2_ERROR_INDEX_OUT_OF_BOUNDS;
+    } else {
+        thread_reader = _get_next_global_event(reader, evtReader);
+        auto token = thread_reader->pollCurToken();
+        next.is_event = token.type == pallas::TypeEvent;
+        if (next.is_event)
+            next.occurrence = thread_reader->getEventOccurrence(token, thread_reader->getCurrentTokenCount(token));
+    }
 
-    auto token = thread_reader->pollCurToken();
-    if (token.type == pallas::TypeEvent) {
-        const pallas::EventOccurrence e = thread_reader->getEventOccurrence(token, thread_reader->getCurrentTokenCount(token));
+    if (next.is_event) {
+        const pallas::EventOccurrence& e = next.occurrence;
 
         pallas::Record event_type = e.event->record;
         pallas::AttributeList * attribute_list;
         pallas_timestamp_t time = e.timestamp;
         switch (event_type) {
+            case pallas::PALLAS_EVENT_MEASUREMENT_ON_OFF:
+                if (evtReader->callbacks.OTF2_GlobalEvtReaderCallback_MeasurementOnOff_callback) {
+                    uint8_t measurement_on;
+                    pallas_read_measurement_on_off(e.event, &attribute_list, &measurement_on);
+                    evtReader->callbacks.OTF2_GlobalEvtReaderCallback_MeasurementOnOff_callback(thread_reader->thread_trace->id,
+                        time,
+                        evtReader->user_data,
+                        (OTF2_AttributeList*) attribute_list,
+                        measurement_on ? OTF2_MEASUREMENT_ON : OTF2_MEASUREMENT_OFF);
+                }
+                break;
+            case pallas::PALLAS_EVENT_BUFFER_FLUSH:
+                if (evtReader->callbacks.OTF2_GlobalEvtReaderCallback_BufferFlush_callback) {
+                    pallas_timestamp_t stop_time;
+                    pallas_read_buffer_flush(e.event, &attribute_list, &stop_time);
+                    evtReader->callbacks.OTF2_GlobalEvtReaderCallback_BufferFlush_callback(thread_reader->thread_trace->id,
+                        time,
+                        evtReader->user_data,
+                        (OTF2_AttributeList*) attribute_list,
+                        stop_time);
+                }
+                break;
             case pallas::PALLAS_EVENT_ENTER:
                 if (evtReader->callbacks.OTF2_GlobalEvtReaderCallback_Enter_callback) {
                     pallas::RegionRef region_ref;
@@ -809,7 +1052,7 @@ OTF2_ErrorCode OTF2_Reader_ReadGlobalEvent(OTF2_Reader *reader, OTF2_GlobalEvtRe
         }
     } // todo: else ?
 
-    if (!thread_reader->getNextToken(PALLAS_READ_FLAG_UNROLL_ALL).isValid()) {
+    if (!prefetcher && !thread_reader->getNextToken(PALLAS_READ_FLAG_UNROLL_ALL).isValid()) {
         pallas_assert(thread_reader->isEndOfTrace());
     }
 
@@ -817,6 +1060,10 @@ OTF2_ErrorCode OTF2_Reader_ReadGlobalEvent(OTF2_Reader *reader, OTF2_GlobalEvtRe
 }
 
 OTF2_ErrorCode OTF2_Reader_HasGlobalEvent(OTF2_Reader* reader, OTF2_GlobalEvtReader* evtReader, int* flag) {
+  if (GlobalEvtPrefetcher* prefetcher = _get_prefetcher(reader)) {
+    *flag = !prefetcher->heap.empty();
+    return OTF2_SUCCESS;
+  }
   pallas::ThreadReader*thread_reader = _get_next_global_event(reader, evtReader);
   *flag = (thread_reader!=nullptr);
 
@@ -968,7 +1215,7 @@ OTF2_ErrorCode OTF2_Reader_ReadGlobalDefinitions(OTF2_Reader* reader,
   }
 
   if(defReader->callbacks.OTF2_GlobalDefReaderCallback_Location_callback) {
-    /*for ( const auto &loc : archive->locations ) {
+    for ( const auto &loc : archive->getLocationList() ) {
       CHECK_OTF2_CALLBACK_SUCCESS(defReader->callbacks.OTF2_GlobalDefReaderCallback_Location_callback
 				  (defReader->user_data,
 				   loc.id, // self
@@ -978,7 +1225,6 @@ OTF2_ErrorCode OTF2_Reader_ReadGlobalDefinitions(OTF2_Reader* reader,
 				   loc.parent // locationGroup
 				   ));
     }
-    */
   }
 
   // todo: handle the other definitions
@@ -1039,8 +1285,8 @@ OTF2_EvtReader* OTF2_Reader_GetEvtReader(OTF2_Reader* reader, OTF2_LocationRef l
 
       if(! reader->thread_readers[i]) {
 	PALLAS(GlobalArchive)* global_archive = (PALLAS(GlobalArchive)*)reader->archive;
-	PALLAS(Archive)* thread_archive = global_archive->getArchiveFromLocation(location);
-	reader->thread_readers[i] = new	pallas::ThreadReader(thread_archive, location, 0);
+	PALLAS(Archive)* thread_archive = global_archive->getArchive(global_archive->getLocation(location)->parent);
+	reader->thread_readers[i] = new	pallas::ThreadReader(thread_archive, location, PALLAS_READ_FLAG_UNROLL_ALL);
       }
 
       if(reader->evt_readers[i].location == OTF2_UNDEFINED_LOCATION) {
@@ -1067,8 +1313,8 @@ OTF2_DefReader* OTF2_Reader_GetDefReader(OTF2_Reader* reader, OTF2_LocationRef l
 
       if(! reader->thread_readers[i]) {
 	PALLAS(GlobalArchive)* global_archive = (PALLAS(GlobalArchive)*)reader->archive;
-	PALLAS(Archive)* thread_archive = global_archive->getArchiveFromLocation(location);
-	reader->thread_readers[i] = new	pallas::ThreadReader(thread_archive, location, 0);
+	PALLAS(Archive)* thread_archive = global_archive->getArchive(global_archive->getLocation(location)->parent);
+	reader->thread_readers[i] = new	pallas::ThreadReader(thread_archive, location, PALLAS_READ_FLAG_UNROLL_ALL);
       }
 
       if(reader->def_readers[i].location == OTF2_UNDEFINED_LOCATION) {
@@ -1114,6 +1360,7 @@ OTF2_ErrorCode OTF2_Reader_CloseEvtReader(OTF2_Reader* reader, OTF2_EvtReader* e
 }
 
 OTF2_ErrorCode OTF2_Reader_CloseGlobalEvtReader(OTF2_Reader* reader, OTF2_GlobalEvtReader* globalEvtReader) {
+  _stop_prefetcher(reader);
   return OTF2_SUCCESS;
 }
 
@@ -20,12 +20,16 @@
 #include "utils/pallas_dbg.h"
 #include "utils/pallas_log.h"
 #include "utils/pallas_linked_vector.h"
+#include "utils/pallas_memory.h"
+#include "utils/pallas_statistics.h"
 #include "utils/pallas_timestamp.h"
 
 #ifdef __cplusplus
 #include <cstdint>
 #include <cstring>
 #include <map>
+#include <string>
+#include <vector>
 #include <ankerl/unordered_dense.h>
 
 #else
@@ -312,6 +316,12 @@ public:
      */
     [[nodiscard]] std::string guessName(const pallas::Thread* thread) const;
 
+    /**
+     * Summarizes the durations of the occurrences of this Sequence that start in [start, end[.
+     * @param approximate Whether only the SubArrays at the edges of the range are read, see LinkedDurationVector::summarize.
+     */
+    [[nodiscard]] DurationSummary summarizeDurations(pallas_timestamp_t start, pallas_timestamp_t end, bool approximate = true) const;
+
     ~Sequence();
     Sequence(Sequence&&) = default;
     Sequence& operator=(Sequence&& other);
@@ -363,19 +373,30 @@ typedef struct Event {
     /** The Event being summarized.*/
     EventData data;
     /** Timestamps for each occurrence of that Event.*/
-    LinkedVector* timestamps;
+    LinkedVector* timestamps CXX({nullptr});
     /** Number of times that Event has happened. */
-    size_t nb_occurrences;
+    size_t nb_occurrences CXX({0});
     /** Storage for Attribute.*/
-    byte* attribute_buffer;
+    byte* attribute_buffer CXX({nullptr});
     /** Size of #attribute_buffer.*/
-    size_t attribute_buffer_size;
+    size_t attribute_buffer_size CXX({0});
     /** Position of #attribute_buffer.*/
-    size_t attribute_pos;
+    size_t attribute_pos CXX({0});
+    /** Offset in #attribute_buffer of the AttributeList of each occurrence, or PALLAS_ATTRIBUTE_NO_OFFSET.
+     * Built when the Event is loaded, or on the first lookup. */
+    size_t* attribute_offsets CXX({nullptr});
+    /** Size of #attribute_offsets. */
+    size_t nb_attribute_offsets CXX({0});
 #ifdef __cplusplus
   Event(TokenId, const EventData&);
   Event() = default;
   void cleanEvent();
+  /** Returns the AttributeList of the given occurrence, or nullptr if it has none. */
+  struct AttributeList* getAttributeList(size_t occurrence_index);
+  /** Builds #attribute_offsets from the AttributeLists stored in #attribute_buffer. */
+  void indexAttributes();
+  /** Frees #attribute_offsets. Must be called when #attribute_buffer is modified. */
+  void clearAttributeIndex();
 #endif
 } Event;
 
@@ -652,11 +673,42 @@ typedef struct Thread {
     size_t nb_loops;
     /** Logical to physical indirection map for Loops */
     DEFINE_Vector(uint32_t, loop_id_map);
+#ifdef __cplusplus
+    /** Interned labels of the pallas::Sequence of this Thread. Built lazily, see Thread::buildSequenceLabels. */
+    mutable std::vector<std::string> sequence_labels;
+    /** Index in #sequence_labels of the label of each pallas::Sequence. Indexed like #sequences. */
+    mutable std::vector<uint32_t> sequence_label_ids;
+#else
+    byte sequence_labels[VECTOR_SIZE];
+    byte sequence_label_ids[VECTOR_SIZE];
+#endif
+    /** Protects the lazy construction of #sequence_labels and #sequence_label_ids. */
+    pthread_mutex_t label_lock;
+#ifdef __cplusplus
+    /** Statistics of the durations of each pallas::Sequence. Built lazily, see Thread::buildStatistics. Indexed like #sequences. */
+    mutable std::vector<DurationStatistics> sequence_statistics;
+    /** Statistics of the time between two occurrences of each pallas::Event. Indexed like #events. */
+    mutable std::vector<DurationStatistics> event_statistics;
+#else
+    byte sequence_statistics[VECTOR_SIZE];
+    byte event_statistics[VECTOR_SIZE];
+#endif
+    /** Protects the construction of #sequence_statistics and #event_statistics. */
+    pthread_mutex_t statistics_lock;
+    /** Where the pallas::Event and pallas::Sequence that were not read yet are in the file of this Thread.
+     * Only set when it was read with ParameterHandler::lazyLoading, see Thread::loadEvent. */
+    struct ThreadIndex* lazy_index;
 #ifdef __cplusplus
     /** Loads all the timestamps for all the Events and Sequences. */
     void loadTimestamps();
     /** Resets the offsets of all the timestamp / duration vectors.*/
     void resetVectorsOffsets();
+    /** Reads the Event at the given index of #events from the trace, unless it was already read. */
+    void loadEvent(size_t index) const;
+    /** Reads the Sequence at the given index of #sequences from the trace, unless it was already read. */
+    void loadSequence(size_t index) const;
+    /** Reads all the Events and Sequences that were not read yet, for the code that walks #events or #sequences. */
+    void loadAll() const;
 
     /** Returns the Event corresponding to the given Token. */
     [[nodiscard]] Event* getEvent(Token) const;
@@ -751,6 +803,37 @@ typedef struct Thread {
     void printEventAttribute(const struct EventOccurrence *es) const;
     /** Returns the name of the thread. */
     [[nodiscard]] const char *getName() const;
+    /**
+     * Builds the label table of the Sequences, unless it was already built or cached on disk.
+     * Sequences that have the same name share the same label id.
+     */
+    void buildSequenceLabels() const;
+    /** Returns the label id of the given Sequence. */
+    [[nodiscard]] uint32_t getSequenceLabelId(Token sequence) const;
+    /** Returns the label corresponding to the given label id. */
+    [[nodiscard]] const std::string& getLabel(uint32_t label_id) const;
+    /** Returns the number of distinct labels in this Thread. */
+    [[nodiscard]] size_t getLabelCount() const;
+    /**
+     * Builds the statistics of the Sequences and Events, unless they were already built or stored with the Thread.
+     * Otherwise they come from their vectors, see updateStatistics.
+     */
+    void buildStatistics() const;
+    /**
+     * Sets the statistics of the Sequences and Events from the ones of their vectors, which are updated as each of
+     * their SubArrays is completed. The vectors read from a file first take the statistics stored with the Thread:
+     * their values are only read, without being kept loaded, when there are none.
+     * Called when the Thread is stored, and before it is modified by pallas_sync and pallas_merge.
+     */
+    void updateStatistics() const;
+    /** Computes the statistics of the Sequences and Events from all their durations and timestamps. */
+    void computeStatistics() const;
+    /** Returns the statistics of the durations of the given Sequence. */
+    [[nodiscard]] const DurationStatistics& getSequenceStatistics(Token sequence) const;
+    /** Returns the statistics of the time between two occurrences of the given Event. */
+    [[nodiscard]] const DurationStatistics& getEventStatistics(Token event) const;
+    /** Returns the memory held by this Thread, by category. Only the loaded parts of its vectors are counted. */
+    [[nodiscard]] MemoryUsage getMemoryUsage() const;
     /**
      * Stores this thread.
      * @param path Path to the root folder of the trace.
@@ -761,14 +844,23 @@ typedef struct Thread {
 
     /**
      * Returns a snapshot of the thread's total time spent in each Block Sequence during that time frame.
+     * When approximate is set, the occurrences that are entirely in the time frame only contribute the summaries of
+     * their SubArrays, unless they are already loaded: only the SubArrays at the edges of the time frame are read.
      */
   //    [[nodiscard]] std::map<Token, pallas_duration_t> getSnapshotView(pallas_timestamp_t start, pallas_timestamp_t end) const;
-  [[nodiscard]] std::map<std::tuple<Token,std::string>, pallas_duration_t> getSnapshotView(pallas_timestamp_t start, pallas_timestamp_t end) const;
+  [[nodiscard]] std::map<std::tuple<Token,std::string>, pallas_duration_t> getSnapshotView(pallas_timestamp_t start, pallas_timestamp_t end, bool approximate = true) const;
 
     /**
      * Returns a snapshot of the thread's total time spent in each Block Sequence during that time frame, grouped by name.
      */
-    [[nodiscard]] std::map<std::string, pallas_duration_t> getSnapshotViewByName(pallas_timestamp_t start, pallas_timestamp_t end) const;
+    [[nodiscard]] std::map<std::string, pallas_duration_t> getSnapshotViewByName(pallas_timestamp_t start, pallas_timestamp_t end, bool approximate = true) const;
+
+    /**
+     * Returns a snapshot of the thread's total time spent in each Block Sequence during that time frame, grouped by label.
+     * The returned vector is indexed by label id (see Thread::getLabel).
+     * When in_view is given, it tells for each label whether a Sequence with that label was counted, even for 0 ticks.
+     */
+    [[nodiscard]] std::vector<pallas_duration_t> getSnapshotViewByLabel(pallas_timestamp_t start, pallas_timestamp_t end, bool approximate = true, std::vector<bool>* in_view = nullptr) const;
 
     // /*** Returns a snapshot of the thread's total time spent in each Block Sequence in *filter* during that time frame. */
     // std::map<Token, pallas_duration_t> getSnapshotViewFast(pallas_timestamp_t start, pallas_timestamp_t end,
@@ -899,8 +991,8 @@ template <typename T>
 void doubleMemorySpaceConstructor(T*& originalArray, size_t& counter) {
     T* newArray = new T[counter * 2];
     // Copy without destructing
-    std::memcpy(newArray, originalArray, counter * sizeof(T));
-    std::memset(originalArray, 0, counter * sizeof(T));
+    std::memcpy(static_cast<void*>(newArray), static_cast<const void*>(originalArray), counter * sizeof(T));
+    std::memset(static_cast<void*>(originalArray), 0, counter * sizeof(T));
     // Create the new objects by calling there constructors
     for (size_t i = counter; i < counter * 2; ++i) {
         new(&newArray[i]) T();
@@ -12,6 +12,7 @@
 
 #include "pallas.h"
 #include "pallas_config.h"
+#include "utils/pallas_definition_table.h"
 #include "utils/pallas_parameter_handler.h"
 
 #define GLOBAL_ARCHIVE_DEPRECATED_LOCATION CXX([[deprecated("You should record Locations on the Archives")]])
@@ -45,43 +46,46 @@ struct Location {
     LocationGroupId parent;
 };
 
+/** Size of a DefinitionTable: a deque, two vectors and a pointer. */
+#define DEFINITION_TABLE_SIZE (DEQUE_SIZE + 2 * VECTOR_SIZE + 8)
+
 /**
  * A Definition stores Strings, Regions and Attributes.
  */
 typedef struct Definition {
     /** List of String stored in that Definition. */
 #ifdef __cplusplus
-    std::map<StringRef, String> strings;
+    DefinitionTable<StringRef, String> strings;
 #else
-    byte strings[MAP_SIZE];
+    byte strings[DEFINITION_TABLE_SIZE];
 #endif
 
     /** List of Region stored in that Definition. */
 #ifdef __cplusplus
-    std::map<RegionRef, Region> regions;
+    DefinitionTable<RegionRef, Region> regions;
 #else
-    byte regions[MAP_SIZE];
+    byte regions[DEFINITION_TABLE_SIZE];
 #endif
 
     /** List of Attribute stored in that Definition. */
 #ifdef __cplusplus
-    std::map<AttributeRef, Attribute> attributes;
+    DefinitionTable<AttributeRef, Attribute> attributes;
 #else
-    byte attributes[MAP_SIZE];
+    byte attributes[DEFINITION_TABLE_SIZE];
 #endif
 
     /** List of Group stored in that Definition. */
 #ifdef __cplusplus
-    std::map<GroupRef, Group> groups;
+    DefinitionTable<GroupRef, Group> groups;
 #else
-    byte groups[MAP_SIZE];
+    byte groups[DEFINITION_TABLE_SIZE];
 #endif
 
     /** List of Comm stored in that Definition. */
 #ifdef __cplusplus
-    std::map<CommRef, Comm> comms;
+    DefinitionTable<CommRef, Comm> comms;
 #else
-    byte comms[MAP_SIZE];
+    byte comms[DEFINITION_TABLE_SIZE];
 #endif
 
 #ifdef __cplusplus
@@ -95,9 +99,15 @@ typedef struct Definition {
     void addGroup(GroupRef, StringRef, GroupType group_type, Paradigm paradigm, uint32_t, const uint64_t*);
     [[nodiscard]] const Comm* getComm(CommRef) const;
     void addComm(CommRef, StringRef, GroupRef, CommRef);
+    /** Returns an estimate of the number of bytes held by these definitions. */
+    [[nodiscard]] size_t getMemoryUsage() const;
 #endif
 } Definition;
 
+#ifdef __cplusplus
+static_assert(sizeof(DefinitionTable<uint32_t, size_t>) == DEFINITION_TABLE_SIZE, "The C definition of Definition is outdated");
+#endif
+
 #ifdef __cplusplus
 typedef std::map<std::string, std::string> Metadata;
 #else
@@ -262,6 +272,7 @@ typedef struct GlobalArchive {
      */
     [[nodiscard]] std::vector<Thread*> getThreadList();
 
+    /** Returns the Archive with the given id, loading it if need be. Can be called concurrently. */
     [[nodiscard]] Archive* getArchive(LocationGroupId archiveId, bool print_warning = true);
 
     void freeArchive(LocationGroupId archiveId);
@@ -272,6 +283,23 @@ typedef struct GlobalArchive {
     /** Returns the final timestamp of this trace. Loads the threads. */
     pallas_timestamp_t get_ending_timestamp();
 
+    /**
+     * Aggregates a list of the Threads of all the Archives, loading them on a pool of worker threads.
+     * @param nb_workers Number of worker threads. 0 means one per hardware thread.
+     */
+    [[nodiscard]] std::vector<Thread*> getThreadList(size_t nb_workers);
+
+    /**
+     * Returns a snapshot of the trace's total time spent in each Block Sequence during that time frame, grouped by name.
+     * Thread::getSnapshotViewByName is computed for every Thread on a pool of worker threads, and the results are summed.
+     * @param nb_workers Number of worker threads. 0 means one per hardware thread.
+     * @param approximate Whether the interior of the time frame is computed from the summaries of the SubArrays.
+     */
+    [[nodiscard]] std::map<std::string, pallas_duration_t> getSnapshotViewByName(pallas_timestamp_t start, pallas_timestamp_t end, size_t nb_workers = 0, bool approximate = true);
+
+    /** Returns the memory held by the definitions of this GlobalArchive, and by its loaded Archives and Threads. */
+    [[nodiscard]] MemoryUsage getMemoryUsage() const;
+
     ~GlobalArchive();
 #endif
 } GlobalArchive;
@@ -384,6 +412,7 @@ typedef struct Archive {
      */
     [[nodiscard]] const Location* getLocation(ThreadId) const;
 
+    /** Returns the Thread with the given id, loading it if need be. Can be called concurrently. */
     [[nodiscard]] Thread* getThread(ThreadId);
     [[nodiscard]] Thread* getThreadAt(size_t index);
     const char* getName();
@@ -391,6 +420,8 @@ typedef struct Archive {
     void freeThread(ThreadId);
     /* Frees the memory of the thread and sets its pointer to nullptr. */
     void freeThreadAt(size_t);
+    /** Returns the memory held by the definitions of this Archive, and by its loaded Threads. */
+    [[nodiscard]] MemoryUsage getMemoryUsage() const;
 
     /**
      * Store this Archive.
@@ -257,6 +257,8 @@ typedef struct AttributeData {
 } __attribute__((packed)) AttributeData;
 
 #define ATTRIBUTE_LIST_HEADER_SIZE (sizeof(int) + sizeof(uint16_t) + sizeof(uint8_t))
+/** Offset of the occurrences of an Event that have no AttributeList. */
+#define PALLAS_ATTRIBUTE_NO_OFFSET SIZE_MAX
 /** Array of attributes. */
 typedef struct AttributeList {
   int index;
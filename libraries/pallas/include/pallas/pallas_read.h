@@ -212,7 +212,7 @@ typedef struct ThreadReader {
     /** Returns the current timestamp. */
     [[nodiscard]] pallas_timestamp_t getCurrentTimestamp() const;
 
-    /** Returns a pointer to the AttributeList for the given occurrence of the given Event. */
+    /** Returns a pointer to the AttributeList for the given occurrence of the given Event, or nullptr if it has none. */
     [[nodiscard]] AttributeList *getEventAttributeList(Token event_id, size_t occurrence_id) const;
 
     /** Returns a map that assigns names to sequences */
@@ -261,6 +261,9 @@ typedef struct ThreadReader {
     /** Enter a block if the current token starts a block, returns a boolean representing if the rader actually entered a block */
     bool enterIfStartOfBlock(int flags = PALLAS_READ_FLAG_UNROLL_ALL);
 
+    /** Returns the memory held by this reader and by the Thread it reads, by category. */
+    [[nodiscard]] MemoryUsage getMemoryUsage() const;
+
     Cursor createCheckpoint() const;
 
     void loadCheckpoint(Cursor *checkpoint);
@@ -310,6 +313,65 @@ typedef struct MultiThreadReader {
     #endif
 } MultiThreadReader;
 
+/**
+ * Reads one thread of a trace while it is being recorded, from the snapshots that its ThreadWriter publishes
+ * in the `live` folder of the trace (see ThreadWriter::publish).
+ * Each refresh loads the last snapshot, and the reading resumes after the last Event that was returned.
+ * The definitions of the snapshot may be one publication behind its Events.
+ */
+typedef struct LiveThreadReader {
+    /** Path to the `main.pallas` file of the snapshots. */
+    char *trace_filename;
+    /** Id of the thread being read. */
+    ThreadId thread_id;
+    /** Id of the Archive of the thread, or PALLAS_LOCATION_GROUP_ID_INVALID if it wasn't found yet. */
+    LocationGroupId archive_id;
+    /** Last snapshot that was loaded, or nullptr. */
+    struct GlobalArchive *trace;
+    /** Reader of the thread in the last snapshot, or nullptr. */
+    ThreadReader *reader;
+    /** Number of Events returned by getNextEvent so far. */
+    size_t nb_events_read;
+    /** Inode of the thread file of the last snapshot, to detect the next one. */
+    uint64_t snapshot_inode;
+    /** Modification date of the thread file of the last snapshot, in nanoseconds. */
+    int64_t snapshot_mtime;
+#ifdef __cplusplus
+    /**
+     * Make a new LiveThreadReader. No snapshot is loaded until refresh is called.
+     * @param trace_filename Path to the `main.pallas` file of the trace being recorded.
+     * @param thread_id Id of the thread to read.
+     */
+    LiveThreadReader(const char *trace_filename, ThreadId thread_id);
+
+    /**
+     * Loads the last snapshot if it's newer than the current one, and moves to the first Event that wasn't returned.
+     * The EventOccurrences returned before stay valid until then.
+     * @return Whether new Events can be read.
+     */
+    bool refresh();
+
+    /**
+     * Gets the next Event of the current snapshot.
+     * @param event_occurrence Set to the next Event.
+     * @return false if all the Events of the current snapshot were read.
+     */
+    bool getNextEvent(EventOccurrence *event_occurrence);
+
+    ~LiveThreadReader();
+    LiveThreadReader(const LiveThreadReader &) = delete;
+    LiveThreadReader &operator=(const LiveThreadReader &) = delete;
+
+   private:
+    /** Returns the number of Events in the given Token of the current snapshot. */
+    [[nodiscard]] size_t getEventCount(Token token) const;
+    /** Skips the current Token of the reader, leaving the blocks that end with it. */
+    void skipToken();
+    /** Frees the current snapshot. */
+    void close();
+#endif
+} LiveThreadReader;
+
 /* C bindings */
 
 /**
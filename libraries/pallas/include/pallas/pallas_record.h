@@ -42,6 +42,13 @@ extern void pallas_read_thread_fork(const EventData* data,AttributeList** attrib
 extern void pallas_record_thread_join(ThreadWriter* thread_writer, AttributeList* attribute_list, pallas_timestamp_t time);
 extern void pallas_read_thread_join(const EventData* data,AttributeList** attribute_list);
 
+/** Records that the measurement was turned on or off. While it is off, the events given to thread_writer are dropped. */
+extern void pallas_record_measurement_on_off(ThreadWriter* thread_writer, AttributeList* attribute_list, pallas_timestamp_t time, uint8_t measurement_on);
+extern void pallas_read_measurement_on_off(const EventData* data,AttributeList** attribute_list, uint8_t* measurement_on);
+
+extern void pallas_record_buffer_flush(ThreadWriter* thread_writer, AttributeList* attribute_list, pallas_timestamp_t time, pallas_timestamp_t stop_time);
+extern void pallas_read_buffer_flush(const EventData* data,AttributeList** attribute_list, pallas_timestamp_t* stop_time);
+
 extern void pallas_record_thread_acquire_lock(ThreadWriter* thread_writer, AttributeList* attribute_list, pallas_timestamp_t time, uint32_t lockID, uint32_t acquisitionOrder);
 extern void pallas_read_thread_acquire_lock(const EventData* data,AttributeList** attribute_list, uint32_t* lockID, uint32_t* acquisitionOrder);
 
@@ -9,6 +9,7 @@
 #include "pallas.h"
 #include "pallas_archive.h"
 #include "pallas_attribute.h"
+#include "utils/pallas_writer_stats.h"
 #ifdef __cplusplus
 namespace pallas {
 #endif
@@ -36,9 +37,35 @@ typedef struct ThreadWriter {
     C_CXX(uint8_t firstTimestamp[TIMEPOINT_SIZE], Timepoint firstTimestamp = {});
     /** Parameter handler for the whole trace. */
     ParameterHandler* parameter_handler;
+    /** Whether the events are recorded. Switched by pallas_record_measurement_on_off. */
+    uint8_t measurement_on CXX({1});
+    /** Number of blocks started while the measurement was off, and not ended yet. Their events are dropped. */
+    int skipped_depth CXX({0});
 #ifdef __cplusplus
 
    private:
+#ifdef PALLAS_WRITER_STATS
+    /** Self-instrumentation counters of this writer. */
+    WriterStats stats{};
+#endif
+    /** What was copied of the Thread to the live snapshots. Created by the first snapshot. */
+    struct LiveState* live = nullptr;
+    /** Number of Events to store before checking whether a live publication is due. */
+    uint32_t live_countdown = 0;
+    /** Queues a snapshot of the Thread if the live period has passed since the last one. */
+    void publishIfDue();
+    /**
+     * Copies what was recorded since the last snapshot, and queues it to be published by the background publisher.
+     * @param last Whether it's the last snapshot of the Thread.
+     * @returns The ticket of the snapshot, to wait for its publication.
+     */
+    size_t queueSnapshot(bool last);
+    /** Data file the vectors of the Events spill their full SubArrays to, when the partialFlush parameter is set. */
+    const char* event_spill_path = nullptr;
+    /** Data file the vectors of the Sequences spill their full SubArrays to, when the partialFlush parameter is set. */
+    const char* sequence_spill_path = nullptr;
+    /** Creates the durations and timestamps vectors of a Sequence. */
+    void createSequenceVectors(Sequence& sequence) const;
     /**
      * Returns the inclusive and exclusive block duration / block duration for the offset-th last given Sequence.
      * The Sequence's token need to be in curIndexSeq for this to work out.
@@ -121,6 +148,17 @@ typedef struct ThreadWriter {
     void threadClose();
     /** Creates the new Event and stores it. Returns the occurrence index of that new Event. */
     size_t storeEvent(enum EventType event_type, TokenId event_id, pallas_timestamp_t ts, struct AttributeList* attribute_list);
+    /** Returns the self-instrumentation counters of this writer. They are all 0 if Pallas was built without ENABLE_WRITER_STATS. */
+    [[nodiscard]] WriterStats getStats() const;
+    /** Returns the memory held by this writer and by the Thread it records, by category. */
+    [[nodiscard]] MemoryUsage getMemoryUsage() const;
+    /**
+     * Publishes a snapshot of the Thread being recorded to the `live` folder of the trace, so that it can be read with
+     * a LiveThreadReader, and waits until it's written. Only what was recorded since the last snapshot is copied,
+     * and it's written by a background thread.
+     * This is done periodically, without waiting, when the livePeriod parameter is set, and when the thread is closed.
+     */
+    void publish();
     ~ThreadWriter();
 #endif
 } ThreadWriter;
@@ -141,6 +179,13 @@ extern void pallas_thread_writer_close(PALLAS(ThreadWriter) * thread_writer);
 extern void pallas_thread_writer_delete(PALLAS(ThreadWriter) * thread_writer);
 extern void pallas_archive_close(PALLAS(Archive) * archive);
 
+/** Returns the number of bytes held by thread_writer and by the Thread it records. */
+extern size_t pallas_thread_writer_get_memory_usage(PALLAS(ThreadWriter) * thread_writer);
+/** Copies the self-instrumentation counters of thread_writer to stats. */
+extern void pallas_thread_writer_get_stats(PALLAS(ThreadWriter) * thread_writer, PALLAS(WriterStats) * stats);
+/** Publishes a snapshot of the thread recorded by thread_writer, so that it can be read while it is written. */
+extern void pallas_thread_writer_publish(PALLAS(ThreadWriter) * thread_writer);
+
 extern void pallas_store_event(PALLAS(ThreadWriter) * thread_writer,
                                enum PALLAS(EventType) event_type,
                                PALLAS(TokenId) id,
@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+/** @file
+ * Table of definitions (Strings, Regions, Attributes, ...) indexed by their ref.
+ * The refs are usually small consecutive integers, so a lookup is an index in an array instead of a walk in a tree.
+ * The refs that are far from the others are kept in a hash map.
+ */
+#pragma once
+
+#ifdef __cplusplus
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <ankerl/unordered_dense.h>
+
+#include "pallas_dbg.h"
+#include "pallas_log.h"
+
+namespace pallas {
+
+/**
+ * Map from the refs of some definitions to the definitions, with the interface of the std::map it replaces.
+ * The definitions are stored in the order they were added, in a deque, so their addresses never change.
+ * The position of each one is found in #dense_index, indexed by ref, for the refs that are smaller than a few times
+ * the number of definitions, and in #sparse_index for the others.
+ * Like in a std::map, they are iterated over in the order of their refs, which #ordered keeps.
+ * Like a std::map, it must not be modified while another thread reads it.
+ */
+template <class Ref, class T>
+class DefinitionTable {
+   public:
+    /** A definition and its ref, like the elements of a std::map. */
+    using value_type = std::pair<const Ref, T>;
+
+    /** Iterator over the definitions, in the order of their refs. */
+    template <class Value>
+    class Iterator {
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Value;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value*;
+        using reference = Value&;
+
+        explicit Iterator(typename std::vector<DefinitionTable::value_type*>::const_iterator it) : it(it) {}
+        Value& operator*() const { return **it; }
+        Value* operator->() const { return *it; }
+        Iterator& operator++() {
+            ++it;
+            return *this;
+        }
+        bool operator==(const Iterator& other) const { return it == other.it; }
+        bool operator!=(const Iterator& other) const { return it != other.it; }
+
+       private:
+        typename std::vector<DefinitionTable::value_type*>::const_iterator it;
+    };
+    using iterator = Iterator<value_type>;
+    using const_iterator = Iterator<const value_type>;
+
+    DefinitionTable() = default;
+    DefinitionTable(const DefinitionTable& other) { *this = other; }
+    DefinitionTable(DefinitionTable&& other) noexcept = default;
+    DefinitionTable& operator=(DefinitionTable&& other) noexcept = default;
+    DefinitionTable& operator=(const DefinitionTable& other) {
+        if (this != &other) {
+            clear();
+            for (const auto& [ref, value] : other)
+                (*this)[ref] = value;
+        }
+        return *this;
+    }
+
+    /** Returns the definition of the given ref, or nullptr if there is none. */
+    [[nodiscard]] const T* get(Ref ref) const {
+        uint32_t position = positionOf(ref);
+        return position ? &entries[position - 1].second : nullptr;
+    }
+    /** Returns the definition of the given ref, or nullptr if there is none. */
+    [[nodiscard]] T* get(Ref ref) {
+        uint32_t position = positionOf(ref);
+        return position ? &entries[position - 1].second : nullptr;
+    }
+
+    /** Returns the definition of the given ref. It must exist. */
+    [[nodiscard]] const T& at(Ref ref) const {
+        const T* value = get(ref);
+        if (value == nullptr)
+            pallas_error("No definition for ref %lu\n", static_cast<unsigned long>(ref));
+        return *value;
+    }
+    /** Returns the definition of the given ref. It must exist. */
+    [[nodiscard]] T& at(Ref ref) {
+        return const_cast<T&>(static_cast<const DefinitionTable*>(this)->at(ref));
+    }
+
+    /** Returns the definition of the given ref, after adding a default-constructed one if there was none. */
+    T& operator[](Ref ref) {
+        uint32_t position = positionOf(ref);
+        if (position)
+            return entries[position - 1].second;
+        entries.emplace_back(std::piecewise_construct, std::forward_as_tuple(ref), std::forward_as_tuple());
+        setPosition(ref, entries.size());
+        // The refs are usually added in increasing order.
+        if (ordered.empty() || ordered.back()->first < ref) {
+            ordered.push_back(&entries.back());
+        } else {
+            auto it = std::lower_bound(ordered.begin(), ordered.end(), ref,
+                                       [](const value_type* entry, Ref r) { return entry->first < r; });
+            ordered.insert(it, &entries.back());
+        }
+        return entries.back().second;
+    }
+
+    /** Returns 1 if the given ref has a definition, 0 otherwise. */
+    [[nodiscard]] size_t count(Ref ref) const { return positionOf(ref) ? 1 : 0; }
+    /** Number of definitions. */
+    [[nodiscard]] size_t size() const { return entries.size(); }
+    [[nodiscard]] bool empty() const { return entries.empty(); }
+
+    /** Removes all the definitions. */
+    void clear() {
+        entries.clear();
+        ordered.clear();
+        dense_index.clear();
+        sparse_index.reset();
+    }
+
+    /** Iterates over the definitions, in the order of their refs. */
+    iterator begin() { return iterator(ordered.begin()); }
+    iterator end() { return iterator(ordered.end()); }
+    const_iterator begin() const { return const_iterator(ordered.begin()); }
+    const_iterator end() const { return const_iterator(ordered.end()); }
+
+    /** Returns an estimate of the number of bytes allocated by the table. */
+    [[nodiscard]] size_t memoryUsage() const {
+        size_t bytes = entries.size() * sizeof(value_type) + ordered.capacity() * sizeof(value_type*)
+                       + dense_index.capacity() * sizeof(uint32_t);
+        if (sparse_index)
+            bytes += sparse_index->size() * sizeof(std::pair<Ref, uint32_t>) + sparse_index->bucket_count() * 8;
+        return bytes;
+    }
+
+   private:
+    /** Refs smaller than this are always in #dense_index. */
+    static constexpr size_t min_dense_size = 1024;
+    /** Definitions, in the order they were added. */
+    std::deque<value_type> entries;
+    /** Definitions, in the order of their refs. */
+    std::vector<value_type*> ordered;
+    /** Position + 1 in #entries of the definition of each ref, 0 if there is none. */
+    std::vector<uint32_t> dense_index;
+    /** Position + 1 in #entries of the refs that are too large for #dense_index. Only allocated if there are some. */
+    std::unique_ptr<ankerl::unordered_dense::map<Ref, uint32_t>> sparse_index;
+
+    [[nodiscard]] uint32_t positionOf(Ref ref) const {
+        auto index = static_cast<size_t>(ref);
+        if (index < dense_index.size())
+            return dense_index[index];
+        if (sparse_index) {
+            auto it = sparse_index->find(ref);
+            if (it != sparse_index->end())
+                return it->second;
+        }
+        return 0;
+    }
+
+    void setPosition(Ref ref, size_t position) {
+        auto index = static_cast<size_t>(ref);
+        if (index >= dense_index.size() && index < std::max(min_dense_size, 4 * entries.size())) {
+            // Grows geometrically, and takes in the refs of the sparse index that now fit.
+            dense_index.resize(std::max({index + 1, 2 * dense_index.size(), min_dense_size}), 0);
+            if (sparse_index) {
+                for (auto it = sparse_index->begin(); it != sparse_index->end();) {
+                    if (static_cast<size_t>(it->first) < dense_index.size()) {
+                        dense_index[it->first] = it->second;
+                        it = sparse_index->erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+            }
+        }
+        if (index < dense_index.size()) {
+            dense_index[index] = static_cast<uint32_t>(position);
+            return;
+        }
+        if (!sparse_index)
+            sparse_index = std::make_unique<ankerl::unordered_dense::map<Ref, uint32_t>>();
+        (*sparse_index)[ref] = static_cast<uint32_t>(position);
+    }
+};
+
+}  // namespace pallas
+#endif
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
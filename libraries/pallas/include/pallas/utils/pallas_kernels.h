@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+/** @file
+ * Kernels over arrays of values, such as the values of a SubArray: statistics, histogram binning and lower bound,
+ * and the CRC32C checksums of the stored data.
+ * Each kernel has a scalar version, and AVX2 and AVX-512 versions on x86-64 that give exactly the same results.
+ * The version is selected at runtime, from the instruction sets supported by the CPU.
+ */
+#pragma once
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+
+namespace pallas {
+
+/** Instruction sets the kernels can be run with. */
+enum class KernelISA {
+    /** Plain C++. Always supported. */
+    Scalar,
+    /** AVX2. */
+    AVX2,
+    /** AVX-512 Foundation and Doubleword/Quadword instructions. */
+    AVX512,
+};
+
+/** Returns the name of an instruction set. */
+const char* toString(KernelISA isa);
+
+/** Returns whether the kernels can be run with the given instruction set, on this CPU and with this build. */
+bool isKernelISASupported(KernelISA isa);
+
+/** Returns the instruction set the kernels are run with. By default, the best one that is supported. */
+KernelISA getKernelISA();
+
+/**
+ * Makes the kernels run with the given instruction set, to compare them. It must be supported.
+ * This isn't thread-safe: no kernel may be running while it is called.
+ */
+void setKernelISA(KernelISA isa);
+
+/** Statistics of an array of values. */
+struct ValueStatistics {
+    /** Smallest value, UINT64_MAX if the array is empty. */
+    uint64_t min = UINT64_MAX;
+    /** Largest value, 0 if the array is empty. */
+    uint64_t max = 0;
+    /** Sum of the values, modulo 2^64. */
+    uint64_t sum = 0;
+};
+
+/** Returns the min, max and sum of the n given values. */
+ValueStatistics computeValueStatistics(const uint64_t* values, size_t n);
+
+/**
+ * Computes the histogram bin of each value: (values[i] - min) / step, rounded down and clamped to [0, 255].
+ * The difference is converted to a double before the division, as the Histogram compression does.
+ * @param values Values to bin. They should all be >= min.
+ * @param n Number of values.
+ * @param min Value of the lower bound of the first bin.
+ * @param step Width of a bin. Must be > 0.
+ * @param bins Array of n bins, where the result is written.
+ */
+void computeHistogramBins(const uint64_t* values, size_t n, uint64_t min, double step, uint8_t* bins);
+
+/**
+ * Returns the index of the first value that is >= value, or n if there is none, like std::lower_bound.
+ * @param values Sorted values.
+ * @param n Number of values.
+ * @param value Value to search for.
+ */
+size_t lowerBound(const uint64_t* values, size_t n, uint64_t value);
+
+/**
+ * Returns the CRC32C (Castagnoli) of size bytes. The AVX2 and AVX-512 versions use the SSE4.2 CRC32 instruction.
+ * @param data Bytes to checksum.
+ * @param size Number of bytes.
+ * @param crc CRC32C of the bytes that come before data, to checksum several buffers as one. 0 for the first one.
+ */
+uint32_t crc32c(const void* data, size_t size, uint32_t crc = 0);
+
+}  // namespace pallas
+#endif
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
@@ -15,15 +15,140 @@
 #ifdef __cplusplus
 #include <cstdint>
 #include <cstring>
+#include <memory>
 #include <vector>
 #include <set>
+#include <string>
+#include <utility>
 
 
 #include "pallas_parameter_handler.h"
+#include "pallas_statistics.h"
 /** Default size for creating Vectors and SubVectors.*/
 #define DEFAULT_VECTOR_SIZE 1000
 
 namespace pallas {
+/**
+ * Frees the array of values of a SubArray. If it was pinned by LinkedVector::pin_data or LinkedDurationVector::pin_data,
+ * it is only freed by the last unpinSubArrayData.
+ */
+void releaseSubArrayData(uint64_t* array);
+/** Releases the pins taken by LinkedVector::pin_data or LinkedDurationVector::pin_data. */
+void unpinSubArrayData(const std::vector<std::pair<uint64_t*, size_t>>& data);
+
+/**
+ * Summary of the durations of a range of a LinkedDurationVector, see LinkedDurationVector::summarize.
+ * When it is approximate, the SubArrays that are entirely in the range aren't read: they are described by
+ * their number of elements, min, max and mean, and the results that depend on their values come with an error bound.
+ * The count, min and max are always exact.
+ */
+struct DurationSummary {
+    /** Statistics of a SubArray whose values weren't read. */
+    struct Block {
+        /** Number of values. */
+        size_t count;
+        /** Smallest value. */
+        uint64_t min;
+        /** Largest value. */
+        uint64_t max;
+    };
+    /** Number of values in the range. */
+    size_t count = 0;
+    /** Lower bound of the sum of the values: the sum is in [#sum, #sum + #sum_error]. */
+    uint64_t sum = 0;
+    /** Error bound of #sum. 0 if the summary is exact. */
+    uint64_t sum_error = 0;
+    /** Smallest value in the range, UINT64_MAX if it's empty. */
+    uint64_t min = UINT64_MAX;
+    /** Largest value in the range. */
+    uint64_t max = 0;
+    /** Values that were read, at the edges of the range or in the SubArrays that were already loaded. */
+    std::vector<uint64_t> values;
+    /** SubArrays whose values weren't read. */
+    std::vector<Block> blocks;
+
+    /** Returns whether all the values were read. */
+    [[nodiscard]] bool isExact() const { return blocks.empty(); }
+    /** Returns an estimate of the mean. Its error bound is #sum_error / 2 / #count. */
+    [[nodiscard]] double mean() const;
+    /** Returns the variance of the values if the summary is exact, NaN otherwise. */
+    [[nodiscard]] double variance() const;
+    /**
+     * Returns an estimate of the q-quantile of the values, for q in [0, 1].
+     * Only the min and max of the unread SubArrays are known, so the quantile is bounded by the ranks they may take.
+     * @param q Quantile to estimate.
+     * @param error If not null, set to the bound of the difference between the estimate and the actual quantile.
+     */
+    [[nodiscard]] uint64_t quantile(double q, uint64_t* error = nullptr) const;
+};
+
+/**
+ * What was published of a vector that is still being written, for the live readers (see ThreadWriter::publish).
+ * Each value is appended once to the live data file while its SubArray fills up, in one block per publication.
+ * Once the SubArray is complete, it is appended again as a single block, and replaces these smaller ones.
+ */
+struct LivePublication {
+    /** A block of values in the live data file, described as a SubArray is in the vector file. */
+    struct Block {
+        /** Number of values. */
+        size_t size;
+        /** First and last values, or min, max and mean for the durations. */
+        uint64_t statistics[3];
+        /** Offset of the block in the data file. */
+        size_t offset;
+        /** Checksum of the block, see SubArray::checksum. */
+        uint32_t checksum;
+    };
+    /** Blocks of the SubArrays that were complete when they were published. */
+    std::vector<Block> full_blocks;
+    /** Blocks of the values of the last SubArray, published while it fills up. */
+    std::vector<Block> tail_blocks;
+    /** Values of the last SubArray that are in #tail_blocks, to publish it as one block once it is complete. */
+    std::vector<uint64_t> tail_values;
+    /** Number of values of the vector, and for the durations their min, max and mean, as of the last snapshot. */
+    size_t size = 0;
+    uint64_t min = 0;
+    uint64_t max = 0;
+    uint64_t mean = 0;
+};
+
+/** How much of a vector that is still being written was copied to the live snapshots. */
+struct LiveCursor {
+    /** Number of values in the last snapshot. */
+    size_t size = 0;
+    /** Number of SubArrays that were complete in the last snapshot. */
+    size_t nb_complete = 0;
+    /** Number of values of the next SubArray that were in the last snapshot. */
+    size_t tail_size = 0;
+};
+
+/**
+ * What a vector that is still being written gained since its last live snapshot (see ThreadWriter::publish).
+ * It only holds copies, so that it can be published by another thread while the vector keeps growing.
+ */
+struct LiveValues {
+    /** Values appended to one SubArray. */
+    struct Piece {
+        /** The new values. Empty if the SubArray was spilled. */
+        std::vector<uint64_t> values;
+        /** Whether the SubArray is complete. */
+        bool complete = false;
+        /** Whether the SubArray was spilled: its block of the spill file, described by #block, is copied instead. */
+        bool spilled = false;
+        /** Block of a spilled SubArray. */
+        LivePublication::Block block{};
+    };
+    /** The SubArrays that changed, in order. */
+    std::vector<Piece> pieces;
+    /** Number of values of the vector, and for the durations their min, max and mean. */
+    size_t size = 0;
+    uint64_t min = 0;
+    uint64_t max = 0;
+    uint64_t mean = 0;
+    /** Spill file of the vector, if it has spilled pieces. */
+    const char* spill_path = nullptr;
+};
+
 /**
  * Classic linked array list. Sub-arrays are implemented as a subclass
  */
@@ -37,6 +162,8 @@ class LinkedVector {
     size_t n_sub_array = 1;
     /** Describes if the SubArrays were all defined contiguously or not. */
     bool is_contiguous = false;
+    /** Whether the statistics are updated as each SubArray is completed, see getStatistics. */
+    bool keep_statistics = true;
     /**
      * Adds a new element at the end of the vector, after its current last element.
      *
@@ -53,6 +180,14 @@ class LinkedVector {
      */
     [[nodiscard]] uint64_t& at(size_t pos);
 
+    /**
+     * Returns a copy of the element at specified location `pos`, with bounds checking.
+     * Unlike at, it can be called while other threads load and unload the vectors of the same ParameterHandler.
+     * @param pos Position of the element in the vector.
+     * @return Value of the requested element.
+     */
+    [[nodiscard]] uint64_t get(size_t pos);
+
     /**
      * Returns a reference to the element at specified location `pos`, without bounds checking.
      * Loads the vector from the file if needed.
@@ -88,23 +223,67 @@ class LinkedVector {
      * @param infoFile File where information about the vector is stored.
      * @param dataFile  File where most of the data are stored.
      * @param parameter_handler Handler for the storage parameters.
+     * @param stream_from_file Whether the subvectors should be read from filePath one at a time while writing them.
+     * This is used when re-storing a trace: only one subvector is in memory at any given time.
+     */
+    void write_to_file(FILE* infoFile, FILE* dataFile, const ParameterHandler* parameter_handler, bool stream_from_file = false);
+
+    /**
+     * Copies the values appended since the last snapshot. Only the SubArrays that changed are visited,
+     * and the ones that were spilled are described by their block instead of being read back.
+     * @param cursor What was in the last snapshot. Updated.
+     * @param values Where the new values are copied.
+     */
+    void snapshot(LiveCursor& cursor, LiveValues& values) const;
+
+    /**
+     * Makes the vector write each SubArray to dataFilePath as soon as it is full, and release it,
+     * so that only the last one stays in memory. The released SubArrays are read back from the file when accessed.
+     * @param dataFilePath Data file the vector is stored to, opened with pallasOpenSpillFiles.
      */
-    void write_to_file(FILE* infoFile, FILE* dataFile, const ParameterHandler* parameter_handler);
+    void spill_to(const char* dataFilePath);
 
     /**
      * Resets the offsets of all the subvectors.
      */
     void reset_offsets();
 
+    /** Returns the number of bytes held by this vector: its SubArrays, and the values of the ones that are loaded. */
+    [[nodiscard]] size_t memoryUsage() const;
+
+    /**
+     * Reads the stored block of each subvector, without decompressing it, and compares it to its checksum.
+     * Nothing is loaded, and the data file is opened separately, so that several threads can be verified at once.
+     * @param errors Where a message is added for each block that doesn't match.
+     * @returns The number of blocks that were verified.
+     */
+    size_t verify_checksums(std::vector<std::string>& errors) const;
+
     /**
      * Given a starting and an ending timestamp, returns an array containing the ratio, for each subvector,
      * of the time spent between those two timestamps over the total duration of the subvector.
      */
     std::vector<double> getWeights(pallas_timestamp_t start, pallas_timestamp_t end);
 
+    /**
+     * Returns the statistics of the time between two consecutive values.
+     * They are updated as each SubArray is completed, so only the values that weren't accounted yet are visited:
+     * the last SubArray of a vector being written, or every SubArray of a vector read from a file whose statistics
+     * weren't given with setStatistics, which are then read and decoded.
+     */
+    [[nodiscard]] DurationStatistics getStatistics() const;
+    /** Sets the statistics of the time between the current values, for example the ones stored with the Thread. */
+    void setStatistics(const DurationStatistics& statistics);
+    /** Whether getStatistics doesn't need to read any SubArray from a file. */
+    [[nodiscard]] bool hasStatistics() const;
+
 private:
     /** Path to the file storing this vector. */
     const char* filePath = nullptr;
+    /** Whether the full SubArrays are written to filePath while the vector is being written, see spill_to. */
+    bool spill = false;
+    /** Whether the checksums of the SubArrays are known. They aren't in traces written before they were added. */
+    bool has_checksums = true;
 
     /** Parameter handler for the whole trace. */
     ParameterHandler& parameter_handler;
@@ -136,6 +315,10 @@ private:
         uint64_t last_value = 0;
         /** Offset where data is written. */
         size_t offset = 0;
+        /** CRC32C of the stored block at offset: its size, then its encoded and compressed data. */
+        uint32_t checksum = 0;
+        /** Vector whose file holds the data, when this SubArray was appended from another vector. */
+        const LinkedVector* source = nullptr;
         /**
          * Adds a new element at the end of the vector, after its current last element.
          *
@@ -185,8 +368,9 @@ private:
          * Load a SubArray's metadata from a file. Doesn't load the data.
          * @param file File where the metadata is stored.
          * @param previous Previous SubArray.
+         * @param has_checksum Whether the metadata ends with the checksum of the data.
          */
-        SubArray(FILE* file, SubArray* previous = nullptr);
+        SubArray(FILE* file, SubArray* previous = nullptr, bool has_checksum = false);
     };
 
     /** Set of loaded subarrays indexes. */
@@ -197,10 +381,43 @@ private:
     /** Last array list in the linked array list structure.*/
     SubArray* last;
 
+    /**
+     * Reads and decompresses the timestamps of a subvector from filePath,
+     * or from the file of the vector it was appended from.
+     * The returned array isn't registered in the memory queue: the caller owns it.
+     */
+    uint64_t* read_data(const SubArray* sub) const;
+    /**
+     * Whether the data of a subvector, as it is stored in its file, can be copied as is
+     * to a file written with the given storage parameters.
+     */
+    bool can_copy_data(const SubArray* sub, const ParameterHandler* parameter_handler) const;
+    /**
+     * Copies the stored (encoded and compressed) data of a subvector to dataFile without decoding it,
+     * and updates its offset.
+     */
+    void copy_data(SubArray* sub, FILE* dataFile) const;
     /**
      * Loads the timestamps from filePath.
      */
     void load_data(SubArray* sub);
+    /**
+     * Writes a full subvector to the end of filePath and releases its values.
+     */
+    void spill_data(SubArray* sub);
+
+    /** Statistics of the time between the first #statistics_size values. nullptr until some are accounted. */
+    std::unique_ptr<DurationStatistics> statistics;
+    /** Number of values accounted in #statistics. */
+    size_t statistics_size = 0;
+    /** Last value accounted in #statistics, where the next interval starts. */
+    uint64_t statistics_last_value = 0;
+    /** Adds the values of a complete SubArray to #statistics, if it follows the values that were accounted. */
+    void account_statistics(const SubArray* sub);
+    /** Returns the first value without loading it: it is kept with the SubArrays that were written. */
+    [[nodiscard]] uint64_t first_value() const;
+    /** Returns the last value without loading it. */
+    [[nodiscard]] uint64_t last_value() const;
 
    public:
     /** Loads all the subvectors. */
@@ -215,12 +432,47 @@ private:
     /** Creates a new LinkedVector from a file. Doesn't actually load it until and element is accessed. */
     LinkedVector(FILE* vectorFile, const char* valueFilePath, ParameterHandler& parameter_handler, uint8_t abi_version);
 
+    /**
+     * Creates a LinkedVector holding the values of the given vectors, one after the other.
+     * Nothing is loaded: the subvectors are read from the files of the given vectors when needed,
+     * and are copied without being decompressed when they are written with the same storage parameters.
+     * The statistics are combined from the ones of the given vectors, when they are known (see hasStatistics).
+     * The given vectors must outlive this one.
+     */
+    LinkedVector(ParameterHandler& parameter_handler, const std::vector<LinkedVector*>& parts);
+
     /**
      * Classic destructor. Calls free_data().
      */
     ~LinkedVector();
     /** Returns an array of size #size containing a copy of the values in this vector.*/
     [[nodiscard]] uint64_t* as_flat_array();
+    /**
+     * Copies the values in this vector to given_array, with one memcpy per subvector.
+     * @param given_array An allocated array of size #size.
+     */
+    void copy_to_array(uint64_t* given_array);
+    /**
+     * Loads all the subvectors and pins their data: they are removed from the queue of subvectors that may be
+     * unloaded to save memory, and their arrays stay allocated until unpinSubArrayData is called,
+     * even if the vector is freed or destroyed meanwhile.
+     * @return The data of each subvector, as (array, number of elements) pairs.
+     */
+    std::vector<std::pair<uint64_t*, size_t>> pin_data();
+    /**
+     * Calls f on each value of this vector, in order.
+     * The subvectors that aren't loaded are read in a temporary array, so nothing stays loaded afterward.
+     */
+    template <class F>
+    void for_each_value(F&& f) const {
+        for (auto* sub = first; sub; sub = sub->next) {
+            uint64_t* array = sub->array ? sub->array : read_data(sub);
+            for (size_t i = 0; i < sub->size; i++)
+                f(array[i]);
+            if (array != sub->array)
+                delete[] array;
+        }
+    }
 };
 
 class LinkedDurationVector {
@@ -234,6 +486,8 @@ class LinkedDurationVector {
     size_t n_sub_array = 1;
     /** Describes if the SubArrays were all defined contiguously or not. */
     bool is_contiguous = false;
+    /** Whether the statistics are updated as each SubArray is completed, see getStatistics. */
+    bool keep_statistics = true;
     /**
      * Adds a new element at the end of the vector, after its current last element.
      * Updates mean, min and max.
@@ -251,6 +505,14 @@ class LinkedDurationVector {
      */
     [[nodiscard]] uint64_t& at(size_t pos);
 
+    /**
+     * Returns a copy of the element at specified location `pos`, with bounds checking.
+     * Unlike at, it can be called while other threads load and unload the vectors of the same ParameterHandler.
+     * @param pos Position of the element in the vector.
+     * @return Value of the requested element.
+     */
+    [[nodiscard]] uint64_t get(size_t pos);
+
     /**
      * Returns a reference to the element at specified location `pos`, without bounds checking.
      * Loads the vector from the file if needed.
@@ -294,22 +556,53 @@ class LinkedDurationVector {
      * @param infoFile File where metadata is stored.
      * @param dataFile File where data is stored (most of the time).
      * @param parameter_handler Handler for the storage parameters.
+     * @param stream_from_file Whether the subvectors should be read from filePath one at a time while writing them.
      */
-    void write_to_file(FILE* infoFile, FILE* dataFile, const ParameterHandler* parameter_handler);
+    void write_to_file(FILE* infoFile, FILE* dataFile, const ParameterHandler* parameter_handler, bool stream_from_file = false);
+
+    /**
+     * Copies the values appended since the last snapshot. Only the SubArrays that changed are visited,
+     * and the ones that were spilled are described by their block instead of being read back.
+     * @param cursor What was in the last snapshot. Updated.
+     * @param values Where the new values are copied.
+     */
+    void snapshot(LiveCursor& cursor, LiveValues& values) const;
 
     /**
      * Returns the weighted mean over the subvectors.
      */
     pallas_duration_t weightedSum(std::vector<double>& weights);
 
+    /**
+     * Makes the vector write each SubArray to dataFilePath as soon as it is full, and release it,
+     * so that only the last one stays in memory. The released SubArrays are read back from the file when accessed.
+     * @param dataFilePath Data file the vector is stored to, opened with pallasOpenSpillFiles.
+     */
+    void spill_to(const char* dataFilePath);
+
     /**
      * Resets the offsets of all the subvectors.
      */
     void reset_offsets();
 
+    /** Returns the number of bytes held by this vector: its SubArrays, and the values of the ones that are loaded. */
+    [[nodiscard]] size_t memoryUsage() const;
+
+    /**
+     * Reads the stored block of each subvector, without decompressing it, and compares it to its checksum.
+     * Nothing is loaded, and the data file is opened separately, so that several threads can be verified at once.
+     * @param errors Where a message is added for each block that doesn't match.
+     * @returns The number of blocks that were verified.
+     */
+    size_t verify_checksums(std::vector<std::string>& errors) const;
+
    private:
     /** Path to the file storing this vector. */
     const char* filePath = nullptr;
+    /** Whether the full SubArrays are written to filePath while the vector is being written, see spill_to. */
+    bool spill = false;
+    /** Whether the checksums of the SubArrays are known. They aren't in traces written before they were added. */
+    bool has_checksums = true;
     /** Parameter handler for the whole trace. */
     ParameterHandler& parameter_handler;
     /**
@@ -337,14 +630,14 @@ class LinkedDurationVector {
 
         /** Offset where data is written. */
         size_t offset = 0;
+        /** CRC32C of the stored block at offset: its size, then its encoded and compressed data. */
+        uint32_t checksum = 0;
 
-        /**
-         * Updates the min/max/mean.
-         */
-        void update_statistics();
+        /** Vector whose file holds the data, when this SubArray was appended from another vector. */
+        const LinkedDurationVector* source = nullptr;
 
        public:
-        /** Replace the sum (being stored in the mean) by the actual mean. */
+        /** Computes the min, max and mean of the values, once the SubArray is complete. */
         void final_update_mean();
         /** Max element stored in the array. */
         uint64_t min = UINT64_MAX;
@@ -357,7 +650,7 @@ class LinkedDurationVector {
 
         /**
          * Adds a new element at the end of the vector, after its current last element.
-         * Updates mean, min and max.
+         * The statistics are only computed when the SubArray is complete, see final_update_mean.
          *
          * @param val Value to be added.
          * @return Pointer to the new element.
@@ -406,8 +699,9 @@ class LinkedDurationVector {
          * Load a SubArray's metadata from a file. Doesn't load the data.
          * @param file File where the metadata is stored.
          * @param previous Previous SubArray.
+         * @param has_checksum Whether the metadata ends with the checksum of the data.
          */
-        SubArray(FILE* file, SubArray* previous = nullptr);
+        SubArray(FILE* file, SubArray* previous = nullptr, bool has_checksum = false);
     };
     /** Set of loaded subarrays indexes. */
     std::set<SubArray*> loaded_subarrays;
@@ -417,14 +711,47 @@ class LinkedDurationVector {
     /** Last array list in the linked array list structure.*/
     SubArray* last;
 
+    /**
+     * Reads and decompresses the durations of a subvector from filePath,
+     * or from the file of the vector it was appended from.
+     * The returned array isn't registered in the memory queue: the caller owns it.
+     */
+    uint64_t* read_data(const SubArray* sub) const;
+    /**
+     * Whether the data of a subvector, as it is stored in its file, can be copied as is
+     * to a file written with the given storage parameters.
+     */
+    bool can_copy_data(const SubArray* sub, const ParameterHandler* parameter_handler) const;
+    /**
+     * Copies the stored (encoded and compressed) data of a subvector to dataFile without decoding it,
+     * and updates its offset.
+     */
+    void copy_data(SubArray* sub, FILE* dataFile) const;
     /**
      * Loads the durations from filePath.
      */
     void load_data(SubArray* sub);
+    /**
+     * Writes a full subvector to the end of filePath and releases its values.
+     */
+    void spill_data(SubArray* sub);
     /**
      * Updates the min/max/mean.
      */
     void update_statistics();
+    /** Statistics of the first #statistics_size values. nullptr until some are accounted. */
+    std::unique_ptr<DurationStatistics> statistics;
+    /** Number of values accounted in #statistics. */
+    size_t statistics_size = 0;
+    /** Adds the values of a complete SubArray to #statistics, if it follows the values that were accounted. */
+    void account_statistics(const SubArray* sub);
+    /**
+     * Visits the durations between [start, end[, one SubArray at a time.
+     * on_values is called with the values of the SubArrays that are read, and on_summary with the SubArrays
+     * that are entirely in the range and aren't loaded, when approximate is set.
+     */
+    template <class OnValues, class OnSummary>
+    void visit_range(size_t start_index, size_t end_index, bool approximate, OnValues&& on_values, OnSummary&& on_summary);
 
    public:
     /**
@@ -433,12 +760,59 @@ class LinkedDurationVector {
     void load_all_data();
     /** Replace the sum (being stored in the mean) by the actual mean. */
     void final_update_mean();
- /** Returns the sum of the durations between [start, end[. */
-    pallas_duration_t computeDurationBetween(size_t start_index, size_t end_index);
+    /**
+     * Returns the statistics of the durations.
+     * They are updated as each SubArray is completed, so only the values that weren't accounted yet are visited:
+     * the last SubArray of a vector being written, or every SubArray of a vector read from a file whose statistics
+     * weren't given with setStatistics, which are then read and decoded.
+     */
+    [[nodiscard]] DurationStatistics getStatistics() const;
+    /** Sets the statistics of the current durations, for example the ones stored with the Thread. */
+    void setStatistics(const DurationStatistics& statistics);
+    /** Whether getStatistics doesn't need to read any SubArray from a file. */
+    [[nodiscard]] bool hasStatistics() const;
+    /**
+     * Returns the sum of the durations between [start, end[.
+     * @param approximate Whether the SubArrays entirely in the range that aren't loaded only contribute their mean times
+     * their size, instead of being loaded. Their means were rounded down, so the sum may then be lower by less than their size.
+     */
+    pallas_duration_t computeDurationBetween(size_t start_index, size_t end_index, bool approximate = true);
+    /**
+     * Summarizes the durations between [start, end[.
+     * @param approximate Whether the SubArrays entirely in the range that aren't loaded are described by their statistics,
+     * instead of being loaded. Only the SubArrays at the edges of the range are then read.
+     */
+    [[nodiscard]] DurationSummary summarize(size_t start_index, size_t end_index, bool approximate = true);
 
     ~LinkedDurationVector();
     /** Returns an array of size #size containing a copy of the values in this vector.*/
     [[nodiscard]] uint64_t* as_flat_array();
+    /**
+     * Copies the values in this vector to given_array, with one memcpy per subvector.
+     * @param given_array An allocated array of size #size.
+     */
+    void copy_to_array(uint64_t* given_array);
+    /**
+     * Loads all the subvectors and pins their data: they are removed from the queue of subvectors that may be
+     * unloaded to save memory, and their arrays stay allocated until unpinSubArrayData is called,
+     * even if the vector is freed or destroyed meanwhile.
+     * @return The data of each subvector, as (array, number of elements) pairs.
+     */
+    std::vector<std::pair<uint64_t*, size_t>> pin_data();
+    /**
+     * Calls f on each value of this vector, in order.
+     * The subvectors that aren't loaded are read in a temporary array, so nothing stays loaded afterward.
+     */
+    template <class F>
+    void for_each_value(F&& f) const {
+        for (auto* sub = first; sub; sub = sub->next) {
+            uint64_t* array = sub->array ? sub->array : read_data(sub);
+            for (size_t i = 0; i < sub->size; i++)
+                f(array[i]);
+            if (array != sub->array)
+                delete[] array;
+        }
+    }
 
     // NOTE: 
     // fix comments
@@ -458,6 +832,12 @@ class LinkedDurationVector {
      * Creates a new LinkedDurationVector.
      */
     LinkedDurationVector(ParameterHandler& p);
+
+    /**
+     * Creates a LinkedDurationVector holding the values of the given vectors, one after the other.
+     * The min, max, mean and statistics are combined from the ones of the given vectors, which must outlive this one.
+     */
+    LinkedDurationVector(ParameterHandler& parameter_handler, const std::vector<LinkedDurationVector*>& parts);
 };
 }  // namespace pallas
 
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+/** @file
+ * Memory accounting: the bytes held by the structures of a trace, by category.
+ * The sizes are computed when they are queried, by walking the structures, so nothing is counted while recording.
+ * The sizes of the hash maps and of the std::map are estimates, since their nodes are not visible.
+ */
+#pragma once
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace pallas {
+
+/** Categories of memory. */
+enum MemoryCategory {
+    PALLAS_MEMORY_EVENTS,         /**< Event arrays, with their EventData. */
+    PALLAS_MEMORY_SEQUENCES,      /**< Sequence arrays, their tokens and their token counts. */
+    PALLAS_MEMORY_LOOPS,          /**< Loop arrays. */
+    PALLAS_MEMORY_ID_MAPS,        /**< Maps from the logical to the physical ids of the Events, Sequences and Loops. */
+    PALLAS_MEMORY_HASH_MAPS,      /**< Thread::hashToEvent and Thread::hashToSequence. */
+    PALLAS_MEMORY_TIMESTAMPS,     /**< LinkedVectors of timestamps, with their loaded SubArrays. */
+    PALLAS_MEMORY_DURATIONS,      /**< LinkedDurationVectors, with their loaded SubArrays. */
+    PALLAS_MEMORY_ATTRIBUTES,     /**< Attribute buffers of the Events. */
+    PALLAS_MEMORY_LABELS,         /**< Labels of the Sequences. */
+    PALLAS_MEMORY_STATISTICS,     /**< Statistics of the durations of the Sequences and Events. */
+    PALLAS_MEMORY_WRITER_STACKS,  /**< Stacks of the sequences being recorded by a ThreadWriter. */
+    PALLAS_MEMORY_READER_CURSORS, /**< Callstack of a ThreadReader, with the token counts of its frames. */
+    PALLAS_MEMORY_DEFINITIONS,    /**< Strings, Regions, Attributes, Groups, Comms, Locations and LocationGroups. */
+    PALLAS_MEMORY_CATEGORY_COUNT,
+};
+
+/** Returns the name of a category. */
+const char* toString(MemoryCategory category);
+
+/** Bytes held by some structures, by category. */
+struct MemoryUsage {
+    /** Number of bytes of each category. */
+    size_t bytes[PALLAS_MEMORY_CATEGORY_COUNT]{};
+
+    /** Adds the bytes of other to this one. */
+    MemoryUsage& operator+=(const MemoryUsage& other);
+    /** Returns the number of bytes of the given category. */
+    [[nodiscard]] size_t operator[](MemoryCategory category) const { return bytes[category]; }
+    /** Returns the number of bytes of all the categories. */
+    [[nodiscard]] size_t total() const;
+    /** Returns the categories that aren't empty as a single line of name=bytes pairs. */
+    [[nodiscard]] std::string toString() const;
+};
+
+/** Returns the number of bytes allocated by a std::vector. */
+template <class T>
+size_t vectorMemoryUsage(const std::vector<T>& vector) {
+    return vector.capacity() * sizeof(T);
+}
+
+/** Returns an estimate of the number of bytes allocated by a hash map: its buckets and one node per element. */
+template <class Map>
+size_t hashMapMemoryUsage(const Map& map) {
+    return map.bucket_count() * sizeof(void*) + map.size() * (sizeof(typename Map::value_type) + sizeof(void*));
+}
+
+/** Returns an estimate of the number of bytes allocated by a std::map: one node per element. */
+template <class Key, class Value>
+size_t mapMemoryUsage(const std::map<Key, Value>& map) {
+    // A red-black tree node has three pointers and a color.
+    return map.size() * (sizeof(std::pair<const Key, Value>) + 4 * sizeof(void*));
+}
+
+}  // namespace pallas
+#endif
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
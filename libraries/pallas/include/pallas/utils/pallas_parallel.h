@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+/** @file
+ * A minimal worker pool, used to process the Threads / Archives of a trace concurrently.
+ */
+#pragma once
+
+#ifdef __cplusplus
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace pallas {
+
+/**
+ * Returns the number of workers to use when nb_workers are requested.
+ * @param nb_workers Requested number of workers. 0 means one per hardware thread.
+ * @param nb_tasks Number of tasks to process. There is no point in having more workers than tasks.
+ */
+inline size_t getNbWorkers(size_t nb_workers, size_t nb_tasks) {
+    if (nb_workers == 0) {
+        nb_workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return std::max<size_t>(1, std::min(nb_workers, nb_tasks));
+}
+
+/**
+ * Calls task(i) for every i in [0, nb_tasks[ on a pool of worker threads.
+ * Tasks are distributed dynamically, so tasks with unbalanced costs are fine.
+ * With a single worker, everything runs on the calling thread.
+ * @param nb_tasks Number of tasks.
+ * @param nb_workers Number of workers. 0 means one per hardware thread.
+ * @param task Callable taking the index of the task as its only parameter.
+ */
+template <typename Task>
+void parallelFor(size_t nb_tasks, size_t nb_workers, Task&& task) {
+    nb_workers = getNbWorkers(nb_workers, nb_tasks);
+    if (nb_workers == 1) {
+        for (size_t i = 0; i < nb_tasks; i++) {
+            task(i);
+        }
+        return;
+    }
+    std::atomic<size_t> next_task{0};
+    auto worker = [&]() {
+        for (size_t i = next_task++; i < nb_tasks; i = next_task++) {
+            task(i);
+        }
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(nb_workers - 1);
+    for (size_t w = 1; w < nb_workers; w++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& w : workers) {
+        w.join();
+    }
+}
+
+}  // namespace pallas
+#endif
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 2;
+   tab-width 2 ;
+   indent-tabs-mode nil
+   -*- */
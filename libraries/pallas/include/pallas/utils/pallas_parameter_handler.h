@@ -10,6 +10,7 @@
 #ifdef __cplusplus
 #include <cstddef>
 #include <deque>
+#include <mutex>
 #include <string>
 
 #ifdef WITH_SZ
@@ -128,6 +129,10 @@ enum class TimestampStorage {
   Invalid,
 };
 const enum TimestampStorage TimestampStorageDefault = TimestampStorage::Delta;
+const size_t livePeriodDefault = 0;
+const bool partialFlushDefault = false;
+const bool verifyChecksumsDefault = true;
+const bool lazyLoadingDefault = false;
 
 /**
  * Converts a TimestampStorage to its string name.
@@ -161,6 +166,20 @@ class ParameterHandler {
 
     /** Timestamp storage method. */
     TimestampStorage timestampStorage{TimestampStorageDefault};
+    /** Period, in milliseconds, at which the ThreadWriters publish a live snapshot of their Thread. 0 disables it.
+     * It only matters while recording, so it isn't stored in the trace. */
+    size_t livePeriod{livePeriodDefault};
+    /** Whether the ThreadWriters write the full SubArrays of durations and timestamps to the data files of their Thread
+     * as soon as they are full, instead of keeping them in memory until the Thread is stored.
+     * It only matters while recording, so it isn't stored in the trace. */
+    bool partialFlush{partialFlushDefault};
+    /** Whether the checksums of the files and of the blocks of durations and timestamps are checked when they are read.
+     * It only matters while reading, so it isn't stored in the trace. */
+    bool verifyChecksums{verifyChecksumsDefault};
+    /** Whether the Events and Sequences of a Thread are only read from the trace when they are first touched,
+     * instead of when the Thread is. Code that walks Thread::events or Thread::sequences must call Thread::loadAll first.
+     * It only matters while reading, so it isn't stored in the trace. */
+    bool lazyLoading{lazyLoadingDefault};
     /** Amount of durations loaded in memory, in bytes. */
     size_t loaded_durations_size = 0;
     /** Max amount of memory taken by timestamps / durations. */
@@ -169,6 +188,9 @@ class ParameterHandler {
     std::deque<void*> subvector_queue;
     /** Does the stats of the vectors need to be computed ?. */
     bool does_stats_need_compute = true;
+    /** Lock protecting the loading / unloading of vectors (#subvector_queue, #loaded_durations_size and the opened files).
+     * It is shared by every ParameterHandler, so that several Threads of a trace can be read concurrently. */
+    static inline std::recursive_mutex storage_lock;
 
    public:
     /** Getter for #maxLoopLength. Error if you're not supposed to have a maximum loop length.
@@ -199,6 +221,8 @@ class ParameterHandler {
 
     void writeToFile(FILE* file) const;
     void readFromFile(FILE* file);
+    /** Loads the parameters that only matter while reading a trace (#verifyChecksums, #lazyLoading) from the environment. */
+    void loadReadingParameters();
 
     ParameterHandler();
     ParameterHandler(const std::string& stringConfig);
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+/** @file
+ * Summary statistics of a set of durations: count, sum, extrema, mean and variance, a log2 histogram,
+ * and a sketch that gives the quantiles with a bounded relative error.
+ * They are updated as the vectors of a Thread are written, and kept next to it so that they can be read without its vectors.
+ */
+#pragma once
+
+#ifdef __cplusplus
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pallas {
+
+/** Number of buckets of DurationStatistics::histogram: one for 0, then one per power of 2. */
+#define PALLAS_STATISTICS_HISTOGRAM_SIZE 65
+/** Relative accuracy of the quantiles given by DurationStatistics::quantile. */
+#define PALLAS_STATISTICS_SKETCH_ACCURACY 0.01
+/** Maximum number of buckets of the quantile sketch. The lowest buckets are merged beyond that. */
+#define PALLAS_STATISTICS_SKETCH_MAX_BUCKETS 2048
+
+/**
+ * Statistics of a set of durations, which can be merged with other ones.
+ * The quantile sketch uses logarithmic buckets, as in DDSketch:
+ * bucket i holds the values in (gamma^(i-1), gamma^i], with gamma = (1 + accuracy) / (1 - accuracy),
+ * so that any value of a bucket is within the accuracy of its estimate.
+ */
+struct DurationStatistics {
+    /** Number of values. */
+    uint64_t count = 0;
+    /** Sum of the values. */
+    uint64_t sum = 0;
+    /** Smallest value, UINT64_MAX if there is none. */
+    uint64_t min = UINT64_MAX;
+    /** Largest value. */
+    uint64_t max = 0;
+    /** Mean of the values. */
+    double mean = 0;
+    /** Sum of the squared differences to the mean, updated with Welford's algorithm. */
+    double m2 = 0;
+    /** Number of values of each bit width: histogram[0] counts the zeros, histogram[i] the values in [2^(i-1), 2^i). */
+    uint64_t histogram[PALLAS_STATISTICS_HISTOGRAM_SIZE]{};
+    /** Number of zeros, which have no logarithmic bucket. */
+    uint64_t sketch_zeros = 0;
+    /** Index of the first bucket of #sketch_counts. */
+    int32_t sketch_offset = 0;
+    /** Number of values in each logarithmic bucket, starting at #sketch_offset. */
+    std::vector<uint64_t> sketch_counts;
+
+    /** Adds a value. */
+    void add(uint64_t value);
+    /** Adds all the values of other, as if they had been added one by one. */
+    void merge(const DurationStatistics& other);
+    /** Returns the variance of the values. */
+    [[nodiscard]] double variance() const;
+    /** Returns the standard deviation of the values. */
+    [[nodiscard]] double stddev() const;
+    /** Returns an estimate of the q-quantile of the values, for q in [0, 1]. 0 if there are no values. */
+    [[nodiscard]] uint64_t quantile(double q) const;
+    /** Returns the statistics as a single line of key=value pairs. */
+    [[nodiscard]] std::string toString() const;
+
+   private:
+    /** Makes room for the bucket index in #sketch_counts, merging the lowest buckets if there are too many. */
+    size_t sketchBucket(int32_t index);
+};
+
+}  // namespace pallas
+#endif
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
@@ -40,6 +40,20 @@ void pallasStoreArchive(PALLAS(Archive) * archive, const char* path, const PALLA
  */
 void pallasStoreGlobalArchive(PALLAS(GlobalArchive) * archive, const char* path, const PALLAS(ParameterHandler)* parameter_handler);
 
+/**
+ * Loads the label table of the thread from the trace, if it was cached there.
+ * @param thread Thread whose labels should be loaded.
+ * @return Whether the label table was loaded.
+ */
+bool pallasLoadThreadLabels(PALLAS(Thread) * thread);
+
+/**
+ * Loads the statistics of the Sequences and Events of the thread from the trace, if they were stored there.
+ * @param thread Thread whose statistics should be loaded.
+ * @return Whether the statistics were loaded.
+ */
+bool pallasLoadThreadStatistics(PALLAS(Thread) * thread);
+
    /**
    * Allocate and read an archive from a `main.pallas` file.
    * @param trace_filename Path to a `main.pallas` file.
@@ -48,6 +62,211 @@ void pallasStoreGlobalArchive(PALLAS(GlobalArchive) * archive, const char* path,
 PALLAS(GlobalArchive*) pallas_open_trace(const char* trace_filename);
 #ifdef __cplusplus
 };
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+class File;
+
+namespace pallas {
+/** A block of a Thread that is still being recorded, published as a Sequence of its own. */
+struct LiveFrame {
+  /** Tokens recorded so far. The last one is the next LiveFrame, if any. */
+  std::vector<Token> tokens;
+  /** Timestamp of the start of the block. */
+  pallas_timestamp_t start;
+  /** Duration of the block so far. */
+  pallas_duration_t duration;
+};
+
+/** The vectors of a Sequence in a LiveSnapshot. */
+struct LiveSequenceValues {
+  /** Id of the Sequence. */
+  uint32_t id;
+  LiveValues durations;
+  LiveValues exclusive_durations;
+  LiveValues timestamps;
+};
+
+/**
+ * What a Thread that is being recorded gained since its last snapshot (see ThreadWriter::publish).
+ * It's made by the recording thread, and only holds copies, so that it's published by another thread.
+ */
+struct LiveSnapshot {
+  /** Thread being recorded. Only its address, its id and the one of its Archive are used by the publisher. */
+  Thread* thread;
+  ThreadId thread_id;
+  /** Archive of the Thread. Its definitions are published with the snapshot, under its lock. */
+  Archive* archive;
+  /** Parameters the Thread is recorded with. */
+  const ParameterHandler* parameter_handler;
+  TokenId sequence_root;
+  pallas_timestamp_t first_timestamp;
+  /** Whether it's the last snapshot of the Thread. The publisher then forgets it. */
+  bool last = false;
+  /** Events created since the last snapshot. */
+  std::vector<EventData> new_events;
+  /** Sequences created since the last snapshot: their type and their tokens. */
+  std::vector<std::pair<SequenceType, std::vector<Token>>> new_sequences;
+  /** New entries of the indirection maps of the Events and Sequences, which only grow while recording. */
+  std::vector<uint32_t> new_event_ids;
+  std::vector<uint32_t> new_sequence_ids;
+  /** All the Loops and their indirection map: they are updated when Loops are squashed. */
+  std::vector<Loop> loops;
+  std::vector<uint32_t> loop_id_map;
+  /** New timestamps of the Events that occurred since the last snapshot. */
+  std::vector<std::pair<uint32_t, LiveValues>> event_timestamps;
+  /** New AttributeLists of the Events, as they are in their attribute buffer. */
+  std::vector<std::pair<uint32_t, std::vector<byte>>> event_attributes;
+  /** New values of the Sequences that occurred since the last snapshot. */
+  std::vector<LiveSequenceValues> sequence_values;
+  /** Blocks that are being recorded, from the root to the innermost one. The first one replaces the root Sequence. */
+  std::vector<LiveFrame> frames;
+};
+
+/** What the publisher knows of a Thread that is being recorded, gathered from its LiveSnapshots. */
+struct LiveThread {
+  /** An Event, and what was published of it. */
+  struct Event {
+    EventData data;
+    /** Every AttributeList of the Event. They are stored again by each publication. */
+    std::vector<byte> attributes;
+    LivePublication timestamps;
+  };
+  /** A Sequence, and what was published of it. */
+  struct Sequence {
+    SequenceType type;
+    std::vector<Token> tokens;
+    LivePublication durations;
+    LivePublication exclusive_durations;
+    LivePublication timestamps;
+  };
+  ThreadId id = PALLAS_THREAD_ID_INVALID;
+  LocationGroupId archive_id = PALLAS_LOCATION_GROUP_ID_INVALID;
+  TokenId sequence_root = 0;
+  pallas_timestamp_t first_timestamp = PALLAS_TIMESTAMP_INVALID;
+  std::vector<Event> events;
+  std::vector<Sequence> sequences;
+  std::vector<uint32_t> event_id_map;
+  std::vector<uint32_t> sequence_id_map;
+  std::vector<Loop> loops;
+  std::vector<uint32_t> loop_id_map;
+  std::vector<LiveFrame> frames;
+  /** Number of snapshots applied so far. */
+  size_t nb_snapshots = 0;
+};
+
+/** What pallasVerifyTrace found. */
+struct VerificationReport {
+  /** Number of files whose checksum was verified. */
+  size_t nb_files = 0;
+  /** Number of blocks of timestamps and durations whose checksum was verified. */
+  size_t nb_blocks = 0;
+  /** One message per corrupted file or block. The trace is intact if there is none. */
+  std::vector<std::string> errors;
+};
+
+/**
+ * Offsets of the records of the Events and Sequences in the file of a Thread. It is written at the end of the file,
+ * so that a Thread read with ParameterHandler::lazyLoading only reads a record when its Event or Sequence is touched.
+ */
+struct ThreadIndex {
+  /** Offset of each Event, indexed like Thread::events. */
+  std::vector<uint64_t> events;
+  /** Offset of the indirection map of the Events, right after them. */
+  uint64_t event_map = 0;
+  /** Offset of each Sequence, indexed like Thread::sequences. */
+  std::vector<uint64_t> sequences;
+  /** Offset of the indirection map of the Sequences, right after them. The Loops follow it. */
+  uint64_t sequence_map = 0;
+  /** CRC32C of the record of each Event / Sequence, verified when it is read. */
+  std::vector<uint32_t> event_checksums;
+  std::vector<uint32_t> sequence_checksums;
+  /** CRC32C of the rest of the file before the index: its header, its indirection maps and its Loops. */
+  uint32_t checksum = 0;
+
+  /** File of the Thread. It is only read through this index, so it isn't in the map of opened files, but it is closed
+   * like them when too many files are open. */
+  File* thread_file = nullptr;
+  /** Paths of the data files of the Events and of the Sequences, for their vectors. */
+  const char* event_duration_path = nullptr;
+  const char* sequence_duration_path = nullptr;
+  /** Data file of the Events. */
+  File* event_duration_file = nullptr;
+  /** Whether the records are verified against their checksum when they are read. */
+  bool verify_checksums = false;
+  /** Protects the reads of the records, so that the Threads can be loaded in parallel. */
+  std::mutex lock;
+  /** Parameters the trace was written with. */
+  ParameterHandler* parameter_handler = nullptr;
+  /** ABI version of the trace. */
+  uint8_t abi_version = 0;
+  /** Whether each Event / Sequence was read. */
+  std::vector<std::atomic<bool>> loaded_events;
+  std::vector<std::atomic<bool>> loaded_sequences;
+  /** Whether each Sequence is referred to by the indirection map, which gives it its id even if it is empty. */
+  std::vector<bool> mapped_sequences;
+
+  ThreadIndex() = default;
+  ThreadIndex(const ThreadIndex&) = delete;
+  ThreadIndex& operator=(const ThreadIndex&) = delete;
+  /** Closes the thread file. */
+  ~ThreadIndex();
+};
+}  // namespace pallas
+
+/**
+ * Verifies the checksums of every file of a trace, and of every block of timestamps and durations,
+ * without decompressing them. The Threads are verified in parallel.
+ * Traces written before the checksums were added (ABI version < 21) are reported as such.
+ * @param trace_filename Path to a `main.pallas` file.
+ * @param nb_workers Number of Threads verified concurrently. 0 means one per hardware thread.
+ */
+pallas::VerificationReport pallasVerifyTrace(const char* trace_filename, size_t nb_workers);
+
+/**
+ * Appends the values of a snapshot of a Thread that is still being recorded to the data files of its live folder,
+ * and adds the rest of the snapshot to what is known of the Thread. The SubArrays that were spilled are copied
+ * from the spill files without being decoded.
+ * @param path Path to the root folder of the snapshots.
+ * @param thread What is known of the Thread. Updated by this function.
+ * @param snapshot Snapshot made by the recording thread. Its content is moved to thread.
+ */
+void pallasApplyLiveSnapshot(const char* path, pallas::LiveThread& thread, pallas::LiveSnapshot& snapshot);
+/**
+ * Publishes a Thread that is still being recorded, so that it can be read while it is written: its thread file refers
+ * to the values that pallasApplyLiveSnapshot appended to the data files. It's written to a temporary file,
+ * then renamed, so that a reader never sees it partially written.
+ * @param path Path to the root folder of the snapshots.
+ * @param thread What is known of the Thread.
+ * @param parameter_handler Handler for the storage parameters.
+ */
+void pallasPublishThread(const char* path, pallas::LiveThread& thread, const pallas::ParameterHandler* parameter_handler);
+/**
+ * Publishes the archive to the root folder of a snapshot. The file is written atomically.
+ * @param archive Archive to be published.
+ * @param path Path to the root folder of the snapshot.
+ */
+void pallasPublishArchive(pallas::Archive* archive, const char* path);
+/**
+ * Publishes the global archive to the root folder of a snapshot. The file is written atomically.
+ * @param archive Archive to be published.
+ * @param path Path to the root folder of the snapshot.
+ * @param parameter_handler Handler for the storage parameters.
+ */
+void pallasPublishGlobalArchive(pallas::GlobalArchive* archive, const char* path, const pallas::ParameterHandler* parameter_handler);
+/**
+ * Opens the data files of a Thread that is being recorded, so that its vectors can write their full SubArrays to them
+ * (see LinkedVector::spill_to). Whatever they held is discarded. When the Thread is stored, the rest is appended to them.
+ * @param path Path to the root folder of the trace.
+ * @param thread Thread being recorded.
+ * @returns The paths of the event and of the sequence data files, to give to the vectors. Both are nullptr if the
+ * timestamps aren't stored.
+ */
+std::pair<const char*, const char*> pallasOpenSpillFiles(const char* path, pallas::Thread* thread);
 #endif
 
 /* -*-
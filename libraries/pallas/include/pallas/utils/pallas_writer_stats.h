@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+/** @file
+ * Self-instrumentation of the ThreadWriter: counters and timers of the recording phases.
+ * They are only updated when Pallas is built with ENABLE_WRITER_STATS, which defines PALLAS_WRITER_STATS.
+ * The counters of each thread are then stored in the metadata of its Archive, as writer_stats.thread_<id>,
+ * when the thread is closed. Otherwise, the macros of this file expand to nothing.
+ */
+#pragma once
+
+#include "pallas_config.h"
+
+#ifdef __cplusplus
+#include <chrono>
+#include <cstdint>
+#include <string>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#else
+#include <stdint.h>
+#endif
+
+#ifdef __cplusplus
+namespace pallas {
+#endif
+
+/** Phases of the recording that are timed. A phase that is entered again while it runs is only timed once. */
+enum WriterPhase {
+    PALLAS_PHASE_STORE_EVENT,     /**< ThreadWriter::storeEvent, which contains the timestamp storage and the sequence and loop finding. */
+    PALLAS_PHASE_GET_EVENT_ID,    /**< Looking up or creating an Event from its EventData. */
+    PALLAS_PHASE_STORE_TIMESTAMP, /**< Adding the timestamps to the LinkedVectors. */
+    PALLAS_PHASE_FIND_SEQUENCE,   /**< Looking the last tokens up in the known Sequences. */
+    PALLAS_PHASE_FIND_LOOP,       /**< Looking for repeated tokens, and creating the Loops. */
+    PALLAS_PHASE_STORE,           /**< Writing the Thread when it is closed, compression included. */
+    PALLAS_PHASE_COMPRESSION,     /**< Encoding and compressing the SubArrays of the LinkedVectors. */
+    PALLAS_PHASE_COUNT,
+};
+
+/**
+ * Counters of one ThreadWriter.
+ * The times are in ticks of pallas_writer_stats_ticks: TSC cycles on x86, nanoseconds elsewhere.
+ */
+typedef struct WriterStats {
+    /** Number of calls to storeEvent. */
+    uint64_t nb_events_stored;
+    /** Number of tokens appended to the current sequences, including the Sequences and Loops that replace them. */
+    uint64_t nb_tokens_stored;
+    /** Number of calls to getEventId. */
+    uint64_t nb_event_lookups;
+    /** Number of Events created by getEventId. */
+    uint64_t nb_events_created;
+    /** Number of Events compared with the EventData because they have the same hash. */
+    uint64_t nb_event_hash_probes;
+    /** Number of hash lookups of the last tokens in findSequence. */
+    uint64_t nb_sequence_lookups;
+    /** Number of Sequences compared with the last tokens because they have the same hash. */
+    uint64_t nb_sequence_hash_probes;
+    /** Number of Sequences found in the last tokens by findSequence. */
+    uint64_t nb_sequences_found;
+    /** Number of Sequences created. */
+    uint64_t nb_sequences_created;
+    /** Number of loop lengths tested by findLoopBasic. */
+    uint64_t nb_loop_candidates;
+    /** Number of Loops created. */
+    uint64_t nb_loops_created;
+    /** Number of iterations added to an existing Loop. */
+    uint64_t nb_loop_iterations_added;
+    /** Number of Loops merged with an identical Loop. */
+    uint64_t nb_loops_squashed;
+    /** Number of SubArrays written when the Thread was stored, encoded and compressed according to the ParameterHandler. */
+    uint64_t nb_subarrays_compressed;
+    /** Size of these SubArrays before they were encoded and compressed. */
+    uint64_t nb_raw_bytes;
+    /** Number of bytes written to the files of the Thread. */
+    uint64_t nb_bytes_written;
+    /** Time spent in each phase. */
+    uint64_t phase_ticks[PALLAS_PHASE_COUNT];
+    /** Phases that are currently timed, as a bitmask. */
+    uint32_t running_phases;
+#ifdef __cplusplus
+    /** Adds the counters of other to this one. */
+    void add(const WriterStats& other);
+    /** Returns the counters as a single line of key=value pairs. */
+    [[nodiscard]] std::string toString() const;
+#endif
+} WriterStats;
+
+#ifdef __cplusplus
+/** Returns the name of a phase. */
+const char* toString(WriterPhase phase);
+
+/** Returns a timestamp for the phase timers. Cheaper than pallas_get_timestamp. */
+inline uint64_t pallas_writer_stats_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/** Times a phase until it goes out of scope. Does nothing if stats is null, or if the phase is already timed. */
+class WriterPhaseTimer {
+   public:
+    WriterPhaseTimer(WriterStats* stats, WriterPhase phase) : phase(phase) {
+        if (stats && !(stats->running_phases & (1u << phase))) {
+            this->stats = stats;
+            stats->running_phases |= 1u << phase;
+            start = pallas_writer_stats_ticks();
+        }
+    }
+    ~WriterPhaseTimer() {
+        if (stats) {
+            stats->phase_ticks[phase] += pallas_writer_stats_ticks() - start;
+            stats->running_phases &= ~(1u << phase);
+        }
+    }
+    WriterPhaseTimer(const WriterPhaseTimer&) = delete;
+    WriterPhaseTimer& operator=(const WriterPhaseTimer&) = delete;
+
+   private:
+    WriterStats* stats = nullptr;
+    WriterPhase phase;
+    uint64_t start = 0;
+};
+
+/** Stats of the ThreadWriter whose Thread is being stored by the current thread, if any. Used by the storage. */
+extern thread_local WriterStats* pallas_current_writer_stats;
+}  // namespace pallas
+
+#ifdef PALLAS_WRITER_STATS
+/** Adds n to a counter of a WriterStats. */
+#define PALLAS_WRITER_STATS_ADD(stats, counter, n) ((stats).counter += (n))
+/** Adds n to a counter of the WriterStats of the Thread being stored, if any. */
+#define PALLAS_WRITER_STATS_ADD_CURRENT(counter, n)          \
+    do {                                                     \
+        if (pallas::pallas_current_writer_stats)             \
+            pallas::pallas_current_writer_stats->counter += (n); \
+    } while (0)
+/** Times the given phase until the end of the current scope. */
+#define PALLAS_WRITER_STATS_PHASE(stats_ptr, phase) pallas::WriterPhaseTimer _pallas_phase_timer(stats_ptr, phase)
+#else
+#define PALLAS_WRITER_STATS_ADD(stats, counter, n) \
+    do {                                           \
+    } while (0)
+#define PALLAS_WRITER_STATS_ADD_CURRENT(counter, n) \
+    do {                                            \
+    } while (0)
+#define PALLAS_WRITER_STATS_PHASE(stats_ptr, phase) \
+    do {                                            \
+    } while (0)
+#endif
+#endif
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
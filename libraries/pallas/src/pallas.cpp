@@ -12,6 +12,7 @@
 
 #include "pallas/utils/pallas_hash.h"
 #include "pallas/utils/pallas_log.h"
+#include "pallas/utils/pallas_storage.h"
 __thread uint64_t pallas_thread_rank = 0;
 unsigned int pallas_mpi_rank = 0;
 
@@ -106,6 +107,7 @@ size_t TokenCountMap::getEventCount() const {
 }
 
 void Thread::loadTimestamps() {
+    loadAll();
     DOFOR(i, nb_events) {
         events[i].timestamps->load_all_data();
     }
@@ -118,11 +120,15 @@ void Thread::loadTimestamps() {
 }
 
 void Thread::resetVectorsOffsets() {
+    // The Events and Sequences that were not read yet have no vectors.
     DOFOR(i, nb_events) {
-        events[i].timestamps->reset_offsets();
+        if (events[i].timestamps)
+            events[i].timestamps->reset_offsets();
     }
     DOFOR(i, nb_sequences) {
         auto& s = sequences[i];
+        if (s.durations == nullptr)
+            continue;
         s.durations->reset_offsets();
         s.exclusive_durations->reset_offsets();
         s.timestamps->reset_offsets();
@@ -134,6 +140,7 @@ void Event::cleanEvent() {
     delete attribute_buffer;
     timestamps = nullptr;
     attribute_buffer = nullptr;
+    clearAttributeIndex();
 }
 
 Event::Event(TokenId token_id, const EventData& e) {
@@ -142,6 +149,8 @@ Event::Event(TokenId token_id, const EventData& e) {
     attribute_buffer = nullptr;
     attribute_buffer_size = 0;
     attribute_pos = 0;
+    attribute_offsets = nullptr;
+    nb_attribute_offsets = 0;
     data = e;
 }
 
@@ -155,6 +164,8 @@ Event* Thread::getEvent(Token token) const {
     uint32_t phys_id = this->event_id_map[token.id];
     pallas_assert(phys_id != PALLAS_INDEX_INVALID);
     pallas_assert(phys_id < this->nb_events);
+    if (lazy_index)
+        loadEvent(phys_id);
     return &this->events[phys_id];
 }
 
@@ -168,6 +179,8 @@ Sequence* Thread::getSequence(Token token) const {
     uint32_t phys_id = this->sequence_id_map[token.id];
     pallas_assert(phys_id != PALLAS_INDEX_INVALID);
     pallas_assert(phys_id < this->nb_sequences);
+    if (lazy_index)
+        loadSequence(phys_id);
     return &sequences[phys_id];
 }
 
@@ -257,42 +270,26 @@ std::string Thread::getTokenString(Token token) const {
 }
 
 pallas_duration_t Thread::getDuration() const {
-  uint32_t phys_id = sequence_id_map[sequence_root];
-  return sequences[phys_id].durations->at(0);
-}
-
-pallas_duration_t get_duration(PALLAS(Thread)* t) {
-    return t->getDuration();
+  return getSequence(PALLAS_SEQUENCE_ID(sequence_root))->durations->at(0);
 }
 
 pallas_timestamp_t Thread::getFirstTimestamp() const {
     return first_timestamp;
 }
 
-pallas_timestamp_t get_first_timestamp(PALLAS(Thread)* t) {
-    return t->getFirstTimestamp();
-}
-
 pallas_timestamp_t Thread::getLastTimestamp() const {
     return getFirstTimestamp() + getDuration();
 }
 
-pallas_timestamp_t get_last_timestamp(PALLAS(Thread)* t) {
-    return t->getLastTimestamp();
-}
-
 size_t Thread::getEventCount() const {
     size_t ret = 0;
     for (unsigned i = 0; i < this->nb_events; i++) {
+        loadEvent(i);
         ret += this->events[i].nb_occurrences;
     }
     return ret;
 }
 
-size_t get_event_count(PALLAS(Thread)* t) {
-    return t->getEventCount();
-}
-
 std::string Thread::getTokenArrayString(const Token* array, size_t start_index, size_t len) const {
     std::string out("[");
     for (int i = 0; i < len; i++) {
@@ -347,6 +344,16 @@ std::string Thread::getEventString(EventData *e) const {
         pallas_read_leave(e, nullptr, &region_ref);
         return "Leave " + std::to_string(region_ref) + " (" + getRegionStringFromEvent(e) + ")";
     }
+    case PALLAS_EVENT_MEASUREMENT_ON_OFF: {
+        uint8_t measurement_on;
+        pallas_read_measurement_on_off(e, nullptr, &measurement_on);
+        return measurement_on ? "MEASUREMENT_ON()" : "MEASUREMENT_OFF()";
+    }
+    case PALLAS_EVENT_BUFFER_FLUSH: {
+        pallas_timestamp_t stop_time;
+        pallas_read_buffer_flush(e, nullptr, &stop_time);
+        return "BUFFER_FLUSH(" + std::to_string(stop_time) + ")";
+    }
     case PALLAS_EVENT_THREAD_BEGIN:
         return "THREAD_BEGIN()";
     case PALLAS_EVENT_THREAD_END:
@@ -646,6 +653,7 @@ std::map<Token, pallas_duration_t> Thread::getSnapshotViewExact(pallas_timestamp
 
 std::map<std::tuple<Token,std::string>, pallas_duration_t> Thread::getSnapshotViewFast(pallas_timestamp_t start, pallas_timestamp_t end) const {
     pallas_duration_t interval_duration = end - start;
+    loadAll();
     auto filter = std::vector<Token>();
     for (size_t i = 0; i < nb_sequences; i++) {
         auto &s = sequences[i];
@@ -654,9 +662,11 @@ std::map<std::tuple<Token,std::string>, pallas_duration_t> Thread::getSnapshotVi
         }
     }
 
+    buildSequenceLabels();
     auto output = std::map<std::tuple<Token, std::string>, pallas_duration_t>();
     for (Token &t: filter) {
         auto *s = getSequence(t);
+        const std::string& sequence_name = sequence_labels[sequence_label_ids[sequence_id_map[t.id]]];
         if (s->type != SEQUENCE_BLOCK)
             continue;
         // s.durations.min here because we don't want to load anything.
@@ -671,48 +681,52 @@ std::map<std::tuple<Token,std::string>, pallas_duration_t> Thread::getSnapshotVi
             pallas_timestamp_t t_start = s->timestamps->front();
             pallas_timestamp_t t_end = duration + t_start;
             if (end < t_end) {
-                output[std::tuple(t, s->guessName(this))] = end - t_start;
+                output[std::tuple(t, sequence_name)] = end - t_start;
             } else {
-                output[std::tuple(t, s->guessName(this))] = duration;
+                output[std::tuple(t, sequence_name)] = duration;
             }
             continue;
         }
         std::vector weights = s->timestamps->getWeights(start, end);
         pallas_duration_t sum = s->exclusive_durations->weightedSum(weights);
-        output[std::tuple(t, s->guessName(this))] = sum;
+        output[std::tuple(t, sequence_name)] = sum;
     }
 
     return output;
 }
 
-std::map<std::tuple<Token,std::string>, pallas_duration_t> Thread::getSnapshotView(pallas_timestamp_t start, pallas_timestamp_t end) const {
-    // This code is the exact same as Thread::getSnapshotViewByName
+std::map<std::tuple<Token,std::string>, pallas_duration_t> Thread::getSnapshotView(pallas_timestamp_t start, pallas_timestamp_t end, bool approximate) const {
+    // This code is the exact same as Thread::getSnapshotViewByLabel
     // Any modifications / fix to this should also be done to the former.
+    buildSequenceLabels();
+    loadAll();
     auto output = std::map<std::tuple<Token, std::string>, pallas_duration_t>();
     for (size_t i = 1; i < nb_sequences; i++) {
         auto &s = sequences[i];
         if (s.type != SEQUENCE_BLOCK)
             continue;
 
-        if (end < s.timestamps->front() || s.timestamps->back() + s.durations->back() < start) {
+        // The snapshot of a GlobalArchive runs on several threads, that unload the durations of each other:
+        // get copies the values before they can be unloaded.
+        if (end < s.timestamps->front() || s.timestamps->back() + s.durations->get(s.durations->size - 1) < start) {
             continue;
         }
         size_t start_index = s.timestamps->getFirstOccurrenceBefore(start);
         size_t end_index = s.timestamps->getFirstOccurrenceBefore(end);
 #ifdef DEBUG
         if (s.timestamps->front() <= start) {
-            pallas_assert_inferior_equal(s.timestamps->at(start_index), start);
+            pallas_assert_inferior_equal(s.timestamps->get(start_index), start);
             if (start_index + 1 < s.timestamps->size) {
-                pallas_assert_inferior_equal(start, s.timestamps->at(start_index + 1));
+                pallas_assert_inferior_equal(start, s.timestamps->get(start_index + 1));
             }
         }
-        pallas_assert_inferior_equal(s.timestamps->at(end_index), end);
+        pallas_assert_inferior_equal(s.timestamps->get(end_index), end);
 #endif
-        std::tuple<Token, std::string> sequence_token_name = std::tuple<Token, std::string>(s.id, s.guessName(this));
+        std::tuple<Token, std::string> sequence_token_name = std::tuple<Token, std::string>(s.id, sequence_labels[sequence_label_ids[i]]);
         // Both of these indexes may be bordering the start/end timestamps
         // We only call computeDurationBetween for whole durations.
         if (start_index + 1 < end_index) {
-            output[sequence_token_name] = s.exclusive_durations->computeDurationBetween(start_index + 1, end_index);
+            output[sequence_token_name] = s.exclusive_durations->computeDurationBetween(start_index + 1, end_index, approximate);
         }
         // Then we need to compute the pro-ratio of the starting and the end events
         // First we compute the capped duration, like in the following diagram
@@ -724,38 +738,38 @@ std::map<std::tuple<Token,std::string>, pallas_duration_t> Thread::getSnapshotVi
         //       [          |###############]        | capped_duration ( 15 ticks )
         //       [          |###        # ##]        | exclusive_duration * capped_duration / duration = 6 ticks
         // Starting event:
-        pallas_timestamp_t start_event_start = s.timestamps->at(start_index);
-        pallas_duration_t start_event_duration = s.durations->at(start_index);
+        pallas_timestamp_t start_event_start = s.timestamps->get(start_index);
+        pallas_duration_t start_event_duration = s.durations->get(start_index);
         pallas_timestamp_t start_event_end = start_event_start + start_event_duration;
         // Check if the starting event is actually in the bounds
         if (start < start_event_end && start_event_start < end) {
             if (start <= start_event_start && start_event_end <= end) {
                 // Trivial case where it's entirely contained in [start, end]
-                output[sequence_token_name] += s.exclusive_durations->at(start_index);
+                output[sequence_token_name] += s.exclusive_durations->get(start_index);
             } else {
                 pallas_duration_t capped_duration = pallas_get_duration(
                     std::max(start, start_event_start),
                     std::min(start_event_end, end)
                 );
-                output[sequence_token_name] += (s.exclusive_durations->at(start_index) * capped_duration) / start_event_duration;
+                output[sequence_token_name] += (s.exclusive_durations->get(start_index) * capped_duration) / start_event_duration;
             }
         }
         // Ending event
         if (end_index != start_index) {
             // Don't count it twice
-            pallas_timestamp_t end_event_start = s.timestamps->at(end_index);
-            pallas_duration_t end_event_duration = s.durations->at(end_index);
+            pallas_timestamp_t end_event_start = s.timestamps->get(end_index);
+            pallas_duration_t end_event_duration = s.durations->get(end_index);
             pallas_timestamp_t end_event_end = end_event_start + end_event_duration;
             if (start < end_event_end && end_event_start < end) {
                 if (start <= end_event_start && end_event_end <= end) {
                     // Trivial case where it's entirely contained in [start, end]
-                    output[sequence_token_name] += s.exclusive_durations->at(end_index);
+                    output[sequence_token_name] += s.exclusive_durations->get(end_index);
                 } else {
                     pallas_duration_t capped_duration = pallas_get_duration(
                         std::max(start, end_event_start),
                         std::min(end_event_end, end)
                     );
-                    output[sequence_token_name] += (s.exclusive_durations->at(end_index) * capped_duration) / end_event_duration;
+                    output[sequence_token_name] += (s.exclusive_durations->get(end_index) * capped_duration) / end_event_duration;
                 }
             }
         }
@@ -763,34 +777,45 @@ std::map<std::tuple<Token,std::string>, pallas_duration_t> Thread::getSnapshotVi
     return output;
 }
 
-std::map<std::string, pallas_duration_t> Thread::getSnapshotViewByName(pallas_timestamp_t start, pallas_timestamp_t end) const {
+std::vector<pallas_duration_t> Thread::getSnapshotViewByLabel(pallas_timestamp_t start, pallas_timestamp_t end, bool approximate, std::vector<bool>* in_view) const {
     // This code is the exact same as Thread::getSnapshotView
     // Any modifications / fix to this should also be done to the former.
-    auto output = std::map<std::string, pallas_duration_t>();
+    buildSequenceLabels();
+    loadAll();
+    auto output = std::vector<pallas_duration_t>(sequence_labels.size(), 0);
+    if (in_view != nullptr) {
+        in_view->assign(sequence_labels.size(), false);
+    }
     for (size_t i = 1; i < nb_sequences; i++) {
         auto &s = sequences[i];
         if (s.type != SEQUENCE_BLOCK)
             continue;
 
-        if (end < s.timestamps->front() || s.timestamps->back() + s.durations->back() < start) {
+        if (end < s.timestamps->front() || s.timestamps->back() + s.durations->get(s.durations->size - 1) < start) {
             continue;
         }
-        std::string sequence_name = s.guessName(this);
+        uint32_t label_id = sequence_label_ids[i];
+        auto add = [&](pallas_duration_t duration) {
+            output[label_id] += duration;
+            if (in_view != nullptr) {
+                (*in_view)[label_id] = true;
+            }
+        };
         size_t start_index = s.timestamps->getFirstOccurrenceBefore(start);
         size_t end_index = s.timestamps->getFirstOccurrenceBefore(end);
 #ifdef DEBUG
         if (s.timestamps->front() <= start) {
-            pallas_assert_inferior_equal(s.timestamps->at(start_index), start);
+            pallas_assert_inferior_equal(s.timestamps->get(start_index), start);
             if (start_index + 1 < s.timestamps->size) {
-                pallas_assert_inferior_equal(start, s.timestamps->at(start_index + 1));
+                pallas_assert_inferior_equal(start, s.timestamps->get(start_index + 1));
             }
         }
-        pallas_assert_inferior_equal(s.timestamps->at(end_index), end);
+        pallas_assert_inferior_equal(s.timestamps->get(end_index), end);
 #endif
         // Both of these indexes may be bordering the start/end timestamps
         // We only call computeDurationBetween for whole durations.
         if (start_index + 1 < end_index) {
-            output[sequence_name] = s.exclusive_durations->computeDurationBetween(start_index + 1, end_index);
+            add(s.exclusive_durations->computeDurationBetween(start_index + 1, end_index, approximate));
         }
         // Then we need to compute the pro-ratio of the starting and the end events
         // First we compute the capped duration, like in the following diagram
@@ -802,40 +827,38 @@ std::map<std::string, pallas_duration_t> Thread::getSnapshotViewByName(pallas_ti
         //       [          |###############]        | capped_duration ( 15 ticks )
         //       [          |###        # ##]        | exclusive_duration * capped_duration / duration = 6 ticks
         // Starting event:
-        pallas_timestamp_t start_event_start = s.timestamps->at(start_index);
-        pallas_duration_t start_event_duration = s.durations->at(start_index);
+        pallas_timestamp_t start_event_start = s.timestamps->get(start_index);
+        pallas_duration_t start_event_duration = s.durations->get(start_index);
         pallas_timestamp_t start_event_end = start_event_start + start_event_duration;
         // Check if the starting event is actually in the bounds
         if (start < start_event_end && start_event_start < end) {
             if (start <= start_event_start && start_event_end <= end) {
                 // Trivial case where it's entirely contained in [start, end]
-                output[sequence_name] += s.exclusive_durations->at(start_index);
+                add(s.exclusive_durations->get(start_index));
             } else {
                 pallas_duration_t capped_duration = pallas_get_duration(
                     std::max(start, start_event_start),
                     std::min(start_event_end, end)
                 );
-                output[sequence_name] += (s.exclusive_durations->at(start_index) * capped_duration) /
-                        start_event_duration;
+                add((s.exclusive_durations->get(start_index) * capped_duration) / start_event_duration);
             }
         }
         // Ending event
         if (end_index != start_index) {
             // Don't count it twice
-            pallas_timestamp_t end_event_start = s.timestamps->at(end_index);
-            pallas_duration_t end_event_duration = s.durations->at(end_index);
+            pallas_timestamp_t end_event_start = s.timestamps->get(end_index);
+            pallas_duration_t end_event_duration = s.durations->get(end_index);
             pallas_timestamp_t end_event_end = end_event_start + end_event_duration;
             if (start < end_event_end && end_event_start < end) {
                 if (start <= end_event_start && end_event_end <= end) {
                     // Trivial case where it's entirely contained in [start, end]
-                    output[sequence_name] += s.exclusive_durations->at(end_index);
+                    add(s.exclusive_durations->get(end_index));
                 } else {
                     pallas_duration_t capped_duration = pallas_get_duration(
                         std::max(start, end_event_start),
                         std::min(end_event_end, end)
                     );
-                    output[sequence_name] += (s.exclusive_durations->at(end_index) * capped_duration) /
-                            end_event_duration;
+                    add((s.exclusive_durations->get(end_index) * capped_duration) / end_event_duration);
                 }
             }
         }
@@ -843,6 +866,18 @@ std::map<std::string, pallas_duration_t> Thread::getSnapshotViewByName(pallas_ti
     return output;
 }
 
+std::map<std::string, pallas_duration_t> Thread::getSnapshotViewByName(pallas_timestamp_t start, pallas_timestamp_t end, bool approximate) const {
+    std::vector<bool> in_view;
+    auto view = getSnapshotViewByLabel(start, end, approximate, &in_view);
+    auto output = std::map<std::string, pallas_duration_t>();
+    for (uint32_t label_id = 0; label_id < view.size(); label_id++) {
+        if (in_view[label_id]) {
+            output[sequence_labels[label_id]] += view[label_id];
+        }
+    }
+    return output;
+}
+
 Thread::Thread() {
     archive = nullptr;
     id = PALLAS_THREAD_ID_INVALID;
@@ -861,6 +896,9 @@ Thread::Thread() {
     nb_loops = 0;
 
     first_timestamp = PALLAS_TIMESTAMP_INVALID;
+    lazy_index = nullptr;
+    pthread_mutex_init(&label_lock, nullptr);
+    pthread_mutex_init(&statistics_lock, nullptr);
 }
 
 Thread::~Thread() {
@@ -871,6 +909,9 @@ Thread::~Thread() {
     delete[] events;
     delete[] sequences;
     delete[] loops;
+    delete lazy_index;
+    pthread_mutex_destroy(&label_lock);
+    pthread_mutex_destroy(&statistics_lock);
 }
 
 const char* Thread::getName() const {
@@ -885,16 +926,17 @@ String::~String() {
     free(this->str);
 }
 
-std::string Sequence::guessName(const pallas::Thread* thread) const {
-    if (this->tokens.size() == 0) {
+/** Computes the name of a Sequence from its first Event. */
+static std::string _sequence_label(const Sequence* sequence, const Thread* thread) {
+    if (sequence->tokens.size() == 0) {
         return "invalid";
     }
-    Token t_start = this->tokens[0];
+    Token t_start = sequence->tokens[0];
     if (t_start.type == TypeEvent) {
         EventData& data = thread->getEvent(t_start)->data;
         if (data.record == PALLAS_EVENT_ENTER) {
             const char* event_name = thread->getRegionStringFromEvent(&data);
-	          return event_name;
+            return event_name;
         }
         if (data.record == PALLAS_EVENT_THREAD_TEAM_BEGIN || data.record == PALLAS_EVENT_THREAD_BEGIN) {
             return "thread";
@@ -902,11 +944,197 @@ std::string Sequence::guessName(const pallas::Thread* thread) const {
     }
 
     char buff[128];
-    snprintf(buff, sizeof(buff), "Sequence_%d", this->id.id);
+    snprintf(buff, sizeof(buff), "Sequence_%d", sequence->id.id);
 
     return buff;
 }
 
+std::string Sequence::guessName(const pallas::Thread* thread) const {
+    return thread->getLabel(thread->getSequenceLabelId(this->id));
+}
+
+void Thread::buildSequenceLabels() const {
+    // Each Thread has its own lock, so that threads build their labels concurrently.
+    auto* lock = const_cast<pthread_mutex_t*>(&label_lock);
+    pthread_mutex_lock(lock);
+    if (sequence_label_ids.size() == nb_sequences && sequence_labels.size() > 0) {
+        pthread_mutex_unlock(lock);
+        return;
+    }
+    if (nb_sequences > 0 && pallasLoadThreadLabels(const_cast<Thread*>(this))) {
+        pthread_mutex_unlock(lock);
+        return;
+    }
+    loadAll();
+    sequence_labels.clear();
+    sequence_label_ids.resize(nb_sequences);
+    std::unordered_map<std::string, uint32_t> label_index;
+    for (size_t i = 0; i < nb_sequences; i++) {
+        std::string label = _sequence_label(&sequences[i], this);
+        auto [it, inserted] = label_index.try_emplace(label, sequence_labels.size());
+        if (inserted) {
+            sequence_labels.push_back(std::move(label));
+        }
+        sequence_label_ids[i] = it->second;
+    }
+    pthread_mutex_unlock(lock);
+}
+
+uint32_t Thread::getSequenceLabelId(Token sequence) const {
+    buildSequenceLabels();
+    pallas_assert(sequence.id < sequence_id_map.size());
+    uint32_t phys_id = sequence_id_map[sequence.id];
+    pallas_assert(phys_id < sequence_label_ids.size());
+    return sequence_label_ids[phys_id];
+}
+
+const std::string& Thread::getLabel(uint32_t label_id) const {
+    pallas_assert(label_id < sequence_labels.size());
+    return sequence_labels[label_id];
+}
+
+size_t Thread::getLabelCount() const {
+    buildSequenceLabels();
+    return sequence_labels.size();
+}
+
+void Thread::computeStatistics() const {
+    loadAll();
+    sequence_statistics.assign(nb_sequences, DurationStatistics());
+    for (size_t i = 0; i < nb_sequences; i++) {
+        if (sequences[i].durations)
+            sequences[i].durations->for_each_value([&](uint64_t duration) { sequence_statistics[i].add(duration); });
+    }
+    event_statistics.assign(nb_events, DurationStatistics());
+    for (size_t i = 0; i < nb_events; i++) {
+        if (events[i].timestamps == nullptr)
+            continue;
+        pallas_timestamp_t previous = PALLAS_TIMESTAMP_INVALID;
+        events[i].timestamps->for_each_value([&](uint64_t timestamp) {
+            if (previous != PALLAS_TIMESTAMP_INVALID)
+                event_statistics[i].add(timestamp - previous);
+            previous = timestamp;
+        });
+    }
+}
+
+/**
+ * Sets the statistics of a Thread from the ones of its vectors. Its statistics_lock must be held.
+ * @param stored Whether the vectors that were read from a file may take the statistics stored with the Thread.
+ */
+static void _update_statistics(const Thread* thread, bool stored) {
+    thread->loadAll();
+    bool known = true;
+    for (size_t i = 0; i < thread->nb_sequences && known; i++) {
+        auto* durations = thread->sequences[i].durations;
+        known = durations == nullptr || durations->hasStatistics();
+    }
+    for (size_t i = 0; i < thread->nb_events && known; i++) {
+        auto* timestamps = thread->events[i].timestamps;
+        known = timestamps == nullptr || timestamps->hasStatistics();
+    }
+    if (!known && stored
+        && ((thread->sequence_statistics.size() == thread->nb_sequences && thread->event_statistics.size() == thread->nb_events)
+            || pallasLoadThreadStatistics(const_cast<Thread*>(thread)))) {
+        for (size_t i = 0; i < thread->nb_sequences; i++) {
+            auto* durations = thread->sequences[i].durations;
+            if (durations && !durations->hasStatistics() && thread->sequence_statistics[i].count == durations->size)
+                durations->setStatistics(thread->sequence_statistics[i]);
+        }
+        for (size_t i = 0; i < thread->nb_events; i++) {
+            auto* timestamps = thread->events[i].timestamps;
+            if (timestamps && !timestamps->hasStatistics() && thread->event_statistics[i].count == (timestamps->size ? timestamps->size - 1 : 0))
+                timestamps->setStatistics(thread->event_statistics[i]);
+        }
+    }
+    thread->sequence_statistics.assign(thread->nb_sequences, DurationStatistics());
+    for (size_t i = 0; i < thread->nb_sequences; i++) {
+        if (thread->sequences[i].durations)
+            thread->sequence_statistics[i] = thread->sequences[i].durations->getStatistics();
+    }
+    thread->event_statistics.assign(thread->nb_events, DurationStatistics());
+    for (size_t i = 0; i < thread->nb_events; i++) {
+        if (thread->events[i].timestamps)
+            thread->event_statistics[i] = thread->events[i].timestamps->getStatistics();
+    }
+}
+
+void Thread::buildStatistics() const {
+    // Each Thread has its own lock, so that threads build their statistics concurrently.
+    auto* lock = const_cast<pthread_mutex_t*>(&statistics_lock);
+    pthread_mutex_lock(lock);
+    if ((sequence_statistics.size() != nb_sequences || event_statistics.size() != nb_events)
+        && !pallasLoadThreadStatistics(const_cast<Thread*>(this))) {
+        _update_statistics(this, false);
+    }
+    pthread_mutex_unlock(lock);
+}
+
+void Thread::updateStatistics() const {
+    auto* lock = const_cast<pthread_mutex_t*>(&statistics_lock);
+    pthread_mutex_lock(lock);
+    _update_statistics(this, true);
+    pthread_mutex_unlock(lock);
+}
+
+const DurationStatistics& Thread::getSequenceStatistics(Token sequence) const {
+    buildStatistics();
+    pallas_assert(sequence.id < sequence_id_map.size());
+    uint32_t phys_id = sequence_id_map[sequence.id];
+    pallas_assert(phys_id < sequence_statistics.size());
+    return sequence_statistics[phys_id];
+}
+
+const DurationStatistics& Thread::getEventStatistics(Token event) const {
+    buildStatistics();
+    pallas_assert(event.id < event_id_map.size());
+    uint32_t phys_id = event_id_map[event.id];
+    pallas_assert(phys_id < event_statistics.size());
+    return event_statistics[phys_id];
+}
+
+MemoryUsage Thread::getMemoryUsage() const {
+    MemoryUsage usage;
+    usage.bytes[PALLAS_MEMORY_EVENTS] += nb_allocated_events * sizeof(Event);
+    for (size_t i = 0; i < nb_events; i++) {
+        if (events[i].timestamps)
+            usage.bytes[PALLAS_MEMORY_TIMESTAMPS] += events[i].timestamps->memoryUsage();
+        usage.bytes[PALLAS_MEMORY_ATTRIBUTES] += events[i].attribute_buffer_size + events[i].nb_attribute_offsets * sizeof(size_t);
+    }
+
+    usage.bytes[PALLAS_MEMORY_SEQUENCES] += nb_allocated_sequences * sizeof(Sequence);
+    for (size_t i = 0; i < nb_allocated_sequences; i++) {
+        auto& sequence = sequences[i];
+        usage.bytes[PALLAS_MEMORY_SEQUENCES] += vectorMemoryUsage(sequence.tokens) + hashMapMemoryUsage(sequence.tokenCount);
+        if (sequence.timestamps)
+            usage.bytes[PALLAS_MEMORY_TIMESTAMPS] += sequence.timestamps->memoryUsage();
+        if (sequence.durations)
+            usage.bytes[PALLAS_MEMORY_DURATIONS] += sequence.durations->memoryUsage();
+        if (sequence.exclusive_durations)
+            usage.bytes[PALLAS_MEMORY_DURATIONS] += sequence.exclusive_durations->memoryUsage();
+    }
+
+    usage.bytes[PALLAS_MEMORY_LOOPS] += nb_allocated_loops * sizeof(Loop);
+    usage.bytes[PALLAS_MEMORY_ID_MAPS] += vectorMemoryUsage(event_id_map) + vectorMemoryUsage(sequence_id_map) + vectorMemoryUsage(loop_id_map);
+
+    for (const auto* map : {&hashToEvent, &hashToSequence}) {
+        usage.bytes[PALLAS_MEMORY_HASH_MAPS] += hashMapMemoryUsage(*map);
+        for (const auto& [hash, ids] : *map)
+            usage.bytes[PALLAS_MEMORY_HASH_MAPS] += vectorMemoryUsage(ids);
+    }
+
+    usage.bytes[PALLAS_MEMORY_LABELS] += vectorMemoryUsage(sequence_labels) + vectorMemoryUsage(sequence_label_ids);
+    for (const auto& label : sequence_labels)
+        usage.bytes[PALLAS_MEMORY_LABELS] += label.capacity();
+
+    usage.bytes[PALLAS_MEMORY_STATISTICS] += vectorMemoryUsage(sequence_statistics) + vectorMemoryUsage(event_statistics);
+    for (const auto* statistics : {&sequence_statistics, &event_statistics}) {
+        for (const auto& s : *statistics)
+            usage.bytes[PALLAS_MEMORY_STATISTICS] += vectorMemoryUsage(s.sketch_counts);
+    }
+    return usage;
+}
+
 void _sequenceGetTokenCountReading(Sequence* seq, const Thread* thread, TokenCountMap& readerTokenCountMap, TokenCountMap& sequenceTokenCountMap, bool isReversedOrder);
 
 void _loopGetTokenCountReading(const Loop* loop, const Thread* thread, TokenCountMap& sequenceTokenCountMap, bool isReversedOrder) {
@@ -984,6 +1212,22 @@ size_t Sequence::size() const {
     return tokens.size();
 }
 
+/** Returns the index of the first timestamp >= ts, or the size of the vector if there is none. */
+static size_t _first_occurrence_after(LinkedVector* timestamps, pallas_timestamp_t ts) {
+    if (timestamps->size == 0 || timestamps->back() < ts)
+        return timestamps->size;
+    size_t index = timestamps->getFirstOccurrenceBefore(ts);
+    return timestamps->at(index) < ts ? index + 1 : index;
+}
+
+DurationSummary Sequence::summarizeDurations(pallas_timestamp_t start, pallas_timestamp_t end, bool approximate) const {
+    if (durations == nullptr || timestamps == nullptr || end <= start)
+        return DurationSummary();
+    size_t start_index = _first_occurrence_after(timestamps, start);
+    size_t end_index = _first_occurrence_after(timestamps, end);
+    return durations->summarize(start_index, end_index, approximate);
+}
+
 Sequence::~Sequence() {
     delete durations;
     delete exclusive_durations;
@@ -1053,6 +1297,22 @@ pallas::Loop* pallas_get_loop(pallas::Thread* thread, pallas::Token id) {
     return thread->getLoop(id);
 }
 
+pallas_duration_t get_duration(pallas::Thread* t) {
+    return t->getDuration();
+}
+
+pallas_timestamp_t get_first_timestamp(pallas::Thread* t) {
+    return t->getFirstTimestamp();
+}
+
+pallas_timestamp_t get_last_timestamp(pallas::Thread* t) {
+    return t->getLastTimestamp();
+}
+
+size_t get_event_count(pallas::Thread* t) {
+    return t->getEventCount();
+}
+
 pallas::Sequence* pallas_get_sequence(pallas::Thread* thread, pallas::Token id) {
     return thread->getSequence(id);
 }
@@ -9,6 +9,7 @@
 
 #include "pallas/utils/pallas_dbg.h"
 #include "pallas/utils/pallas_log.h"
+#include "pallas/utils/pallas_parallel.h"
 
 namespace pallas {
 /**
@@ -16,10 +17,7 @@ namespace pallas {
  * @returns First String matching the given pallas::StringRef, nullptr if it doesn't have a match.
  */
 const String* Definition::getString(StringRef string_ref) const {
-  if (strings.count(string_ref) > 0)
-    return &strings.at(string_ref);
-  else
-    return nullptr;
+  return strings.get(string_ref);
 }
 
 /**
@@ -44,10 +42,7 @@ void Definition::addString(StringRef string_ref, const char* string) {
  * @returns First Region matching the given pallas::RegionRef, nullptr if it doesn't have a match.
  */
 const Region* Definition::getRegion(RegionRef region_ref) const {
-  if (regions.count(region_ref) > 0)
-    return &regions.at(region_ref);
-  else
-    return nullptr;
+  return regions.get(region_ref);
 }
 
 /**
@@ -70,9 +65,7 @@ void Definition::addRegion(RegionRef region_ref, StringRef string_ref) {
  * @returns First Attribute matching the given pallas::AttributeRef, nullptr if it doesn't have a match.
  */
 const Attribute* Definition::getAttribute(AttributeRef attribute_ref) const {
-  if (attributes.count(attribute_ref) > 0)
-    return &attributes.at(attribute_ref);
-  return nullptr;
+  return attributes.get(attribute_ref);
 }
 
 /**
@@ -96,10 +89,7 @@ void Definition::addAttribute(AttributeRef attribute_ref, StringRef name_ref, St
  * @returns First Group matching the given pallas::GroupRef, nullptr if it doesn't have a match.
  */
 const Group* Definition::getGroup(GroupRef group_ref) const {
-  if (groups.count(group_ref) > 0)
-    return &groups.at(group_ref);
-  else
-    return nullptr;
+  return groups.get(group_ref);
 }
 
 /**
@@ -134,10 +124,7 @@ void Definition::addGroup(GroupRef group_ref,
  * @returns First Comm matching the given pallas::CommRef, nullptr if it doesn't have a match.
  */
 const Comm* Definition::getComm(CommRef comm_ref) const {
-  if (comms.count(comm_ref) > 0)
-    return &comms.at(comm_ref);
-  else
-    return nullptr;
+  return comms.get(comm_ref);
 }
 
 /**
@@ -157,6 +144,17 @@ void Definition::addComm(CommRef comm_ref, StringRef name, GroupRef group, CommR
   pallas_log(DebugLevel::Verbose, "Register comm #%zu{.ref=%d, .str=%d, .group=%d, .parent=%d}\n", comms.size() - 1, c.comm_ref, c.name, c.group, c.parent);
 }
 
+size_t Definition::getMemoryUsage() const {
+  size_t bytes = strings.memoryUsage() + regions.memoryUsage() + attributes.memoryUsage() + groups.memoryUsage() + comms.memoryUsage();
+  for (const auto& [ref, string] : strings) {
+    bytes += string.length + 1;
+  }
+  for (const auto& [ref, group] : groups) {
+    bytes += group.numberOfMembers * sizeof(*group.members);
+  }
+  return bytes;
+}
+
 char* pallas_global_archive_fullpath(char* dir_name, char* trace_name) {
   int len = strlen(dir_name) + strlen(trace_name) + 2;
   char* fullpath = new char[len];
@@ -278,7 +276,53 @@ std::vector<Thread*> GlobalArchive::getThreadList() {
   return output;
 }
 
+std::vector<Thread*> GlobalArchive::getThreadList(size_t nb_workers) {
+    // Archives are loaded first, since loading them modifies archive_list.
+    std::vector<std::pair<Archive*, ThreadId>> to_load;
+    for (auto& lg : location_groups) {
+        auto a = getArchive(lg.id);
+        for (const auto& l : a->locations) {
+            to_load.emplace_back(a, l.id);
+        }
+    }
+    std::vector<Thread*> output(to_load.size());
+    parallelFor(to_load.size(), nb_workers, [&](size_t i) {
+        output[i] = to_load[i].first->getThread(to_load[i].second);
+    });
+    return output;
+}
 
+std::map<std::string, pallas_duration_t> GlobalArchive::getSnapshotViewByName(pallas_timestamp_t start, pallas_timestamp_t end, size_t nb_workers, bool approximate) {
+    auto threads = getThreadList(nb_workers);
+    std::vector<std::vector<pallas_duration_t>> views(threads.size());
+    std::vector<std::vector<bool>> in_views(threads.size());
+    parallelFor(threads.size(), nb_workers, [&](size_t i) {
+        if (threads[i] != nullptr) {
+            views[i] = threads[i]->getSnapshotViewByLabel(start, end, approximate, &in_views[i]);
+        }
+    });
+
+    // Labels are only converted to strings once per Thread.
+    std::map<std::string, pallas_duration_t> output;
+    for (size_t i = 0; i < threads.size(); i++) {
+        for (uint32_t label_id = 0; label_id < views[i].size(); label_id++) {
+            if (in_views[i][label_id]) {
+                output[threads[i]->getLabel(label_id)] += views[i][label_id];
+            }
+        }
+    }
+    return output;
+}
+
+MemoryUsage GlobalArchive::getMemoryUsage() const {
+  MemoryUsage usage;
+  usage.bytes[PALLAS_MEMORY_DEFINITIONS] += definitions.getMemoryUsage() + vectorMemoryUsage(locations) + vectorMemoryUsage(location_groups);
+  for (int i = 0; i < nb_archives; i++) {
+    if (archive_list[i])
+      usage += archive_list[i]->getMemoryUsage();
+  }
+  return usage;
+}
 
 Archive* GlobalArchive::getArchiveFromLocation(ThreadId location_id) const {
   for (int i = 0; i < nb_archives; i++) {
@@ -355,6 +399,16 @@ Archive::~Archive() {
   delete[] threads;
 }
 
+MemoryUsage Archive::getMemoryUsage() const {
+  MemoryUsage usage;
+  usage.bytes[PALLAS_MEMORY_DEFINITIONS] += definitions.getMemoryUsage() + vectorMemoryUsage(locations) + vectorMemoryUsage(location_groups);
+  for (size_t i = 0; i < nb_threads; i++) {
+    if (threads[i])
+      usage += threads[i]->getMemoryUsage();
+  }
+  return usage;
+}
+
 Archive::Archive(GlobalArchive& global_archive, LocationGroupId archive_id) : Archive(global_archive.dir_name, archive_id) {
   this->global_archive = &global_archive;
 }
@@ -3,6 +3,7 @@
  * See LICENSE in top-level directory.
  */
 
+#include <algorithm>
 #include <cinttypes>
 
 #include "pallas/pallas.h"
@@ -258,6 +259,49 @@ void Thread::printAttributeList(const AttributeList* attribute_list) const {
 void Thread::printEventAttribute(const struct EventOccurrence* e) const {
   printAttributeList(e->attributes);
 }
+
+void Event::indexAttributes() {
+  clearAttributeIndex();
+  if (attribute_buffer == nullptr)
+    return;
+  int max_index = -1;
+  for (size_t pos = 0; pos + ATTRIBUTE_LIST_HEADER_SIZE <= attribute_pos;) {
+    auto* l = reinterpret_cast<AttributeList*>(&attribute_buffer[pos]);
+    if (l->struct_size == 0)
+      break;
+    max_index = std::max(max_index, l->index);
+    pos += l->struct_size;
+  }
+  if (max_index < 0)
+    return;
+  nb_attribute_offsets = max_index + 1;
+  attribute_offsets = new size_t[nb_attribute_offsets];
+  std::fill_n(attribute_offsets, nb_attribute_offsets, PALLAS_ATTRIBUTE_NO_OFFSET);
+  for (size_t pos = 0; pos + ATTRIBUTE_LIST_HEADER_SIZE <= attribute_pos;) {
+    auto* l = reinterpret_cast<AttributeList*>(&attribute_buffer[pos]);
+    if (l->struct_size == 0)
+      break;
+    if (l->index >= 0)
+      attribute_offsets[l->index] = pos;
+    pos += l->struct_size;
+  }
+}
+
+AttributeList* Event::getAttributeList(size_t occurrence_index) {
+  if (attribute_buffer == nullptr)
+    return nullptr;
+  if (attribute_offsets == nullptr)
+    indexAttributes();
+  if (occurrence_index >= nb_attribute_offsets || attribute_offsets[occurrence_index] == PALLAS_ATTRIBUTE_NO_OFFSET)
+    return nullptr;
+  return reinterpret_cast<AttributeList*>(&attribute_buffer[attribute_offsets[occurrence_index]]);
+}
+
+void Event::clearAttributeIndex() {
+  delete[] attribute_offsets;
+  attribute_offsets = nullptr;
+  nb_attribute_offsets = 0;
+}
 }  // namespace pallas
 
 void pallas_attribute_list_push_data(pallas::AttributeList * l, pallas::AttributeData * data) {
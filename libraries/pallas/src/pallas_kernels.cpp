@@ -0,0 +1,367 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "pallas/utils/pallas_dbg.h"
+#include "pallas/utils/pallas_kernels.h"
+#include "pallas/utils/pallas_log.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PALLAS_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace pallas {
+
+/** Highest histogram bin. */
+static constexpr double MAX_BIN = 255.;
+
+/* Scalar kernels. They are the reference that the other ones must match. */
+
+static ValueStatistics computeValueStatisticsScalar(const uint64_t* values, size_t n) {
+    ValueStatistics statistics;
+    for (size_t i = 0; i < n; i++) {
+        statistics.min = std::min(statistics.min, values[i]);
+        statistics.max = std::max(statistics.max, values[i]);
+        statistics.sum += values[i];
+    }
+    return statistics;
+}
+
+static inline uint8_t histogramBin(uint64_t value, uint64_t min, double step) {
+    double bin = static_cast<double>(value - min) / step;
+    return bin > MAX_BIN ? 255 : static_cast<uint8_t>(bin);
+}
+
+static void computeHistogramBinsScalar(const uint64_t* values, size_t n, uint64_t min, double step, uint8_t* bins) {
+    for (size_t i = 0; i < n; i++)
+        bins[i] = histogramBin(values[i], min, step);
+}
+
+static size_t lowerBoundScalar(const uint64_t* values, size_t n, uint64_t value) {
+    return std::lower_bound(values, values + n, value) - values;
+}
+
+/** Tables of the slicing-by-8 CRC32C: table[k][b] is the CRC of byte b followed by k zero bytes. */
+struct Crc32cTables {
+    uint32_t table[8][256];
+    Crc32cTables() {
+        // Reversed Castagnoli polynomial.
+        const uint32_t polynomial = 0x82F63B78;
+        for (uint32_t b = 0; b < 256; b++) {
+            uint32_t crc = b;
+            for (int bit = 0; bit < 8; bit++)
+                crc = (crc >> 1) ^ (crc & 1 ? polynomial : 0);
+            table[0][b] = crc;
+        }
+        for (uint32_t b = 0; b < 256; b++) {
+            for (int k = 1; k < 8; k++)
+                table[k][b] = (table[k - 1][b] >> 8) ^ table[0][table[k - 1][b] & 0xFF];
+        }
+    }
+};
+
+static uint32_t crc32cScalar(const void* data, size_t size, uint32_t crc) {
+    static const Crc32cTables tables;
+    const auto& table = tables.table;
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (; size >= 8; size -= 8, bytes += 8) {
+        uint64_t word;
+        memcpy(&word, bytes, sizeof(word));
+        word ^= crc;
+        crc = table[7][word & 0xFF] ^ table[6][(word >> 8) & 0xFF] ^ table[5][(word >> 16) & 0xFF] ^
+              table[4][(word >> 24) & 0xFF] ^ table[3][(word >> 32) & 0xFF] ^ table[2][(word >> 40) & 0xFF] ^
+              table[1][(word >> 48) & 0xFF] ^ table[0][word >> 56];
+    }
+    for (; size > 0; size--, bytes++)
+        crc = (crc >> 8) ^ table[0][(crc ^ *bytes) & 0xFF];
+    return ~crc;
+}
+
+/**
+ * Narrows the range where the lower bound of value is by dichotomy, until it holds at most block_size values,
+ * which are then compared all at once.
+ * @param n Number of values. Set to the size of the range.
+ * @returns The index of the range.
+ */
+static inline size_t narrowLowerBound(const uint64_t* values, size_t& n, uint64_t value, size_t block_size) {
+    size_t base = 0;
+    while (n > block_size) {
+        size_t half = n / 2;
+        if (values[base + half - 1] < value) {
+            base += half;
+            n -= half;
+        } else {
+            n = half;
+        }
+    }
+    return base;
+}
+
+#ifdef PALLAS_X86_KERNELS
+/* AVX2 kernels. AVX2 only compares signed 64-bit integers: the values are biased by flipping their highest bit. */
+
+static const uint64_t SIGN_BIT = UINT64_C(1) << 63;
+
+__attribute__((target("avx2"))) static ValueStatistics computeValueStatisticsAVX2(const uint64_t* values, size_t n) {
+    const __m256i bias = _mm256_set1_epi64x(SIGN_BIT);
+    // Two sets of accumulators, so that consecutive iterations don't depend on each other.
+    __m256i min[2] = {_mm256_set1_epi64x(INT64_MAX), _mm256_set1_epi64x(INT64_MAX)};
+    __m256i max[2] = {_mm256_set1_epi64x(INT64_MIN), _mm256_set1_epi64x(INT64_MIN)};
+    __m256i sum[2] = {_mm256_setzero_si256(), _mm256_setzero_si256()};
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        for (int k = 0; k < 2; k++) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&values[i + 4 * k]));
+            __m256i biased = _mm256_xor_si256(v, bias);
+            min[k] = _mm256_blendv_epi8(min[k], biased, _mm256_cmpgt_epi64(min[k], biased));
+            max[k] = _mm256_blendv_epi8(max[k], biased, _mm256_cmpgt_epi64(biased, max[k]));
+            sum[k] = _mm256_add_epi64(sum[k], v);
+        }
+    }
+    uint64_t lanes[3][2][4];
+    for (int k = 0; k < 2; k++) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes[0][k]), min[k]);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes[1][k]), max[k]);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes[2][k]), sum[k]);
+    }
+    ValueStatistics statistics = computeValueStatisticsScalar(&values[i], n - i);
+    for (int k = 0; k < 2; k++) {
+        for (int lane = 0; lane < 4; lane++) {
+            statistics.min = std::min(statistics.min, lanes[0][k][lane] ^ SIGN_BIT);
+            statistics.max = std::max(statistics.max, lanes[1][k][lane] ^ SIGN_BIT);
+            statistics.sum += lanes[2][k][lane];
+        }
+    }
+    return statistics;
+}
+
+__attribute__((target("avx2"))) static void computeHistogramBinsAVX2(const uint64_t* values, size_t n, uint64_t min, double step, uint8_t* bins) {
+    const __m256i vmin = _mm256_set1_epi64x(min);
+    // A difference below 2^52 is converted exactly by using it as the mantissa of 2^52, then subtracting 2^52.
+    const __m256d two_52 = _mm256_set1_pd(4503599627370496.);
+    const __m256i exponent = _mm256_castpd_si256(two_52);
+    const __m256i high_bits = _mm256_set1_epi64x(~((INT64_C(1) << 52) - 1));
+    const __m256d vstep = _mm256_set1_pd(step);
+    const __m256d max_bin = _mm256_set1_pd(MAX_BIN);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i diff = _mm256_sub_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&values[i])), vmin);
+        if (!_mm256_testz_si256(diff, high_bits)) {
+            // The conversion of these differences rounds them, so they are binned like the scalar kernel does.
+            computeHistogramBinsScalar(&values[i], 4, min, step, &bins[i]);
+            continue;
+        }
+        __m256d converted = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(diff, exponent)), two_52);
+        __m256d bin = _mm256_min_pd(_mm256_div_pd(converted, vstep), max_bin);
+        __m128i bin32 = _mm256_cvttpd_epi32(bin);
+        __m128i bin8 = _mm_packus_epi16(_mm_packus_epi32(bin32, bin32), _mm_setzero_si128());
+        uint32_t packed = _mm_cvtsi128_si32(bin8);
+        memcpy(&bins[i], &packed, sizeof(packed));
+    }
+    computeHistogramBinsScalar(&values[i], n - i, min, step, &bins[i]);
+}
+
+__attribute__((target("avx2"))) static size_t lowerBoundAVX2(const uint64_t* values, size_t n, uint64_t value) {
+    size_t base = narrowLowerBound(values, n, value, 32);
+    const __m256i bias = _mm256_set1_epi64x(SIGN_BIT);
+    const __m256i target = _mm256_set1_epi64x(value ^ SIGN_BIT);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&values[base + i])), bias);
+        count += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(target, v))));
+    }
+    for (; i < n; i++)
+        count += values[base + i] < value;
+    return base + count;
+}
+
+/* Every CPU with AVX2 has SSE4.2, so the AVX2 and AVX-512 kernels compute the CRC32C with its instruction. */
+__attribute__((target("sse4.2"))) static uint32_t crc32cSSE42(const void* data, size_t size, uint32_t crc) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    uint64_t crc64 = ~crc;
+    for (; size >= 8; size -= 8, bytes += 8) {
+        uint64_t word;
+        memcpy(&word, bytes, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    uint32_t crc32 = crc64;
+    for (; size > 0; size--, bytes++)
+        crc32 = _mm_crc32_u8(crc32, *bytes);
+    return ~crc32;
+}
+
+/* AVX-512 kernels. The last values are handled with masks. */
+
+__attribute__((target("avx512f,avx512dq"))) static ValueStatistics computeValueStatisticsAVX512(const uint64_t* values, size_t n) {
+    __m512i min[2] = {_mm512_set1_epi64(-1), _mm512_set1_epi64(-1)};
+    __m512i max[2] = {_mm512_setzero_si512(), _mm512_setzero_si512()};
+    __m512i sum[2] = {_mm512_setzero_si512(), _mm512_setzero_si512()};
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        for (int k = 0; k < 2; k++) {
+            __m512i v = _mm512_loadu_si512(&values[i + 8 * k]);
+            min[k] = _mm512_min_epu64(min[k], v);
+            max[k] = _mm512_max_epu64(max[k], v);
+            sum[k] = _mm512_add_epi64(sum[k], v);
+        }
+    }
+    for (; i < n; i += 8) {
+        __mmask8 mask = n - i >= 8 ? 0xFF : (1u << (n - i)) - 1;
+        __m512i v = _mm512_maskz_loadu_epi64(mask, &values[i]);
+        min[0] = _mm512_mask_min_epu64(min[0], mask, min[0], v);
+        max[0] = _mm512_max_epu64(max[0], v);
+        sum[0] = _mm512_add_epi64(sum[0], v);
+    }
+    ValueStatistics statistics;
+    statistics.min = _mm512_reduce_min_epu64(_mm512_min_epu64(min[0], min[1]));
+    statistics.max = _mm512_reduce_max_epu64(_mm512_max_epu64(max[0], max[1]));
+    statistics.sum = _mm512_reduce_add_epi64(_mm512_add_epi64(sum[0], sum[1]));
+    return statistics;
+}
+
+__attribute__((target("avx512f,avx512dq"))) static void computeHistogramBinsAVX512(const uint64_t* values, size_t n, uint64_t min, double step, uint8_t* bins) {
+    const __m512i vmin = _mm512_set1_epi64(min);
+    const __m512d vstep = _mm512_set1_pd(step);
+    const __m512d max_bin = _mm512_set1_pd(MAX_BIN);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i bin32[2];
+        for (int k = 0; k < 2; k++) {
+            __m512i diff = _mm512_sub_epi64(_mm512_loadu_si512(&values[i + 8 * k]), vmin);
+            __m512d bin = _mm512_min_pd(_mm512_div_pd(_mm512_cvtepu64_pd(diff), vstep), max_bin);
+            bin32[k] = _mm512_cvttpd_epi32(bin);
+        }
+        __m512i bin = _mm512_inserti64x4(_mm512_castsi256_si512(bin32[0]), bin32[1], 1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&bins[i]), _mm512_cvtepi32_epi8(bin));
+    }
+    computeHistogramBinsScalar(&values[i], n - i, min, step, &bins[i]);
+}
+
+__attribute__((target("avx512f,avx512dq"))) static size_t lowerBoundAVX512(const uint64_t* values, size_t n, uint64_t value) {
+    size_t base = narrowLowerBound(values, n, value, 64);
+    const __m512i target = _mm512_set1_epi64(value);
+    size_t count = 0;
+    for (size_t i = 0; i < n; i += 8) {
+        __mmask8 mask = n - i >= 8 ? 0xFF : (1u << (n - i)) - 1;
+        __m512i v = _mm512_maskz_loadu_epi64(mask, &values[base + i]);
+        count += __builtin_popcount(_mm512_mask_cmplt_epu64_mask(mask, v, target));
+    }
+    return base + count;
+}
+#endif
+
+/** Kernels of an instruction set. */
+struct Kernels {
+    KernelISA isa;
+    ValueStatistics (*computeValueStatistics)(const uint64_t* values, size_t n);
+    void (*computeHistogramBins)(const uint64_t* values, size_t n, uint64_t min, double step, uint8_t* bins);
+    size_t (*lowerBound)(const uint64_t* values, size_t n, uint64_t value);
+    uint32_t (*crc32c)(const void* data, size_t size, uint32_t crc);
+};
+
+static const Kernels scalarKernels{KernelISA::Scalar, computeValueStatisticsScalar, computeHistogramBinsScalar, lowerBoundScalar, crc32cScalar};
+#ifdef PALLAS_X86_KERNELS
+static const Kernels avx2Kernels{KernelISA::AVX2, computeValueStatisticsAVX2, computeHistogramBinsAVX2, lowerBoundAVX2, crc32cSSE42};
+static const Kernels avx512Kernels{KernelISA::AVX512, computeValueStatisticsAVX512, computeHistogramBinsAVX512, lowerBoundAVX512, crc32cSSE42};
+#endif
+
+const char* toString(KernelISA isa) {
+    switch (isa) {
+    case KernelISA::Scalar:
+        return "scalar";
+    case KernelISA::AVX2:
+        return "avx2";
+    case KernelISA::AVX512:
+        return "avx512";
+    default:
+        return "invalid";
+    }
+}
+
+bool isKernelISASupported(KernelISA isa) {
+    switch (isa) {
+    case KernelISA::Scalar:
+        return true;
+#ifdef PALLAS_X86_KERNELS
+    case KernelISA::AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("sse4.2");
+    case KernelISA::AVX512:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("sse4.2");
+#endif
+    default:
+        return false;
+    }
+}
+
+static const Kernels& getKernels(KernelISA isa) {
+    switch (isa) {
+#ifdef PALLAS_X86_KERNELS
+    case KernelISA::AVX2:
+        return avx2Kernels;
+    case KernelISA::AVX512:
+        return avx512Kernels;
+#endif
+    default:
+        return scalarKernels;
+    }
+}
+
+/** Returns the kernels that are used, the ones of the best supported instruction set by default. */
+static const Kernels*& activeKernels() {
+    static const Kernels* kernels = [] {
+        for (auto isa : {KernelISA::AVX512, KernelISA::AVX2}) {
+            if (isKernelISASupported(isa)) {
+                pallas_log(DebugLevel::Debug, "Using the %s kernels\n", toString(isa));
+                return &getKernels(isa);
+            }
+        }
+        return &scalarKernels;
+    }();
+    return kernels;
+}
+
+KernelISA getKernelISA() {
+    return activeKernels()->isa;
+}
+
+void setKernelISA(KernelISA isa) {
+    if (!isKernelISASupported(isa)) {
+        pallas_error("The %s kernels aren't supported\n", toString(isa));
+    }
+    activeKernels() = &getKernels(isa);
+}
+
+ValueStatistics computeValueStatistics(const uint64_t* values, size_t n) {
+    return activeKernels()->computeValueStatistics(values, n);
+}
+
+void computeHistogramBins(const uint64_t* values, size_t n, uint64_t min, double step, uint8_t* bins) {
+    activeKernels()->computeHistogramBins(values, n, min, step, bins);
+}
+
+size_t lowerBound(const uint64_t* values, size_t n, uint64_t value) {
+    return activeKernels()->lowerBound(values, n, value);
+}
+
+uint32_t crc32c(const void* data, size_t size, uint32_t crc) {
+    return activeKernels()->crc32c(data, size, crc);
+}
+
+}  // namespace pallas
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
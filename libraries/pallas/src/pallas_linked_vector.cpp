@@ -4,18 +4,75 @@
  */
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <deque>
 #include <iostream>
 #include <sstream>
+#include <unordered_map>
 
 #include "pallas/utils/pallas_dbg.h"
+#include "pallas/utils/pallas_kernels.h"
 #include "pallas/utils/pallas_linked_vector.h"
 #include "pallas/utils/pallas_log.h"
 
 #define SAME_FOR_BOTH_VECTORS(return_type, function_core) return_type LinkedVector::function_core return_type LinkedDurationVector::function_core
 
+/** (array, number of elements) of each subvector. */
+using SubArrayDataList = std::vector<std::pair<uint64_t*, size_t>>;
+
 namespace pallas {
 
+/** Number of pins of an array given out by pin_data, and whether its SubArray released it meanwhile. */
+struct PinnedArray {
+    size_t nb_pins = 0;
+    bool released = false;
+};
+/** The arrays that are pinned. Protected by ParameterHandler::storage_lock. */
+static std::unordered_map<uint64_t*, PinnedArray> pinned_arrays;
+/** Size of #pinned_arrays, so that the SubArrays are released without the lock when nothing is pinned. */
+static std::atomic<size_t> nb_pinned_arrays{0};
+
+void releaseSubArrayData(uint64_t* array) {
+    if (array == nullptr)
+        return;
+    if (nb_pinned_arrays.load(std::memory_order_acquire) > 0) {
+        std::lock_guard lock(ParameterHandler::storage_lock);
+        auto it = pinned_arrays.find(array);
+        if (it != pinned_arrays.end()) {
+            it->second.released = true;
+            return;
+        }
+    }
+    delete[] array;
+}
+
+/** Pins an array, so that it is not freed when its SubArray is unloaded. storage_lock must be held. */
+static void pinArray(uint64_t* array) {
+    auto& pinned = pinned_arrays[array];
+    if (pinned.nb_pins++ == 0)
+        nb_pinned_arrays.fetch_add(1, std::memory_order_release);
+}
+
+/** Unpins an array, and frees it if its SubArray released it meanwhile. storage_lock must be held. */
+static void unpinArray(uint64_t* array) {
+    auto it = pinned_arrays.find(array);
+    pallas_assert(it != pinned_arrays.end());
+    if (--it->second.nb_pins > 0)
+        return;
+    if (it->second.released)
+        delete[] array;
+    pinned_arrays.erase(it);
+    nb_pinned_arrays.fetch_sub(1, std::memory_order_release);
+}
+
+void unpinSubArrayData(const SubArrayDataList& data) {
+    std::lock_guard lock(ParameterHandler::storage_lock);
+    for (auto& [array, size] : data) {
+        unpinArray(array);
+    }
+}
+
 std::string LinkedVector::to_string() {
     if (size == 0)
         return "[ ]";
@@ -61,6 +118,121 @@ LinkedDurationVector::LinkedDurationVector(ParameterHandler& p ) : parameter_han
     last = first;
 }
 
+uint64_t LinkedVector::first_value() const {
+    return first->array ? first->array[0] : first->first_value;
+}
+
+uint64_t LinkedVector::last_value() const {
+    return last->array ? last->array[last->size - 1] : last->last_value;
+}
+
+LinkedVector::LinkedVector(ParameterHandler& p, const std::vector<LinkedVector*>& parts) : parameter_handler(p) {
+    first = nullptr;
+    last = nullptr;
+    n_sub_array = 0;
+    // The statistics are known as long as the ones of all the previous parts are.
+    bool known_statistics = true;
+    for (auto* part : parts) {
+        if (known_statistics && part && part->size) {
+            known_statistics = part->hasStatistics();
+            if (known_statistics) {
+                if (!statistics)
+                    statistics = std::make_unique<DurationStatistics>();
+                if (statistics_size > 0)
+                    statistics->add(part->first_value() - statistics_last_value);
+                statistics->merge(part->getStatistics());
+                statistics_size += part->size;
+                statistics_last_value = part->last_value();
+            }
+        }
+        for (auto* sub = part && part->size ? part->first : nullptr; sub != nullptr; sub = sub->next) {
+            auto* copy = new SubArray(*sub);
+            copy->array = nullptr;
+            copy->next = nullptr;
+            copy->previous = last;
+            copy->allocated = 0;
+            copy->starting_index = size;
+            copy->source = sub->source ? sub->source : part;
+            if (sub->source == nullptr && part->filePath == nullptr) {
+                // Never written to a file: keep our own copy of the data.
+                copy->array = new uint64_t[sub->size];
+                sub->copy_to_array(copy->array);
+                copy->first_value = sub->array[0];
+                copy->last_value = sub->array[sub->size - 1];
+                copy->source = nullptr;
+            }
+            if (last) {
+                last->next = copy;
+            } else {
+                first = copy;
+            }
+            last = copy;
+            size += copy->size;
+            n_sub_array++;
+        }
+    }
+    if (first == nullptr) {
+        first = new SubArray(DEFAULT_VECTOR_SIZE);
+        last = first;
+        n_sub_array = 1;
+    }
+}
+
+LinkedDurationVector::LinkedDurationVector(ParameterHandler& p, const std::vector<LinkedDurationVector*>& parts) : parameter_handler(p) {
+    first = nullptr;
+    last = nullptr;
+    n_sub_array = 0;
+    double sum = 0;
+    // The statistics are known as long as the ones of all the previous parts are.
+    bool known_statistics = true;
+    for (auto* part : parts) {
+        if (part == nullptr || part->size == 0)
+            continue;
+        min = std::min(min, part->min);
+        max = std::max(max, part->max);
+        sum += static_cast<double>(part->mean) * part->size;
+        if (known_statistics) {
+            known_statistics = part->hasStatistics();
+            if (known_statistics) {
+                if (!statistics)
+                    statistics = std::make_unique<DurationStatistics>();
+                statistics->merge(part->getStatistics());
+                statistics_size += part->size;
+            }
+        }
+        for (auto* sub = part->first; sub != nullptr; sub = sub->next) {
+            auto* copy = new SubArray(*sub);
+            copy->array = nullptr;
+            copy->next = nullptr;
+            copy->previous = last;
+            copy->allocated = 0;
+            copy->starting_index = size;
+            copy->source = sub->source ? sub->source : part;
+            if (sub->source == nullptr && part->filePath == nullptr) {
+                copy->array = new uint64_t[sub->size];
+                sub->copy_to_array(copy->array);
+                copy->source = nullptr;
+            }
+            if (last) {
+                last->next = copy;
+            } else {
+                first = copy;
+            }
+            last = copy;
+            size += copy->size;
+            n_sub_array++;
+        }
+    }
+    if (first == nullptr) {
+        first = new SubArray(DEFAULT_VECTOR_SIZE);
+        last = first;
+        n_sub_array = 1;
+        return;
+    }
+    mean = static_cast<uint64_t>(sum / size);
+    mean = std::clamp(mean, min, max);
+}
+
 uint64_t* LinkedVector::SubArray::add(uint64_t val) {
     array[size] = val;
     return &array[size++];
@@ -68,7 +240,6 @@ uint64_t* LinkedVector::SubArray::add(uint64_t val) {
 
 uint64_t* LinkedDurationVector::SubArray::add(uint64_t val) {
     array[size++] = val;
-    update_statistics();
     return &array[size-1];
 }
 
@@ -106,10 +277,21 @@ LinkedDurationVector::SubArray::SubArray(size_t size, LinkedDurationVector::SubA
 }
 
 
-SAME_FOR_BOTH_VECTORS(, SubArray::~SubArray() { delete[] array; })
+SAME_FOR_BOTH_VECTORS(, SubArray::~SubArray() { releaseSubArrayData(array); })
 
 SAME_FOR_BOTH_VECTORS(void, SubArray::copy_to_array(uint64_t* given_array) const { memcpy(given_array, array, size * sizeof(uint64_t)); })
 
+SAME_FOR_BOTH_VECTORS(size_t, memoryUsage() const {
+    size_t bytes = sizeof(*this) + loaded_subarrays.size() * 4 * sizeof(void*);
+    for (auto* sub = first; sub != nullptr; sub = sub->next) {
+        bytes += sizeof(*sub);
+        // SubArrays read from a file have no allocated size: their array holds exactly their values.
+        if (sub->array)
+            bytes += std::max(sub->allocated, sub->size) * sizeof(uint64_t);
+    }
+    return bytes;
+})
+
 void LinkedDurationVector::update_statistics() {
     auto& val = at(size - 1);
     max = std::max(max, val);
@@ -125,15 +307,14 @@ void LinkedDurationVector::final_update_mean() {
 }
 
 
-void LinkedDurationVector::SubArray::update_statistics() {
-    auto& val = at(size - 1 + starting_index);
-        max = std::max(max, val);
-        min = std::min(min, val);
-        mean += val;
-}
-
 void LinkedDurationVector::SubArray::final_update_mean() {
-    mean /= size;
+    // The statistics of a SubArray that isn't loaded were read with it.
+    if (array == nullptr || size == 0)
+        return;
+    auto statistics = computeValueStatistics(array, size);
+    min = statistics.min;
+    max = statistics.max;
+    mean = statistics.sum / size;
     pallas_assert_inferior_equal(mean, max);
     pallas_assert_inferior_equal(min, mean);
 }
@@ -141,6 +322,9 @@ void LinkedDurationVector::SubArray::final_update_mean() {
 uint64_t* LinkedDurationVector::add(uint64_t val) {
     if (this->last->size >= this->last->allocated) {
         last->final_update_mean();
+        account_statistics(last);
+        if (spill)
+            spill_data(last);
         last = new SubArray(DEFAULT_VECTOR_SIZE, last);
         n_sub_array++;
     }
@@ -152,6 +336,9 @@ uint64_t* LinkedDurationVector::add(uint64_t val) {
 
 uint64_t* LinkedVector::add(uint64_t val) {
     if (this->last->size >= this->last->allocated) {
+        account_statistics(last);
+        if (spill)
+            spill_data(last);
         last = new SubArray(DEFAULT_VECTOR_SIZE, last);
         n_sub_array++;
     }
@@ -159,15 +346,110 @@ uint64_t* LinkedVector::add(uint64_t val) {
     return last->add(val);
 }
 
+void LinkedVector::account_statistics(const SubArray* sub) {
+    if (!keep_statistics || sub->starting_index != statistics_size || sub->array == nullptr)
+        return;
+    if (!statistics)
+        statistics = std::make_unique<DurationStatistics>();
+    for (size_t i = 0; i < sub->size; i++) {
+        if (statistics_size > 0)
+            statistics->add(sub->array[i] - statistics_last_value);
+        statistics_last_value = sub->array[i];
+        statistics_size++;
+    }
+}
+
+void LinkedDurationVector::account_statistics(const SubArray* sub) {
+    if (!keep_statistics || sub->starting_index != statistics_size || sub->array == nullptr)
+        return;
+    if (!statistics)
+        statistics = std::make_unique<DurationStatistics>();
+    for (size_t i = 0; i < sub->size; i++)
+        statistics->add(sub->array[i]);
+    statistics_size += sub->size;
+}
+
+DurationStatistics LinkedVector::getStatistics() const {
+    DurationStatistics result = statistics ? *statistics : DurationStatistics();
+    uint64_t previous = statistics_last_value;
+    size_t position = statistics_size;
+    for (auto* sub = first; sub != nullptr && position < size; sub = sub->next) {
+        if (sub->starting_index + sub->size <= position)
+            continue;
+        uint64_t* array = sub->array ? sub->array : read_data(sub);
+        for (size_t i = position - sub->starting_index; i < sub->size; i++, position++) {
+            if (position > 0)
+                result.add(array[i] - previous);
+            previous = array[i];
+        }
+        if (array != sub->array)
+            delete[] array;
+    }
+    return result;
+}
+
+DurationStatistics LinkedDurationVector::getStatistics() const {
+    DurationStatistics result = statistics ? *statistics : DurationStatistics();
+    for (auto* sub = first; sub != nullptr && statistics_size < size; sub = sub->next) {
+        if (sub->starting_index + sub->size <= statistics_size)
+            continue;
+        uint64_t* array = sub->array ? sub->array : read_data(sub);
+        for (size_t i = std::max(statistics_size, sub->starting_index) - sub->starting_index; i < sub->size; i++)
+            result.add(array[i]);
+        if (array != sub->array)
+            delete[] array;
+    }
+    return result;
+}
+
+void LinkedVector::setStatistics(const DurationStatistics& s) {
+    statistics = std::make_unique<DurationStatistics>(s);
+    statistics_size = size;
+    statistics_last_value = size ? last_value() : 0;
+}
+
+void LinkedDurationVector::setStatistics(const DurationStatistics& s) {
+    statistics = std::make_unique<DurationStatistics>(s);
+    statistics_size = size;
+}
+
+SAME_FOR_BOTH_VECTORS(bool, hasStatistics() const {
+    for (auto* sub = last; sub != nullptr && sub->starting_index + sub->size > statistics_size; sub = sub->previous) {
+        if (sub->array == nullptr)
+            return false;
+    }
+    return true;
+})
+
 SAME_FOR_BOTH_VECTORS(void, load_all_data() {
     auto* v = first;
     while (v) {
-        load_data(v);
-        loaded_subarrays.insert(v);
+        if (v->array == nullptr) {
+            load_data(v);
+            loaded_subarrays.insert(v);
+        }
         v = v->next;
     }
 })
 
+SAME_FOR_BOTH_VECTORS(SubArrayDataList, pin_data() {
+    std::lock_guard lock(ParameterHandler::storage_lock);
+    load_all_data();
+    auto& dq = parameter_handler.subvector_queue;
+    SubArrayDataList output;
+    output.reserve(n_sub_array);
+    for (auto* v = first; v != nullptr; v = v->next) {
+        auto it = std::find(dq.begin(), dq.end(), v);
+        if (it != dq.end()) {
+            dq.erase(it);
+            parameter_handler.loaded_durations_size -= v->size * sizeof(uint64_t);
+        }
+        pinArray(v->array);
+        output.emplace_back(v->array, v->size);
+    }
+    return output;
+})
+
 
 SAME_FOR_BOTH_VECTORS(
     uint64_t&,
@@ -178,6 +460,12 @@ SAME_FOR_BOTH_VECTORS(
       return operator[](pos);
   })
 
+SAME_FOR_BOTH_VECTORS(uint64_t, get(size_t pos) {
+    // The SubArray can't be unloaded by another thread before its value is copied.
+    std::lock_guard lock(ParameterHandler::storage_lock);
+    return at(pos);
+})
+
 uint64_t& LinkedVector::operator[](size_t pos) {
     SubArray* correct_sub = last;
     while (pos < correct_sub->starting_index) {
@@ -192,10 +480,11 @@ uint64_t& LinkedVector::operator[](size_t pos) {
         if (pos == correct_sub->starting_index + correct_sub->size - 1) {
             return correct_sub->last_value;
         }
-        while (parameter_handler.loaded_durations_size > parameter_handler.max_memory_durations) {
+        std::lock_guard lock(ParameterHandler::storage_lock);
+        while (parameter_handler.loaded_durations_size > parameter_handler.max_memory_durations && !parameter_handler.subvector_queue.empty()) {
             auto* temp = (SubArray*)parameter_handler.subvector_queue.front();
             parameter_handler.subvector_queue.pop_front();
-            delete[] temp->array;
+            releaseSubArrayData(temp->array);
             temp->array = nullptr;
             parameter_handler.loaded_durations_size -= temp->size * sizeof(uint64_t);
         }
@@ -211,10 +500,11 @@ uint64_t& LinkedDurationVector::operator[](size_t pos) {
           correct_sub = correct_sub->previous;
       }
       if (correct_sub->array == nullptr) {
-          while (parameter_handler.loaded_durations_size > parameter_handler.max_memory_durations) {
+          std::lock_guard lock(ParameterHandler::storage_lock);
+          while (parameter_handler.loaded_durations_size > parameter_handler.max_memory_durations && !parameter_handler.subvector_queue.empty()) {
               auto * temp = (SubArray*) parameter_handler.subvector_queue.front();
               parameter_handler.subvector_queue.pop_front();
-              delete[] temp->array;
+              releaseSubArrayData(temp->array);
               temp->array = nullptr;
               parameter_handler.loaded_durations_size -= temp->size * sizeof(uint64_t);
           }
@@ -248,69 +538,137 @@ size_t LinkedVector::getFirstOccurrenceBefore(pallas_timestamp_t ts) {
         }
         return 0;
     }
+    // Another thread may unload the SubArray while it's searched.
+    std::lock_guard lock(ParameterHandler::storage_lock);
     if (current_subarray->array == nullptr) {
         load_data(current_subarray);
+        loaded_subarrays.insert(current_subarray);
+    }
+    if (ts >= current_subarray->array[current_subarray->size - 1]) {
+        return current_subarray->starting_index + current_subarray->size - 1;
     }
-    // Then we do a dichotomy.
-    size_t start = 0;
-    size_t end = current_subarray->size - 1;
+    // The last value <= ts is the one before the first value > ts.
+    return current_subarray->starting_index + lowerBound(current_subarray->array, current_subarray->size, ts + 1) - 1;
+}
 
-    while (start < end) {
-        size_t middle = (start + end ) / 2;
-        if (current_subarray->array[middle] <= ts && current_subarray->array[middle + 1] > ts) {
-            return current_subarray->starting_index + middle;
+template <class OnValues, class OnSummary>
+void LinkedDurationVector::visit_range(size_t start_index, size_t end_index, bool approximate, OnValues&& on_values, OnSummary&& on_summary) {
+    end_index = std::min(end_index, size);
+    for (auto* sub = first; sub != nullptr && start_index < end_index; sub = sub->next) {
+        size_t sub_end = sub->starting_index + sub->size;
+        if (sub_end <= start_index || sub->size == 0)
+            continue;
+        if (sub->starting_index >= end_index)
+            break;
+        size_t from = std::max(start_index, sub->starting_index);
+        size_t to = std::min(end_index, sub_end);
+        if (approximate && sub->array == nullptr && from == sub->starting_index && to == sub_end) {
+            on_summary(sub);
+            continue;
         }
-        if (current_subarray->array[middle] < ts) {
-            if (start == middle) {
-                return end;
-            }
-            start = middle;
-        } else {
-            end = middle;
+        // Loads the SubArray like any other access, so that it is unloaded when there are too many of them.
+        // Other threads may then unload it while it's visited, so it stays pinned until on_values returns.
+        uint64_t* array;
+        const uint64_t* values;
+        {
+            std::lock_guard lock(ParameterHandler::storage_lock);
+            values = &at(from);
+            array = sub->array;
+            pinArray(array);
         }
+        on_values(values, to - from);
+        std::lock_guard lock(ParameterHandler::storage_lock);
+        unpinArray(array);
     }
-    pallas_error("This shouldn't have happened: Out of the Loop\n");
 }
 
-pallas_duration_t LinkedDurationVector::computeDurationBetween(size_t start_index, size_t end_index) {
-    // Find the correct starting sub-array
-    auto* start_subarray = first;
-    while (start_subarray->starting_index + start_subarray->size < start_index) {
-        start_subarray = start_subarray->next;
-        if (start_subarray == nullptr)
-            return 0;
-    }
-
+pallas_duration_t LinkedDurationVector::computeDurationBetween(size_t start_index, size_t end_index, bool approximate) {
     pallas_duration_t sum = 0;
-    if ( start_subarray->starting_index != start_index ) {
-        // Load the sub_array
-        size_t i = start_index;
-        sum += at( i++ );
-        for (; i < start_subarray->starting_index + start_subarray->size && i < end_index; i++) {
-            sum += start_subarray->at(i);
-        }
-        start_subarray = start_subarray->next;
-        if (start_subarray == nullptr)
-            return sum;
-    }
+    visit_range(
+      start_index, end_index, approximate,
+      [&](const uint64_t* values, size_t n) { sum += computeValueStatistics(values, n).sum; },
+      [&](const SubArray* sub) { sum += sub->mean * sub->size; });
+    return sum;
+}
 
-    while (start_subarray->starting_index + start_subarray->size < end_index) {
-        sum += start_subarray->mean * start_subarray->size;
-        start_subarray = start_subarray->next;
-        if (start_subarray == nullptr)
-            return sum;
-    }
+DurationSummary LinkedDurationVector::summarize(size_t start_index, size_t end_index, bool approximate) {
+    DurationSummary summary;
+    visit_range(
+      start_index, end_index, approximate,
+      [&](const uint64_t* values, size_t n) {
+          auto statistics = computeValueStatistics(values, n);
+          summary.sum += statistics.sum;
+          summary.min = std::min(summary.min, statistics.min);
+          summary.max = std::max(summary.max, statistics.max);
+          summary.values.insert(summary.values.end(), values, values + n);
+          summary.count += n;
+      },
+      [&](const SubArray* sub) {
+          // The mean of a SubArray is rounded down.
+          summary.sum += sub->mean * sub->size;
+          summary.sum_error += sub->size - 1;
+          summary.min = std::min(summary.min, sub->min);
+          summary.max = std::max(summary.max, sub->max);
+          summary.blocks.push_back({sub->size, sub->min, sub->max});
+          summary.count += sub->size;
+      });
+    return summary;
+}
 
-    size_t i = start_subarray->starting_index;
-    sum += at(i ++);
-    for (; i < end_index; i++) {
-        sum += start_subarray->at(i);
-    }
-    return sum;
+double DurationSummary::mean() const {
+    return count ? (sum + sum_error / 2.) / count : 0;
 }
 
+double DurationSummary::variance() const {
+    if (!isExact())
+        return NAN;
+    double m = mean();
+    double m2 = 0;
+    for (auto v : values)
+        m2 += (v - m) * (v - m);
+    return count ? m2 / count : 0;
+}
 
+/**
+ * Returns the smallest position at which the number of values, counting each block as being at the position
+ * given by block_position, exceeds rank.
+ */
+template <class BlockPosition>
+static uint64_t _summary_rank_position(const DurationSummary& summary, size_t rank, BlockPosition&& block_position) {
+    std::vector<std::pair<uint64_t, size_t>> points;
+    points.reserve(summary.values.size() + summary.blocks.size());
+    for (auto v : summary.values)
+        points.emplace_back(v, 1);
+    for (const auto& block : summary.blocks)
+        points.emplace_back(block_position(block), block.count);
+    std::sort(points.begin(), points.end());
+    size_t seen = 0;
+    for (const auto& [position, n] : points) {
+        seen += n;
+        if (rank < seen)
+            return position;
+    }
+    return summary.max;
+}
 
+uint64_t DurationSummary::quantile(double q, uint64_t* error) const {
+    if (error)
+        *error = 0;
+    if (count == 0)
+        return 0;
+    auto rank = static_cast<size_t>(std::clamp(q, 0.0, 1.0) * (count - 1));
+    if (isExact()) {
+        auto sorted = values;
+        std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+        return sorted[rank];
+    }
+    // The values of a block are at least its min, and at most its max.
+    uint64_t lower = _summary_rank_position(*this, rank, [](const Block& b) { return b.min; });
+    uint64_t upper = _summary_rank_position(*this, rank, [](const Block& b) { return b.max; });
+    if (error)
+        *error = (upper - lower + 1) / 2;
+    return lower + (upper - lower) / 2;
+}
 
 uint64_t& LinkedVector::front() {
     return first->first_value;
@@ -332,31 +690,33 @@ uint64_t& LinkedDurationVector::back() {
 void LinkedVector::free_data() {
     if (first == nullptr)
         return;
+    std::lock_guard lock(ParameterHandler::storage_lock);
     auto& dq = parameter_handler.subvector_queue;
     for (auto* sub : loaded_subarrays) {
         // We need to remove the subvector from the global memory queue
         auto it = std::find(dq.begin(), dq.end(), sub);
         if (it != dq.end()) {
             dq.erase(it);
+            parameter_handler.loaded_durations_size -= sub->size * sizeof(uint64_t);
         }
-        delete[] sub->array;
+        releaseSubArrayData(sub->array);
         sub->array = nullptr;
-        parameter_handler.loaded_durations_size -= sub->size;
     }
 }
 void LinkedDurationVector::free_data() {
     if (first == nullptr)
         return;
+    std::lock_guard lock(ParameterHandler::storage_lock);
     auto& dq = parameter_handler.subvector_queue;
     for (auto* sub : loaded_subarrays) {
         // We need to remove the subvector from the global memory queue
         auto it = std::find(dq.begin(), dq.end(), sub);
         if (it != dq.end()) {
             dq.erase(it);
+            parameter_handler.loaded_durations_size -= sub->size * sizeof(uint64_t);
         }
-        delete[] sub->array;
+        releaseSubArrayData(sub->array);
         sub->array = nullptr;
-        parameter_handler.loaded_durations_size -= sub->size;
     }
 }
 
@@ -365,6 +725,7 @@ LinkedVector::~LinkedVector() {
     if (is_contiguous) {
         // All the subvectors were allocated using a single big calloc
 #ifdef DEBUG
+        std::lock_guard lock(ParameterHandler::storage_lock);
         auto* temp = first;
         auto& dq = parameter_handler.subvector_queue;
         for (int i = 0; i < n_sub_array; i ++, temp++) {
@@ -391,6 +752,7 @@ LinkedDurationVector::~LinkedDurationVector() {
     if (is_contiguous) {
         // All the subvectors were allocated using a single big calloc
 #ifdef DEBUG
+        std::lock_guard lock(ParameterHandler::storage_lock);
         auto* temp = first;
         auto& dq = parameter_handler.subvector_queue;
         for (int i = 0; i < n_sub_array; i ++, temp++) {
@@ -412,6 +774,74 @@ LinkedDurationVector::~LinkedDurationVector() {
     }
 }
 
+SAME_FOR_BOTH_VECTORS(void, spill_to(const char* dataFilePath) {
+    filePath = dataFilePath;
+    spill = true;
+})
+
+/**
+ * Copies the values appended to the SubArrays ending with last since the last snapshot, see LinkedVector::snapshot.
+ * describe fills the statistics of the block of a spilled SubArray.
+ */
+template <class SubArray, class Describe>
+static void snapshot_sub_arrays(SubArray* last, size_t n_sub_array, LiveCursor& cursor, LiveValues& values, Describe describe) {
+    values.pieces.clear();
+    cursor.size = values.size;
+    if (values.size == 0)
+        return;
+    // The SubArrays before the cursor didn't change: the first one that did is found from the end.
+    auto* sub = last;
+    for (size_t i = n_sub_array - 1; i > cursor.nb_complete && sub->previous; i--) {
+        sub = sub->previous;
+    }
+    for (; sub; sub = sub->next) {
+        LiveValues::Piece piece;
+        piece.complete = sub->next != nullptr;
+        if (sub->array == nullptr) {
+            // A SubArray is only spilled once it's full: its block is copied as it is.
+            piece.complete = piece.spilled = true;
+            piece.block = {sub->size, {0, 0, 0}, sub->offset, sub->checksum};
+            describe(sub, piece.block.statistics);
+        } else if (sub->size > cursor.tail_size) {
+            piece.values.assign(&sub->array[cursor.tail_size], &sub->array[sub->size]);
+        } else if (!piece.complete) {
+            break;
+        }
+        if (piece.complete) {
+            cursor.nb_complete++;
+            cursor.tail_size = 0;
+        } else {
+            cursor.tail_size = sub->size;
+        }
+        values.pieces.push_back(std::move(piece));
+    }
+}
+
+void LinkedVector::snapshot(LiveCursor& cursor, LiveValues& values) const {
+    values.size = size;
+    values.spill_path = spill ? filePath : nullptr;
+    snapshot_sub_arrays(last, n_sub_array, cursor, values, [](const SubArray* sub, uint64_t* statistics) {
+        statistics[0] = sub->first_value;
+        statistics[1] = sub->last_value;
+    });
+}
+
+void LinkedDurationVector::snapshot(LiveCursor& cursor, LiveValues& values) const {
+    values.size = size;
+    values.spill_path = spill ? filePath : nullptr;
+    if (size > 0) {
+        // While the vector is written, its mean holds the sum of its values.
+        values.min = min;
+        values.max = max;
+        values.mean = std::clamp(parameter_handler.does_stats_need_compute ? mean / size : mean, min, max);
+    }
+    snapshot_sub_arrays(last, n_sub_array, cursor, values, [](const SubArray* sub, uint64_t* statistics) {
+        statistics[0] = sub->min;
+        statistics[1] = sub->max;
+        statistics[2] = sub->mean;
+    });
+}
+
 SAME_FOR_BOTH_VECTORS(void, reset_offsets() {
     auto* v = first;
     while (v != nullptr) {
@@ -421,16 +851,21 @@ SAME_FOR_BOTH_VECTORS(void, reset_offsets() {
 })
 
 SAME_FOR_BOTH_VECTORS(uint64_t*, as_flat_array() {
-    load_all_data();
     auto * output = new uint64_t[size];
+    copy_to_array(output);
+    return output;
+})
+
+SAME_FOR_BOTH_VECTORS(void, copy_to_array(uint64_t* given_array) {
+    std::lock_guard lock(ParameterHandler::storage_lock);
+    load_all_data();
     auto * start = first;
     size_t i = 0;
     while (start != nullptr) {
-        std::memcpy(&output[i], start->array, start->size * sizeof(uint64_t));
+        start->copy_to_array(&given_array[i]);
         i += start->size;
         start = start->next;
     }
-    return output;
 })
 
 
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+#include <sstream>
+
+#include "pallas/utils/pallas_memory.h"
+
+namespace pallas {
+
+const char* toString(MemoryCategory category) {
+    switch (category) {
+    case PALLAS_MEMORY_EVENTS:
+        return "events";
+    case PALLAS_MEMORY_SEQUENCES:
+        return "sequences";
+    case PALLAS_MEMORY_LOOPS:
+        return "loops";
+    case PALLAS_MEMORY_ID_MAPS:
+        return "id_maps";
+    case PALLAS_MEMORY_HASH_MAPS:
+        return "hash_maps";
+    case PALLAS_MEMORY_TIMESTAMPS:
+        return "timestamps";
+    case PALLAS_MEMORY_DURATIONS:
+        return "durations";
+    case PALLAS_MEMORY_ATTRIBUTES:
+        return "attributes";
+    case PALLAS_MEMORY_LABELS:
+        return "labels";
+    case PALLAS_MEMORY_STATISTICS:
+        return "statistics";
+    case PALLAS_MEMORY_WRITER_STACKS:
+        return "writer_stacks";
+    case PALLAS_MEMORY_READER_CURSORS:
+        return "reader_cursors";
+    case PALLAS_MEMORY_DEFINITIONS:
+        return "definitions";
+    default:
+        return "invalid";
+    }
+}
+
+MemoryUsage& MemoryUsage::operator+=(const MemoryUsage& other) {
+    for (int category = 0; category < PALLAS_MEMORY_CATEGORY_COUNT; category++) {
+        bytes[category] += other.bytes[category];
+    }
+    return *this;
+}
+
+size_t MemoryUsage::total() const {
+    size_t total = 0;
+    for (int category = 0; category < PALLAS_MEMORY_CATEGORY_COUNT; category++) {
+        total += bytes[category];
+    }
+    return total;
+}
+
+std::string MemoryUsage::toString() const {
+    std::ostringstream out;
+    out << "total=" << total();
+    for (int category = 0; category < PALLAS_MEMORY_CATEGORY_COUNT; category++) {
+        if (bytes[category])
+            out << " " << pallas::toString(static_cast<MemoryCategory>(category)) << "=" << bytes[category];
+    }
+    return out.str();
+}
+
+}  // namespace pallas
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
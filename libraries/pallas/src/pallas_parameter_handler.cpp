@@ -219,6 +219,54 @@ class ConfigFile {
     return ret;
   }
 
+  uint64_t loadLivePeriod() {
+    uint64_t value = loadUInt64FromEnv("PALLAS_LIVE_PERIOD");
+    // The live publication is optional: don't warn when the key is missing.
+    if (value == UINT64_MAX && config.find("livePeriod") != config.end()) {
+      value = loadUInt64FromConfig("livePeriod");
+    }
+    if (value == UINT64_MAX) {
+      return livePeriodDefault;
+    }
+    return value;
+  }
+
+  bool loadPartialFlush() {
+    uint64_t value = loadUInt64FromEnv("PALLAS_PARTIAL_FLUSH");
+    // The partial flush is optional: don't warn when the key is missing.
+    if (value == UINT64_MAX && config.find("partialFlush") != config.end()) {
+      value = loadUInt64FromConfig("partialFlush");
+    }
+    if (value == UINT64_MAX) {
+      return partialFlushDefault;
+    }
+    return value != 0;
+  }
+
+  bool loadVerifyChecksums() {
+    uint64_t value = loadUInt64FromEnv("PALLAS_VERIFY_CHECKSUMS");
+    // The verification is enabled unless it's disabled: don't warn when the key is missing.
+    if (value == UINT64_MAX && config.find("verifyChecksums") != config.end()) {
+      value = loadUInt64FromConfig("verifyChecksums");
+    }
+    if (value == UINT64_MAX) {
+      return verifyChecksumsDefault;
+    }
+    return value != 0;
+  }
+
+  bool loadLazyLoading() {
+    uint64_t value = loadUInt64FromEnv("PALLAS_LAZY_LOADING");
+    // The lazy loading is optional: don't warn when the key is missing.
+    if (value == UINT64_MAX && config.find("lazyLoading") != config.end()) {
+      value = loadUInt64FromConfig("lazyLoading");
+    }
+    if (value == UINT64_MAX) {
+      return lazyLoadingDefault;
+    }
+    return value != 0;
+  }
+
   explicit ConfigFile(const std::string& configPath) {
     std::ifstream configFile(configPath);
     if (configFile.is_open()) {
@@ -243,6 +291,10 @@ ParameterHandler::ParameterHandler(const std::string& stringConfig) {
   maxLoopLength = config.loadMaxLoopLength();
   zstdCompressionLevel = config.loadZSTDCompressionLevel();
   timestampStorage = config.loadTimestampStorageConfig();
+  livePeriod = config.loadLivePeriod();
+  partialFlush = config.loadPartialFlush();
+  verifyChecksums = config.loadVerifyChecksums();
+  lazyLoading = config.loadLazyLoading();
 
   pallas_log(DebugLevel::Normal, "%s\n", to_string().c_str());
 }
@@ -279,10 +331,21 @@ ParameterHandler::ParameterHandler() {
   maxLoopLength = config.loadMaxLoopLength();
   zstdCompressionLevel = config.loadZSTDCompressionLevel();
   timestampStorage = config.loadTimestampStorageConfig();
+  livePeriod = config.loadLivePeriod();
+  partialFlush = config.loadPartialFlush();
+  verifyChecksums = config.loadVerifyChecksums();
+  lazyLoading = config.loadLazyLoading();
 
   pallas_log(DebugLevel::Debug, "%s\n", to_string().c_str());
 }
 
+void ParameterHandler::loadReadingParameters() {
+  // They aren't stored in the trace, and there is no configuration file when reading one.
+  ConfigFile config("");
+  verifyChecksums = config.loadVerifyChecksums();
+  lazyLoading = config.loadLazyLoading();
+}
+
 size_t ParameterHandler::getMaxLoopLength() const {
   if (loopFindingAlgorithm == LoopFindingAlgorithm::BasicTruncated)
     return maxLoopLength;
@@ -317,6 +380,10 @@ std::string ParameterHandler::to_string() const {
   stream << "maxLoopLength=" << maxLoopLength << "\n";
   stream << "zstdCompressionLevel=" << zstdCompressionLevel << "\n";
   stream << "timestampStorage=" << toString(timestampStorage) << "\n";
+  stream << "livePeriod=" << livePeriod << "\n";
+  stream << "partialFlush=" << partialFlush << "\n";
+  stream << "verifyChecksums=" << verifyChecksums << "\n";
+  stream << "lazyLoading=" << lazyLoading << "\n";
   return stream.str();
 }
 
@@ -6,13 +6,16 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <sys/stat.h>
 
 #include "pallas/pallas.h"
 #include "pallas/pallas_archive.h"
 #include "pallas/pallas_read.h"
 
 #include "pallas/utils/pallas_log.h"
+#include "pallas/utils/pallas_storage.h"
 
 namespace pallas {
 
@@ -31,7 +34,7 @@ Cursor::Cursor(const Cursor& other) {
         callstack[i].callstack_iterable = other.callstack[i].callstack_iterable;
         callstack[i].current_timestamp = other.callstack[i].current_timestamp;
     }
-    currentFrame = &callstack[current_frame_index];
+    currentFrame = &callstack[current_frame_index < 0 ? 0 : current_frame_index];
 }
 Cursor& Cursor::operator=(const Cursor& other) {
     current_frame_index = other.current_frame_index;
@@ -41,7 +44,7 @@ Cursor& Cursor::operator=(const Cursor& other) {
         callstack[i].callstack_iterable = other.callstack[i].callstack_iterable;
         callstack[i].current_timestamp = other.callstack[i].current_timestamp;
     }
-    currentFrame = &callstack[current_frame_index];
+    currentFrame = &callstack[current_frame_index < 0 ? 0 : current_frame_index];
     return *this;
 }
 
@@ -72,6 +75,8 @@ ThreadReader::ThreadReader(Archive* archive, ThreadId threadId, int read_flags)
     }
     else {
         pallas_warn("Thread %s is empty\n", this->thread_trace->getName());
+        this->currentState.current_frame_index = -1;
+        this->currentState.currentFrame = &currentState.callstack[0];
     }
 }
 
@@ -179,7 +184,7 @@ bool ThreadReader::isEndOfCurrentBlock() const {
     return isEndOfBlock(current_index, current_iterable_token);
 }
 bool ThreadReader::isEndOfTrace() const {
-    return currentState.current_frame_index == 0;
+    return currentState.current_frame_index < 0;
 }
 
 pallas_duration_t ThreadReader::getLoopDuration(Token loop_id) const {
@@ -233,28 +238,11 @@ size_t ThreadReader::getCurrentTokenCount(Token t) const {
 }
 
 AttributeList* ThreadReader::getEventAttributeList(Token event_id, size_t occurrence_id) const {
-    auto* summary = getEvent(event_id);
-    if (summary->attribute_buffer == nullptr)
-        return nullptr;
-
-    if (summary->attribute_pos < summary->attribute_buffer_size) {
-        auto* l = (AttributeList*)&summary->attribute_buffer[summary->attribute_pos];
-
-        while (l->index < occurrence_id) { /* move to the next attribute until we reach the needed index */
-            summary->attribute_pos += l->struct_size;
-            l = (AttributeList*)&summary->attribute_buffer[summary->attribute_pos];
-        }
-        if (l->index == occurrence_id) {
-            return l;
-        }
-        if (l->index > occurrence_id) {
-            pallas_error("Error fetching attribute %zu. We went too far (cur position: %d) !\n", occurrence_id, l->index);
-        }
-    }
-    return nullptr;
+    return getEvent(event_id)->getAttributeList(occurrence_id);
 }
 
 void ThreadReader::guessSequencesNames(std::map<pallas::Sequence*, std::string>& names) const {
+    thread_trace->loadAll();
     // Let's call the main sequence "main"
     names[&thread_trace->sequences[thread_trace->sequence_id_map[thread_trace->sequence_root]]] = "main";
 
@@ -419,6 +407,10 @@ bool ThreadReader::moveToNextToken(int flags) {
     }
 
     if (isEndOfCurrentBlock()) {
+        if (currentState.current_frame_index == 0) {
+            // The main sequence may hold several tokens: the trace only ends after its last one.
+            currentState.current_frame_index = -1;
+        }
         return false;
     }
 
@@ -632,6 +624,17 @@ bool ThreadReader::enterIfStartOfBlock(int flags) {
     return false;
 }
 
+MemoryUsage ThreadReader::getMemoryUsage() const {
+    MemoryUsage usage;
+    if (thread_trace)
+        usage = thread_trace->getMemoryUsage();
+    usage.bytes[PALLAS_MEMORY_READER_CURSORS] += sizeof(*this);
+    for (const auto& frame : currentState.callstack) {
+        usage.bytes[PALLAS_MEMORY_READER_CURSORS] += hashMapMemoryUsage(frame.tokenCount);
+    }
+    return usage;
+}
+
 Cursor ThreadReader::createCheckpoint() const {
     return Cursor(this->currentState);
 }
@@ -748,6 +751,143 @@ Token MultiThreadReader::getNextToken() {
     return INVALID_TOKEN;
 }
 
+LiveThreadReader::LiveThreadReader(const char* trace_filename, ThreadId thread_id) {
+    std::filesystem::path path(trace_filename);
+    path = path.parent_path() / "live" / path.filename();
+    this->trace_filename = strdup(path.c_str());
+    this->thread_id = thread_id;
+    archive_id = PALLAS_LOCATION_GROUP_ID_INVALID;
+    trace = nullptr;
+    reader = nullptr;
+    nb_events_read = 0;
+    snapshot_inode = 0;
+    snapshot_mtime = 0;
+}
+
+LiveThreadReader::~LiveThreadReader() {
+    close();
+    free(trace_filename);
+}
+
+void LiveThreadReader::close() {
+    // The reader frees its Thread from the Archive, so it goes first.
+    delete reader;
+    reader = nullptr;
+    delete trace;
+    trace = nullptr;
+}
+
+/** Returns the path to the thread file of the given thread in the snapshots of trace_filename. */
+static std::string getLiveThreadFilename(const char* trace_filename, LocationGroupId archive_id, ThreadId thread_id) {
+    std::filesystem::path path(trace_filename);
+    auto thread_path = path.parent_path() / ("archive_" + std::to_string(archive_id)) / ("thread_" + std::to_string(thread_id)) / "thread.pallas";
+    return thread_path.string();
+}
+
+bool LiveThreadReader::refresh() {
+    struct stat file_stat;
+    if (archive_id != PALLAS_LOCATION_GROUP_ID_INVALID) {
+        // A new snapshot replaces the thread file, so checking it is enough to know whether there is one.
+        if (stat(getLiveThreadFilename(trace_filename, archive_id, thread_id).c_str(), &file_stat) != 0)
+            return false;
+        int64_t mtime = file_stat.st_mtim.tv_sec * 1000000000 + file_stat.st_mtim.tv_nsec;
+        if (file_stat.st_ino == snapshot_inode && mtime == snapshot_mtime)
+            return false;
+    }
+
+    std::error_code error;
+    if (!std::filesystem::exists(trace_filename, error))
+        return false;
+    auto* new_trace = pallas_open_trace(trace_filename);
+    if (new_trace == nullptr)
+        return false;
+
+    // GlobalArchive::getLocation would load the Archives of the threads that weren't published yet.
+    Archive* archive = nullptr;
+    for (auto& location_group : new_trace->location_groups) {
+        std::filesystem::path archive_path = std::filesystem::path(trace_filename).parent_path() / ("archive_" + std::to_string(location_group.id)) / "archive.pallas";
+        if (!std::filesystem::exists(archive_path, error))
+            continue;
+        auto* a = new_trace->getArchive(location_group.id, false);
+        if (a && a->getLocation(thread_id)) {
+            archive = a;
+            break;
+        }
+    }
+    std::string thread_filename = archive ? getLiveThreadFilename(trace_filename, archive->id, thread_id) : "";
+    if (archive == nullptr || stat(thread_filename.c_str(), &file_stat) != 0) {
+        delete new_trace;
+        return false;
+    }
+    archive_id = archive->id;
+    snapshot_inode = file_stat.st_ino;
+    snapshot_mtime = file_stat.st_mtim.tv_sec * 1000000000 + file_stat.st_mtim.tv_nsec;
+
+    auto* thread = archive->getThread(thread_id);
+    if (thread == nullptr || thread->getSequence(Token(TypeSequence, thread->sequence_root))->size() == 0) {
+        // Nothing was recorded yet.
+        if (thread)
+            archive->freeThread(thread_id);
+        delete new_trace;
+        return false;
+    }
+    close();
+    trace = new_trace;
+    reader = new ThreadReader(archive, thread_id, PALLAS_READ_FLAG_UNROLL_ALL);
+
+    // The Events of a snapshot start with the ones of the previous snapshots:
+    // skip the ones that were read, without unrolling the blocks that were read entirely.
+    size_t nb_skipped = nb_events_read;
+    while (nb_skipped > 0 && !reader->isEndOfTrace()) {
+        Token token = reader->pollCurToken();
+        size_t nb_events = getEventCount(token);
+        if (nb_events <= nb_skipped) {
+            nb_skipped -= nb_events;
+            skipToken();
+        } else {
+            reader->enterBlock();
+        }
+    }
+    return !reader->isEndOfTrace();
+}
+
+size_t LiveThreadReader::getEventCount(Token token) const {
+    auto* thread = reader->thread_trace;
+    switch (token.type) {
+    case TypeEvent:
+        return 1;
+    case TypeSequence:
+        return thread->getSequence(token)->getTokenCountReading(thread).getEventCount();
+    case TypeLoop: {
+        auto* loop = thread->getLoop(token);
+        return loop->nb_iterations * thread->getSequence(loop->repeated_token)->getTokenCountReading(thread).getEventCount();
+    }
+    default:
+        return 0;
+    }
+}
+
+void LiveThreadReader::skipToken() {
+    while (!reader->moveToNextToken(PALLAS_READ_FLAG_NO_UNROLL)) {
+        if (reader->isEndOfTrace() || !reader->exitIfEndOfBlock(PALLAS_READ_FLAG_UNROLL_ALL))
+            return;
+    }
+}
+
+bool LiveThreadReader::getNextEvent(EventOccurrence* event_occurrence) {
+    if (reader == nullptr)
+        return false;
+    while (!reader->isEndOfTrace() && reader->pollCurToken().type != TypeEvent) {
+        reader->moveToNextToken(PALLAS_READ_FLAG_UNROLL_ALL);
+    }
+    if (reader->isEndOfTrace())
+        return false;
+    Token token = reader->pollCurToken();
+    *event_occurrence = reader->getEventOccurrence(token, reader->getCurrentTokenCount(token));
+    nb_events_read++;
+    reader->moveToNextToken(PALLAS_READ_FLAG_UNROLL_ALL);
+    return true;
+}
 
 /* C bindings */
 
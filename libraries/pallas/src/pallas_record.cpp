@@ -24,6 +24,30 @@ static inline void push_data(EventData *e, void *data, size_t data_size) {
     e->event_size += data_size;
 }
 
+/* Returns true if the event must not be recorded: either it is recorded by Pallas itself,
+ * or the measurement is off on this thread.
+ * The blocks opened while the measurement is off are counted, so that their ends are dropped too,
+ * while the blocks that were already open when it was turned off can still be closed. */
+static inline bool skip_event(ThreadWriter *thread_writer, EventType event_type) {
+    if (pallas_recursion_shield)
+        return true;
+    if (thread_writer->measurement_on && thread_writer->skipped_depth == 0)
+        return false;
+    switch (event_type) {
+    case PALLAS_BLOCK_START:
+        // Also skip the blocks nested in a skipped one, so that its end is matched.
+        thread_writer->skipped_depth++;
+        return true;
+    case PALLAS_BLOCK_END:
+        if (thread_writer->skipped_depth == 0)
+            return false;
+        thread_writer->skipped_depth--;
+        return true;
+    default:
+        return !thread_writer->measurement_on;
+    }
+}
+
 void pallas_event_pop_data(const EventData *e, void *data, size_t data_size, const byte **cursor) {
     if (*cursor == nullptr) {
         /* initialize the cursor to the beginning of event data */
@@ -47,6 +71,45 @@ void pallas_record_generic(ThreadWriter *thread_writer,
   pallas::Record event_type = data->record;				\
   pallas_assert(event_type == (expected_event_type));
 
+void pallas_record_measurement_on_off(ThreadWriter *thread_writer,
+                                      struct AttributeList *attribute_list,
+                                      pallas_timestamp_t time,
+                                      uint8_t measurement_on) {
+    if (pallas_recursion_shield)
+        return;
+    // The event is recorded while the measurement is on: before turning it off, after turning it on.
+    if (measurement_on)
+        thread_writer->measurement_on = 1;
+    if (thread_writer->measurement_on)
+        pallas_record_singleton(thread_writer, attribute_list, PALLAS_EVENT_MEASUREMENT_ON_OFF, time,
+                                sizeof(measurement_on), reinterpret_cast<byte *>(&measurement_on));
+    thread_writer->measurement_on = measurement_on;
+}
+
+void pallas_read_measurement_on_off(const EventData *data,
+                                    struct AttributeList **attribute_list,
+                                    uint8_t *measurement_on) {
+    PALLAS_READ_PROLOG(PALLAS_EVENT_MEASUREMENT_ON_OFF);
+    if (attribute_list) *attribute_list = nullptr;
+    if (measurement_on) pallas_event_pop_data(data, measurement_on, sizeof(*measurement_on), &cursor);
+}
+
+void pallas_record_buffer_flush(ThreadWriter *thread_writer,
+                                struct AttributeList *attribute_list,
+                                pallas_timestamp_t time,
+                                pallas_timestamp_t stop_time) {
+    pallas_record_singleton(thread_writer, attribute_list, PALLAS_EVENT_BUFFER_FLUSH, time, sizeof(stop_time),
+                            reinterpret_cast<byte *>(&stop_time));
+}
+
+void pallas_read_buffer_flush(const EventData *data,
+                              struct AttributeList **attribute_list,
+                              pallas_timestamp_t *stop_time) {
+    PALLAS_READ_PROLOG(PALLAS_EVENT_BUFFER_FLUSH);
+    if (attribute_list) *attribute_list = nullptr;
+    if (stop_time) pallas_event_pop_data(data, stop_time, sizeof(*stop_time), &cursor);
+}
+
 void pallas_read_generic(const EventData *data,
                          struct AttributeList **attribute_list,
                          StringRef *event_name_ref) {
@@ -61,7 +124,7 @@ void pallas_record_singleton(ThreadWriter *thread_writer,
                              pallas_timestamp_t time,
                              uint32_t args_n_bytes,
                              byte arg_array[]) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_SINGLETON))
         return;
     pallas_recursion_shield++;
     EventData e;
@@ -76,7 +139,7 @@ void pallas_record_enter(ThreadWriter *thread_writer,
                          struct AttributeList *attribute_list __attribute__((unused)),
                          pallas_timestamp_t time,
                          RegionRef region_ref) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_BLOCK_START))
         return;
     pallas_recursion_shield++;
 
@@ -103,7 +166,7 @@ void pallas_record_leave(ThreadWriter *thread_writer,
                          struct AttributeList *attribute_list __attribute__((unused)),
                          pallas_timestamp_t time,
                          RegionRef region_ref) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_BLOCK_END))
         return;
     pallas_recursion_shield++;
 
@@ -129,7 +192,7 @@ void pallas_read_leave(const EventData *data,
 void pallas_record_thread_begin(ThreadWriter *thread_writer,
                                 struct AttributeList *attribute_list __attribute__((unused)),
                                 pallas_timestamp_t time) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_BLOCK_START))
         return;
     pallas_recursion_shield++;
 
@@ -151,7 +214,7 @@ void pallas_read_thread_begin(const EventData *data,
 void pallas_record_thread_end(ThreadWriter *thread_writer,
                               struct AttributeList *attribute_list __attribute__((unused)),
                               pallas_timestamp_t time) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_BLOCK_END))
         return;
     pallas_recursion_shield++;
 
@@ -172,7 +235,7 @@ extern void pallas_read_thread_end(const EventData *data,
 void pallas_record_thread_team_begin(ThreadWriter *thread_writer,
                                      struct AttributeList *attribute_list __attribute__((unused)),
                                      pallas_timestamp_t time) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_BLOCK_START))
         return;
     pallas_recursion_shield++;
 
@@ -193,7 +256,7 @@ void pallas_read_thread_team_begin(const EventData *data,
 void pallas_record_thread_team_end(ThreadWriter *thread_writer,
                                    struct AttributeList *attribute_list __attribute__((unused)),
                                    pallas_timestamp_t time) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_BLOCK_END))
         return;
     pallas_recursion_shield++;
 
@@ -215,7 +278,7 @@ void pallas_record_thread_fork(ThreadWriter *thread_writer,
                                AttributeList *attribute_list __attribute__((unused)),
                                pallas_timestamp_t time,
                                uint32_t numberOfRequestedThreads) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_BLOCK_START))
         return;
     pallas_recursion_shield++;
     EventData e;
@@ -240,6 +303,10 @@ void pallas_read_thread_fork(const EventData *data,
 void pallas_record_thread_join(ThreadWriter *thread_writer,
                                AttributeList *attribute_list,
                                pallas_timestamp_t time) {
+    if (skip_event(thread_writer, PALLAS_BLOCK_END))
+        return;
+    pallas_recursion_shield++;
+
     EventData e;
     init_event(&e, PALLAS_EVENT_OMP_JOIN);
     TokenId e_id = thread_writer->getEventId(&e);
@@ -260,7 +327,7 @@ void pallas_record_mpi_send(ThreadWriter *thread_writer,
                             uint32_t communicator,
                             uint32_t msgTag,
                             uint64_t msgLength) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_SINGLETON))
         return;
     pallas_recursion_shield++;
 
@@ -301,7 +368,7 @@ void pallas_record_mpi_isend(ThreadWriter *thread_writer,
                              uint32_t msgTag,
                              uint64_t msgLength,
                              uint64_t requestID) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_SINGLETON))
         return;
     pallas_recursion_shield++;
 
@@ -343,7 +410,7 @@ void pallas_record_mpi_isend_complete(ThreadWriter *thread_writer,
                                       struct AttributeList *attribute_list __attribute__((unused)),
                                       pallas_timestamp_t time,
                                       uint64_t requestID) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_SINGLETON))
         return;
     pallas_recursion_shield++;
 
@@ -372,7 +439,7 @@ void pallas_record_mpi_irecv_request(ThreadWriter *thread_writer,
                                      struct AttributeList *attribute_list __attribute__((unused)),
                                      pallas_timestamp_t time,
                                      uint64_t requestID) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_SINGLETON))
         return;
     pallas_recursion_shield++;
 
@@ -404,7 +471,7 @@ void pallas_record_mpi_recv(ThreadWriter *thread_writer,
                             uint32_t communicator,
                             uint32_t msgTag,
                             uint64_t msgLength) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_SINGLETON))
         return;
     pallas_recursion_shield++;
 
@@ -445,7 +512,7 @@ void pallas_record_mpi_irecv(ThreadWriter *thread_writer,
                              uint32_t msgTag,
                              uint64_t msgLength,
                              uint64_t requestID) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_SINGLETON))
         return;
     pallas_recursion_shield++;
 
@@ -485,7 +552,7 @@ void pallas_read_mpi_irecv(const EventData *data,
 void pallas_record_mpi_collective_begin(ThreadWriter *thread_writer,
                                         struct AttributeList *attribute_list __attribute__((unused)),
                                         pallas_timestamp_t time) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_SINGLETON))
         return;
     pallas_recursion_shield++;
 
@@ -513,7 +580,7 @@ void pallas_record_mpi_collective_end(ThreadWriter *thread_writer,
                                       uint32_t root,
                                       uint64_t sizeSent,
                                       uint64_t sizeReceived) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_SINGLETON))
         return;
     pallas_recursion_shield++;
 
@@ -554,7 +621,7 @@ void pallas_record_omp_fork(ThreadWriter *thread_writer,
                             AttributeList *attribute_list,
                             pallas_timestamp_t time,
                             uint32_t numberOfRequestedThreads) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_BLOCK_START))
         return;
     pallas_recursion_shield++;
     EventData e;
@@ -581,7 +648,7 @@ void pallas_read_omp_fork(const EventData *data,
 void pallas_record_omp_join(ThreadWriter *thread_writer,
                             AttributeList *attribute_list,
                             pallas_timestamp_t time) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_BLOCK_END))
         return;
     pallas_recursion_shield++;
     EventData e;
@@ -602,7 +669,7 @@ void pallas_record_omp_acquire_lock(ThreadWriter *thread_writer,
                                     pallas_timestamp_t time,
                                     uint32_t lockID,
                                     uint32_t acquisitionOrder) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_SINGLETON))
         return;
     pallas_recursion_shield++;
     EventData e;
@@ -630,7 +697,7 @@ void pallas_record_thread_acquire_lock(ThreadWriter *thread_writer,
                                        pallas_timestamp_t time,
                                        uint32_t lockID,
                                        uint32_t acquisitionOrder) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_SINGLETON))
         return;
     pallas_recursion_shield++;
     EventData e;
@@ -661,7 +728,7 @@ void pallas_record_thread_release_lock(ThreadWriter *thread_writer,
                                        pallas_timestamp_t time,
                                        uint32_t lockID,
                                        uint32_t acquisitionOrder) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_SINGLETON))
         return;
     pallas_recursion_shield++;
     EventData e;
@@ -690,7 +757,7 @@ void pallas_record_omp_release_lock(ThreadWriter *thread_writer,
                                     pallas_timestamp_t time,
                                     uint32_t lockID,
                                     uint32_t acquisitionOrder) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_SINGLETON))
         return;
     pallas_recursion_shield++;
     EventData e;
@@ -718,7 +785,7 @@ void pallas_record_omp_task_create(ThreadWriter *thread_writer,
                                    AttributeList *attribute_list,
                                    pallas_timestamp_t time,
                                    uint64_t taskID) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_SINGLETON))
         return;
     pallas_recursion_shield++;
     EventData e;
@@ -742,7 +809,7 @@ void pallas_record_omp_task_switch(ThreadWriter *thread_writer,
                                    AttributeList *attribute_list,
                                    pallas_timestamp_t time,
                                    uint64_t taskID) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_SINGLETON))
         return;
     pallas_recursion_shield++;
     EventData e;
@@ -766,7 +833,7 @@ void pallas_record_omp_task_complete(ThreadWriter *thread_writer,
                                      AttributeList *attribute_list,
                                      pallas_timestamp_t time,
                                      uint64_t taskID) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_SINGLETON))
         return;
     pallas_recursion_shield++;
     EventData e;
@@ -789,7 +856,7 @@ void pallas_read_omp_task_complete(const EventData *data,
 void pallas_record_thread_task_create(ThreadWriter *thread_writer,
                                       AttributeList *attribute_list,
                                       pallas_timestamp_t time) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_SINGLETON))
         return;
     pallas_recursion_shield++;
     EventData e;
@@ -808,7 +875,7 @@ void pallas_read_thread_task_create(const EventData *data,
 void pallas_record_thread_task_switch(ThreadWriter *thread_writer,
                                       AttributeList *attribute_list,
                                       pallas_timestamp_t time) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_SINGLETON))
         return;
     pallas_recursion_shield++;
     EventData e;
@@ -827,7 +894,7 @@ void pallas_read_thread_task_switch(const EventData *data,
 void pallas_record_thread_task_complete(ThreadWriter *thread_writer,
                                         AttributeList *attribute_list,
                                         pallas_timestamp_t time) {
-    if (pallas_recursion_shield)
+    if (skip_event(thread_writer, PALLAS_SINGLETON))
         return;
     pallas_recursion_shield++;
     EventData e;
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <sstream>
+
+#include "pallas/utils/pallas_statistics.h"
+
+namespace pallas {
+
+static const double sketch_gamma = (1 + PALLAS_STATISTICS_SKETCH_ACCURACY) / (1 - PALLAS_STATISTICS_SKETCH_ACCURACY);
+static const double sketch_log_gamma = std::log(sketch_gamma);
+
+/** Returns the logarithmic bucket of a value greater than 0. */
+static int32_t _sketch_index(uint64_t value) {
+    return static_cast<int32_t>(std::ceil(std::log(static_cast<double>(value)) / sketch_log_gamma));
+}
+
+/** Returns the value that represents a logarithmic bucket: the one with the smallest relative error. */
+static double _sketch_value(int32_t index) {
+    return 2 * std::pow(sketch_gamma, index) / (sketch_gamma + 1);
+}
+
+size_t DurationStatistics::sketchBucket(int32_t index) {
+    if (sketch_counts.empty()) {
+        sketch_offset = index;
+        sketch_counts.push_back(0);
+        return 0;
+    }
+    if (index < sketch_offset) {
+        // Below the lowest bucket, values go into it if the sketch can't grow any more.
+        size_t missing = sketch_offset - index;
+        if (sketch_counts.size() + missing > PALLAS_STATISTICS_SKETCH_MAX_BUCKETS)
+            return 0;
+        sketch_counts.insert(sketch_counts.begin(), missing, 0);
+        sketch_offset = index;
+        return 0;
+    }
+    size_t bucket = index - sketch_offset;
+    if (bucket >= sketch_counts.size()) {
+        sketch_counts.resize(bucket + 1, 0);
+        if (sketch_counts.size() > PALLAS_STATISTICS_SKETCH_MAX_BUCKETS) {
+            // Merges the lowest buckets, whose relative error matters least.
+            size_t extra = sketch_counts.size() - PALLAS_STATISTICS_SKETCH_MAX_BUCKETS;
+            uint64_t merged = 0;
+            for (size_t i = 0; i <= extra; i++)
+                merged += sketch_counts[i];
+            sketch_counts.erase(sketch_counts.begin(), sketch_counts.begin() + extra);
+            sketch_counts[0] = merged;
+            sketch_offset += extra;
+            bucket -= extra;
+        }
+    }
+    return bucket;
+}
+
+void DurationStatistics::add(uint64_t value) {
+    count++;
+    sum += value;
+    min = std::min(min, value);
+    max = std::max(max, value);
+    double delta = value - mean;
+    mean += delta / count;
+    m2 += delta * (value - mean);
+    histogram[std::bit_width(value)]++;
+    if (value == 0) {
+        sketch_zeros++;
+    } else {
+        sketch_counts[sketchBucket(_sketch_index(value))]++;
+    }
+}
+
+void DurationStatistics::merge(const DurationStatistics& other) {
+    if (other.count == 0)
+        return;
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+    // Chan et al.'s parallel update of the mean and of the sum of squared differences.
+    uint64_t total = count + other.count;
+    double delta = other.mean - mean;
+    m2 += other.m2 + delta * delta * (static_cast<double>(count) * other.count / total);
+    mean += delta * other.count / total;
+    count = total;
+    sum += other.sum;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    for (int i = 0; i < PALLAS_STATISTICS_HISTOGRAM_SIZE; i++)
+        histogram[i] += other.histogram[i];
+    sketch_zeros += other.sketch_zeros;
+    for (size_t i = 0; i < other.sketch_counts.size(); i++) {
+        if (other.sketch_counts[i])
+            sketch_counts[sketchBucket(other.sketch_offset + static_cast<int32_t>(i))] += other.sketch_counts[i];
+    }
+}
+
+double DurationStatistics::variance() const {
+    return count > 1 ? m2 / count : 0;
+}
+
+double DurationStatistics::stddev() const {
+    return std::sqrt(variance());
+}
+
+uint64_t DurationStatistics::quantile(double q) const {
+    if (count == 0)
+        return 0;
+    q = std::clamp(q, 0.0, 1.0);
+    auto rank = static_cast<uint64_t>(q * (count - 1));
+    if (rank < sketch_zeros)
+        return 0;
+    uint64_t seen = sketch_zeros;
+    for (size_t i = 0; i < sketch_counts.size(); i++) {
+        seen += sketch_counts[i];
+        if (rank < seen) {
+            auto value = static_cast<uint64_t>(std::llround(_sketch_value(sketch_offset + static_cast<int32_t>(i))));
+            return std::clamp(value, min, max);
+        }
+    }
+    return max;
+}
+
+std::string DurationStatistics::toString() const {
+    std::ostringstream out;
+    out << "count=" << count << " sum=" << sum << " min=" << (count ? min : 0) << " max=" << max << " mean=" << mean
+        << " stddev=" << stddev() << " p50=" << quantile(.5) << " p90=" << quantile(.9) << " p99=" << quantile(.99);
+    return out.str();
+}
+
+}  // namespace pallas
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
@@ -4,6 +4,7 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <cerrno>
 #include <cmath>
 #include <cstdio>
@@ -12,6 +13,8 @@
 #include <iostream>
 #include <filesystem>
 #include <libgen.h>
+#include <list>
+#include <map>
 #include <sstream>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -25,11 +28,15 @@
 #endif
 
 #include "pallas/pallas.h"
+#include "pallas/pallas_attribute.h"
 
 #include "pallas/utils/pallas_dbg.h"
+#include "pallas/utils/pallas_kernels.h"
 #include "pallas/utils/pallas_log.h"
+#include "pallas/utils/pallas_parallel.h"
 #include "pallas/utils/pallas_parameter_handler.h"
 #include "pallas/utils/pallas_storage.h"
+#include "pallas/utils/pallas_writer_stats.h"
 
 short STORE_TIMESTAMPS = 1;
 static short STORE_HASHING = 0;
@@ -95,46 +102,63 @@ static FILE* pallasFileOpen(const char* filename, const char* mode) {
     size_t ret = fwrite(ptr, size, nmemb, stream); \
     if (ret != (nmemb))                            \
       pallas_error("fwrite failed\n");             \
+    PALLAS_WRITER_STATS_ADD_CURRENT(nb_bytes_written, (size) * (nmemb)); \
   } while (0)
 
 size_t numberOpenFiles = 0;
 size_t maxNumberFilesOpen = 32;
 class File;
 
-File* getFirstOpenFile();
+/** The evictable Files that are open, least recently opened first. Protected by ParameterHandler::storage_lock. */
+static std::list<File*> openFiles;
 
 class File {
 public:
     FILE* file = nullptr;
     char* path = nullptr;
     bool isOpen = false;
+    /**
+     * Whether opening another file may close this one, to keep at most maxNumberFilesOpen files open.
+     * It's the case of the files that are kept for the whole reading of a trace: they're reopened when they're needed,
+     * and storage_lock must be held while they're read.
+     */
+    bool evictable = false;
+    /** Position of this File in openFiles, when it's evictable and open. */
+    std::list<File*>::iterator openPosition;
+    /** Mode the file was last opened with. */
+    std::string mode;
     bool is_open() const { return isOpen; }
-    // TODO Add the file mode to the File class
     void open(const char* mode) {
+        std::lock_guard lock(pallas::ParameterHandler::storage_lock);
         if (isOpen) {
             pallas_log(pallas::DebugLevel::Verbose, "Trying to open file that is already open: %s\n", path);
             // store();
             return;
         }
         while (numberOpenFiles >= maxNumberFilesOpen) {
-            auto* openedFilePath = getFirstOpenFile();
-            if (!openedFilePath) {
+            if (openFiles.empty()) {
                 pallas_warn("Could not find any more duration files to store: %lu files opened.\n", numberOpenFiles);
                 break;
             }
-            openedFilePath->close();
+            openFiles.front()->close();
         }
         file = pallasFileOpen(path, mode);
         if (file) {
             numberOpenFiles++;
             isOpen = true;
+            this->mode = mode;
+            if (evictable) {
+                openPosition = openFiles.insert(openFiles.end(), this);
+            }
         }
     };
 
     void close() {
-        // TODO grab the lock
+        std::lock_guard lock(pallas::ParameterHandler::storage_lock);
         if (!isOpen) {
             pallas_log(pallas::DebugLevel::Debug, "Trying to store file that is already closed: %s\n", path);
+        } else if (evictable) {
+            openFiles.erase(openPosition);
         }
         isOpen = false;
         fclose(file);
@@ -193,13 +217,15 @@ public:
 
 FileMap fileMap;
 
-File* getFirstOpenFile() {
-    for (auto& a : fileMap) {
-        if (a.second->isOpen) {
-            return a.second;
-        }
+/** Returns the File of the map of opened files for path, which must have been allocated for the whole reading. */
+static File* _pallas_get_mapped_file(const char* path) {
+    std::lock_guard lock(pallas::ParameterHandler::storage_lock);
+    auto& file = fileMap[path];
+    if (file == nullptr) {
+        file = new File(path);
+        file->evictable = true;
     }
-    return nullptr;
+    return file;
 }
 
 
@@ -420,11 +446,8 @@ inline static size_t _pallas_histogram_compress(const uint64_t* src, size_t n, b
   // First check that the destination size of enough to write everything in case you can't compress enough
   pallas_assert(destSize >= (N_BYTES * n + 2 * sizeof(uint64_t)));
   // Compute the min and max
-  uint64_t min = UINT64_MAX, max = 0;
-  for (size_t i = 0; i < n; i++) {
-    min = (src[i] < min) ? src[i] : min;
-    max = (src[i] > max) ? src[i] : max;
-  }
+  auto statistics = pallas::computeValueStatistics(src, n);
+  uint64_t min = statistics.min, max = statistics.max;
 #ifdef DEBUG
   // collectHistogramStats(min, max, src, n);
 #endif
@@ -451,14 +474,8 @@ inline static size_t _pallas_histogram_compress(const uint64_t* src, size_t n, b
     dest = &dest[sizeof(max)];  // Offset the address
 
     // Write each bin
-    for (size_t i = 0; i < n; i++) {
-      size_t binNumber = std::floor((src[i] - min)) / stepSize;
-      binNumber = (binNumber > MAX_BIT) ? MAX_BIT : binNumber;
-      // This last check is here in the rare cases of overflow.
-      // printf("Writing %lu as %lu\n", src[i], temp);
-      memcpy(&dest[i * N_BYTES], &binNumber, N_BYTES);
-      // TODO This will not work on small endians architectures.
-    }
+    static_assert(N_BYTES == 1, "The histogram bins are bytes");
+    pallas::computeHistogramBins(src, n, min, stepSize, reinterpret_cast<uint8_t*>(dest));
   }
   return N_BYTES * n + 2 * sizeof(uint64_t);
 }
@@ -556,8 +573,101 @@ inline static uint64_t* _pallas_masking_read(size_t n, byte* encodedArray, size_
   return dest;
 }
 
-size_t numberRawBytes = 0;
-size_t numberCompressedBytes = 0;
+std::atomic<size_t> numberRawBytes = 0;
+std::atomic<size_t> numberCompressedBytes = 0;
+
+/** Returns the checksum of a block of stored data, as it is written: its size, then its data. */
+static inline uint32_t _pallas_block_checksum(size_t size, const void* data) {
+    return pallas::crc32c(data, size, pallas::crc32c(&size, sizeof(size)));
+}
+
+/** Magic number of the trailer of a file ("PCRC"), followed by the CRC32C of everything before it. */
+static const uint32_t _pallas_trailer_magic = 0x43524350;
+
+/** Returns the CRC32C of the first size bytes of a file, or false if they can't be read. */
+static bool _pallas_file_checksum(FILE* file, size_t size, uint32_t& checksum) {
+    std::vector<byte> buffer(1 << 20);
+    checksum = 0;
+    rewind(file);
+    while (size > 0) {
+        size_t chunk = std::min(size, buffer.size());
+        if (fread(buffer.data(), chunk, 1, file) != 1)
+            return false;
+        checksum = pallas::crc32c(buffer.data(), chunk, checksum);
+        size -= chunk;
+    }
+    return true;
+}
+
+/**
+ * Appends a trailer to a file that was just written and closed: a magic number, then the CRC32C of its content.
+ * The readers never read past what they expect, so they don't see it.
+ */
+static void _pallas_seal_file(const char* path) {
+    FILE* file = fopen(path, "r+");
+    if (file == nullptr) {
+        pallas_warn("Cannot add a checksum to %s: %s\n", path, strerror(errno));
+        return;
+    }
+    fseek(file, 0, SEEK_END);
+    size_t size = ftell(file);
+    uint32_t trailer[2] = {_pallas_trailer_magic, 0};
+    if (!_pallas_file_checksum(file, size, trailer[1])) {
+        pallas_error("Cannot read back %s\n", path);
+    }
+    fseek(file, 0, SEEK_END);
+    _pallas_fwrite(trailer, sizeof(trailer), 1, file);
+    fclose(file);
+}
+
+/** Returns whether a file ends with a trailer that matches its content, see _pallas_seal_file. */
+static bool _pallas_verify_file(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (file == nullptr)
+        return false;
+    uint32_t trailer[2];
+    uint32_t checksum = 0;
+    bool valid = fseek(file, -static_cast<long>(sizeof(trailer)), SEEK_END) == 0;
+    size_t size = valid ? ftell(file) : 0;
+    valid = valid && fread(trailer, sizeof(trailer), 1, file) == 1 && trailer[0] == _pallas_trailer_magic
+      && _pallas_file_checksum(file, size, checksum) && checksum == trailer[1];
+    fclose(file);
+    return valid;
+}
+
+/**
+ * Reads a whole file in memory and returns whether it ends with a trailer that matches its content.
+ * The file is then read from that copy, so that it's only read once from the disk.
+ * @param file Open file. Its stream is replaced by one over buffer.
+ * @param buffer Set to the content of the file. It must outlive the reads of the file.
+ */
+static bool _pallas_verify_and_buffer_file(File& file, std::vector<byte>& buffer) {
+    uint32_t trailer[2];
+    if (fseek(file.file, 0, SEEK_END) != 0)
+        return false;
+    size_t size = ftell(file.file);
+    if (size < sizeof(trailer))
+        return false;
+    buffer.resize(size);
+    rewind(file.file);
+    if (fread(buffer.data(), size, 1, file.file) != 1)
+        return false;
+    size -= sizeof(trailer);
+    memcpy(trailer, buffer.data() + size, sizeof(trailer));
+    if (trailer[0] != _pallas_trailer_magic || pallas::crc32c(buffer.data(), size, 0) != trailer[1])
+        return false;
+    FILE* memory_file = fmemopen(buffer.data(), size, "r");
+    if (memory_file == nullptr)
+        return false;
+    fclose(file.file);
+    file.file = memory_file;
+    return true;
+}
+
+/** Returns whether the trailers of the files of a trace should be verified when they are read. */
+static bool _pallas_should_verify_files(const pallas::GlobalArchive* trace) {
+    return trace->abi_version >= 21 && trace->parameter_handler != nullptr && trace->parameter_handler->verifyChecksums;
+}
 
 /**
  * Writes the array to the given file, but encodes and compresses it before
@@ -566,9 +676,13 @@ size_t numberCompressedBytes = 0;
  * @param n Number of elements in src.
  * @param file File to write in.
  * @param parameter_handler Handler for the storage options.
+ * @returns The checksum of the block that was written.
  */
-inline static void _pallas_compress_write(uint64_t* src, size_t n, FILE* file, const pallas::ParameterHandler* parameter_handler) {
+inline static uint32_t _pallas_compress_write(uint64_t* src, size_t n, FILE* file, const pallas::ParameterHandler* parameter_handler) {
     size_t size = n * sizeof(uint64_t);
+    PALLAS_WRITER_STATS_PHASE(pallas::pallas_current_writer_stats, pallas::PALLAS_PHASE_COMPRESSION);
+    PALLAS_WRITER_STATS_ADD_CURRENT(nb_subarrays_compressed, 1);
+    PALLAS_WRITER_STATS_ADD_CURRENT(nb_raw_bytes, size);
     uint64_t* encodedArray = nullptr;
     size_t encodedSize;
     // First we do the encoding
@@ -639,169 +753,317 @@ inline static void _pallas_compress_write(uint64_t* src, size_t n, FILE* file, c
         pallas_error("Invalid Compression algorithm\n");
     }
 
+    uint32_t checksum;
     if (parameter_handler->getCompressionAlgorithm() != pallas::CompressionAlgorithm::None) {
         pallas_log(pallas::DebugLevel::Debug, "Compressing %lu bytes as %lu bytes\n", size, compressedSize);
         _pallas_fwrite(&compressedSize, sizeof(compressedSize), 1, file);
         _pallas_fwrite(compressedArray, compressedSize, 1, file);
+        checksum = _pallas_block_checksum(compressedSize, compressedArray);
         numberRawBytes += size;
         numberCompressedBytes += compressedSize;
     } else if (parameter_handler->getEncodingAlgorithm() != pallas::EncodingAlgorithm::None) {
         pallas_log(pallas::DebugLevel::Debug, "Encoding %lu bytes as %lu bytes\n", size, encodedSize);
         _pallas_fwrite(&encodedSize, sizeof(encodedSize), 1, file);
         _pallas_fwrite(encodedArray, encodedSize, 1, file);
+        checksum = _pallas_block_checksum(encodedSize, encodedArray);
     } else {
         size_t offset = ftell(file);
         pallas_log(pallas::DebugLevel::Debug, "Writing %lu bytes as is @%lu in %p.\n", size, offset, file);
         _pallas_fwrite(&size, sizeof(size), 1, file);
         _pallas_fwrite(src, size, 1, file);
+        checksum = _pallas_block_checksum(size, src);
     }
     if (parameter_handler->getCompressionAlgorithm() != pallas::CompressionAlgorithm::None)
         delete[] compressedArray;
     if (parameter_handler->getEncodingAlgorithm() != pallas::EncodingAlgorithm::None)
         delete[] encodedArray;
+    return checksum;
+}
+
+/**
+ * Decompresses a block compressed by ZSTD, whose content must not be larger than maxSize.
+ * @param realSize Set to the size of the uncompressed data.
+ * @returns The uncompressed array, or nullptr if the block isn't a valid ZSTD frame of at most maxSize bytes.
+ */
+inline static uint64_t* _pallas_zstd_read_block(size_t& realSize, const byte* compArray, size_t compSize, size_t maxSize) {
+  auto contentSize = ZSTD_getFrameContentSize(compArray, compSize);
+  if (contentSize == ZSTD_CONTENTSIZE_ERROR || contentSize == ZSTD_CONTENTSIZE_UNKNOWN || contentSize > maxSize)
+    return nullptr;
+  realSize = contentSize;
+  auto dest = new uint64_t[realSize / sizeof(uint64_t) + 1];
+  if (ZSTD_isError(ZSTD_decompress(dest, realSize, compArray, compSize))) {
+    delete[] dest;
+    return nullptr;
+  }
+  return dest;
 }
 
 /**
  * Reads, de-encodes and decompresses an array from the given file,
  * according to the values of parameterHandler::EncodingAlgorithm and parameterHandler::CompressingAlgorithm.
+ * The size of the block is checked before it's allocated, and the block is compared to its checksum before it's
+ * decoded, so that a corrupted block is reported as such instead of making the decoders fail.
  * @param n Number of elements of 8 bytes dest is supposed to have.
  * @param file File to read from
- * @returns Array of uncompressed data of size uint64_t * n.
+ * @param expected_checksum Checksum of the block, if it must be verified, nullptr otherwise.
+ * @param error Set to the reason why the block can't be read, if it can't.
+ * @returns Array of uncompressed data of size uint64_t * n, or nullptr if the block is corrupted.
  */
-inline static uint64_t* _pallas_compress_read(size_t n, FILE* file, const pallas::ParameterHandler& parameter_handler) {
+inline static uint64_t* _pallas_compress_read(size_t n, FILE* file, const pallas::ParameterHandler& parameter_handler,
+                                              const uint32_t* expected_checksum, const char*& error) {
   size_t expectedSize = n * sizeof(uint64_t);
-  uint64_t* uncompressedArray = nullptr;
-
-  size_t compressedSize;
-  byte* compressedArray = nullptr;
-
-  size_t encodedSize;
-  byte* encodedArray = nullptr;
-
   auto compressionAlgorithm = parameter_handler.getCompressionAlgorithm();
   auto encodingAlgorithm = parameter_handler.getEncodingAlgorithm();
-  if (compressionAlgorithm != pallas::CompressionAlgorithm::None) {
-    _pallas_fread(&compressedSize, sizeof(compressedSize), 1, file);
-    compressedArray = new byte[compressedSize];
-    _pallas_fread(compressedArray, compressedSize, 1, file);
+
+  // Whatever the algorithms, the block is written as its size, then its data.
+  size_t blockSize;
+  long position = ftell(file);
+  if (position < 0 || fread(&blockSize, sizeof(blockSize), 1, file) != 1 || fseek(file, 0, SEEK_END) != 0) {
+    error = "cannot read the block";
+    return nullptr;
+  }
+  size_t remaining = ftell(file) - position - sizeof(blockSize);
+  fseek(file, position + sizeof(blockSize), SEEK_SET);
+  // Without compression, the size of the data is known.
+  bool validSize = blockSize <= remaining;
+  if (compressionAlgorithm == pallas::CompressionAlgorithm::None) {
+    validSize = validSize
+      && (encodingAlgorithm == pallas::EncodingAlgorithm::None ? blockSize == expectedSize : blockSize <= expectedSize);
+  }
+  if (!validSize) {
+    error = "invalid block size";
+    return nullptr;
+  }
+  auto block = new uint64_t[blockSize / sizeof(uint64_t) + 1];
+  auto blockData = reinterpret_cast<byte*>(block);
+  if (blockSize > 0 && fread(blockData, blockSize, 1, file) != 1) {
+    delete[] block;
+    error = "cannot read the block";
+    return nullptr;
+  }
+  if (expected_checksum && _pallas_block_checksum(blockSize, blockData) != *expected_checksum) {
+    delete[] block;
+    error = "checksum mismatch";
+    return nullptr;
   }
 
+  // Decompresses the block, if it was compressed. The Histogram compressions give the values directly.
+  uint64_t* uncompressedArray = nullptr;
+  uint64_t* encodedArray = block;
+  size_t encodedSize = blockSize;
   switch (compressionAlgorithm) {
   case pallas::CompressionAlgorithm::None:
     break;
   case pallas::CompressionAlgorithm::ZSTD: {
-    if (encodingAlgorithm == pallas::EncodingAlgorithm::None) {
-      size_t uncompressedSize;
-      uncompressedArray = _pallas_zstd_read(uncompressedSize, compressedArray, compressedSize);
-      pallas_assert(uncompressedSize == expectedSize);
-    } else {
-      encodedArray = reinterpret_cast<byte*>(_pallas_zstd_read(encodedSize, compressedArray, compressedSize));
-      pallas_assert(encodedSize <= expectedSize);
+    encodedArray = _pallas_zstd_read_block(encodedSize, blockData, blockSize, expectedSize);
+    if (encodedArray && encodingAlgorithm == pallas::EncodingAlgorithm::None && encodedSize != expectedSize) {
+      delete[] encodedArray;
+      encodedArray = nullptr;
     }
-    delete[] compressedArray;
     break;
   }
   case pallas::CompressionAlgorithm::Histogram: {
-    uncompressedArray = _pallas_histogram_read(n, compressedArray, compressedSize);
+    if (blockSize >= N_BYTES * n + 2 * sizeof(uint64_t))
+      uncompressedArray = _pallas_histogram_read(n, blockData, blockSize);
     break;
   }
   case pallas::CompressionAlgorithm::ZSTD_Histogram: {
-    // First ZSTD Decode
     size_t histogramSize;
-    auto tempUncompressedArray =
-      reinterpret_cast<byte*>(_pallas_zstd_read(histogramSize, compressedArray, compressedSize));
-    uncompressedArray = _pallas_histogram_read(n, tempUncompressedArray, histogramSize);
-    pallas_assert(n * sizeof(uint64_t) == expectedSize);
+    auto histogramArray = _pallas_zstd_read_block(histogramSize, blockData, blockSize, N_BYTES * n + 2 * sizeof(uint64_t));
+    if (histogramArray && histogramSize == N_BYTES * n + 2 * sizeof(uint64_t))
+      uncompressedArray = _pallas_histogram_read(n, reinterpret_cast<byte*>(histogramArray), histogramSize);
+    delete[] histogramArray;
     break;
   }
 #ifdef WITH_ZFP
   case pallas::CompressionAlgorithm::ZFP: {
-    uncompressedArray = _pallas_zfp_decompress(n, compressedArray, compressedSize);
+    uncompressedArray = _pallas_zfp_decompress(n, blockData, blockSize);
     break;
   }
 #endif
 #ifdef WITH_SZ
   case pallas::CompressionAlgorithm::SZ:
-    uncompressedArray = _pallas_sz_decompress(n, compressedArray, compressedSize);
+    uncompressedArray = _pallas_sz_decompress(n, blockData, blockSize);
     break;
 #endif
   default:
     pallas_error("Invalid Compression algorithm\n");
   }
 
-  switch (encodingAlgorithm) {
-  case pallas::EncodingAlgorithm::None:
-    break;
-  case pallas::EncodingAlgorithm::Masking: {
-    if (compressionAlgorithm == pallas::CompressionAlgorithm::None) {
-      _pallas_fread(&encodedSize, sizeof(encodedSize), 1, file);
-      encodedArray = new byte[encodedSize];  // Too big but don't care
-      _pallas_fread(encodedArray, encodedSize, 1, file);
+  // Then decodes it, unless it was decompressed to the values.
+  if (uncompressedArray == nullptr && encodedArray != nullptr) {
+    switch (encodingAlgorithm) {
+    case pallas::EncodingAlgorithm::None:
+      uncompressedArray = encodedArray;
+      encodedArray = nullptr;
+      break;
+    case pallas::EncodingAlgorithm::Masking:
+      uncompressedArray = _pallas_masking_read(n, reinterpret_cast<byte*>(encodedArray), encodedSize);
+      break;
+    case pallas::EncodingAlgorithm::LeadingZeroes:
+      pallas_error("Not yet implemented\n");
+      break;
+    default:
+      pallas_error("Invalid Encoding algorithm\n");
     }
-    uncompressedArray = _pallas_masking_read(n, encodedArray, encodedSize);
-    delete[] encodedArray;
-    break;
-  }
-  case pallas::EncodingAlgorithm::LeadingZeroes: {
-    pallas_error("Not yet implemented\n");
-    break;
-  }
-  default:
-    pallas_error("Invalid Encoding algorithm\n");
-  }
-
-  if (compressionAlgorithm == pallas::CompressionAlgorithm::None &&
-      encodingAlgorithm == pallas::EncodingAlgorithm::None) {
-    size_t realSize;
-    _pallas_fread(&realSize, sizeof(realSize), 1, file);
-    uncompressedArray = new uint64_t[n];
-    _pallas_fread(uncompressedArray, realSize, 1, file);
-    pallas_assert(realSize == n * sizeof(uint64_t));
   }
+  if (encodedArray != block)
+    delete[] encodedArray;
+  if (uncompressedArray != block)
+    delete[] block;
+  if (uncompressedArray == nullptr)
+    error = "invalid compressed data";
   return uncompressedArray;
 }
 
+/**
+ * Copies a block of stored data ([size][data], as written by _pallas_compress_write) from a file to another,
+ * without decoding it.
+ * @param srcPath Path of the file the block is read from.
+ * @param offset Offset of the block in srcPath.
+ * @param dst File to write in, at its current offset.
+ * @param checksum Checksum of the block. It's checked if has_checksum, and set otherwise.
+ * @param has_checksum Whether the checksum of the block is known, ie. whether its trace has checksums.
+ * @returns The offset of the block in dst.
+ */
+static size_t _pallas_copy_block(const char* srcPath, size_t offset, FILE* dst, uint32_t& checksum, bool has_checksum) {
+    size_t blockSize;
+    byte* block;
+    {
+        std::lock_guard lock(pallas::ParameterHandler::storage_lock);
+        File& f = *fileMap[srcPath];
+        if (!f.isOpen) {
+            f.open("r");
+        }
+        int ret = fseek(f.file, offset, 0);
+        while (ret == EBADF) {
+            f.close();
+            f.open("r");
+            ret = fseek(f.file, offset, 0);
+        }
+        _pallas_fread(&blockSize, sizeof(blockSize), 1, f.file);
+        block = new byte[blockSize];
+        _pallas_fread(block, blockSize, 1, f.file);
+    }
+    uint32_t blockChecksum = _pallas_block_checksum(blockSize, block);
+    if (has_checksum && blockChecksum != checksum) {
+        pallas_error("Checksum mismatch in the block @%zu of %s: the file is corrupted\n", offset, srcPath);
+    }
+    checksum = blockChecksum;
+    size_t newOffset = ftell(dst);
+    _pallas_fwrite(&blockSize, sizeof(blockSize), 1, dst);
+    _pallas_fwrite(block, blockSize, 1, dst);
+    delete[] block;
+    return newOffset;
+}
+
+/**
+ * Compares the blocks of stored data of a file to their checksums, without decoding them.
+ * The file is opened separately, so that several files can be verified at once.
+ * @param path Path of the file.
+ * @param blocks Offset and checksum of each block.
+ * @param errors Where a message is added for each block that doesn't match.
+ */
+static void _pallas_verify_blocks(const char* path, const std::vector<std::pair<size_t, uint32_t>>& blocks, std::vector<std::string>& errors) {
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+        errors.push_back(std::string("Cannot open ") + path + ": " + strerror(errno));
+        return;
+    }
+    fseek(file, 0, SEEK_END);
+    size_t fileSize = ftell(file);
+    std::vector<byte> block;
+    for (auto& [offset, checksum] : blocks) {
+        size_t blockSize = 0;
+        bool valid = offset + sizeof(blockSize) <= fileSize && fseek(file, offset, SEEK_SET) == 0
+          && fread(&blockSize, sizeof(blockSize), 1, file) == 1;
+        // The size is checked first, so that a corrupted one can't make us allocate the whole memory.
+        valid = valid && blockSize <= fileSize - offset - sizeof(blockSize);
+        if (valid) {
+            block.resize(blockSize);
+            valid = (blockSize == 0 || fread(block.data(), blockSize, 1, file) == 1)
+              && _pallas_block_checksum(blockSize, block.data()) == checksum;
+        }
+        if (!valid) {
+            errors.push_back(std::string("Checksum mismatch in the block @") + std::to_string(offset) + " of " + path);
+        }
+    }
+    fclose(file);
+}
+
 void pallas::LinkedVector::SubArray::write_to_file(FILE* file,  const ParameterHandler* parameter_handler) {
     first_value = array[0];
     last_value = array[size-1];
     offset = ftell(file);
-    _pallas_compress_write(array, size, file, parameter_handler);
-    delete[] array;
+    checksum = _pallas_compress_write(array, size, file, parameter_handler);
+    pallas::releaseSubArrayData(array);
     array = nullptr;
 }
 
 void pallas::LinkedDurationVector::SubArray::write_to_file(FILE* file,  const ParameterHandler* parameter_handler) {
     offset = ftell(file);
-    _pallas_compress_write(array, size, file, parameter_handler);
-    delete [] array;
+    checksum = _pallas_compress_write(array, size, file, parameter_handler);
+    pallas::releaseSubArrayData(array);
     array = nullptr;
 }
 
-void pallas::LinkedVector::write_to_file(FILE* infoFile, FILE* dataFile, const ParameterHandler* parameter_handler) {
+void pallas::LinkedVector::write_to_file(FILE* infoFile, FILE* dataFile, const ParameterHandler* parameter_handler, bool stream_from_file) {
     _pallas_fwrite(&size, sizeof(size), 1, infoFile);
     _pallas_fwrite(&n_sub_array, sizeof(n_sub_array), 1, infoFile);
     if (size == 0)
         return;
+    if (stream_from_file || spill) {
+        // Everything is in filePath: drop what's loaded, so the eviction can't free it while we're writing it.
+        // The spilled SubArrays that were loaded again are then skipped, instead of being written twice.
+        free_data();
+    }
     // Write the Subarrays statistics
     auto* sub_array = first;
     while (sub_array) {
-        if (sub_array->array != nullptr) {
-            sub_array->write_to_file(dataFile, parameter_handler);
+        if (stream_from_file && can_copy_data(sub_array, parameter_handler)) {
+            copy_data(sub_array, dataFile);
+        } else {
+            if (stream_from_file && sub_array->array == nullptr) {
+                sub_array->array = read_data(sub_array);
+            }
+            if (sub_array->array != nullptr) {
+                sub_array->write_to_file(dataFile, parameter_handler);
+            }
         }
         _pallas_fwrite(&sub_array->size, sizeof(sub_array->size), 1, infoFile);
         _pallas_fwrite(&sub_array->first_value, sizeof(sub_array->first_value), 1, infoFile);
         _pallas_fwrite(&sub_array->last_value, sizeof(sub_array->last_value), 1, infoFile);
         _pallas_fwrite(&sub_array->offset, sizeof(sub_array->offset), 1, infoFile);
+        _pallas_fwrite(&sub_array->checksum, sizeof(sub_array->checksum), 1, infoFile);
         sub_array = sub_array->next;
     }
     free_data();
 }
 
-pallas::LinkedVector::SubArray::SubArray(FILE* file, SubArray* previous) {
+/** Appends values to a live data file as one block, and returns its description with its first and last values. */
+static pallas::LivePublication::Block _pallas_publish_block(uint64_t* values, size_t n, FILE* dataFile, const pallas::ParameterHandler* parameter_handler) {
+    pallas::LivePublication::Block block{n, {values[0], values[n - 1], 0}, static_cast<size_t>(ftell(dataFile)), 0};
+    block.checksum = _pallas_compress_write(values, n, dataFile, parameter_handler);
+    return block;
+}
+
+/** Appends durations to a live data file as one block, and returns its description with their min, max and mean. */
+static pallas::LivePublication::Block _pallas_publish_duration_block(uint64_t* values, size_t n, FILE* dataFile, const pallas::ParameterHandler* parameter_handler) {
+    auto block = _pallas_publish_block(values, n, dataFile, parameter_handler);
+    auto statistics = pallas::computeValueStatistics(values, n);
+    block.statistics[0] = statistics.min;
+    block.statistics[1] = statistics.max;
+    block.statistics[2] = std::clamp(statistics.sum / n, statistics.min, statistics.max);
+    return block;
+}
+
+pallas::LinkedVector::SubArray::SubArray(FILE* file, SubArray* previous, bool has_checksum) {
     _pallas_fread(&size, sizeof(size), 1, file);
     _pallas_fread(&first_value, sizeof(first_value), 1, file);
     _pallas_fread(&last_value, sizeof(last_value), 1, file);
     _pallas_fread(&offset, sizeof(offset), 1, file);
+    if (has_checksum)
+        _pallas_fread(&checksum, sizeof(checksum), 1, file);
     allocated = 0;
     this->previous = previous;
     if (previous) {
@@ -812,6 +1074,7 @@ pallas::LinkedVector::SubArray::SubArray(FILE* file, SubArray* previous) {
 
 pallas::LinkedVector::LinkedVector(FILE* vectorFile, const char* valueFilePath, ParameterHandler& parameter_handler, uint8_t abi_version) : parameter_handler(parameter_handler) {
     filePath = valueFilePath;
+    has_checksums = abi_version >= 21;
     first = nullptr;
     last = nullptr;
     _pallas_fread(&size, sizeof(size), 1, vectorFile);
@@ -825,12 +1088,12 @@ pallas::LinkedVector::LinkedVector(FILE* vectorFile, const char* valueFilePath,
         first = reinterpret_cast<SubArray*>(std::calloc(n_sub_array, sizeof(SubArray)));
         is_contiguous = true;
         for (size_t i = 0; i <n_sub_array; i++) {
-            last = new (&first[i]) SubArray(vectorFile, last);
+            last = new (&first[i]) SubArray(vectorFile, last, has_checksums);
         }
     } else {
         size_t temp_size = 0;
         while (temp_size < size) {
-            last = new SubArray(vectorFile, last);
+            last = new SubArray(vectorFile, last, has_checksums);
             if (first == nullptr) {
                 first = last;
             }
@@ -840,7 +1103,7 @@ pallas::LinkedVector::LinkedVector(FILE* vectorFile, const char* valueFilePath,
     }
 }
 
-void pallas::LinkedDurationVector::write_to_file(FILE* vectorFile, FILE* valueFile, const ParameterHandler* parameter_handler) {
+void pallas::LinkedDurationVector::write_to_file(FILE* vectorFile, FILE* valueFile, const ParameterHandler* parameter_handler, bool stream_from_file) {
     _pallas_fwrite(&size, sizeof(size), 1, vectorFile);
     _pallas_fwrite(&n_sub_array, sizeof(n_sub_array), 1, vectorFile);
     if (size == 0)
@@ -854,11 +1117,23 @@ void pallas::LinkedDurationVector::write_to_file(FILE* vectorFile, FILE* valueFi
     _pallas_fwrite(&mean, sizeof(mean), 1, vectorFile);
     pallas_assert_inferior_equal(mean, max);
     pallas_assert_inferior_equal(min, mean);
+    if (stream_from_file || spill) {
+        // Everything is in filePath: drop what's loaded, so the eviction can't free it while we're writing it.
+        // The spilled SubArrays that were loaded again are then skipped, instead of being written twice.
+        free_data();
+    }
     // Then write the statistics for all the sub_arrays.
     auto* sub_array = first;
     while (sub_array) {
-        if (sub_array->array != nullptr) {
-            sub_array->write_to_file(valueFile, parameter_handler);
+        if (stream_from_file && can_copy_data(sub_array, parameter_handler)) {
+            copy_data(sub_array, valueFile);
+        } else {
+            if (stream_from_file && sub_array->array == nullptr) {
+                sub_array->array = read_data(sub_array);
+            }
+            if (sub_array->array != nullptr) {
+                sub_array->write_to_file(valueFile, parameter_handler);
+            }
         }
         _pallas_fwrite(&sub_array->size, sizeof(sub_array->size), 1, vectorFile);
         _pallas_fwrite(&sub_array->min, sizeof(sub_array->min), 1, vectorFile);
@@ -867,13 +1142,14 @@ void pallas::LinkedDurationVector::write_to_file(FILE* vectorFile, FILE* valueFi
         pallas_assert_inferior_equal(sub_array->mean, sub_array->max);
         pallas_assert_inferior_equal(sub_array->min, sub_array->mean);
         _pallas_fwrite(&sub_array->offset, sizeof(sub_array->offset), 1, vectorFile);
+        _pallas_fwrite(&sub_array->checksum, sizeof(sub_array->checksum), 1, vectorFile);
         sub_array = sub_array->next;
     }
     free_data();
 }
 
 // NOTE: leading space
- pallas::LinkedDurationVector::SubArray::SubArray(FILE* file, SubArray* previous) {
+ pallas::LinkedDurationVector::SubArray::SubArray(FILE* file, SubArray* previous, bool has_checksum) {
     _pallas_fread(&size, sizeof(size), 1, file);
     _pallas_fread(&min, sizeof(min), 1, file);
     _pallas_fread(&max, sizeof(max), 1, file);
@@ -893,6 +1169,8 @@ void pallas::LinkedDurationVector::write_to_file(FILE* vectorFile, FILE* valueFi
     pallas_assert_inferior_equal(mean, max);
     pallas_assert_inferior_equal(min, mean);
     _pallas_fread(&offset, sizeof(offset), 1, file);
+    if (has_checksum)
+        _pallas_fread(&checksum, sizeof(checksum), 1, file);
     allocated = 0;
     this->previous = previous;
     if (previous) {
@@ -904,6 +1182,7 @@ void pallas::LinkedDurationVector::write_to_file(FILE* vectorFile, FILE* valueFi
 
 pallas::LinkedDurationVector::LinkedDurationVector(FILE* vectorFile, const char* valueFilePath, ParameterHandler& parameter_handler, uint8_t abi_version): parameter_handler(parameter_handler) {
     filePath = valueFilePath;
+    has_checksums = abi_version >= 21;
     first = nullptr;
     last = nullptr;
     _pallas_fread(&size, sizeof(size), 1, vectorFile);
@@ -921,12 +1200,12 @@ pallas::LinkedDurationVector::LinkedDurationVector(FILE* vectorFile, const char*
         first = reinterpret_cast<SubArray*>(std::calloc(n_sub_array, sizeof(SubArray)));
         is_contiguous = true;
         for (size_t i = 0; i <n_sub_array; i++) {
-            last = new (&first[i]) SubArray(vectorFile, last);
+            last = new (&first[i]) SubArray(vectorFile, last, has_checksums);
         }
     } else {
         size_t temp_size = 0;
         while (temp_size < size) {
-            last = new SubArray(vectorFile, last);
+            last = new SubArray(vectorFile, last, has_checksums);
             if (first == nullptr) {
                 first = last;
             }
@@ -936,9 +1215,31 @@ pallas::LinkedDurationVector::LinkedDurationVector(FILE* vectorFile, const char*
     }
 }
 
-void pallas::LinkedVector::load_data(SubArray* sub) {
-  pallas_log(DebugLevel::Debug, "Loading timestamps from %s @ %lu\n", filePath, sub->offset);
-  File& f = *fileMap[filePath];
+/**
+ * Returns a data file that SubArrays are spilled to, positioned at its end.
+ * It's reopened for appending if it was closed, or opened for reading by read_data.
+ * The caller must hold the storage lock.
+ */
+static FILE* _pallas_spill_file(const char* path) {
+  File& f = *fileMap[path];
+  if (!f.isOpen || f.mode == "r") {
+    if (f.isOpen) {
+      f.close();
+    }
+    f.open("a+");
+  }
+  if (!f.isOpen) {
+    pallas_error("Cannot spill to %s\n", path);
+  }
+  fseek(f.file, 0, SEEK_END);
+  return f.file;
+}
+
+uint64_t* pallas::LinkedVector::read_data(const SubArray* sub) const {
+  const auto* owner = sub->source ? sub->source : this;
+  pallas_log(DebugLevel::Debug, "Loading timestamps from %s @ %lu\n", owner->filePath, sub->offset);
+  std::lock_guard lock(ParameterHandler::storage_lock);
+  File& f = *fileMap[owner->filePath];
   if (!f.isOpen) {
     f.open("r");
   }
@@ -948,15 +1249,61 @@ void pallas::LinkedVector::load_data(SubArray* sub) {
     f.open("r");
     ret = fseek(f.file, sub->offset, 0);
   }
-  sub->array = _pallas_compress_read(sub->size, f.file, parameter_handler);
+  bool verify = owner->has_checksums && owner->parameter_handler.verifyChecksums;
+  const char* error = nullptr;
+  uint64_t* array = _pallas_compress_read(sub->size, f.file, owner->parameter_handler, verify ? &sub->checksum : nullptr, error);
+  if (array == nullptr) {
+    pallas_error("Cannot read the timestamps of %s @ %lu: %s, the file is corrupted (PALLAS_VERIFY_CHECKSUMS=0 skips the checksums)\n",
+                 owner->filePath, sub->offset, error);
+  }
+  return array;
+}
+
+bool pallas::LinkedVector::can_copy_data(const SubArray* sub, const ParameterHandler* parameter_handler) const {
+    const auto* owner = sub->source ? sub->source : this;
+    return sub->array == nullptr && owner->filePath != nullptr
+      && owner->parameter_handler.getCompressionAlgorithm() == parameter_handler->getCompressionAlgorithm()
+      && owner->parameter_handler.getEncodingAlgorithm() == parameter_handler->getEncodingAlgorithm();
+}
+
+void pallas::LinkedVector::copy_data(SubArray* sub, FILE* dataFile) const {
+    const auto* owner = sub->source ? sub->source : this;
+    sub->offset = _pallas_copy_block(owner->filePath, sub->offset, dataFile, sub->checksum, owner->has_checksums);
+}
+
+size_t pallas::LinkedVector::verify_checksums(std::vector<std::string>& errors) const {
+    std::map<const char*, std::vector<std::pair<size_t, uint32_t>>> blocks;
+    size_t nb_blocks = 0;
+    for (auto* sub = first; sub != nullptr; sub = sub->next) {
+        const auto* owner = sub->source ? sub->source : this;
+        if (owner->filePath == nullptr || !owner->has_checksums || sub->size == 0)
+            continue;
+        blocks[owner->filePath].emplace_back(sub->offset, sub->checksum);
+        nb_blocks++;
+    }
+    for (auto& [path, file_blocks] : blocks) {
+        _pallas_verify_blocks(path, file_blocks, errors);
+    }
+    return nb_blocks;
+}
+
+void pallas::LinkedVector::load_data(SubArray* sub) {
+    std::lock_guard lock(ParameterHandler::storage_lock);
+    sub->array = read_data(sub);
     parameter_handler.loaded_durations_size += sub->size * sizeof(uint64_t);
     parameter_handler.subvector_queue.emplace_back(sub);
 }
 
+void pallas::LinkedVector::spill_data(SubArray* sub) {
+    std::lock_guard lock(ParameterHandler::storage_lock);
+    sub->write_to_file(_pallas_spill_file(filePath), &parameter_handler);
+}
 
-void pallas::LinkedDurationVector::load_data(SubArray* sub) {
-    pallas_log(DebugLevel::Debug, "Loading timestamps from %s @ %lu\n", filePath, sub->offset);
-    File& f = *fileMap[filePath];
+uint64_t* pallas::LinkedDurationVector::read_data(const SubArray* sub) const {
+    const auto* owner = sub->source ? sub->source : this;
+    pallas_log(DebugLevel::Debug, "Loading durations from %s @ %lu\n", owner->filePath, sub->offset);
+    std::lock_guard lock(ParameterHandler::storage_lock);
+    File& f = *fileMap[owner->filePath];
     if (!f.isOpen) {
         f.open("r");
     }
@@ -966,11 +1313,56 @@ void pallas::LinkedDurationVector::load_data(SubArray* sub) {
         f.open("r");
         ret = fseek(f.file, sub->offset, 0);
     }
-    sub->array = _pallas_compress_read(sub->size, f.file, parameter_handler);
+    bool verify = owner->has_checksums && owner->parameter_handler.verifyChecksums;
+    const char* error = nullptr;
+    uint64_t* array = _pallas_compress_read(sub->size, f.file, owner->parameter_handler, verify ? &sub->checksum : nullptr, error);
+    if (array == nullptr) {
+        pallas_error("Cannot read the durations of %s @ %lu: %s, the file is corrupted (PALLAS_VERIFY_CHECKSUMS=0 skips the checksums)\n",
+                     owner->filePath, sub->offset, error);
+    }
+    return array;
+}
+
+bool pallas::LinkedDurationVector::can_copy_data(const SubArray* sub, const ParameterHandler* parameter_handler) const {
+    const auto* owner = sub->source ? sub->source : this;
+    return sub->array == nullptr && owner->filePath != nullptr
+      && owner->parameter_handler.getCompressionAlgorithm() == parameter_handler->getCompressionAlgorithm()
+      && owner->parameter_handler.getEncodingAlgorithm() == parameter_handler->getEncodingAlgorithm();
+}
+
+void pallas::LinkedDurationVector::copy_data(SubArray* sub, FILE* dataFile) const {
+    const auto* owner = sub->source ? sub->source : this;
+    sub->offset = _pallas_copy_block(owner->filePath, sub->offset, dataFile, sub->checksum, owner->has_checksums);
+}
+
+size_t pallas::LinkedDurationVector::verify_checksums(std::vector<std::string>& errors) const {
+    std::map<const char*, std::vector<std::pair<size_t, uint32_t>>> blocks;
+    size_t nb_blocks = 0;
+    for (auto* sub = first; sub != nullptr; sub = sub->next) {
+        const auto* owner = sub->source ? sub->source : this;
+        if (owner->filePath == nullptr || !owner->has_checksums || sub->size == 0)
+            continue;
+        blocks[owner->filePath].emplace_back(sub->offset, sub->checksum);
+        nb_blocks++;
+    }
+    for (auto& [path, file_blocks] : blocks) {
+        _pallas_verify_blocks(path, file_blocks, errors);
+    }
+    return nb_blocks;
+}
+
+void pallas::LinkedDurationVector::load_data(SubArray* sub) {
+    std::lock_guard lock(ParameterHandler::storage_lock);
+    sub->array = read_data(sub);
     parameter_handler.loaded_durations_size += sub->size * sizeof(uint64_t);
     parameter_handler.subvector_queue.emplace_back(sub);
 }
 
+void pallas::LinkedDurationVector::spill_data(SubArray* sub) {
+    std::lock_guard lock(ParameterHandler::storage_lock);
+    sub->write_to_file(_pallas_spill_file(filePath), &parameter_handler);
+}
+
 /**************** Storage Functions ****************/
 
 void pallas_storage_init(const char* dir_name) {
@@ -982,13 +1374,17 @@ static const char* base_dirname(pallas::Archive* a) {
   return a->dir_name;
 }
 
-static const char* getThreadPath(pallas::Thread* th) {
+static const char* getThreadPath(pallas::LocationGroupId archive_id, pallas::ThreadId thread_id) {
   char* folderPath = new char[1024];
-  snprintf(folderPath, 1024, "archive_%u/thread_%u", th->archive->id, th->id);
+  snprintf(folderPath, 1024, "archive_%u/thread_%u", archive_id, thread_id);
   //  snprintf(folderPath, 1024, "thread_%u", th->id);
   return folderPath;
 }
 
+static const char* getThreadPath(pallas::Thread* th) {
+  return getThreadPath(th->archive->id, th->id);
+}
+
 static const char* pallasGetEventDurationFilename(const char* base_dirname, pallas::Thread* th) {
   char* filename = new char[1024];
   const char* threadPath = getThreadPath(th);
@@ -997,47 +1393,506 @@ static const char* pallasGetEventDurationFilename(const char* base_dirname, pall
   return filename;
 }
 
-static void _pallas_store_attribute_values(pallas::Event* e, const File& file, const pallas::ParameterHandler& parameter_handler) {
-  file.write(&e->attribute_pos, sizeof(e->attribute_pos), 1);
-  if (e->attribute_pos > 0) {
-    pallas_log(pallas::DebugLevel::Debug, "\t\tStore %lu attributes\n", e->attribute_pos);
-    if (parameter_handler.getCompressionAlgorithm() != pallas::CompressionAlgorithm::None) {
-      size_t compressedSize = ZSTD_compressBound(e->attribute_pos);
-      byte* compressedArray = new byte[compressedSize];
-      compressedSize = _pallas_zstd_compress(e->attribute_buffer, e->attribute_pos, compressedArray, compressedSize, parameter_handler.getZstdCompressionLevel());
-      file.write(&compressedSize, sizeof(compressedSize), 1);
-      file.write(compressedArray, compressedSize, 1);
-      delete[] compressedArray;
-    } else {
-      file.write(e->attribute_buffer, e->attribute_pos, 1);
+static const char* pallasGetLabelsFilename(const char* base_dirname, pallas::Thread* th) {
+  char* filename = new char[1024];
+  const char* threadPath = getThreadPath(th);
+  snprintf(filename, 1024, "%s/%s/labels.dat", base_dirname, threadPath);
+  delete[] threadPath;
+  return filename;
+}
+
+/**
+ * Returns a checksum of the id maps of a Thread. pallas_sync and pallas_merge renumber the definitions of the Threads,
+ * sometimes without changing their number: the caches indexed by definition are only valid for the same id maps.
+ */
+static uint32_t _pallas_id_maps_checksum(const pallas::Thread* th) {
+  uint32_t checksum = _pallas_block_checksum(th->event_id_map.size() * sizeof(uint32_t), th->event_id_map.data());
+  checksum = pallas::crc32c(th->sequence_id_map.data(), th->sequence_id_map.size() * sizeof(uint32_t), checksum);
+  return pallas::crc32c(th->loop_id_map.data(), th->loop_id_map.size() * sizeof(uint32_t), checksum);
+}
+
+/**
+ * Stores the label table of a Thread. It is only a cache: it can be deleted, and it is rebuilt if it's missing
+ * or if the id maps of the Thread changed.
+ */
+static void pallasStoreThreadLabels(const char* path, pallas::Thread* th) {
+  const char* labelsFilename = pallasGetLabelsFilename(path, th);
+  File labelsFile = File(labelsFilename, "w");
+  delete[] labelsFilename;
+  if (!labelsFile.is_open())
+    return;
+  size_t nb_sequences = th->nb_sequences;
+  size_t nb_labels = th->sequence_labels.size();
+  uint32_t id_maps_checksum = _pallas_id_maps_checksum(th);
+  labelsFile.write(&nb_sequences, sizeof(nb_sequences), 1);
+  labelsFile.write(&id_maps_checksum, sizeof(id_maps_checksum), 1);
+  labelsFile.write(&nb_labels, sizeof(nb_labels), 1);
+  for (const auto& label : th->sequence_labels) {
+    labelsFile.writeString(label);
+  }
+  labelsFile.write(th->sequence_label_ids.data(), sizeof(uint32_t), nb_sequences);
+  labelsFile.close();
+  _pallas_seal_file(labelsFile.path);
+}
+
+bool pallasLoadThreadLabels(pallas::Thread* th) {
+  if (th->archive == nullptr || th->archive->dir_name == nullptr)
+    return false;
+  const char* labelsFilename = pallasGetLabelsFilename(th->archive->dir_name, th);
+  std::error_code error;
+  if (!std::filesystem::exists(labelsFilename, error)) {
+    delete[] labelsFilename;
+    return false;
+  }
+  if (th->archive->global_archive && _pallas_should_verify_files(th->archive->global_archive)
+      && !_pallas_verify_file(labelsFilename)) {
+    pallas_warn("Ignoring the labels of Thread %u, %s is corrupted\n", th->id, labelsFilename);
+    delete[] labelsFilename;
+    return false;
+  }
+  File labelsFile = File(labelsFilename, "r");
+  delete[] labelsFilename;
+  if (!labelsFile.is_open())
+    return false;
+  size_t nb_sequences;
+  size_t nb_labels;
+  uint32_t id_maps_checksum;
+  labelsFile.read(&nb_sequences, sizeof(nb_sequences), 1);
+  labelsFile.read(&id_maps_checksum, sizeof(id_maps_checksum), 1);
+  if (nb_sequences != th->nb_sequences || id_maps_checksum != _pallas_id_maps_checksum(th)) {
+    pallas_log(pallas::DebugLevel::Verbose, "Ignoring outdated labels of Thread %u\n", th->id);
+    labelsFile.close();
+    return false;
+  }
+  labelsFile.read(&nb_labels, sizeof(nb_labels), 1);
+  th->sequence_labels.resize(nb_labels);
+  for (size_t i = 0; i < nb_labels; i++) {
+    th->sequence_labels[i] = labelsFile.readString();
+  }
+  th->sequence_label_ids.resize(nb_sequences);
+  labelsFile.read(th->sequence_label_ids.data(), sizeof(uint32_t), nb_sequences);
+  labelsFile.close();
+  return true;
+}
+
+static const char* pallasGetStatisticsFilename(const char* base_dirname, pallas::Thread* th) {
+  char* filename = new char[1024];
+  const char* threadPath = getThreadPath(th);
+  snprintf(filename, 1024, "%s/%s/statistics.dat", base_dirname, threadPath);
+  delete[] threadPath;
+  return filename;
+}
+
+/** Writes a DurationStatistics. The histogram and the sketch are written sparsely, as (index, count) pairs. */
+static void _pallas_write_statistics(const pallas::DurationStatistics& statistics, const File& file) {
+  file.write((void*)&statistics.count, sizeof(statistics.count), 1);
+  if (statistics.count == 0)
+    return;
+  file.write((void*)&statistics.sum, sizeof(statistics.sum), 1);
+  file.write((void*)&statistics.min, sizeof(statistics.min), 1);
+  file.write((void*)&statistics.max, sizeof(statistics.max), 1);
+  file.write((void*)&statistics.mean, sizeof(statistics.mean), 1);
+  file.write((void*)&statistics.m2, sizeof(statistics.m2), 1);
+
+  uint8_t nb_buckets = 0;
+  for (auto bucket_count : statistics.histogram)
+    nb_buckets += bucket_count != 0;
+  file.write(&nb_buckets, sizeof(nb_buckets), 1);
+  for (uint8_t i = 0; i < PALLAS_STATISTICS_HISTOGRAM_SIZE; i++) {
+    if (statistics.histogram[i]) {
+      file.write(&i, sizeof(i), 1);
+      file.write((void*)&statistics.histogram[i], sizeof(uint64_t), 1);
+    }
+  }
+
+  file.write((void*)&statistics.sketch_zeros, sizeof(statistics.sketch_zeros), 1);
+  file.write((void*)&statistics.sketch_offset, sizeof(statistics.sketch_offset), 1);
+  uint32_t sketch_size = statistics.sketch_counts.size();
+  uint32_t nb_sketch_buckets = 0;
+  for (auto bucket_count : statistics.sketch_counts)
+    nb_sketch_buckets += bucket_count != 0;
+  file.write(&sketch_size, sizeof(sketch_size), 1);
+  file.write(&nb_sketch_buckets, sizeof(nb_sketch_buckets), 1);
+  for (uint32_t i = 0; i < sketch_size; i++) {
+    if (statistics.sketch_counts[i]) {
+      file.write(&i, sizeof(i), 1);
+      file.write((void*)&statistics.sketch_counts[i], sizeof(uint64_t), 1);
     }
   }
 }
 
-static void _pallas_read_attribute_values(pallas::Event* e, const File& file, const pallas::ParameterHandler& parameter_handler, uint8_t abi_version) {
-  file.read(&e->attribute_pos, sizeof(e->attribute_pos), 1);
-  e->attribute_buffer_size = e->attribute_pos;
+static void _pallas_read_statistics(pallas::DurationStatistics& statistics, const File& file) {
+  statistics = pallas::DurationStatistics();
+  file.read(&statistics.count, sizeof(statistics.count), 1);
+  if (statistics.count == 0)
+    return;
+  file.read(&statistics.sum, sizeof(statistics.sum), 1);
+  file.read(&statistics.min, sizeof(statistics.min), 1);
+  file.read(&statistics.max, sizeof(statistics.max), 1);
+  file.read(&statistics.mean, sizeof(statistics.mean), 1);
+  file.read(&statistics.m2, sizeof(statistics.m2), 1);
+
+  uint8_t nb_buckets;
+  file.read(&nb_buckets, sizeof(nb_buckets), 1);
+  for (uint8_t n = 0; n < nb_buckets; n++) {
+    uint8_t i;
+    file.read(&i, sizeof(i), 1);
+    pallas_assert(i < PALLAS_STATISTICS_HISTOGRAM_SIZE);
+    file.read(&statistics.histogram[i], sizeof(uint64_t), 1);
+  }
+
+  file.read(&statistics.sketch_zeros, sizeof(statistics.sketch_zeros), 1);
+  file.read(&statistics.sketch_offset, sizeof(statistics.sketch_offset), 1);
+  uint32_t sketch_size;
+  uint32_t nb_sketch_buckets;
+  file.read(&sketch_size, sizeof(sketch_size), 1);
+  file.read(&nb_sketch_buckets, sizeof(nb_sketch_buckets), 1);
+  statistics.sketch_counts.resize(sketch_size, 0);
+  for (uint32_t n = 0; n < nb_sketch_buckets; n++) {
+    uint32_t i;
+    file.read(&i, sizeof(i), 1);
+    pallas_assert(i < sketch_size);
+    file.read(&statistics.sketch_counts[i], sizeof(uint64_t), 1);
+  }
+}
+
+/**
+ * Stores the statistics of the Sequences and Events of a Thread.
+ * Like the labels, they are only a cache: they are computed again if they are missing, or if the number of
+ * definitions or the id maps of the Thread changed.
+ */
+static void pallasStoreThreadStatistics(const char* path, pallas::Thread* th) {
+  const char* statisticsFilename = pallasGetStatisticsFilename(path, th);
+  File statisticsFile = File(statisticsFilename, "w");
+  delete[] statisticsFilename;
+  if (!statisticsFile.is_open())
+    return;
+  size_t nb_events = th->nb_events;
+  size_t nb_sequences = th->nb_sequences;
+  uint32_t id_maps_checksum = _pallas_id_maps_checksum(th);
+  statisticsFile.write(&nb_events, sizeof(nb_events), 1);
+  statisticsFile.write(&nb_sequences, sizeof(nb_sequences), 1);
+  statisticsFile.write(&id_maps_checksum, sizeof(id_maps_checksum), 1);
+  for (const auto& statistics : th->event_statistics)
+    _pallas_write_statistics(statistics, statisticsFile);
+  for (const auto& statistics : th->sequence_statistics)
+    _pallas_write_statistics(statistics, statisticsFile);
+  statisticsFile.close();
+  _pallas_seal_file(statisticsFile.path);
+}
+
+bool pallasLoadThreadStatistics(pallas::Thread* th) {
+  if (th->archive == nullptr || th->archive->dir_name == nullptr)
+    return false;
+  const char* statisticsFilename = pallasGetStatisticsFilename(th->archive->dir_name, th);
+  std::error_code error;
+  if (!std::filesystem::exists(statisticsFilename, error)) {
+    delete[] statisticsFilename;
+    return false;
+  }
+  if (th->archive->global_archive && _pallas_should_verify_files(th->archive->global_archive)
+      && !_pallas_verify_file(statisticsFilename)) {
+    pallas_warn("Ignoring the statistics of Thread %u, %s is corrupted\n", th->id, statisticsFilename);
+    delete[] statisticsFilename;
+    return false;
+  }
+  File statisticsFile = File(statisticsFilename, "r");
+  delete[] statisticsFilename;
+  if (!statisticsFile.is_open())
+    return false;
+  size_t nb_events;
+  size_t nb_sequences;
+  uint32_t id_maps_checksum;
+  statisticsFile.read(&nb_events, sizeof(nb_events), 1);
+  statisticsFile.read(&nb_sequences, sizeof(nb_sequences), 1);
+  statisticsFile.read(&id_maps_checksum, sizeof(id_maps_checksum), 1);
+  if (nb_events != th->nb_events || nb_sequences != th->nb_sequences
+      || id_maps_checksum != _pallas_id_maps_checksum(th)) {
+    pallas_log(pallas::DebugLevel::Verbose, "Ignoring outdated statistics of Thread %u\n", th->id);
+    statisticsFile.close();
+    return false;
+  }
+  std::vector<pallas::DurationStatistics> event_statistics(nb_events);
+  std::vector<pallas::DurationStatistics> sequence_statistics(nb_sequences);
+  for (auto& statistics : event_statistics)
+    _pallas_read_statistics(statistics, statisticsFile);
+  for (auto& statistics : sequence_statistics)
+    _pallas_read_statistics(statistics, statisticsFile);
+  statisticsFile.close();
+  // The number of occurrences of the Sequences is known without loading their durations.
+  for (size_t i = 0; i < nb_sequences; i++) {
+    auto* durations = th->sequences[i].durations;
+    if (durations && durations->size != sequence_statistics[i].count) {
+      pallas_log(pallas::DebugLevel::Verbose, "Ignoring outdated statistics of Thread %u\n", th->id);
+      return false;
+    }
+  }
+  th->event_statistics = std::move(event_statistics);
+  th->sequence_statistics = std::move(sequence_statistics);
+  return true;
+}
+
+/*
+ * The attributes of an Event are stored by column: the AttributeLists are split in one column of values per
+ * AttributeRef, and each list is described by its occurrence index and by its layout, the columns of its values.
+ * The columns are then stored as arrays of uint64_t, encoded and compressed independently of each other.
+ */
+
+/** Values of one AttributeRef, in the order of the occurrences. */
+struct AttributeColumn {
+  pallas::AttributeRef ref;
+  uint16_t value_size;
+  std::vector<uint64_t> values;
+};
+
+/** How an array of attribute values is encoded. */
+enum AttributeArrayEncoding : uint8_t {
+  ATTRIBUTE_ARRAY_RAW = 0,   /**< The values themselves. */
+  ATTRIBUTE_ARRAY_DELTA = 1, /**< The zigzag-encoded differences between consecutive values, for counters. */
+};
+
+/** Returns the number of bytes needed to store the largest of the values. */
+static uint8_t _pallas_attribute_array_width(const std::vector<uint64_t>& values) {
+  uint64_t mask = 0;
+  for (auto v : values)
+    mask |= v;
+  uint8_t width = 0;
+  while (mask != 0) {
+    mask >>= 8;
+    width++;
+  }
+  return width;
+}
+
+/**
+ * Writes an array of attribute values, either as is or as deltas, whichever needs the fewest bytes per value.
+ * The values are packed on that many bytes, and compressed with ZSTD unless the compression is disabled.
+ * Attributes must not be altered, so the lossy compression algorithms are replaced by ZSTD.
+ */
+static void _pallas_write_attribute_array(const std::vector<uint64_t>& values, const File& file, const pallas::ParameterHandler& parameter_handler) {
+  std::vector<uint64_t> deltas(values.size());
+  uint64_t previous = 0;
+  for (size_t i = 0; i < values.size(); i++) {
+    auto delta = static_cast<int64_t>(values[i] - previous);
+    deltas[i] = (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63);
+    previous = values[i];
+  }
+  uint8_t raw_width = _pallas_attribute_array_width(values);
+  uint8_t delta_width = _pallas_attribute_array_width(deltas);
+  AttributeArrayEncoding encoding = delta_width < raw_width ? ATTRIBUTE_ARRAY_DELTA : ATTRIBUTE_ARRAY_RAW;
+  uint8_t width = encoding == ATTRIBUTE_ARRAY_DELTA ? delta_width : raw_width;
+  const auto& encoded = encoding == ATTRIBUTE_ARRAY_DELTA ? deltas : values;
+  file.write(&encoding, sizeof(encoding), 1);
+  file.write(&width, sizeof(width), 1);
+  if (width == 0)
+    return;
+
+  size_t size = encoded.size() * width;
+  auto* packed = new byte[size];
+  for (size_t i = 0; i < encoded.size(); i++) {
+    // FIXME Only works on little-endian architectures, like the Masking encoding.
+    memcpy(&packed[i * width], &encoded[i], width);
+  }
+  if (parameter_handler.getCompressionAlgorithm() != pallas::CompressionAlgorithm::None) {
+    size_t compressedSize = ZSTD_compressBound(size);
+    auto* compressedArray = new byte[compressedSize];
+    compressedSize = _pallas_zstd_compress(packed, size, compressedArray, compressedSize, parameter_handler.getZstdCompressionLevel());
+    file.write(&compressedSize, sizeof(compressedSize), 1);
+    file.write(compressedArray, compressedSize, 1);
+    delete[] compressedArray;
+  } else {
+    file.write(packed, size, 1);
+  }
+  delete[] packed;
+}
+
+/** Reads an array of n attribute values written by _pallas_write_attribute_array. */
+static std::vector<uint64_t> _pallas_read_attribute_array(size_t n, const File& file, const pallas::ParameterHandler& parameter_handler) {
+  AttributeArrayEncoding encoding;
+  uint8_t width;
+  file.read(&encoding, sizeof(encoding), 1);
+  file.read(&width, sizeof(width), 1);
+  std::vector<uint64_t> values(n, 0);
+  if (width == 0)
+    return values;
+  if (width > sizeof(uint64_t))
+    pallas_error("Invalid width of attribute values: %u\n", width);
+
+  size_t size = n * width;
+  byte* packed;
+  if (parameter_handler.getCompressionAlgorithm() != pallas::CompressionAlgorithm::None) {
+    size_t compressedSize;
+    file.read(&compressedSize, sizeof(compressedSize), 1);
+    auto* compressedArray = new byte[compressedSize];
+    file.read(compressedArray, compressedSize, 1);
+    size_t realSize;
+    packed = reinterpret_cast<byte*>(_pallas_zstd_read(realSize, compressedArray, compressedSize));
+    pallas_assert(realSize == size);
+    delete[] compressedArray;
+  } else {
+    packed = new byte[size];
+    file.read(packed, size, 1);
+  }
+  for (size_t i = 0; i < n; i++) {
+    memcpy(&values[i], &packed[i * width], width);
+  }
+  delete[] packed;
+
+  if (encoding == ATTRIBUTE_ARRAY_DELTA) {
+    uint64_t previous = 0;
+    for (auto& v : values) {
+      auto delta = static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+      v = previous + static_cast<uint64_t>(delta);
+      previous = v;
+    }
+  }
+  return values;
+}
+
+/** Stores the AttributeLists of an Event by column. */
+static void _pallas_store_attribute_values(pallas::Event* e, const File& file, const pallas::ParameterHandler& parameter_handler) {
+  std::vector<uint64_t> occurrences;
+  std::vector<uint64_t> layout_ids;
+  std::vector<AttributeColumn> columns;
+  std::map<std::pair<pallas::AttributeRef, uint16_t>, uint16_t> column_ids;
+  std::map<std::vector<uint16_t>, uint64_t> layouts;
+  for (size_t pos = 0; pos + ATTRIBUTE_LIST_HEADER_SIZE <= e->attribute_pos;) {
+    auto* l = reinterpret_cast<pallas::AttributeList*>(&e->attribute_buffer[pos]);
+    if (l->struct_size == 0)
+      break;
+    std::vector<uint16_t> layout(l->nb_values);
+    uint16_t offset = 0;
+    for (int i = 0; i < l->nb_values; i++) {
+      pallas::AttributeData data;
+      pallas_attribute_list_pop_data(l, &data, &offset);
+      pallas::AttributeRef ref = data.ref;
+      uint16_t value_size = data.struct_size - ATTRIBUTE_HEADER_SIZE;
+      auto [column, inserted] = column_ids.try_emplace({ref, value_size}, static_cast<uint16_t>(columns.size()));
+      if (inserted)
+        columns.push_back({ref, value_size, {}});
+      uint64_t value = 0;
+      memcpy(&value, &data.value, std::min<size_t>(value_size, sizeof(value)));
+      columns[column->second].values.push_back(value);
+      layout[i] = column->second;
+    }
+    occurrences.push_back(l->index);
+    layout_ids.push_back(layouts.try_emplace(layout, layouts.size()).first->second);
+    pos += l->struct_size;
+  }
+
+  size_t nb_lists = occurrences.size();
+  file.write(&nb_lists, sizeof(nb_lists), 1);
+  if (nb_lists == 0)
+    return;
+  pallas_log(pallas::DebugLevel::Debug, "\t\tStore %zu attribute lists in %zu columns\n", nb_lists, columns.size());
+
+  size_t nb_columns = columns.size();
+  file.write(&nb_columns, sizeof(nb_columns), 1);
+  for (auto& column : columns) {
+    size_t nb_values = column.values.size();
+    file.write(&column.ref, sizeof(column.ref), 1);
+    file.write(&column.value_size, sizeof(column.value_size), 1);
+    file.write(&nb_values, sizeof(nb_values), 1);
+  }
+  std::vector<const std::vector<uint16_t>*> sorted_layouts(layouts.size());
+  for (auto& [layout, id] : layouts)
+    sorted_layouts[id] = &layout;
+  size_t nb_layouts = sorted_layouts.size();
+  file.write(&nb_layouts, sizeof(nb_layouts), 1);
+  for (auto* layout : sorted_layouts) {
+    uint8_t nb_values = layout->size();
+    file.write(&nb_values, sizeof(nb_values), 1);
+    file.write(const_cast<uint16_t*>(layout->data()), sizeof(uint16_t), nb_values);
+  }
+
+  _pallas_write_attribute_array(occurrences, file, parameter_handler);
+  _pallas_write_attribute_array(layout_ids, file, parameter_handler);
+  for (auto& column : columns) {
+    _pallas_write_attribute_array(column.values, file, parameter_handler);
+  }
+}
+
+/** Reads the AttributeLists of an Event stored by _pallas_store_attribute_values, and indexes them. */
+static void _pallas_read_attribute_values(pallas::Event* e, const File& file, const pallas::ParameterHandler& parameter_handler) {
+  e->attribute_buffer = nullptr;
+  e->attribute_buffer_size = 0;
   e->attribute_pos = 0;
+
+  size_t nb_lists = 0;
+  file.read(&nb_lists, sizeof(nb_lists), 1);
+  if (nb_lists == 0)
+    return;
+
+  size_t nb_columns;
+  file.read(&nb_columns, sizeof(nb_columns), 1);
+  std::vector<AttributeColumn> columns(nb_columns);
+  std::vector<size_t> column_sizes(nb_columns);
+  for (size_t c = 0; c < nb_columns; c++) {
+    file.read(&columns[c].ref, sizeof(columns[c].ref), 1);
+    file.read(&columns[c].value_size, sizeof(columns[c].value_size), 1);
+    file.read(&column_sizes[c], sizeof(column_sizes[c]), 1);
+  }
+  size_t nb_layouts;
+  file.read(&nb_layouts, sizeof(nb_layouts), 1);
+  std::vector<std::vector<uint16_t>> layouts(nb_layouts);
+  std::vector<size_t> layout_sizes(nb_layouts, ATTRIBUTE_LIST_HEADER_SIZE);
+  for (size_t i = 0; i < nb_layouts; i++) {
+    uint8_t nb_values;
+    file.read(&nb_values, sizeof(nb_values), 1);
+    layouts[i].resize(nb_values);
+    file.read(layouts[i].data(), sizeof(uint16_t), nb_values);
+    for (auto c : layouts[i])
+      layout_sizes[i] += ATTRIBUTE_HEADER_SIZE + columns[c].value_size;
+  }
+
+  auto occurrences = _pallas_read_attribute_array(nb_lists, file, parameter_handler);
+  auto layout_ids = _pallas_read_attribute_array(nb_lists, file, parameter_handler);
+  for (size_t c = 0; c < nb_columns; c++) {
+    columns[c].values = _pallas_read_attribute_array(column_sizes[c], file, parameter_handler);
+  }
+
+  // Rebuilds the AttributeLists, so that they can be handed out as they were recorded.
+  size_t size = 0;
+  for (auto id : layout_ids)
+    size += layout_sizes[id];
+  e->attribute_buffer = new byte[size];
+  e->attribute_buffer_size = size;
+  std::vector<size_t> column_pos(nb_columns, 0);
+  for (size_t i = 0; i < nb_lists; i++) {
+    auto* l = reinterpret_cast<pallas::AttributeList*>(&e->attribute_buffer[e->attribute_pos]);
+    pallas_attribute_list_init(l);
+    l->index = occurrences[i];
+    for (auto c : layouts[layout_ids[i]]) {
+      auto& column = columns[c];
+      pallas::AttributeData data;
+      data.ref = column.ref;
+      data.struct_size = ATTRIBUTE_HEADER_SIZE + column.value_size;
+      data.value.uint64 = 0;
+      memcpy(&data.value, &column.values[column_pos[c]++], std::min<size_t>(column.value_size, sizeof(uint64_t)));
+      pallas_attribute_list_push_data(l, &data);
+    }
+    e->attribute_pos += l->struct_size;
+  }
+  pallas_assert(e->attribute_pos == size);
+  e->indexAttributes();
+}
+
+/** Reads the AttributeLists of an Event stored as a single buffer, before ABI version 21. */
+static void _pallas_read_attribute_buffer(pallas::Event* e, const File& file) {
+  size_t serialized_attr_size = 0;
+  file.read(&serialized_attr_size, sizeof(serialized_attr_size), 1);
+
   e->attribute_buffer = nullptr;
+  e->attribute_buffer_size = serialized_attr_size;
+  e->attribute_pos = serialized_attr_size;
 
-  if (e->attribute_buffer_size > 0) {
-    e->attribute_buffer = new byte[e->attribute_buffer_size];
-    if (e->attribute_buffer == nullptr) {
-      pallas_error("Cannot allocate memory\n");
-    }
-    if (parameter_handler.getCompressionAlgorithm() != pallas::CompressionAlgorithm::None) {
-      size_t compressedSize;
-      file.read(&compressedSize, sizeof(compressedSize), 1);
-      byte* compressedArray = new byte[compressedSize];
-      file.read(e->attribute_buffer, compressedSize, 1);
-      e->attribute_buffer =
-        reinterpret_cast<byte*>(_pallas_zstd_read(e->attribute_buffer_size, compressedArray, compressedSize));
-      delete[] compressedArray;
-    } else {
-      file.read(e->attribute_buffer, e->attribute_buffer_size, 1);
-    }
+  if (serialized_attr_size > 0) {
+    e->attribute_buffer = new byte[serialized_attr_size];
+    file.read(e->attribute_buffer, sizeof(byte), serialized_attr_size);
+    e->indexAttributes();
   }
 }
+
 static void storeEventData(pallas::EventData& event,
                            const File& eventFile,
                            const pallas::ParameterHandler& parameter_handler) {
@@ -1066,6 +1921,7 @@ static void readEventData(pallas::EventData& event,
     }
 };
 
+/** Stores an Event: its data, its attributes and its timestamps. */
 static void storeEvent(pallas::Event& event,
                                     const File& eventFile,
                                     const File& durationFile,
@@ -1094,18 +1950,9 @@ static void storeEvent(pallas::Event& event,
     pallas_log(pallas::DebugLevel::Debug, "%s\n", event.timestamps->to_string().c_str());
 
     storeEventData(event.data, eventFile, *parameter_handler);
-    size_t serialized_attr_size = event.attribute_pos;
-    eventFile.write(&serialized_attr_size, sizeof(serialized_attr_size), 1);
-    if (serialized_attr_size > 0) {
-        pallas_log(pallas::DebugLevel::Debug, "\t\tStore %lu attributes\n", serialized_attr_size);
-        eventFile.write(event.attribute_buffer, sizeof(byte), serialized_attr_size);
-    }
+    _pallas_store_attribute_values(&event, eventFile, *parameter_handler);
     if (STORE_TIMESTAMPS) {
-        if (load_thread) {
-            event.timestamps->load_all_data();
-            event.timestamps->reset_offsets();
-        }
-        event.timestamps->write_to_file(eventFile.file, durationFile.file, parameter_handler);
+        event.timestamps->write_to_file(eventFile.file, durationFile.file, parameter_handler, load_thread);
     }
 }
 
@@ -1116,17 +1963,12 @@ static void readEvent(pallas::Event& event,
                                    pallas::ParameterHandler& parameter_handler,
                                    uint8_t abi_version) {
     readEventData(event.data, eventFile, parameter_handler, abi_version);
-
-    size_t serialized_attr_size = 0;
-    eventFile.read(&serialized_attr_size, sizeof(serialized_attr_size), 1);
-
-    event.attribute_buffer = nullptr;
-    event.attribute_buffer_size = serialized_attr_size;
-    event.attribute_pos = serialized_attr_size;
-
-    if (serialized_attr_size > 0) {
-        event.attribute_buffer = new byte[serialized_attr_size];
-        eventFile.read(event.attribute_buffer, sizeof(byte), serialized_attr_size);
+    event.attribute_offsets = nullptr;
+    event.nb_attribute_offsets = 0;
+    if (abi_version >= 21) {
+        _pallas_read_attribute_values(&event, eventFile, parameter_handler);
+    } else {
+        _pallas_read_attribute_buffer(&event, eventFile);
     }
 
     if (event.data.record == pallas::PALLAS_EVENT_MAX_ID) {
@@ -1191,21 +2033,9 @@ static void storeSequence(pallas::Sequence& sequence,
     }
 #endif
     if (STORE_TIMESTAMPS) {
-        if (load_thread) {
-            sequence.durations->load_all_data();
-            sequence.durations->reset_offsets();
-        }
-        sequence.durations->write_to_file(sequenceFile.file, durationFile.file, parameter_handler);
-        if (load_thread) {
-            sequence.exclusive_durations->load_all_data();
-            sequence.exclusive_durations->reset_offsets();
-        }
-        sequence.exclusive_durations->write_to_file(sequenceFile.file, durationFile.file, parameter_handler);
-        if (load_thread) {
-            sequence.timestamps->load_all_data();
-            sequence.timestamps->reset_offsets();
-        }
-        sequence.timestamps->write_to_file(sequenceFile.file, durationFile.file, parameter_handler);
+        sequence.durations->write_to_file(sequenceFile.file, durationFile.file, parameter_handler, load_thread);
+        sequence.exclusive_durations->write_to_file(sequenceFile.file, durationFile.file, parameter_handler, load_thread);
+        sequence.timestamps->write_to_file(sequenceFile.file, durationFile.file, parameter_handler, load_thread);
     }
 }
 
@@ -1327,10 +2157,9 @@ static void storeAttributes(pallas::Definition& definitions, File& file) {
   size_t size = definitions.attributes.size();
   file.write(&size, sizeof(size), 1);
   pallas_log(pallas::DebugLevel::Debug, "\tStore %zu Attributes\n", definitions.attributes.size());
-  for (int i = 0; i < definitions.attributes.size(); i++) {
-    pallas_log(pallas::DebugLevel::Debug, "\t\t[%d] {ref=%d, name=%d, type=%d}\n", i,
-               definitions.attributes[i].attribute_ref, definitions.attributes[i].name,
-               definitions.attributes[i].type);
+  for (auto& [ref, attribute] : definitions.attributes) {
+    pallas_log(pallas::DebugLevel::Debug, "\t\t{ref=%d, name=%d, type=%d}\n", attribute.attribute_ref, attribute.name,
+               attribute.type);
   }
 
   for (auto& attribute : definitions.attributes) {
@@ -1515,7 +2344,167 @@ static File pallasGetThreadFile(const char* dir_name, pallas::Thread* thread, co
   return File(filename, mode);
 }
 
+/** Data files that SubArrays are being spilled to, by path. Their File is also in the file map, for read_data. */
+static std::map<std::string, File*> spillFiles;
+
+static const char* pallasOpenSpillFile(const char* filename) {
+  std::lock_guard lock(pallas::ParameterHandler::storage_lock);
+  auto& file = spillFiles[filename];
+  if (file == nullptr) {
+    file = new File(filename);
+    file->evictable = true;
+    fileMap[file->path] = file;
+  } else if (file->isOpen) {
+    file->close();
+  }
+  // Discard what a previous run left there.
+  file->open("w+");
+  return file->path;
+}
+
+std::pair<const char*, const char*> pallasOpenSpillFiles(const char* path, pallas::Thread* th) {
+  if (!STORE_TIMESTAMPS) {
+    return {nullptr, nullptr};
+  }
+  const char* eventDurationFilename = pallasGetEventDurationFilename(path, th);
+  const char* sequenceDurationFilename = pallasGetSequenceDurationFilename(path, th);
+  std::pair<const char*, const char*> spillPaths{pallasOpenSpillFile(eventDurationFilename), pallasOpenSpillFile(sequenceDurationFilename)};
+  delete[] eventDurationFilename;
+  delete[] sequenceDurationFilename;
+  return spillPaths;
+}
+
+/**
+ * Returns the mode a data file of a Thread is stored with: if SubArrays were spilled to it while the Thread was recorded,
+ * the rest is appended to it, so that their offsets stay valid. The spilled SubArrays remain readable.
+ */
+static const char* pallasGetDataFileMode(const char* filename) {
+  std::lock_guard lock(pallas::ParameterHandler::storage_lock);
+  auto spilled = spillFiles.find(filename);
+  if (spilled == spillFiles.end()) {
+    return "w";
+  }
+  // Flush what was spilled before it's appended to by another FILE.
+  if (spilled->second->isOpen) {
+    spilled->second->close();
+  }
+  spillFiles.erase(spilled);
+  return "a";
+}
+
+/** Writes a placeholder for the offset of the ThreadIndex of a thread file, and returns where it is. */
+static long _pallas_reserve_thread_index(const File& threadFile) {
+  long position = ftell(threadFile.file);
+  uint64_t index_offset = 0;
+  threadFile.write(&index_offset, sizeof(index_offset), 1);
+  return position;
+}
+
+/** Returns the CRC32C of the bytes of a file between begin and end, chained to checksum, or false if they can't be read. */
+static bool _pallas_range_checksum(FILE* file, uint64_t begin, uint64_t end, uint32_t& checksum) {
+  std::vector<byte> buffer(end - begin);
+  if (fseek(file, begin, SEEK_SET) != 0 || (!buffer.empty() && fread(buffer.data(), buffer.size(), 1, file) != 1))
+    return false;
+  checksum = pallas::crc32c(buffer.data(), buffer.size(), checksum);
+  return true;
+}
+
+/** Returns where the record of an Event / Sequence of a ThreadIndex ends: at the next one, or at the indirection map. */
+static uint64_t _pallas_record_end(const std::vector<uint64_t>& records, size_t i, uint64_t map) {
+  return i + 1 < records.size() ? records[i + 1] : map;
+}
+
+/**
+ * Computes the checksum of what isn't in a record of a thread file before its ThreadIndex: the header,
+ * the indirection maps and the Loops. Returns false if the file can't be read.
+ */
+static bool _pallas_thread_checksum(FILE* file, uint64_t index_offset, const pallas::ThreadIndex& index, uint32_t& checksum) {
+  checksum = 0;
+  return _pallas_range_checksum(file, 0, index.events.empty() ? index.event_map : index.events[0], checksum)
+    && _pallas_range_checksum(file, index.event_map, index.sequences.empty() ? index.sequence_map : index.sequences[0], checksum)
+    && _pallas_range_checksum(file, index.sequence_map, index_offset, checksum);
+}
+
+/** Returns the CRC32C of a ThreadIndex, as it's written. */
+static uint32_t _pallas_thread_index_checksum(const pallas::ThreadIndex& index) {
+  uint32_t checksum = pallas::crc32c(index.events.data(), index.events.size() * sizeof(uint64_t), 0);
+  checksum = pallas::crc32c(&index.event_map, sizeof(index.event_map), checksum);
+  checksum = pallas::crc32c(index.sequences.data(), index.sequences.size() * sizeof(uint64_t), checksum);
+  checksum = pallas::crc32c(&index.sequence_map, sizeof(index.sequence_map), checksum);
+  checksum = pallas::crc32c(index.event_checksums.data(), index.event_checksums.size() * sizeof(uint32_t), checksum);
+  checksum = pallas::crc32c(index.sequence_checksums.data(), index.sequence_checksums.size() * sizeof(uint32_t), checksum);
+  return pallas::crc32c(&index.checksum, sizeof(index.checksum), checksum);
+}
+
+/**
+ * Writes the ThreadIndex at the end of a thread file, then its offset where _pallas_reserve_thread_index left room.
+ * The file is read back to compute the checksum of each record, so that a Thread read lazily can verify a record
+ * without reading the whole file.
+ */
+static void _pallas_write_thread_index(const File& threadFile, long index_position, pallas::ThreadIndex& index) {
+  uint64_t index_offset = ftell(threadFile.file);
+  fseek(threadFile.file, index_position, SEEK_SET);
+  threadFile.write(&index_offset, sizeof(index_offset), 1);
+  fflush(threadFile.file);
+
+  FILE* file = fopen(threadFile.path, "r");
+  bool valid = file != nullptr;
+  index.event_checksums.assign(index.events.size(), 0);
+  for (size_t i = 0; valid && i < index.events.size(); i++) {
+    valid = _pallas_range_checksum(file, index.events[i], _pallas_record_end(index.events, i, index.event_map), index.event_checksums[i]);
+  }
+  index.sequence_checksums.assign(index.sequences.size(), 0);
+  for (size_t i = 0; valid && i < index.sequences.size(); i++) {
+    valid = _pallas_range_checksum(file, index.sequences[i], _pallas_record_end(index.sequences, i, index.sequence_map), index.sequence_checksums[i]);
+  }
+  valid = valid && _pallas_thread_checksum(file, index_offset, index, index.checksum);
+  if (file) {
+    fclose(file);
+  }
+  if (!valid) {
+    pallas_error("Cannot read back %s\n", threadFile.path);
+  }
+
+  fseek(threadFile.file, index_offset, SEEK_SET);
+  threadFile.write(index.events.data(), sizeof(uint64_t), index.events.size());
+  threadFile.write(&index.event_map, sizeof(index.event_map), 1);
+  threadFile.write(index.sequences.data(), sizeof(uint64_t), index.sequences.size());
+  threadFile.write(&index.sequence_map, sizeof(index.sequence_map), 1);
+  threadFile.write(index.event_checksums.data(), sizeof(uint32_t), index.event_checksums.size());
+  threadFile.write(index.sequence_checksums.data(), sizeof(uint32_t), index.sequence_checksums.size());
+  threadFile.write(&index.checksum, sizeof(index.checksum), 1);
+  uint32_t index_checksum = _pallas_thread_index_checksum(index);
+  threadFile.write(&index_checksum, sizeof(index_checksum), 1);
+}
+
+/**
+ * Reads the ThreadIndex of a thread file, whose number of Events and Sequences is known.
+ * When verify is set, returns whether the index and the rest of the file outside of the records match their checksums.
+ */
+static bool _pallas_read_thread_index(const File& threadFile, uint64_t index_offset, pallas::ThreadIndex& index, bool verify) {
+  fseek(threadFile.file, index_offset, SEEK_SET);
+  threadFile.read(index.events.data(), sizeof(uint64_t), index.events.size());
+  threadFile.read(&index.event_map, sizeof(index.event_map), 1);
+  threadFile.read(index.sequences.data(), sizeof(uint64_t), index.sequences.size());
+  threadFile.read(&index.sequence_map, sizeof(index.sequence_map), 1);
+  index.event_checksums.resize(index.events.size());
+  threadFile.read(index.event_checksums.data(), sizeof(uint32_t), index.event_checksums.size());
+  index.sequence_checksums.resize(index.sequences.size());
+  threadFile.read(index.sequence_checksums.data(), sizeof(uint32_t), index.sequence_checksums.size());
+  threadFile.read(&index.checksum, sizeof(index.checksum), 1);
+  uint32_t index_checksum;
+  threadFile.read(&index_checksum, sizeof(index_checksum), 1);
+  if (!verify) {
+    return true;
+  }
+  uint32_t checksum;
+  return index_checksum == _pallas_thread_index_checksum(index)
+    && _pallas_thread_checksum(threadFile.file, index_offset, index, checksum) && checksum == index.checksum;
+}
+
 void pallasStoreThread(const char* path, pallas::Thread* th, const pallas::ParameterHandler* parameter_handler, bool load_thread) {
+  // A Thread that was read lazily is written as a whole.
+  th->loadAll();
   File threadFile = pallasGetThreadFile(path, th, "w");
   if(!threadFile.is_open())
     return;
@@ -1533,16 +2522,23 @@ void pallasStoreThread(const char* path, pallas::Thread* th, const pallas::Param
   threadFile.write(&th->sequence_root, sizeof(th->sequence_root), 1);
 
   threadFile.write(&th->first_timestamp, sizeof(th->first_timestamp), 1);
+  long index_position = _pallas_reserve_thread_index(threadFile);
+  pallas::ThreadIndex index;
+
+  // The statistics are taken before the vectors are written, while the data they don't account yet is still where it was.
+  th->updateStatistics();
 
   const char* eventDurationFilename = pallasGetEventDurationFilename(path, th);
-  File eventDurationFile = File(eventDurationFilename, "w");
+  File eventDurationFile = File(eventDurationFilename, pallasGetDataFileMode(eventDurationFilename));
   delete[] eventDurationFilename;
   for (int i = 0; i < th->nb_events; i++) {
+    index.events.push_back(ftell(threadFile.file));
     storeEvent(th->events[i], threadFile, eventDurationFile, parameter_handler, load_thread);
   }
   eventDurationFile.close();
 
   // write event indirection map
+  index.event_map = ftell(threadFile.file);
   size_t event_map_size = th->event_id_map.size();
   threadFile.write(&event_map_size, sizeof(size_t), 1);
   if (event_map_size > 0) {
@@ -1550,14 +2546,16 @@ void pallasStoreThread(const char* path, pallas::Thread* th, const pallas::Param
   }
 
   const char* sequenceDurationFilename = pallasGetSequenceDurationFilename(path, th);
-  File sequenceDurationFile = File(sequenceDurationFilename, "w");
+  File sequenceDurationFile = File(sequenceDurationFilename, pallasGetDataFileMode(sequenceDurationFilename));
   delete[] sequenceDurationFilename;
   for (int i = 0; i < th->nb_sequences; i++) {
+    index.sequences.push_back(ftell(threadFile.file));
     storeSequence(th->sequences[i], threadFile, sequenceDurationFile, parameter_handler, load_thread);
   }
   sequenceDurationFile.close();
 
   // write sequence indirection map
+  index.sequence_map = ftell(threadFile.file);
   size_t seq_map_size = th->sequence_id_map.size();
   threadFile.write(&seq_map_size, sizeof(size_t), 1);
   if (seq_map_size > 0) {
@@ -1574,10 +2572,279 @@ void pallasStoreThread(const char* path, pallas::Thread* th, const pallas::Param
   if (loop_map_size > 0) {
     threadFile.write(th->loop_id_map.data(), sizeof(uint32_t), loop_map_size);
   }
+  _pallas_write_thread_index(threadFile, index_position, index);
 
   threadFile.close();
+  _pallas_seal_file(threadFile.path);
+
+  // A Thread that was read from a trace has all its definitions: we can cache its labels.
+  if (load_thread) {
+    th->buildSequenceLabels();
+  }
+  if (th->nb_sequences > 0 && th->sequence_label_ids.size() == th->nb_sequences) {
+    pallasStoreThreadLabels(path, th);
+  } else {
+    // Don't leave an outdated cache behind.
+    const char* labelsFilename = pallasGetLabelsFilename(path, th);
+    std::error_code error;
+    std::filesystem::remove(labelsFilename, error);
+    delete[] labelsFilename;
+  }
+  pallasStoreThreadStatistics(path, th);
   pallas_log(pallas::DebugLevel::Debug, "Average compression ratio: %.2f\n",
-             (numberRawBytes + .0) / numberCompressedBytes);
+             (numberRawBytes.load() + .0) / numberCompressedBytes.load());
+}
+
+/** Returns the path of a file of a Thread in the root folder of the snapshots. */
+static std::string _pallas_live_filename(const char* path, const pallas::LiveThread& thread, const char* name) {
+  const char* threadPath = getThreadPath(thread.archive_id, thread.id);
+  std::string filename = std::string(path) + "/" + threadPath + "/" + name;
+  delete[] threadPath;
+  return filename;
+}
+
+/**
+ * Appends the new values of a vector to its live data file, and updates what was published of it.
+ * The values of a SubArray are published as a block at each snapshot while it fills up. Once it is complete,
+ * it is published again as one block, which replaces the previous ones: a spilled SubArray is copied as it is.
+ */
+static void _pallas_publish_values(pallas::LiveValues& values,
+                                   pallas::LivePublication& publication,
+                                   bool durations,
+                                   FILE* dataFile,
+                                   const pallas::ParameterHandler* parameter_handler) {
+  auto publish_block = durations ? _pallas_publish_duration_block : _pallas_publish_block;
+  for (auto& piece : values.pieces) {
+    if (piece.spilled) {
+      auto block = piece.block;
+      block.offset = _pallas_copy_block(values.spill_path, block.offset, dataFile, block.checksum, true);
+      publication.full_blocks.push_back(block);
+      publication.tail_blocks.clear();
+      publication.tail_values.clear();
+      continue;
+    }
+    publication.tail_values.insert(publication.tail_values.end(), piece.values.begin(), piece.values.end());
+    if (piece.complete) {
+      publication.full_blocks.push_back(publish_block(publication.tail_values.data(), publication.tail_values.size(), dataFile, parameter_handler));
+      publication.tail_blocks.clear();
+      publication.tail_values.clear();
+    } else {
+      publication.tail_blocks.push_back(publish_block(piece.values.data(), piece.values.size(), dataFile, parameter_handler));
+    }
+  }
+  publication.size = values.size;
+  publication.min = values.min;
+  publication.max = values.max;
+  publication.mean = values.mean;
+}
+
+/** Describes the published blocks of a vector to infoFile, in the format of LinkedVector::write_to_file. */
+static void _pallas_write_publication(pallas::LivePublication& publication, const File& infoFile, bool durations) {
+  size_t n_blocks = publication.full_blocks.size() + publication.tail_blocks.size();
+  infoFile.write(&publication.size, sizeof(publication.size), 1);
+  infoFile.write(&n_blocks, sizeof(n_blocks), 1);
+  if (publication.size == 0)
+    return;
+  if (durations) {
+    infoFile.write(&publication.min, sizeof(publication.min), 1);
+    infoFile.write(&publication.max, sizeof(publication.max), 1);
+    infoFile.write(&publication.mean, sizeof(publication.mean), 1);
+  }
+  for (auto* blocks : {&publication.full_blocks, &publication.tail_blocks}) {
+    for (auto& block : *blocks) {
+      infoFile.write(&block.size, sizeof(block.size), 1);
+      infoFile.write(block.statistics, sizeof(uint64_t), durations ? 3 : 2);
+      infoFile.write(&block.offset, sizeof(block.offset), 1);
+      infoFile.write(&block.checksum, sizeof(block.checksum), 1);
+    }
+  }
+}
+
+/** Publishes a LinkedDurationVector that holds a single value, as the durations of a LiveFrame. */
+static void _pallas_publish_duration(pallas_duration_t value, const File& infoFile, const File& dataFile, const pallas::ParameterHandler* parameter_handler) {
+  pallas::LivePublication publication;
+  publication.full_blocks.push_back(_pallas_publish_duration_block(&value, 1, dataFile.file, parameter_handler));
+  publication.size = 1;
+  publication.min = publication.max = publication.mean = value;
+  _pallas_write_publication(publication, infoFile, true);
+}
+
+/** Publishes a LinkedVector that holds a single value, as the timestamps of a LiveFrame. */
+static void _pallas_publish_timestamp(pallas_timestamp_t value, const File& infoFile, const File& dataFile, const pallas::ParameterHandler* parameter_handler) {
+  pallas::LivePublication publication;
+  publication.full_blocks.push_back(_pallas_publish_block(&value, 1, dataFile.file, parameter_handler));
+  publication.size = 1;
+  _pallas_write_publication(publication, infoFile, false);
+}
+/** Publishes a LiveFrame as a Sequence that occurred once. Its exclusive duration isn't known yet, so it's 0. */
+static void _pallas_publish_frame(const pallas::LiveFrame& frame,
+                                  const File& sequenceFile,
+                                  const File& durationFile,
+                                  const pallas::ParameterHandler* parameter_handler) {
+  enum pallas::SequenceType type = pallas::SEQUENCE_BLOCK;
+  sequenceFile.write(&type, sizeof(type), 1);
+  size_t size = frame.tokens.size();
+  sequenceFile.write(&size, sizeof(size), 1);
+  if (size == 0) {
+    return;
+  }
+  sequenceFile.write(const_cast<pallas::Token*>(frame.tokens.data()), sizeof(frame.tokens[0]), size);
+  if (STORE_TIMESTAMPS) {
+    _pallas_publish_duration(frame.duration, sequenceFile, durationFile, parameter_handler);
+    _pallas_publish_duration(0, sequenceFile, durationFile, parameter_handler);
+    _pallas_publish_timestamp(frame.start, sequenceFile, durationFile, parameter_handler);
+  }
+}
+
+/** Writes a file to a temporary file, then renames it, so that it's never seen partially written. */
+template <class Writer>
+static void _pallas_publish_file(const std::string& filename, Writer writer) {
+  std::string tmp_filename = filename + ".tmp";
+  File file(tmp_filename.c_str(), "w");
+  if (!file.is_open())
+    return;
+  writer(file);
+  file.close();
+  _pallas_seal_file(tmp_filename.c_str());
+  std::error_code error;
+  std::filesystem::rename(tmp_filename, filename, error);
+  if (error) {
+    pallas_warn("Cannot publish %s: %s\n", filename.c_str(), error.message().c_str());
+  }
+}
+
+void pallasApplyLiveSnapshot(const char* path, pallas::LiveThread& thread, pallas::LiveSnapshot& snapshot) {
+  thread.id = snapshot.thread_id;
+  thread.archive_id = snapshot.archive->id;
+  thread.sequence_root = snapshot.sequence_root;
+  thread.first_timestamp = snapshot.first_timestamp;
+  for (auto& data : snapshot.new_events) {
+    thread.events.push_back({data, {}, {}});
+  }
+  for (auto& [type, tokens] : snapshot.new_sequences) {
+    thread.sequences.push_back({type, std::move(tokens), {}, {}, {}});
+  }
+  thread.event_id_map.insert(thread.event_id_map.end(), snapshot.new_event_ids.begin(), snapshot.new_event_ids.end());
+  thread.sequence_id_map.insert(thread.sequence_id_map.end(), snapshot.new_sequence_ids.begin(), snapshot.new_sequence_ids.end());
+  thread.loops = std::move(snapshot.loops);
+  thread.loop_id_map = std::move(snapshot.loop_id_map);
+  thread.frames = std::move(snapshot.frames);
+  for (auto& [id, attributes] : snapshot.event_attributes) {
+    auto& buffer = thread.events[id].attributes;
+    buffer.insert(buffer.end(), attributes.begin(), attributes.end());
+  }
+
+  // The data files only grow: what was published stays valid for the readers of the previous snapshot.
+  // The first publication starts them over, in case they were left by a previous run.
+  const char* data_mode = thread.nb_snapshots++ == 0 ? "w" : "a";
+  File eventDurationFile(_pallas_live_filename(path, thread, "event_durations.dat").c_str(), data_mode);
+  File sequenceDurationFile(_pallas_live_filename(path, thread, "sequence_durations.dat").c_str(), data_mode);
+  if (!eventDurationFile.is_open() || !sequenceDurationFile.is_open())
+    return;
+  fseek(eventDurationFile.file, 0, SEEK_END);
+  fseek(sequenceDurationFile.file, 0, SEEK_END);
+  for (auto& [id, values] : snapshot.event_timestamps) {
+    _pallas_publish_values(values, thread.events[id].timestamps, false, eventDurationFile.file, snapshot.parameter_handler);
+  }
+  for (auto& values : snapshot.sequence_values) {
+    auto& sequence = thread.sequences[values.id];
+    _pallas_publish_values(values.durations, sequence.durations, true, sequenceDurationFile.file, snapshot.parameter_handler);
+    _pallas_publish_values(values.exclusive_durations, sequence.exclusive_durations, true, sequenceDurationFile.file, snapshot.parameter_handler);
+    _pallas_publish_values(values.timestamps, sequence.timestamps, false, sequenceDurationFile.file, snapshot.parameter_handler);
+  }
+}
+
+void pallasPublishThread(const char* path, pallas::LiveThread& thread, const pallas::ParameterHandler* parameter_handler) {
+  pallas_assert(!thread.frames.empty());
+  pallas_log(pallas::DebugLevel::Debug, "\tPublish thread %u {.nb_events=%zu, .nb_sequences=%zu, .nb_loops=%zu, .depth=%zu}\n", thread.id,
+             thread.events.size(), thread.sequences.size(), thread.loops.size(), thread.frames.size() - 1);
+
+  // The frames are appended to the sequence data file, after the values of the snapshots.
+  File sequenceDurationFile(_pallas_live_filename(path, thread, "sequence_durations.dat").c_str(), "a");
+  if (!sequenceDurationFile.is_open())
+    return;
+  fseek(sequenceDurationFile.file, 0, SEEK_END);
+
+  _pallas_publish_file(_pallas_live_filename(path, thread, "thread.pallas"), [&](File& threadFile) {
+    // Each LiveFrame but the root one is published as an additional Sequence.
+    size_t nb_events = thread.events.size();
+    size_t nb_sequences = thread.sequences.size() + thread.frames.size() - 1;
+    size_t nb_loops = thread.loops.size();
+    threadFile.write(&thread.id, sizeof(thread.id), 1);
+    threadFile.write(&thread.archive_id, sizeof(thread.archive_id), 1);
+    threadFile.write(&nb_events, sizeof(nb_events), 1);
+    threadFile.write(&nb_sequences, sizeof(nb_sequences), 1);
+    threadFile.write(&nb_loops, sizeof(nb_loops), 1);
+    threadFile.write(&thread.sequence_root, sizeof(thread.sequence_root), 1);
+    threadFile.write(&thread.first_timestamp, sizeof(thread.first_timestamp), 1);
+    long index_position = _pallas_reserve_thread_index(threadFile);
+    pallas::ThreadIndex index;
+
+    for (auto& live_event : thread.events) {
+      index.events.push_back(ftell(threadFile.file));
+      storeEventData(live_event.data, threadFile, *parameter_handler);
+      // The AttributeLists are stored from a copy of the attribute buffer of the Event.
+      pallas::Event event;
+      event.attribute_buffer = live_event.attributes.data();
+      event.attribute_pos = live_event.attributes.size();
+      _pallas_store_attribute_values(&event, threadFile, *parameter_handler);
+      if (STORE_TIMESTAMPS) {
+        _pallas_write_publication(live_event.timestamps, threadFile, false);
+      }
+    }
+    index.event_map = ftell(threadFile.file);
+    size_t event_map_size = thread.event_id_map.size();
+    threadFile.write(&event_map_size, sizeof(size_t), 1);
+    if (event_map_size > 0) {
+      threadFile.write(thread.event_id_map.data(), sizeof(uint32_t), event_map_size);
+    }
+
+    uint32_t root_id = thread.sequence_id_map[thread.sequence_root];
+    for (size_t i = 0; i < thread.sequences.size(); i++) {
+      index.sequences.push_back(ftell(threadFile.file));
+      auto& sequence = thread.sequences[i];
+      if (i == root_id) {
+        _pallas_publish_frame(thread.frames[0], threadFile, sequenceDurationFile, parameter_handler);
+        continue;
+      }
+      threadFile.write(&sequence.type, sizeof(sequence.type), 1);
+      size_t size = sequence.tokens.size();
+      threadFile.write(&size, sizeof(size), 1);
+      if (size == 0)
+        continue;
+      threadFile.write(sequence.tokens.data(), sizeof(sequence.tokens[0]), size);
+      if (STORE_TIMESTAMPS) {
+        _pallas_write_publication(sequence.durations, threadFile, true);
+        _pallas_write_publication(sequence.exclusive_durations, threadFile, true);
+        _pallas_write_publication(sequence.timestamps, threadFile, false);
+      }
+    }
+    for (size_t depth = 1; depth < thread.frames.size(); depth++) {
+      index.sequences.push_back(ftell(threadFile.file));
+      _pallas_publish_frame(thread.frames[depth], threadFile, sequenceDurationFile, parameter_handler);
+    }
+    index.sequence_map = ftell(threadFile.file);
+    std::vector<uint32_t> sequence_id_map(thread.sequence_id_map);
+    for (size_t depth = 1; depth < thread.frames.size(); depth++) {
+      sequence_id_map.push_back(thread.sequences.size() + depth - 1);
+    }
+    size_t seq_map_size = sequence_id_map.size();
+    threadFile.write(&seq_map_size, sizeof(size_t), 1);
+    threadFile.write(sequence_id_map.data(), sizeof(uint32_t), seq_map_size);
+
+    for (auto& loop : thread.loops) {
+      storeLoop(loop, threadFile);
+    }
+    size_t loop_map_size = thread.loop_id_map.size();
+    threadFile.write(&loop_map_size, sizeof(size_t), 1);
+    if (loop_map_size > 0) {
+      threadFile.write(thread.loop_id_map.data(), sizeof(uint32_t), loop_map_size);
+    }
+    _pallas_write_thread_index(threadFile, index_position, index);
+
+    // The values must be in the data files before the thread file that refers to them is renamed.
+    sequenceDurationFile.close();
+  });
 }
 
 void pallas::Thread::store(const char *path, const ParameterHandler* parameter_handler, bool load_thread) {
@@ -1594,6 +2861,8 @@ void pallas::GlobalArchive::store(const char *path, const ParameterHandler* para
 
 static void readThread(pallas::GlobalArchive* global_archive, pallas::Thread* th, pallas::ThreadId thread_id, uint8_t abi_version) {
   th->id = thread_id;
+  // Content of the thread file, when it's verified.
+  std::vector<byte> threadData;
   File threadFile = pallasGetThreadFile(global_archive->dir_name, th, "r");
   if (! threadFile.is_open()) {
     return;
@@ -1623,14 +2892,52 @@ static void readThread(pallas::GlobalArchive* global_archive, pallas::Thread* th
 
   threadFile.read(&th->first_timestamp, sizeof(th->first_timestamp), 1);
 
+  // With lazy loading, only the indirection maps and the Loops are read now, and the ThreadIndex tells where the rest is.
+  uint64_t index_offset = 0;
+  if (abi_version >= 21) {
+    threadFile.read(&index_offset, sizeof(index_offset), 1);
+  }
+  // A Thread read lazily verifies each record when it reads it, instead of the whole file now.
+  bool verify = _pallas_should_verify_files(global_archive);
+  pallas::ThreadIndex* index = nullptr;
+  if (index_offset != 0 && global_archive->parameter_handler->lazyLoading) {
+    index = new pallas::ThreadIndex();
+    index->events.resize(th->nb_events);
+    index->sequences.resize(th->nb_sequences);
+    long position = ftell(threadFile.file);
+    if (!_pallas_read_thread_index(threadFile, index_offset, *index, verify)) {
+      pallas_error("Checksum mismatch in %s: the file is corrupted (PALLAS_VERIFY_CHECKSUMS=0 skips this check)\n", threadFile.path);
+    }
+    fseek(threadFile.file, position, SEEK_SET);
+    index->loaded_events = std::vector<std::atomic<bool>>(th->nb_events);
+    index->loaded_sequences = std::vector<std::atomic<bool>>(th->nb_sequences);
+    index->parameter_handler = global_archive->parameter_handler;
+    index->abi_version = abi_version;
+    index->verify_checksums = verify;
+    index->thread_file = new File(threadFile.path);
+    // With thousands of Threads, their files can't all stay open until they're loaded.
+    index->thread_file->evictable = true;
+  } else if (verify) {
+    long position = ftell(threadFile.file);
+    if (!_pallas_verify_and_buffer_file(threadFile, threadData)) {
+      pallas_error("Checksum mismatch in %s: the file is corrupted (PALLAS_VERIFY_CHECKSUMS=0 skips this check)\n", threadFile.path);
+    }
+    fseek(threadFile.file, position, SEEK_SET);
+  }
+
   pallas_log(pallas::DebugLevel::Verbose, "Reading %lu events\n", th->nb_events);
   const char* eventDurationFilename = pallasGetEventDurationFilename(global_archive->dir_name, th);
-  if (fileMap.find(eventDurationFilename) == fileMap.end()) {
-    fileMap[eventDurationFilename] = new File(eventDurationFilename);;
-  }
+  File* eventDurationFile = _pallas_get_mapped_file(eventDurationFilename);
   for (size_t i = 0; i < th->nb_events; i++) {
     th->events[i].id = i;
-    readEvent(th->events[i], threadFile, *fileMap[eventDurationFilename], eventDurationFilename, *global_archive->parameter_handler, abi_version);
+    if (index == nullptr) {
+      readEvent(th->events[i], threadFile, *eventDurationFile, eventDurationFilename, *global_archive->parameter_handler, abi_version);
+    }
+  }
+  if (index) {
+    index->event_duration_path = eventDurationFilename;
+    index->event_duration_file = eventDurationFile;
+    fseek(threadFile.file, index->event_map, SEEK_SET);
   }
 
   // read events with indirection map if supported
@@ -1657,12 +2964,17 @@ static void readThread(pallas::GlobalArchive* global_archive, pallas::Thread* th
 
   pallas_log(pallas::DebugLevel::Verbose, "Reading %lu sequences\n", th->nb_sequences);
   const char* sequenceDurationFilename = pallasGetSequenceDurationFilename(global_archive->dir_name, th);
-  if (fileMap.find(sequenceDurationFilename) == fileMap.end()) {
-    fileMap[sequenceDurationFilename] = new File(sequenceDurationFilename);;
-  }
+  _pallas_get_mapped_file(sequenceDurationFilename);
   for (size_t i = 0; i < th->nb_sequences; i++) {
     th->sequences[i].id = PALLAS_SEQUENCE_ID(i);
-    readSequence(th->sequences[i], threadFile, sequenceDurationFilename, *global_archive->parameter_handler, abi_version);
+    if (index == nullptr) {
+      readSequence(th->sequences[i], threadFile, sequenceDurationFilename, *global_archive->parameter_handler, abi_version);
+    }
+  }
+  if (index) {
+    index->sequence_duration_path = sequenceDurationFilename;
+    index->mapped_sequences.assign(th->nb_sequences, false);
+    fseek(threadFile.file, index->sequence_map, SEEK_SET);
   }
 
   // read sequences with indirection map if supported
@@ -1677,6 +2989,9 @@ static void readThread(pallas::GlobalArchive* global_archive, pallas::Thread* th
       uint32_t phys_id = th->sequence_id_map[logi_id];
       if (phys_id != PALLAS_INDEX_INVALID) {
         th->sequences[phys_id].id = PALLAS_SEQUENCE_ID(logi_id);
+        if (index) {
+          index->mapped_sequences[phys_id] = true;
+        }
       }
     }
   } else {
@@ -1716,25 +3031,109 @@ static void readThread(pallas::GlobalArchive* global_archive, pallas::Thread* th
   }
 
   threadFile.close();
+  th->lazy_index = index;
 
   pallas_log(pallas::DebugLevel::Verbose, "\tThread %u: {.nb_events=%lu, .nb_sequences=%lu, .nb_loops=%lu}\n", th->id,
              th->nb_events, th->nb_sequences, th->nb_loops);
 }
 
-void pallasStoreGlobalArchive(pallas::GlobalArchive* archive, const char* path, const pallas::ParameterHandler* parameter_handler) {
-    pallas_log(pallas::DebugLevel::Debug, "Storing global archive\n");
-    if (!archive)
-        return;
+pallas::ThreadIndex::~ThreadIndex() {
+  delete thread_file;
+}
+
+/**
+ * Returns the file of a Thread that is read lazily, opened at the record that starts at begin and ends at end.
+ * Verifies the record first, if needed. The lock of the index and storage_lock must be held, since opening another
+ * file may close this one.
+ */
+static File& _pallas_lazy_thread_file(pallas::ThreadIndex& index, uint64_t begin, uint64_t end, uint32_t checksum) {
+  File& file = *index.thread_file;
+  if (!file.isOpen) {
+    file.open("r");
+  }
+  if (!file.isOpen) {
+    pallas_error("Cannot read %s\n", file.path);
+  }
+  if (index.verify_checksums) {
+    uint32_t record_checksum = 0;
+    if (!_pallas_range_checksum(file.file, begin, end, record_checksum) || record_checksum != checksum) {
+      pallas_error("Checksum mismatch in %s: the file is corrupted (PALLAS_VERIFY_CHECKSUMS=0 skips this check)\n", file.path);
+    }
+  }
+  fseek(file.file, begin, SEEK_SET);
+  return file;
+}
 
+void pallas::Thread::loadEvent(size_t index) const {
+  // The Events that were added after the Thread was read are already in memory.
+  if (lazy_index == nullptr || index >= lazy_index->events.size() ||
+      lazy_index->loaded_events[index].load(std::memory_order_acquire)) {
+    return;
+  }
+  std::lock_guard lock(lazy_index->lock);
+  if (lazy_index->loaded_events[index].load(std::memory_order_relaxed)) {
+    return;
+  }
+  std::lock_guard storage_lock(ParameterHandler::storage_lock);
+  pallas_log(DebugLevel::Debug, "Loading event %zu of Thread %u\n", index, id);
+  File& threadFile = _pallas_lazy_thread_file(*lazy_index, lazy_index->events[index],
+                                              _pallas_record_end(lazy_index->events, index, lazy_index->event_map),
+                                              lazy_index->event_checksums[index]);
+  readEvent(events[index], threadFile, *lazy_index->event_duration_file, lazy_index->event_duration_path,
+            *lazy_index->parameter_handler, lazy_index->abi_version);
+  lazy_index->loaded_events[index].store(true, std::memory_order_release);
+}
+
+void pallas::Thread::loadSequence(size_t index) const {
+  if (lazy_index == nullptr || index >= lazy_index->sequences.size() ||
+      lazy_index->loaded_sequences[index].load(std::memory_order_acquire)) {
+    return;
+  }
+  std::lock_guard lock(lazy_index->lock);
+  if (lazy_index->loaded_sequences[index].load(std::memory_order_relaxed)) {
+    return;
+  }
+  std::lock_guard storage_lock(ParameterHandler::storage_lock);
+  pallas_log(DebugLevel::Debug, "Loading sequence %zu of Thread %u\n", index, id);
+  File& threadFile = _pallas_lazy_thread_file(*lazy_index, lazy_index->sequences[index],
+                                              _pallas_record_end(lazy_index->sequences, index, lazy_index->sequence_map),
+                                              lazy_index->sequence_checksums[index]);
+  auto& sequence = sequences[index];
+  Token sequence_id = sequence.id;
+  readSequence(sequence, threadFile, lazy_index->sequence_duration_path, *lazy_index->parameter_handler, lazy_index->abi_version);
+  // As in readThread, the indirection map gives their id to the Sequences it refers to, even the empty ones.
+  if (lazy_index->mapped_sequences[index]) {
+    sequence.id = sequence_id;
+  }
+  lazy_index->loaded_sequences[index].store(true, std::memory_order_release);
+}
+
+void pallas::Thread::loadAll() const {
+  if (lazy_index == nullptr) {
+    return;
+  }
+  for (size_t i = 0; i < nb_events; i++) {
+    loadEvent(i);
+  }
+  for (size_t i = 0; i < nb_sequences; i++) {
+    loadSequence(i);
+  }
+  // Nothing is left to read from the thread file.
+  std::lock_guard lock(lazy_index->lock);
+  if (lazy_index->thread_file->isOpen) {
+    lazy_index->thread_file->close();
+  }
+}
+
+static std::filesystem::path pallas_global_archive_fullpath(pallas::GlobalArchive* archive, const char* path) {
     std::filesystem::path fullpath(std::string(path) + "/" + std::string(archive->trace_name));
     if (fullpath.extension() != ".pallas") {
         fullpath += ".pallas";
     }
+    return fullpath;
+}
 
-    File file = File(fullpath.c_str(), "w");
-    if (!file.is_open())
-        pallas_abort();
-
+static void writeGlobalArchive(pallas::GlobalArchive* archive, File& file, const pallas::ParameterHandler* parameter_handler) {
     uint8_t version = PALLAS_ABI_VERSION;
     file.write(&version, sizeof(version), 1);
     parameter_handler->writeToFile(file.file);
@@ -1743,8 +3142,28 @@ void pallasStoreGlobalArchive(pallas::GlobalArchive* archive, const char* path,
     storeLocationGroups(archive->location_groups, file);
     storeLocations(archive->locations, file);
     storeMetadata(archive->metadata, file);
+}
 
+void pallasStoreGlobalArchive(pallas::GlobalArchive* archive, const char* path, const pallas::ParameterHandler* parameter_handler) {
+    pallas_log(pallas::DebugLevel::Debug, "Storing global archive\n");
+    if (!archive)
+        return;
+
+    auto fullpath = pallas_global_archive_fullpath(archive, path);
+    File file = File(fullpath.c_str(), "w");
+    if (!file.is_open())
+        pallas_abort();
+
+    writeGlobalArchive(archive, file, parameter_handler);
     file.close();
+    _pallas_seal_file(file.path);
+}
+
+void pallasPublishGlobalArchive(pallas::GlobalArchive* archive, const char* path, const pallas::ParameterHandler* parameter_handler) {
+    if (!archive)
+        return;
+    _pallas_publish_file(pallas_global_archive_fullpath(archive, path).string(),
+                         [&](File& file) { writeGlobalArchive(archive, file, parameter_handler); });
 }
 
 
@@ -1755,16 +3174,7 @@ char* pallas_archive_fullpath(pallas::Archive* a, const char* path) {
   return fullpath;
 }
 
-void pallasStoreArchive(pallas::Archive* archive, const char* path, const pallas::ParameterHandler* parameter_handler) {
-    pallas_log(pallas::DebugLevel::Debug, "Storing archive %d\n", archive->id);
-    if (!archive)
-        return;
-
-    char* fullpath = pallas_archive_fullpath(archive, path);
-    File file = File(fullpath, "w");
-    if (!file.is_open())
-        pallas_abort();
-    delete[] fullpath;
+static void writeArchive(pallas::Archive* archive, File& file) {
     file.write(&archive->id, sizeof(pallas::LocationGroupId), 1);
 #ifdef DEBUG
     if (archive->locations.size() != archive->nb_threads) {
@@ -1777,7 +3187,29 @@ void pallasStoreArchive(pallas::Archive* archive, const char* path, const pallas
     storeLocationGroups(archive->location_groups, file);
     storeLocations(archive->locations, file);
     storeMetadata(archive->metadata, file);
+}
+
+void pallasStoreArchive(pallas::Archive* archive, const char* path, const pallas::ParameterHandler* parameter_handler) {
+    pallas_log(pallas::DebugLevel::Debug, "Storing archive %d\n", archive->id);
+    if (!archive)
+        return;
+
+    char* fullpath = pallas_archive_fullpath(archive, path);
+    File file = File(fullpath, "w");
+    if (!file.is_open())
+        pallas_abort();
+    delete[] fullpath;
+    writeArchive(archive, file);
     file.close();
+    _pallas_seal_file(file.path);
+}
+
+void pallasPublishArchive(pallas::Archive* archive, const char* path) {
+    if (!archive)
+        return;
+    char* fullpath = pallas_archive_fullpath(archive, path);
+    _pallas_publish_file(fullpath, [&](File& file) { writeArchive(archive, file); });
+    delete[] fullpath;
 }
 
 static char* pallas_archive_filename(pallas::GlobalArchive* archive, pallas::LocationGroupId id) {
@@ -1809,6 +3241,7 @@ void pallas::ParameterHandler::writeToFile(FILE* file) const {
 
 pallas::ParameterHandler::ParameterHandler(FILE* file) {
   readFromFile(file);
+  loadReadingParameters();
 }
 
 
@@ -1825,11 +3258,14 @@ void pallas::ParameterHandler::readFromFile(FILE* file) {
 
 pallas::Archive* pallas::GlobalArchive::getArchive(pallas::LocationGroupId archive_id, bool print_warning) {
   /* check if archive_id is already known */
+  pthread_mutex_lock(&lock);
   for (int i = 0; i < nb_archives; i++) {
     if (archive_list[i] != nullptr && archive_list[i]->id == archive_id) {
+      pthread_mutex_unlock(&lock);
       return archive_list[i];
     }
   }
+  pthread_mutex_unlock(&lock);
 
 
   auto* archive = new Archive(*this, archive_id);
@@ -1844,6 +3280,9 @@ pallas::Archive* pallas::GlobalArchive::getArchive(pallas::LocationGroupId archi
     pallas_warn("I can't read %s: %s\n", file.path, strerror(errno));
     return nullptr;
   }
+  if (_pallas_should_verify_files(this) && !_pallas_verify_file(file.path)) {
+    pallas_error("Checksum mismatch in %s: the file is corrupted (PALLAS_VERIFY_CHECKSUMS=0 skips this check)\n", file.path);
+  }
 
   file.read(&archive->id, sizeof(pallas::LocationGroupId), 1);
   file.read(&archive->nb_threads, sizeof(int), 1);
@@ -1859,6 +3298,15 @@ pallas::Archive* pallas::GlobalArchive::getArchive(pallas::LocationGroupId archi
   readMetadata(archive->metadata, file, abi_version);
   file.close();
 
+  pthread_mutex_lock(&lock);
+  /* Another thread may have loaded the same archive in the meantime: keep the first one. */
+  for (int i = 0; i < nb_archives; i++) {
+    if (archive_list[i] != nullptr && archive_list[i]->id == archive_id) {
+      pthread_mutex_unlock(&lock);
+      delete archive;
+      return archive_list[i];
+    }
+  }
   int index = 0;
   while (archive_list[index] != nullptr) {
     index++;
@@ -1867,6 +3315,7 @@ pallas::Archive* pallas::GlobalArchive::getArchive(pallas::LocationGroupId archi
     }
   }
   archive_list[index] = archive;
+  pthread_mutex_unlock(&lock);
 
   return archive;
 }
@@ -1886,10 +3335,14 @@ void pallas::GlobalArchive::freeArchive(pallas::LocationGroupId archiveId) {
  * @returns First Thread matching the given pallas::ThreadId, or nullptr if it doesn't have a match.
  */
 pallas::Thread* pallas::Archive::getThread(ThreadId thread_id) {
+  pthread_mutex_lock(&lock);
   for (int i = 0; i < nb_threads; i++) {
-    if (threads[i] && threads[i]->id == thread_id)
+    if (threads[i] && threads[i]->id == thread_id) {
+      pthread_mutex_unlock(&lock);
       return threads[i];
+    }
   }
+  pthread_mutex_unlock(&lock);
   pallas_log(pallas::DebugLevel::Verbose, "Loading Thread %d in Archive %d\n", thread_id, id);
   auto* thread = new Thread();
   auto location = getLocation(thread_id);
@@ -1902,7 +3355,15 @@ pallas::Thread* pallas::Archive::getThread(ThreadId thread_id) {
     thread->archive = this;
     readThread(global_archive, thread, location->id, global_archive->abi_version);
     auto index = thread_id - locations[0].id;
+    pthread_mutex_lock(&lock);
+    if (threads[index] != nullptr) {
+      /* Another thread loaded it in the meantime: keep the first one. */
+      pthread_mutex_unlock(&lock);
+      delete thread;
+      return threads[index];
+    }
     threads[index] = thread;
+    pthread_mutex_unlock(&lock);
     return thread;
   }
   pallas_warn("Archive::getThread(%u): Location's parent isn't us: %u != %u\n", thread_id, id, parent->id);
@@ -1918,12 +3379,14 @@ pallas::Thread* pallas::Archive::getThreadAt(size_t index) {
 
 void pallas::Archive::freeThread(pallas::ThreadId thread_id) {
     pallas_log(DebugLevel::Debug, "{%p}.freeThread(%d)\n", this, thread_id);
+    pthread_mutex_lock(&lock);
     for (int i = 0; i < nb_threads; i++) {
         if (threads[i] && threads[i]->id == thread_id) {
             delete threads[i];
             threads[i] = nullptr;
         }
     }
+    pthread_mutex_unlock(&lock);
 };
 
 void pallas::Archive::freeThreadAt(size_t i) {
@@ -1957,6 +3420,9 @@ pallas::GlobalArchive* pallas_open_trace(const char* trace_filename) {
     trace->abi_version = abi_version;
     trace->parameter_handler = new pallas::ParameterHandler(file.file);
     trace->parameter_handler->does_stats_need_compute = false;
+    if (_pallas_should_verify_files(trace) && !_pallas_verify_file(path.c_str())) {
+        pallas_error("Checksum mismatch in %s: the file is corrupted (PALLAS_VERIFY_CHECKSUMS=0 skips this check)\n", path.c_str());
+    }
     pallas_log(pallas::DebugLevel::Debug, "Reading GlobalArchive {.dir_name='%s', .trace='%s'}\n", trace->dir_name, trace->trace_name);
 
     readDefinitions(trace->definitions, file, abi_version);
@@ -1975,6 +3441,106 @@ pallas::GlobalArchive* pallas_open_trace(const char* trace_filename) {
     return trace;
 }
 
+/** Verifies the trailer of a file, and adds an error to the report if it doesn't match. */
+static bool _pallas_verify_file(const char* path, pallas::VerificationReport& report) {
+    report.nb_files++;
+    if (_pallas_verify_file(path))
+        return true;
+    report.errors.push_back(std::string("Checksum mismatch in ") + path);
+    return false;
+}
+
+/** Verifies the files of a Thread, then the blocks of each of its vectors. */
+static void _pallas_verify_thread(pallas::GlobalArchive* trace, pallas::Archive* archive, pallas::ThreadId thread_id, pallas::VerificationReport& report) {
+    // Only used to build the paths of the files, since the Thread can't be read before they are verified.
+    pallas::Thread paths;
+    paths.archive = archive;
+    paths.id = thread_id;
+    File threadFile = pallasGetThreadFile(trace->dir_name, &paths, nullptr);
+    if (!_pallas_verify_file(threadFile.path, report))
+        return;
+    // The labels and the statistics are optional.
+    for (const char* filename : {pallasGetLabelsFilename(trace->dir_name, &paths), pallasGetStatisticsFilename(trace->dir_name, &paths)}) {
+        std::error_code error;
+        if (std::filesystem::exists(filename, error))
+            _pallas_verify_file(filename, report);
+        delete[] filename;
+    }
+
+    auto* thread = archive->getThread(thread_id);
+    if (thread == nullptr) {
+        report.errors.push_back(std::string("Cannot read ") + threadFile.path);
+        return;
+    }
+    thread->loadAll();
+    for (size_t i = 0; i < thread->nb_events; i++) {
+        if (thread->events[i].timestamps)
+            report.nb_blocks += thread->events[i].timestamps->verify_checksums(report.errors);
+    }
+    for (size_t i = 0; i < thread->nb_sequences; i++) {
+        auto& sequence = thread->sequences[i];
+        if (sequence.durations)
+            report.nb_blocks += sequence.durations->verify_checksums(report.errors);
+        if (sequence.exclusive_durations)
+            report.nb_blocks += sequence.exclusive_durations->verify_checksums(report.errors);
+        if (sequence.timestamps)
+            report.nb_blocks += sequence.timestamps->verify_checksums(report.errors);
+    }
+    archive->freeThread(thread_id);
+}
+
+pallas::VerificationReport pallasVerifyTrace(const char* trace_filename, size_t nb_workers) {
+    pallas::VerificationReport report;
+    uint8_t abi_version = 0;
+    FILE* file = fopen(trace_filename, "r");
+    if (file == nullptr || fread(&abi_version, sizeof(abi_version), 1, file) != 1) {
+        report.errors.push_back(std::string("Cannot read ") + trace_filename);
+        if (file)
+            fclose(file);
+        return report;
+    }
+    fclose(file);
+    if (abi_version < 21) {
+        report.errors.push_back("This trace uses Pallas ABI version " + std::to_string(abi_version) + ", which has no checksums");
+        return report;
+    }
+    if (!_pallas_verify_file(trace_filename, report))
+        return report;
+
+    auto* trace = pallas_open_trace(trace_filename);
+    if (trace == nullptr) {
+        report.errors.push_back(std::string("Cannot open ") + trace_filename);
+        return report;
+    }
+    // Everything is verified before it's read, so that the corrupted files are reported instead of aborting.
+    trace->parameter_handler->verifyChecksums = false;
+    std::vector<std::pair<pallas::Archive*, pallas::ThreadId>> threads;
+    for (auto& location_group : trace->location_groups) {
+        char* archive_filename = pallas_archive_filename(trace, location_group.id);
+        std::string path = std::string(trace->dir_name) + "/" + archive_filename;
+        delete[] archive_filename;
+        if (!_pallas_verify_file(path.c_str(), report))
+            continue;
+        auto* archive = trace->getArchive(location_group.id);
+        if (archive == nullptr)
+            continue;
+        for (auto& location : archive->locations)
+            threads.emplace_back(archive, location.id);
+    }
+
+    std::vector<pallas::VerificationReport> thread_reports(threads.size());
+    pallas::parallelFor(threads.size(), nb_workers, [&](size_t i) {
+        _pallas_verify_thread(trace, threads[i].first, threads[i].second, thread_reports[i]);
+    });
+    for (auto& thread_report : thread_reports) {
+        report.nb_files += thread_report.nb_files;
+        report.nb_blocks += thread_report.nb_blocks;
+        report.errors.insert(report.errors.end(), thread_report.errors.begin(), thread_report.errors.end());
+    }
+    delete trace;
+    return report;
+}
+
 /* -*-
    mode: c;
    c-file-style: "k&r";
@@ -3,10 +3,22 @@
  * See LICENSE in top-level directory.
  */
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 
 #include "pallas/pallas.h"
 #include "pallas/pallas_archive.h"
@@ -15,10 +27,81 @@
 #include "pallas/utils/pallas_hash.h"
 #include "pallas/utils/pallas_log.h"
 #include "pallas/utils/pallas_parameter_handler.h"
+#include "pallas/utils/pallas_storage.h"
 #include "pallas/utils/pallas_timestamp.h"
+#include "pallas/utils/pallas_writer_stats.h"
 
 thread_local int pallas_recursion_shield = 0;
 namespace pallas {
+thread_local WriterStats* pallas_current_writer_stats = nullptr;
+
+const char* toString(WriterPhase phase) {
+    switch (phase) {
+    case PALLAS_PHASE_STORE_EVENT:
+        return "store_event";
+    case PALLAS_PHASE_GET_EVENT_ID:
+        return "get_event_id";
+    case PALLAS_PHASE_STORE_TIMESTAMP:
+        return "store_timestamp";
+    case PALLAS_PHASE_FIND_SEQUENCE:
+        return "find_sequence";
+    case PALLAS_PHASE_FIND_LOOP:
+        return "find_loop";
+    case PALLAS_PHASE_STORE:
+        return "store";
+    case PALLAS_PHASE_COMPRESSION:
+        return "compression";
+    default:
+        return "invalid";
+    }
+}
+
+void WriterStats::add(const WriterStats& other) {
+    nb_events_stored += other.nb_events_stored;
+    nb_tokens_stored += other.nb_tokens_stored;
+    nb_event_lookups += other.nb_event_lookups;
+    nb_events_created += other.nb_events_created;
+    nb_event_hash_probes += other.nb_event_hash_probes;
+    nb_sequence_lookups += other.nb_sequence_lookups;
+    nb_sequence_hash_probes += other.nb_sequence_hash_probes;
+    nb_sequences_found += other.nb_sequences_found;
+    nb_sequences_created += other.nb_sequences_created;
+    nb_loop_candidates += other.nb_loop_candidates;
+    nb_loops_created += other.nb_loops_created;
+    nb_loop_iterations_added += other.nb_loop_iterations_added;
+    nb_loops_squashed += other.nb_loops_squashed;
+    nb_subarrays_compressed += other.nb_subarrays_compressed;
+    nb_raw_bytes += other.nb_raw_bytes;
+    nb_bytes_written += other.nb_bytes_written;
+    for (int phase = 0; phase < PALLAS_PHASE_COUNT; phase++) {
+        phase_ticks[phase] += other.phase_ticks[phase];
+    }
+}
+
+std::string WriterStats::toString() const {
+    std::ostringstream out;
+    out << "events_stored=" << nb_events_stored
+        << " tokens_stored=" << nb_tokens_stored
+        << " event_lookups=" << nb_event_lookups
+        << " events_created=" << nb_events_created
+        << " event_hash_probes=" << nb_event_hash_probes
+        << " sequence_lookups=" << nb_sequence_lookups
+        << " sequence_hash_probes=" << nb_sequence_hash_probes
+        << " sequences_found=" << nb_sequences_found
+        << " sequences_created=" << nb_sequences_created
+        << " loop_candidates=" << nb_loop_candidates
+        << " loops_created=" << nb_loops_created
+        << " loop_iterations_added=" << nb_loop_iterations_added
+        << " loops_squashed=" << nb_loops_squashed
+        << " subarrays_compressed=" << nb_subarrays_compressed
+        << " raw_bytes=" << nb_raw_bytes
+        << " bytes_written=" << nb_bytes_written;
+    for (int phase = 0; phase < PALLAS_PHASE_COUNT; phase++) {
+        out << " ticks_" << pallas::toString(static_cast<WriterPhase>(phase)) << "=" << phase_ticks[phase];
+    }
+    return out.str();
+}
+
 /**
  * Compares two arrays of tokens array1 and array2
  */
@@ -64,14 +147,13 @@ Sequence& ThreadWriter::getOrCreateSequenceFromArray(pallas::Token* token_array,
     }
 
     // Then if it doesn't exist, create it
+    PALLAS_WRITER_STATS_ADD(stats, nb_sequences_created, 1);
 
     if (thread->nb_sequences >= thread->nb_allocated_sequences) {
         pallas_log(DebugLevel::Debug, "Doubling mem space of sequence for thread trace %p\n", this);
         doubleMemorySpaceConstructor(thread->sequences, thread->nb_allocated_sequences);
         for (uint i = thread->nb_allocated_sequences / 2; i < thread->nb_allocated_sequences; i++) {
-            thread->sequences[i].durations = new LinkedDurationVector(*parameter_handler);
-            thread->sequences[i].exclusive_durations = new LinkedDurationVector(*parameter_handler);
-            thread->sequences[i].timestamps = new LinkedVector(*parameter_handler);
+            createSequenceVectors(thread->sequences[i]);
         }
     }
 
@@ -113,6 +195,7 @@ Loop* ThreadWriter::createLoop(Token sequence_id) {
 
     uint32_t phys_id = thread->nb_loops++;
     uint32_t logi_id = phys_id;
+    PALLAS_WRITER_STATS_ADD(stats, nb_loops_created, 1);
 
     if (logi_id >= thread->loop_id_map.size()) {
         thread->loop_id_map.resize(logi_id + 1, PALLAS_INDEX_INVALID);
@@ -130,6 +213,7 @@ Loop* ThreadWriter::createLoop(Token sequence_id) {
 }
 
 void ThreadWriter::storeTimestamp(Event* es, pallas_timestamp_t ts) {
+    PALLAS_WRITER_STATS_PHASE(&stats, PALLAS_PHASE_STORE_TIMESTAMP);
     es->timestamps->add(ts);
     if (thread->first_timestamp == PALLAS_TIMESTAMP_INVALID) {
         thread->first_timestamp = ts;
@@ -139,6 +223,8 @@ void ThreadWriter::storeTimestamp(Event* es, pallas_timestamp_t ts) {
 
 void ThreadWriter::storeAttributeList(pallas::Event* es, struct pallas::AttributeList* attribute_list, const size_t occurrence_index) {
     attribute_list->index = occurrence_index;
+    // The index of the attributes is rebuilt if they are looked up again.
+    es->clearAttributeIndex();
     if (es->attribute_pos + attribute_list->struct_size >= es->attribute_buffer_size) {
         if (es->attribute_buffer_size == 0) {
             pallas_log(DebugLevel::Debug, "Allocating attribute memory for event %u\n", es->id);
@@ -162,6 +248,7 @@ void ThreadWriter::storeAttributeList(pallas::Event* es, struct pallas::Attribut
 void ThreadWriter::storeToken(Token t, size_t i) {
     pallas_log(DebugLevel::Debug, "storeToken: (%c%d) n°%zu in seq at callstack[%d] (size: %zu)\n", PALLAS_TOKEN_TYPE_C(t), t.id, i, cur_depth,
                sequence_stack[cur_depth].size() + 1);
+    PALLAS_WRITER_STATS_ADD(stats, nb_tokens_stored, 1);
     sequence_stack[cur_depth].push_back(t);
     index_stack[cur_depth].push_back(i);
     pallas_log(DebugLevel::Debug, "storeToken: %s\n",thread->getTokenArrayString(sequence_stack[cur_depth].data(), 0, sequence_stack[cur_depth].size()).c_str());
@@ -171,6 +258,7 @@ void ThreadWriter::storeToken(Token t, size_t i) {
 void ThreadWriter::incrementLoop(Loop* loop) {
     pallas_log(DebugLevel::Debug, "incrementLoop: + 1 to L%d (to %u)\n", loop->self_id.id, loop->nb_iterations + 1);
     loop->nb_iterations++;
+    PALLAS_WRITER_STATS_ADD(stats, nb_loop_iterations_added, 1);
 }
 
 Loop* ThreadWriter::unsquashLoop(Loop* loop) {
@@ -191,6 +279,7 @@ Loop* ThreadWriter::squashLoop(Loop* loop) {
         auto& otherLoop = thread->loops[phys_id];
         if (otherLoop.repeated_token == loop->repeated_token && otherLoop.nb_iterations == loop->nb_iterations) {
             otherLoop.nb_occurrences ++;
+            PALLAS_WRITER_STATS_ADD(stats, nb_loops_squashed, 1);
             thread->loop_id_map[loop->self_id.id] = PALLAS_INDEX_INVALID;
 
             // NOTE: removed physical compaction for now, recheck later
@@ -346,6 +435,7 @@ void ThreadWriter::checkLoopBefore() {
 }
 
 void ThreadWriter::findLoopBasic(size_t maxLoopLength) {
+    PALLAS_WRITER_STATS_PHASE(&stats, PALLAS_PHASE_FIND_LOOP);
     auto& curTokenSeq = getCurrentTokenSequence();
     auto& curIndexSeq = getCurrentIndexSequence();
     if (curTokenSeq.size() <= 1)
@@ -361,6 +451,7 @@ void ThreadWriter::findLoopBasic(size_t maxLoopLength) {
         const size_t startS1 = cur_index + 1 - loopLength;
         if (cur_index + 1 >= 2 * loopLength) {
             const size_t startS2 = cur_index + 1 - 2 * loopLength;
+            PALLAS_WRITER_STATS_ADD(stats, nb_loop_candidates, 1);
             /* search for a loop of loopLength tokens */
             if (_pallas_arrays_equal(&curTokenSeq[startS1], loopLength, &curTokenSeq[startS2], loopLength)) {
                 pallas_log(DebugLevel::Debug, "findLoopBasic: Found a loop of len %d\n", loopLength);
@@ -373,6 +464,7 @@ void ThreadWriter::findLoopBasic(size_t maxLoopLength) {
 }
 
 void ThreadWriter::findSequence(size_t n) {
+    PALLAS_WRITER_STATS_PHASE(&stats, PALLAS_PHASE_FIND_SEQUENCE);
     auto& curTokenSeq = getCurrentTokenSequence();
     auto& curTokenIndex = index_stack[cur_depth];
     size_t currentIndex = curTokenSeq.size() - 1;
@@ -382,11 +474,13 @@ void ThreadWriter::findSequence(size_t n) {
     for (int array_len = 1; array_len <= n; array_len++) {
         auto token_array = &curTokenSeq[currentIndex - array_len + 1];
         uint32_t hash = hash32_Token(token_array, array_len, SEED);
+        PALLAS_WRITER_STATS_ADD(stats, nb_sequence_lookups, 1);
         if (thread->hashToSequence.find(hash) != thread->hashToSequence.end()) {
             auto& sequencesWithSameHash = thread->hashToSequence[hash];
             if (!sequencesWithSameHash.empty()) {
                 for (const auto sid : sequencesWithSameHash) {
                     uint32_t phys_id = thread->sequence_id_map[sid];
+                    PALLAS_WRITER_STATS_ADD(stats, nb_sequence_hash_probes, 1);
                     if (_pallas_arrays_equal(token_array, array_len, thread->sequences[phys_id].tokens.data(), thread->sequences[phys_id].size())) {
                         found_sequence_id = sid;
                         break;
@@ -396,6 +490,7 @@ void ThreadWriter::findSequence(size_t n) {
         }
         if (found_sequence_id) {
             pallas_log(DebugLevel::Debug, "Found S%d in %d last tokens\n", found_sequence_id, array_len);
+            PALLAS_WRITER_STATS_ADD(stats, nb_sequences_found, 1);
             pallas_assert_equals(curTokenIndex.size(), curTokenSeq.size());
 
             auto sequence_token = Token(TypeSequence, found_sequence_id);
@@ -567,6 +662,8 @@ void ThreadWriter::recordExitFunction() {
 }  // namespace pallas
 
 size_t ThreadWriter::storeEvent(enum EventType event_type, TokenId event_id, pallas_timestamp_t ts, AttributeList* attribute_list) {
+    PALLAS_WRITER_STATS_PHASE(&stats, PALLAS_PHASE_STORE_EVENT);
+    PALLAS_WRITER_STATS_ADD(stats, nb_events_stored, 1);
     ts = timestamp(ts);
     if (event_type == PALLAS_BLOCK_START) {
         recordEnterFunction();
@@ -587,14 +684,250 @@ size_t ThreadWriter::storeEvent(enum EventType event_type, TokenId event_id, pal
     if (event_type == PALLAS_BLOCK_END) {
         recordExitFunction();
     }
+    // Reading the clock at each Event would cost too much: it's only read every LIVE_CHECK_INTERVAL Events.
+    if (parameter_handler->livePeriod > 0 && live_countdown-- == 0) {
+        live_countdown = LIVE_CHECK_INTERVAL;
+        publishIfDue();
+    }
     return occurrence_index;
 }
 
+/** What a ThreadWriter has copied of its Thread to the live snapshots. */
+struct LiveState {
+    /** Number of Events and Sequences in the last snapshot, and of entries of their indirection maps. */
+    size_t nb_events = 0;
+    size_t nb_sequences = 0;
+    size_t event_map_size = 0;
+    size_t sequence_map_size = 0;
+    /** What was copied of the timestamps of each Event, and of its attribute buffer. */
+    std::vector<LiveCursor> event_cursors;
+    std::vector<size_t> attribute_positions;
+    /** What was copied of the durations, exclusive durations and timestamps of each Sequence. */
+    std::vector<std::array<LiveCursor, 3>> sequence_cursors;
+    /** Date after which the next periodic publication is due. */
+    std::chrono::steady_clock::time_point next_publication;
+    /** Number of snapshots so far. */
+    size_t nb_publications = 0;
+};
+
+/**
+ * Publishes the snapshots of the ThreadWriters from a background thread, so that recording only costs a copy of what
+ * was recorded since the previous snapshot. The snapshots queued meanwhile are published together: the definitions
+ * of each Archive are published once for all of them, and the file of each Thread once.
+ */
+class LivePublisher {
+   public:
+    /** Queues a snapshot, and returns its ticket. The publisher thread is started by the first one. */
+    size_t queue(LiveSnapshot* snapshot) {
+        std::lock_guard guard(lock);
+        if (!thread.joinable()) {
+            thread = std::thread(&LivePublisher::run, this);
+        }
+        snapshots.emplace_back(snapshot);
+        queued.notify_one();
+        return ++nb_queued;
+    }
+
+    /** Waits until the snapshot with the given ticket, and the ones queued before it, are published. */
+    void wait(size_t ticket) {
+        std::unique_lock guard(lock);
+        published.wait(guard, [&] { return nb_published >= ticket; });
+    }
+
+    ~LivePublisher() {
+        {
+            std::lock_guard guard(lock);
+            stopping = true;
+            queued.notify_one();
+        }
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+   private:
+    void run() {
+        // Nothing the publisher does is recorded.
+        pallas_recursion_shield++;
+        std::unique_lock guard(lock);
+        while (true) {
+            queued.wait(guard, [&] { return stopping || !snapshots.empty(); });
+            if (snapshots.empty())
+                break;
+            auto batch = std::move(snapshots);
+            snapshots.clear();
+            size_t last_ticket = nb_queued;
+            guard.unlock();
+            publish(batch);
+            guard.lock();
+            nb_published = last_ticket;
+            published.notify_all();
+        }
+        pallas_recursion_shield--;
+    }
+
+    /** Publishes a batch of snapshots, in the order they were queued. */
+    void publish(std::vector<std::unique_ptr<LiveSnapshot>>& batch) {
+        // The definitions may be updated by the recording threads while they are written.
+        std::vector<Archive*> archives;
+        std::vector<GlobalArchive*> global_archives;
+        for (auto& snapshot : batch) {
+            Archive* archive = snapshot->archive;
+            if (std::find(archives.begin(), archives.end(), archive) != archives.end())
+                continue;
+            archives.push_back(archive);
+            std::string path = std::string(archive->dir_name) + "/live";
+            auto* global_archive = archive->global_archive;
+            if (global_archive && std::find(global_archives.begin(), global_archives.end(), global_archive) == global_archives.end()) {
+                global_archives.push_back(global_archive);
+                pthread_mutex_lock(&global_archive->lock);
+                pallasPublishGlobalArchive(global_archive, path.c_str(), snapshot->parameter_handler);
+                pthread_mutex_unlock(&global_archive->lock);
+            }
+            pthread_mutex_lock(&archive->lock);
+            pallasPublishArchive(archive, path.c_str());
+            pthread_mutex_unlock(&archive->lock);
+        }
+
+        // The values of every snapshot are appended, but the file of each Thread is only written for its last one.
+        std::vector<LiveSnapshot*> last_snapshots;
+        for (auto& snapshot : batch) {
+            std::string path = std::string(snapshot->archive->dir_name) + "/live";
+            pallasApplyLiveSnapshot(path.c_str(), threads[snapshot->thread], *snapshot);
+            auto same_thread = [&](const LiveSnapshot* other) { return other->thread == snapshot->thread; };
+            last_snapshots.erase(std::remove_if(last_snapshots.begin(), last_snapshots.end(), same_thread), last_snapshots.end());
+            last_snapshots.push_back(snapshot.get());
+        }
+        for (auto* snapshot : last_snapshots) {
+            std::string path = std::string(snapshot->archive->dir_name) + "/live";
+            auto& live_thread = threads[snapshot->thread];
+            pallasPublishThread(path.c_str(), live_thread, snapshot->parameter_handler);
+            pallas_log(DebugLevel::Debug, "Thread %u: live publication %zu\n", live_thread.id, live_thread.nb_snapshots);
+            if (snapshot->last) {
+                threads.erase(snapshot->thread);
+            }
+        }
+    }
+
+    std::mutex lock;
+    /** Signaled when a snapshot is queued, or when the publisher is stopping. */
+    std::condition_variable queued;
+    /** Signaled when a batch of snapshots is published. */
+    std::condition_variable published;
+    /** Snapshots that weren't taken by the publisher thread yet. */
+    std::vector<std::unique_ptr<LiveSnapshot>> snapshots;
+    /** Number of snapshots queued, and published, so far. */
+    size_t nb_queued = 0;
+    size_t nb_published = 0;
+    bool stopping = false;
+    std::thread thread;
+    /** What is known of each Thread being recorded. Only used by the publisher thread. */
+    std::unordered_map<const Thread*, LiveThread> threads;
+};
+
+/** Returns the publisher of the live snapshots of the process. */
+static LivePublisher& live_publisher() {
+    static LivePublisher publisher;
+    return publisher;
+}
+
+void ThreadWriter::publishIfDue() {
+    if (live == nullptr || std::chrono::steady_clock::now() >= live->next_publication) {
+        queueSnapshot(false);
+    }
+}
+
+void ThreadWriter::publish() {
+    live_publisher().wait(queueSnapshot(false));
+}
+
+size_t ThreadWriter::queueSnapshot(bool last) {
+    if (live == nullptr) {
+        live = new LiveState;
+    }
+    auto* snapshot = new LiveSnapshot;
+    snapshot->thread = thread;
+    snapshot->thread_id = thread->id;
+    snapshot->archive = thread->archive;
+    snapshot->parameter_handler = parameter_handler;
+    snapshot->sequence_root = thread->sequence_root;
+    snapshot->first_timestamp = thread->first_timestamp;
+    snapshot->last = last;
+
+    // The definitions and their indirection maps only grow: only the new ones are copied.
+    for (size_t i = live->nb_events; i < thread->nb_events; i++) {
+        snapshot->new_events.push_back(thread->events[i].data);
+    }
+    for (size_t i = live->nb_sequences; i < thread->nb_sequences; i++) {
+        snapshot->new_sequences.emplace_back(thread->sequences[i].type, thread->sequences[i].tokens);
+    }
+    live->nb_events = thread->nb_events;
+    live->nb_sequences = thread->nb_sequences;
+    live->event_cursors.resize(thread->nb_events);
+    live->attribute_positions.resize(thread->nb_events);
+    live->sequence_cursors.resize(thread->nb_sequences);
+    snapshot->new_event_ids.assign(thread->event_id_map.begin() + live->event_map_size, thread->event_id_map.end());
+    snapshot->new_sequence_ids.assign(thread->sequence_id_map.begin() + live->sequence_map_size, thread->sequence_id_map.end());
+    live->event_map_size = thread->event_id_map.size();
+    live->sequence_map_size = thread->sequence_id_map.size();
+    snapshot->loops.assign(thread->loops, thread->loops + thread->nb_loops);
+    snapshot->loop_id_map = thread->loop_id_map;
+
+    // Only the vectors and the attribute buffers that grew are copied.
+    for (size_t i = 0; i < thread->nb_events; i++) {
+        auto& event = thread->events[i];
+        if (event.timestamps->size != live->event_cursors[i].size) {
+            snapshot->event_timestamps.emplace_back(i, LiveValues{});
+            event.timestamps->snapshot(live->event_cursors[i], snapshot->event_timestamps.back().second);
+        }
+        size_t& attribute_position = live->attribute_positions[i];
+        if (event.attribute_pos > attribute_position) {
+            snapshot->event_attributes.emplace_back(i, std::vector<byte>(&event.attribute_buffer[attribute_position], &event.attribute_buffer[event.attribute_pos]));
+            attribute_position = event.attribute_pos;
+        }
+    }
+    // The main Sequence is only filled when the Thread is closed: it is published as the first LiveFrame.
+    uint32_t root_id = thread->sequence_id_map[thread->sequence_root];
+    for (uint32_t i = 0; i < thread->nb_sequences; i++) {
+        auto& sequence = thread->sequences[i];
+        auto& cursors = live->sequence_cursors[i];
+        if (i == root_id || (sequence.durations->size == cursors[0].size && sequence.timestamps->size == cursors[2].size))
+            continue;
+        auto& values = snapshot->sequence_values.emplace_back();
+        values.id = i;
+        sequence.durations->snapshot(cursors[0], values.durations);
+        sequence.exclusive_durations->snapshot(cursors[1], values.exclusive_durations);
+        sequence.timestamps->snapshot(cursors[2], values.timestamps);
+    }
+
+    // The blocks that are being recorded are published as Sequences that occurred once,
+    // whose ids follow the ones of the Thread. The first one is the main Sequence.
+    snapshot->frames.resize(cur_depth + 1);
+    for (int depth = 0; depth <= cur_depth; depth++) {
+        auto& frame = snapshot->frames[depth];
+        frame.tokens = sequence_stack[depth];
+        if (depth < cur_depth) {
+            frame.tokens.emplace_back(TypeSequence, thread->sequence_id_map.size() + depth);
+        }
+        frame.start = depth == 0 ? thread->first_timestamp : sequence_start_timestamp[depth];
+        frame.duration = last_timestamp == PALLAS_TIMESTAMP_INVALID ? 0 : last_timestamp - frame.start;
+    }
+    live->nb_publications++;
+    live->next_publication = std::chrono::steady_clock::now() + std::chrono::milliseconds(parameter_handler->livePeriod);
+    return live_publisher().queue(snapshot);
+}
+
 void ThreadWriter::threadClose() {
     while (cur_depth > 0) {
         pallas_warn("Closing unfinished sequence (lvl %d)\n", cur_depth);
         recordExitFunction();
     }
+    // The live readers get the last Events before the Thread is stored.
+    if (live) {
+        live_publisher().wait(queueSnapshot(true));
+        delete live;
+        live = nullptr;
+    }
     // Then we need to store the main sequence
     auto& mainSequence = thread->sequences[thread->sequence_id_map[thread->sequence_root]];
     mainSequence.tokens = sequence_stack[0];
@@ -606,14 +939,62 @@ void ThreadWriter::threadClose() {
     mainSequence.exclusive_durations->add(0);
     // TODO Maybe not the correct exclusive duration for the main thread ? Who knows, who cares.
     mainSequence.timestamps->add(thread->first_timestamp);
+#ifdef PALLAS_WRITER_STATS
+    pallas_current_writer_stats = &stats;
+    {
+        PALLAS_WRITER_STATS_PHASE(&stats, PALLAS_PHASE_STORE);
+        thread->store(thread->archive->dir_name, parameter_handler);
+    }
+    pallas_current_writer_stats = nullptr;
+    // The counters are stored in the metadata of the Archive, so that they are dumped with it.
+    thread->archive->add_metadata("writer_stats.thread_" + std::to_string(thread->id), stats.toString());
+    pallas_log(DebugLevel::Verbose, "Writer stats of thread %u: %s\n", thread->id, stats.toString().c_str());
+#else
     thread->store(thread->archive->dir_name, parameter_handler);
+#endif
+}
+
+MemoryUsage ThreadWriter::getMemoryUsage() const {
+    MemoryUsage usage = thread->getMemoryUsage();
+    usage.bytes[PALLAS_MEMORY_WRITER_STACKS] += sizeof(*this) + max_depth * (2 * sizeof(std::vector<Token>) + sizeof(pallas_timestamp_t));
+    for (int depth = 0; depth < max_depth; depth++) {
+        usage.bytes[PALLAS_MEMORY_WRITER_STACKS] += vectorMemoryUsage(sequence_stack[depth]) + vectorMemoryUsage(index_stack[depth]);
+    }
+    return usage;
+}
+
+WriterStats ThreadWriter::getStats() const {
+#ifdef PALLAS_WRITER_STATS
+    return stats;
+#else
+    return WriterStats{};
+#endif
 }
 ThreadWriter::~ThreadWriter() {
+    if (live) {
+        // The publisher forgets the Thread with its last snapshot.
+        live_publisher().wait(queueSnapshot(true));
+        delete live;
+    }
     delete[] sequence_stack;
     delete[] index_stack;
     delete[] sequence_start_timestamp;
 }
 
+void ThreadWriter::createSequenceVectors(Sequence& sequence) const {
+    sequence.durations = new LinkedDurationVector(*parameter_handler);
+    sequence.exclusive_durations = new LinkedDurationVector(*parameter_handler);
+    sequence.timestamps = new LinkedVector(*parameter_handler);
+    // Only the statistics of the durations of the Sequences are kept with the Thread.
+    sequence.exclusive_durations->keep_statistics = false;
+    sequence.timestamps->keep_statistics = false;
+    if (sequence_spill_path) {
+        sequence.durations->spill_to(sequence_spill_path);
+        sequence.exclusive_durations->spill_to(sequence_spill_path);
+        sequence.timestamps->spill_to(sequence_spill_path);
+    }
+}
+
 ThreadWriter::ThreadWriter(Archive& a, ThreadId thread_id) {
     if (pallas_recursion_shield)
         return;
@@ -639,13 +1020,15 @@ ThreadWriter::ThreadWriter(Archive& a, ThreadId thread_id) {
     thread->events = new Event[thread->nb_allocated_events]();
     thread->nb_events = 0;
 
+    if (parameter_handler->partialFlush) {
+        std::tie(event_spill_path, sequence_spill_path) = pallasOpenSpillFiles(a.dir_name, thread);
+    }
+
     thread->nb_allocated_sequences = NB_SEQUENCE_DEFAULT;
     thread->sequences = new Sequence[thread->nb_allocated_sequences]();
     thread->nb_sequences = 0;
     for (int i = 0; i < thread->nb_allocated_sequences; i++) {
-        thread->sequences[i].durations = new LinkedDurationVector(*parameter_handler);
-        thread->sequences[i].exclusive_durations = new LinkedDurationVector(*parameter_handler);
-        thread->sequences[i].timestamps = new LinkedVector(*parameter_handler);
+        createSequenceVectors(thread->sequences[i]);
     }
     thread->sequence_id_map.resize(1);
     thread->sequence_id_map[thread->sequence_root] = 0;
@@ -676,6 +1059,8 @@ ThreadWriter::ThreadWriter(Archive& a, ThreadId thread_id) {
 }
 
 TokenId ThreadWriter::getEventId(EventData* e) {
+    PALLAS_WRITER_STATS_PHASE(&stats, PALLAS_PHASE_GET_EVENT_ID);
+    PALLAS_WRITER_STATS_ADD(stats, nb_event_lookups, 1);
     pallas_log(DebugLevel::Max, "getEventId: Searching for event {.event_type=%d}\n", e->record);
 
     uint32_t hash = hash32(reinterpret_cast<byte*>(e), sizeof(EventData), SEED);
@@ -686,6 +1071,7 @@ TokenId ThreadWriter::getEventId(EventData* e) {
         }
         for (const auto eid : eventWithSameHash) {
             uint32_t phys_id = thread->event_id_map[eid];
+            PALLAS_WRITER_STATS_ADD(stats, nb_event_hash_probes, 1);
             if (memcmp(e, &thread->events[phys_id].data, e->event_size) == 0) {
                 pallas_log(DebugLevel::Debug, "getEventId: \t found with id=%u\n", eid);
                 return eid;
@@ -700,6 +1086,7 @@ TokenId ThreadWriter::getEventId(EventData* e) {
 
     TokenId logi_id = thread->nb_events;
     uint32_t phys_id = thread->nb_events++;
+    PALLAS_WRITER_STATS_ADD(stats, nb_events_created, 1);
 
     if (logi_id >= thread->event_id_map.size()) {
         thread->event_id_map.resize(logi_id + 1, PALLAS_INDEX_INVALID);
@@ -710,6 +1097,9 @@ TokenId ThreadWriter::getEventId(EventData* e) {
 
     auto* new_event = new (&thread->events[phys_id]) Event(logi_id, *e);
     new_event->timestamps = new LinkedVector(*parameter_handler);
+    if (event_spill_path) {
+        new_event->timestamps->spill_to(event_spill_path);
+    }
 
     // In-place initialisation
     thread->hashToEvent[hash].push_back(logi_id);
@@ -817,6 +1207,15 @@ extern void pallas_store_event(PALLAS(ThreadWriter) * thread_writer,
                                PALLAS(AttributeList) * attribute_list) {
     thread_writer->storeEvent(event_type, id, ts, attribute_list);
 };
+extern size_t pallas_thread_writer_get_memory_usage(PALLAS(ThreadWriter) * thread_writer) {
+    return thread_writer->getMemoryUsage().total();
+};
+extern void pallas_thread_writer_get_stats(PALLAS(ThreadWriter) * thread_writer, PALLAS(WriterStats) * stats) {
+    *stats = thread_writer->getStats();
+};
+extern void pallas_thread_writer_publish(PALLAS(ThreadWriter) * thread_writer) {
+    thread_writer->publish();
+};
 extern void pallas_thread_writer_delete(PALLAS(ThreadWriter) * thread_writer) {
     delete thread_writer;
 };
@@ -92,7 +92,7 @@ void setupEnums(const py::module_ &m) {
 }
 
 PYBIND11_MODULE(_core, m) {
-    PYBIND11_NUMPY_DTYPE(SequenceStatisticsLine, sequence_id, min, mean, max, nb_occurrences);
+    PYBIND11_NUMPY_DTYPE(SequenceStatisticsLine, sequence_id, min, mean, max, nb_occurrences, stddev, p50, p90, p99);
     PYBIND11_NUMPY_DTYPE(MPIMessageLine, id, sender, receiver, tag, msg_length, isend_ts, start_swait_ts, end_swait_ts,
                          irecv_ts, start_rwait_ts, end_rwait_ts);
     pandas = py::module::import("pandas");
@@ -119,7 +119,11 @@ PYBIND11_MODULE(_core, m) {
             .def("__iter__", [](const PyLinkedVector self) {
                 return PyLinkedVectorIterator{self.linked_vector, self.linked_duration_vector, 0};
             })
-            .def("as_numpy_array", &linked_vector_to_numpy);
+            .def("as_numpy_array", &linked_vector_to_numpy,
+                 "Copies the vector in a new NumPy array, with one memcpy per subvector.")
+            .def("as_numpy_views", &linked_vector_to_numpy_views,
+                 "Returns a list of read-only NumPy arrays that point directly at the data of each subvector.\n"
+                 "Nothing is copied. The arrays keep the data alive, even after the trace or its reader is deleted.");
 
     py::class_<PyLinkedVectorIterator>(m, "Vector_Iterator", "An iterator over a Pallas custom vector")
             .def("__next__", [](PyLinkedVectorIterator &self) {
@@ -166,10 +170,34 @@ PYBIND11_MODULE(_core, m) {
                 return doesSequenceContains(self, other);
             })
             .def("guessName", [](const PySequence &self) { return self.self->guessName(self.thread); })
+            .def("summarize_durations", [](const PySequence &self, pallas_timestamp_t start, pallas_timestamp_t end, bool approximate) {
+                     py::gil_scoped_release release;
+                     return self.self->summarizeDurations(start, end, approximate);
+                 }, py::arg("start"), py::arg("end"), py::arg("approximate") = true,
+                 "Summarizes the durations of the occurrences that start in [start, end[.\n"
+                 ":param approximate: Only read the durations at the edges of the time frame, and use summaries elsewhere.")
             .def("__repr__", [](const PySequence &self) {
                 return "<pallas_python.Sequence " + std::to_string(self.self->id.id) + ">";
             });
 
+    py::class_<pallas::DurationSummary>(m, "DurationSummary", "Summary of the durations of a time frame, which may be approximate.")
+            .def_readonly("count", &pallas::DurationSummary::count)
+            .def_readonly("sum", &pallas::DurationSummary::sum)
+            .def_readonly("sum_error", &pallas::DurationSummary::sum_error)
+            .def_readonly("min", &pallas::DurationSummary::min)
+            .def_readonly("max", &pallas::DurationSummary::max)
+            .def_property_readonly("exact", &pallas::DurationSummary::isExact)
+            .def_property_readonly("mean", &pallas::DurationSummary::mean)
+            .def_property_readonly("variance", &pallas::DurationSummary::variance)
+            .def("quantile", [](const pallas::DurationSummary &self, double q) {
+                     uint64_t error;
+                     uint64_t value = self.quantile(q, &error);
+                     return std::make_pair(value, error);
+                 }, py::arg("q"), "Returns an estimate of the q-quantile, and the bound of its error.")
+            .def("__repr__", [](const pallas::DurationSummary &self) {
+                return "<pallas_python.DurationSummary count=" + std::to_string(self.count) + (self.isExact() ? "" : " approximate") + ">";
+            });
+
     py::class_<PyLoop>(m, "Loop", "A Pallas Loop, ie a repetition of a Sequence token.")
             .def_property_readonly("id", [](const PyLoop &self) { return self.self->self_id; })
             .def_property_readonly("sequence", [](const PyLoop &self) {
@@ -201,7 +229,7 @@ PYBIND11_MODULE(_core, m) {
             .def_property_readonly("starting_timestamp",
                                    [](const pallas::Thread &self) { return self.first_timestamp; })
             .def_property_readonly("finish_timestamp", [](const pallas::Thread &self) {
-                return (self.first_timestamp + self.sequences[self.sequence_id_map[self.sequence_root]].durations->at(0));
+                return self.getLastTimestamp();
             })
             .def_property_readonly("events", [](pallas::Thread &self) { return threadGetEvents(self); })
             .def_property_readonly("sequences", [](pallas::Thread &self) { return threadGetSequences(self); })
@@ -211,24 +239,44 @@ PYBIND11_MODULE(_core, m) {
             .def("__repr__", [](const pallas::Thread &self) {
                 return "<pallas_python.Thread " + std::to_string(self.id) + ">";
             })
-            .def("getSnapshotView", &pallas::Thread::getSnapshotView)
-            .def("getSnapshotViewByName", &pallas::Thread::getSnapshotViewByName)
-            .def("getSnapshotViewFast", &pallas::Thread::getSnapshotViewFast)
+            .def("getSnapshotView", &pallas::Thread::getSnapshotView, py::arg("start"), py::arg("end"), py::arg("approximate") = true,
+                 py::call_guard<py::gil_scoped_release>())
+            .def("getSnapshotViewByName", &pallas::Thread::getSnapshotViewByName, py::arg("start"), py::arg("end"), py::arg("approximate") = true,
+                 py::call_guard<py::gil_scoped_release>())
+            .def("getSnapshotViewByLabel",
+                 [](const pallas::Thread& self, pallas_timestamp_t start, pallas_timestamp_t end, bool approximate) {
+                     return self.getSnapshotViewByLabel(start, end, approximate);
+                 },
+                 py::arg("start"), py::arg("end"), py::arg("approximate") = true,
+                 py::call_guard<py::gil_scoped_release>())
+            .def_property_readonly("labels", [](const pallas::Thread &self) {
+                {
+                    py::gil_scoped_release release;
+                    self.buildSequenceLabels();
+                }
+                return self.sequence_labels;
+            })
+            .def("getSnapshotViewFast", &pallas::Thread::getSnapshotViewFast, py::call_guard<py::gil_scoped_release>())
             .def("__iter__", [](const pallas::Thread &self) {
                 return new PyThreadIterator{
                     new pallas::ThreadReader(self.archive, self.id, PALLAS_READ_FLAG_UNROLL_ALL)
                 };
-            })
+            }, py::call_guard<py::gil_scoped_release>())
             .def("reader", [](const pallas::Thread &self) {
                 return new pallas::ThreadReader(self.archive, self.id, PALLAS_READ_FLAG_UNROLL_ALL);
-            });
+            }, py::call_guard<py::gil_scoped_release>());
 
     py::class_<PyThreadIterator>(m, "Thread_Iterator", "An iterator over the thread.")
             .def("__next__", [](PyThreadIterator &self) {
-                bool out = self.inner->moveToNextToken();
+                bool out;
                 pallas::Token t;
-                while (t = self.inner->pollCurToken(), t.type != pallas::TypeEvent) {
+                {
+                    // Moving in the thread may load data from the disk.
+                    py::gil_scoped_release release;
                     out = self.inner->moveToNextToken();
+                    while (t = self.inner->pollCurToken(), t.type != pallas::TypeEvent) {
+                        out = self.inner->moveToNextToken();
+                    }
                 }
                 if (out) {
                     if (!t.isValid()) {
@@ -241,10 +289,14 @@ PYBIND11_MODULE(_core, m) {
 
     py::class_<PyTraceIterator>(m, "Trace_Iterator", "An iterator over the trace.")
             .def("__next__", [](PyTraceIterator &self) {
-                bool out = self.inner->moveToNextToken();
+                bool out;
                 pallas::Token t;
-                while (t = self.inner->pollCurToken(), t.type != pallas::TypeEvent) {
+                {
+                    py::gil_scoped_release release;
                     out = self.inner->moveToNextToken();
+                    while (t = self.inner->pollCurToken(), t.type != pallas::TypeEvent) {
+                        out = self.inner->moveToNextToken();
+                    }
                 }
                 if (out) {
                     if (!t.isValid()) {
@@ -261,7 +313,7 @@ PYBIND11_MODULE(_core, m) {
             .def("moveToNextToken", [](pallas::ThreadReader &self, bool enter_sequence = true, bool enter_loop = true) {
                 int flags = get_read_flags_from_bools(enter_sequence, enter_loop);
                 self.moveToNextToken(flags);
-            })
+            }, py::call_guard<py::gil_scoped_release>())
             .def("pollCurToken", [](pallas::ThreadReader &self) {
                 return makePyObjectFromToken(self.pollCurToken(), self);
             })
@@ -269,11 +321,11 @@ PYBIND11_MODULE(_core, m) {
                  [](pallas::ThreadReader &self, bool enter_sequence = true, bool enter_loop = true) {
                      int flags = get_read_flags_from_bools(enter_sequence, enter_loop);
                      return self.enterIfStartOfBlock(flags);
-                 })
+                 }, py::call_guard<py::gil_scoped_release>())
             .def("exitIfEndOfBlock", [](pallas::ThreadReader &self, bool exit_sequence = true, bool exit_loop = true) {
                 int flags = get_read_flags_from_bools(exit_sequence, exit_loop);
                 return self.exitIfEndOfBlock(flags);
-            })
+            }, py::call_guard<py::gil_scoped_release>())
             .def("isEndOfCurrentBlock", &pallas::ThreadReader::isEndOfCurrentBlock)
             .def("isEndOfTrace", &pallas::ThreadReader::isEndOfTrace);
 
@@ -307,9 +359,12 @@ PYBIND11_MODULE(_core, m) {
             .def_property_readonly("locations", &Archive_get_locations)
             .def_property_readonly("strings", &Archive_get_strings)
             .def_property_readonly("regions", &Archive_get_regions)
-            .def_property_readonly("threads", &Archive_get_threads);
+            .def_property_readonly("threads", [](pallas::Archive &self) {
+                py::gil_scoped_release release;
+                return Archive_get_threads(self);
+            });
 
-    m.def("open_trace", &open_trace, "Open a Pallas trace")
+    m.def("open_trace", &open_trace, py::call_guard<py::gil_scoped_release>(), "Open a Pallas trace")
             .def("get_ABI", []() { return PALLAS_ABI_VERSION; })
             .def("get_communication_matrix", get_communication_matrix,
                  "Returns an MPI communication matrix for given trace.\n"
@@ -323,11 +378,11 @@ PYBIND11_MODULE(_core, m) {
                  }, "Returns an MPI communication matrix for given trace between the given timestamps.\n"
                  "Doesn't read more than the grammar.\n")
             .def("get_message_size_histogram", get_message_size_histogram, py::arg("trace"), py::kw_only(),
-                 py::arg("count_data_amount") = false,
+                 py::arg("count_data_amount") = false, py::call_guard<py::gil_scoped_release>(),
                  "Returns a histogram of the message sizes sent in this trace.\n"
                  ":param count_data_amount: If true, the histogram doesn't count the number of messages, but the amount of data sent.")
             .def("get_message_size_histogram", get_message_size_histogram_local, py::arg("archive"), py::kw_only(),
-                 py::arg("count_data_amount") = false,
+                 py::arg("count_data_amount") = false, py::call_guard<py::gil_scoped_release>(),
                  "Returns a histogram of the message sizes sent in this archive.\n"
                  ":param count_data_amount: If true, the histogram doesn't count the number of messages, but the amount of data sent.")
             .def("get_communication_over_time", get_communication_over_time, py::arg("trace"), py::arg("timestamps"),
@@ -341,11 +396,19 @@ PYBIND11_MODULE(_core, m) {
                  "Returns a binned histogram for the given timestamps.\n"
                  ":param timestamps: Bins of timestamps. Beware that the last given timestamp is the end of the last bin.\n"
                  ":param count_messages: If False, count the number of messages rather than the data amount.")
-            .def("get_sequences_statistics", get_sequences_statistics)
-            .def("get_mpi_message_list", get_mpi_message_list);
+            .def("get_sequences_statistics", get_sequences_statistics,
+                 py::arg("thread"), py::arg("start") = 0, py::arg("end") = PALLAS_TIMESTAMP_INVALID, py::arg("approximate") = true)
+            .def("get_mpi_messages", get_mpi_messages, py::arg("trace"), py::kw_only(), py::arg("nb_workers") = 0,
+                 "Returns the matched MPI messages of the trace, as a dict of NumPy arrays ( one per column ).\n"
+                 "Each rank is read on its own worker, then sends and receives are matched on\n"
+                 "(sender, receiver, communicator, tag, sequence number).\n"
+                 ":param nb_workers: Number of workers. 0 means one per hardware thread.")
+            .def("get_mpi_message_list", get_mpi_message_list, py::arg("trace"), py::kw_only(), py::arg("nb_workers") = 0,
+                 "Returns the matched MPI messages of the trace, as a pandas DataFrame with one MPIMessageLine per row.\n"
+                 ":param nb_workers: Number of workers. 0 means one per hardware thread.");
 
     py::class_<pallas::GlobalArchive>(m, "Trace", "A Pallas Trace file.")
-            .def(py::init(&open_trace), "Open a trace file and read its structure.")
+            .def(py::init(&open_trace), py::call_guard<py::gil_scoped_release>(), "Open a trace file and read its structure.")
             .def_readonly("dir_name", &pallas::GlobalArchive::dir_name)
             .def_readonly("trace_name", &pallas::GlobalArchive::trace_name)
             .def_readonly("fullpath", &pallas::GlobalArchive::fullpath)
@@ -355,8 +418,22 @@ PYBIND11_MODULE(_core, m) {
             .def_property_readonly("strings", &Trace_get_strings)
             .def_property_readonly("regions", &Trace_get_regions)
             .def_property_readonly("archives", &Trace_get_archives)
-            .def_property_readonly("starting_timestamp", &pallas::GlobalArchive::get_starting_timestamp)
-            .def_property_readonly("ending_timestamp", &pallas::GlobalArchive::get_ending_timestamp)
+            .def_property_readonly("starting_timestamp", [](pallas::GlobalArchive &self) {
+                py::gil_scoped_release release;
+                return self.get_starting_timestamp();
+            })
+            .def_property_readonly("ending_timestamp", [](pallas::GlobalArchive &self) {
+                py::gil_scoped_release release;
+                return self.get_ending_timestamp();
+            })
+            .def("getSnapshotViewByName", [](pallas::GlobalArchive &self, pallas_timestamp_t start, pallas_timestamp_t end, size_t nb_workers, bool approximate) {
+                     py::gil_scoped_release release;
+                     return self.getSnapshotViewByName(start, end, nb_workers, approximate);
+                 }, py::arg("start"), py::arg("end"), py::kw_only(), py::arg("nb_workers") = 0, py::arg("approximate") = true,
+                 "Returns the time spent in each Block Sequence of the whole trace during the given time frame, grouped by name.\n"
+                 "Threads are processed concurrently, and the GIL is released during the computation.\n"
+                 ":param nb_workers: Number of worker threads. 0 means one per core.\n"
+                 ":param approximate: Only read the durations at the edges of the time frame, and use summaries elsewhere.")
             .def("__iter__", [](pallas::GlobalArchive &self) {
                 return new PyTraceIterator{new pallas::MultiThreadReader(self)};
             });
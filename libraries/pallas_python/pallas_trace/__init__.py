@@ -92,6 +92,7 @@ from ._core import (
     get_message_size_histogram,
     get_sequences_statistics,
     get_mpi_message_list,
+    get_mpi_messages,
     open_trace,
 )
 
@@ -123,6 +124,7 @@ __all__ = [
     get_message_size_histogram,
     get_sequences_statistics,
     get_mpi_message_list,
+    get_mpi_messages,
     open_trace,
     # Enums
     BUFFER_FLUSH,
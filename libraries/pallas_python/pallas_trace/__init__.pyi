@@ -9,6 +9,7 @@ import typing
 
 import numpy
 import numpy.typing
+import pandas
 
 class Archive:
     """
@@ -409,6 +410,10 @@ class Thread:
     def __repr__(self) -> str: ...
     def getSnapshotView(self, start: int, end: int) -> dict[Token, int]: ...
     def getSnapshotViewFast(self, start: int, end: int) -> dict[Token, int]: ...
+    def getSnapshotViewByLabel(self, start: int, end: int) -> list[int]:
+        """
+        Time spent in each Block Sequence during [start, end], indexed by label id (see Thread.labels).
+        """
     @typing.overload
     def get_events_from_record(self, record: Record) -> list[Event]: ...
     @typing.overload
@@ -422,6 +427,11 @@ class Thread:
     @property
     def id(self) -> int: ...
     @property
+    def labels(self) -> list[str]:
+        """
+        Interned names of the Sequences of this thread.
+        """
+    @property
     def loops(self) -> list[Loop]: ...
     def reader(self) -> ThreadReader: ...
     @property
@@ -511,6 +521,13 @@ class Trace:
         Open a trace file and read its structure.
         """
     def __iter__(self) -> Trace_Iterator: ...
+    def getSnapshotViewByName(self, start: int, end: int, *, nb_workers: int = 0) -> dict[str, int]:
+        """
+        Returns the time spent in each Block Sequence of the whole trace during the given time frame, grouped by name.
+        Threads are processed concurrently, and the GIL is released during the computation.
+        :param nb_workers: Number of worker threads. 0 means one per core.
+        """
+        ...
     @property
     def archives(self) -> list[Archive]: ...
     @property
@@ -544,7 +561,15 @@ class Vector:
 
     def __iter__(self) -> ...: ...
     def __getitem__(self, index: int) -> int: ...
-    def as_numpy_array(self) -> numpy.typing.NDArray[numpy.uint64]: ...
+    def as_numpy_array(self) -> numpy.typing.NDArray[numpy.uint64]:
+        """
+        Copies the vector in a new NumPy array, with one memcpy per subvector.
+        """
+    def as_numpy_views(self) -> list[numpy.typing.NDArray[numpy.uint64]]:
+        """
+        Returns a list of read-only NumPy arrays that point directly at the data of each subvector.
+        Nothing is copied. The arrays keep the data alive, even after the trace or its reader is deleted.
+        """
     @property
     def size(self) -> int: ...
 
@@ -602,6 +627,24 @@ def get_communication_over_time(
     """
     ...
 
+def get_mpi_messages(
+    trace: Trace, *, nb_workers: int = 0
+) -> dict[str, numpy.typing.NDArray[numpy.uint64]]:
+    """
+    Returns the matched MPI messages of the trace, as a dict of NumPy arrays ( one per column ).
+    Each rank is read on its own worker, then sends and receives are matched on
+    (sender, receiver, communicator, tag, sequence number).
+    :param nb_workers: Number of workers. 0 means one per hardware thread.
+    """
+    ...
+
+def get_mpi_message_list(trace: Trace, *, nb_workers: int = 0) -> pandas.DataFrame:
+    """
+    Returns the matched MPI messages of the trace, as a pandas DataFrame with one MPIMessageLine per row.
+    :param nb_workers: Number of workers. 0 means one per hardware thread.
+    """
+    ...
+
 def open_trace(path: str) -> Trace:
     """
     Open a Pallas trace
@@ -19,6 +19,10 @@ struct SequenceStatisticsLine {
     pallas_duration_t mean;
     pallas_duration_t max;
     uint64_t nb_occurrences;
+    double stddev;
+    pallas_duration_t p50;
+    pallas_duration_t p90;
+    pallas_duration_t p99;
 };
 
 struct MPIMessageLine {
@@ -63,6 +67,15 @@ py::array_t<uint64_t> get_communication_over_time(pallas::GlobalArchive& trace,
 
 py::array_t<uint64_t> get_communication_over_time_archive(pallas::Archive& archive, py::array_t<uint64_t> timestamps, bool count_messages = false);
 
-py::object get_sequences_statistics(pallas::Thread& thread);
+/**
+ * Returns the statistics of the durations of each Sequence of the thread, as a pandas DataFrame.
+ * Over the whole thread, they come from Thread::buildStatistics. Over a time frame, from Sequence::summarizeDurations:
+ * when approximate is set, only the durations at the edges of the time frame are read, and the stddev is NaN.
+ */
+py::object get_sequences_statistics(pallas::Thread& thread, pallas_timestamp_t start = 0, pallas_timestamp_t end = PALLAS_TIMESTAMP_INVALID, bool approximate = true);
+
+/** Returns the matched MPI messages of the trace, as a dict of NumPy arrays ( one per column ). See match_mpi_messages. */
+py::dict get_mpi_messages(pallas::GlobalArchive &trace, size_t nb_workers = 0);
 
-py::object get_mpi_message_list(pallas::GlobalArchive &trace);
+/** Returns the matched MPI messages of the trace, as a pandas DataFrame of MPIMessageLine. */
+py::object get_mpi_message_list(pallas::GlobalArchive &trace, size_t nb_workers = 0);
@@ -0,0 +1,378 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+#include "python_mpi.h"
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <pallas/pallas_read.h>
+#include <pallas/pallas_record.h>
+#include <pallas/utils/pallas_parallel.h>
+
+/** One side ( send or receive ) of an MPI message, as seen by one rank. */
+struct MPIEndpoint {
+    /** Rank of the other side of the communication. */
+    uint32_t peer;
+    uint32_t communicator;
+    uint32_t tag;
+    uint64_t msg_length;
+    /** Timestamp of the Send/ISend/Recv/IRecv call. Receives are matched in that order. */
+    pallas_timestamp_t call_ts = PALLAS_TIMESTAMP_INVALID;
+    pallas_timestamp_t start_wait_ts = PALLAS_TIMESTAMP_INVALID;
+    pallas_timestamp_t end_wait_ts = PALLAS_TIMESTAMP_INVALID;
+};
+
+/** Every send and receive of a rank. */
+struct MPIRankEndpoints {
+    std::vector<MPIEndpoint> sends;
+    std::vector<MPIEndpoint> recvs;
+};
+
+/** Functions after which blocking communications are over. */
+static const std::unordered_set<std::string> implicit_mpi_wait{
+    "MPI_Send", "mpi_send_",
+    "MPI_Recv", "mpi_recv_",
+    "MPI_Bsend", "mpi_bsend_",
+    "MPI_Ssend", "mpi_ssend_",
+    "MPI_Rsend", "mpi_rsend_",
+    "MPI_Sendrecv", "mpi_sendrecv_",
+    "MPI_Sendrecv_replace", "mpi_sendrecv_replace_",
+    "MPI_Test", "mpi_test_",
+    "MPI_Wait", "mpi_wait_",
+    "MPI_Waitany", "mpi_waitany_",
+    "MPI_Testany", "mpi_testany_",
+    "MPI_Waitsome", "mpi_waitsome_",
+    "MPI_Testsome", "mpi_testsome_",
+    "MPI_Probe", "mpi_probe_",
+};
+
+/** Request posted by MPI_ISend or MPI_IRecv, and not completed yet. */
+struct MPIPendingRequest {
+    /** Index of the endpoint in MPIRankEndpoints::sends for an ISend. Unused for an IRecv. */
+    size_t send_index = SIZE_MAX;
+    /** Timestamp of the MPI_IRecv call. */
+    pallas_timestamp_t irecv_ts = PALLAS_TIMESTAMP_INVALID;
+};
+
+/** Reads all the threads of a rank and lists its sends and receives. Only accesses this Archive. */
+static MPIRankEndpoints collect_endpoints(pallas::Archive* archive) {
+    MPIRankEndpoints output;
+    std::unordered_map<uint64_t, MPIPendingRequest> pending_requests;
+    std::unordered_map<pallas::RegionRef, bool> is_implicit_wait;
+
+    for (auto& location : archive->locations) {
+        auto reader = pallas::ThreadReader(archive, location.id, PALLAS_READ_FLAG_UNROLL_ALL);
+        // Blocking communications waiting for the end of their MPI call.
+        std::vector<size_t> blocking_sends;
+        std::vector<size_t> blocking_recvs;
+
+        for (auto t = reader.pollCurToken(); t != pallas::INVALID_TOKEN; t = reader.getNextToken()) {
+            if (t.type != pallas::TypeEvent) {
+                continue;
+            }
+            auto data = reader.getEventOccurrence(t, reader.getCurrentTokenCount(t));
+            // Timestamp of the Enter of the MPI call containing this event.
+            // An event at depth 0 is not in any call: its own timestamp is used instead.
+            auto enter_ts = [&]() {
+                if (reader.currentState.current_frame_index <= 0) {
+                    return data.timestamp;
+                }
+                return reader.currentState.currentFrame[-1].current_timestamp;
+            };
+            switch (data.event->record) {
+            case pallas::PALLAS_EVENT_MPI_SEND: {
+                MPIEndpoint e;
+                uint32_t communicator, tag;
+                pallas::pallas_read_mpi_send(data.event, nullptr, &e.peer, &communicator, &tag, &e.msg_length);
+                e.communicator = communicator;
+                e.tag = tag;
+                e.call_ts = e.start_wait_ts = data.timestamp;
+                blocking_sends.push_back(output.sends.size());
+                output.sends.push_back(e);
+                break;
+            }
+            case pallas::PALLAS_EVENT_MPI_RECV: {
+                MPIEndpoint e;
+                uint32_t communicator, tag;
+                pallas::pallas_read_mpi_recv(data.event, nullptr, &e.peer, &communicator, &tag, &e.msg_length);
+                e.communicator = communicator;
+                e.tag = tag;
+                e.call_ts = e.start_wait_ts = data.timestamp;
+                blocking_recvs.push_back(output.recvs.size());
+                output.recvs.push_back(e);
+                break;
+            }
+            case pallas::PALLAS_EVENT_MPI_ISEND: {
+                MPIEndpoint e;
+                uint32_t communicator, tag;
+                uint64_t request_id;
+                pallas::pallas_read_mpi_isend(data.event, nullptr, &e.peer, &communicator, &tag, &e.msg_length, &request_id);
+                e.communicator = communicator;
+                e.tag = tag;
+                e.call_ts = data.timestamp;
+                pending_requests[request_id] = {output.sends.size(), PALLAS_TIMESTAMP_INVALID};
+                output.sends.push_back(e);
+                break;
+            }
+            case pallas::PALLAS_EVENT_MPI_ISEND_COMPLETE: {
+                uint64_t request_id;
+                pallas::pallas_read_mpi_isend_complete(data.event, nullptr, &request_id);
+                auto it = pending_requests.find(request_id);
+                if (it == pending_requests.end() || it->second.send_index == SIZE_MAX) {
+                    pallas_warn("Matching request for ISEND_COMPLETE not found!\n");
+                    break;
+                }
+                auto& e = output.sends[it->second.send_index];
+                e.start_wait_ts = enter_ts();
+                e.end_wait_ts = data.timestamp;
+                pending_requests.erase(it);
+                break;
+            }
+            case pallas::PALLAS_EVENT_MPI_IRECV_REQUEST: {
+                uint64_t request_id;
+                pallas::pallas_read_mpi_irecv_request(data.event, nullptr, &request_id);
+                pending_requests[request_id] = {SIZE_MAX, data.timestamp};
+                break;
+            }
+            case pallas::PALLAS_EVENT_MPI_IRECV: {
+                MPIEndpoint e;
+                uint32_t communicator, tag;
+                uint64_t request_id;
+                pallas::pallas_read_mpi_irecv(data.event, nullptr, &e.peer, &communicator, &tag, &e.msg_length, &request_id);
+                e.communicator = communicator;
+                e.tag = tag;
+                e.start_wait_ts = enter_ts();
+                e.end_wait_ts = data.timestamp;
+                auto it = pending_requests.find(request_id);
+                if (it == pending_requests.end() || it->second.send_index != SIZE_MAX) {
+                    pallas_warn("Matching request for IRECV not found!\n");
+                    e.call_ts = e.start_wait_ts;
+                } else {
+                    e.call_ts = it->second.irecv_ts;
+                    pending_requests.erase(it);
+                }
+                output.recvs.push_back(e);
+                break;
+            }
+            case pallas::PALLAS_EVENT_LEAVE: {
+                if (blocking_sends.empty() && blocking_recvs.empty()) {
+                    break;
+                }
+                pallas::RegionRef region_ref;
+                pallas::pallas_read_leave(data.event, nullptr, &region_ref);
+                auto it = is_implicit_wait.find(region_ref);
+                if (it == is_implicit_wait.end()) {
+                    const char* region_name = reader.thread_trace->getRegionStringFromEvent(data.event);
+                    it = is_implicit_wait.emplace(region_ref, implicit_mpi_wait.contains(region_name)).first;
+                }
+                if (it->second) {
+                    for (auto index : blocking_sends) {
+                        output.sends[index].end_wait_ts = data.timestamp;
+                    }
+                    for (auto index : blocking_recvs) {
+                        output.recvs[index].end_wait_ts = data.timestamp;
+                    }
+                    blocking_sends.clear();
+                    blocking_recvs.clear();
+                }
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    }
+    return output;
+}
+
+/** Sends of a stream: same sender, receiver, communicator and tag. Messages of a stream are non-overtaking. */
+struct MPISendQueue {
+    uint32_t sender;
+    uint32_t tag;
+    /** Sends as (rank, index in that rank's endpoints), sorted by call timestamp. */
+    std::vector<std::pair<uint32_t, size_t>> sends;
+    /** Index of the first send that didn't match any receive yet. */
+    size_t next = 0;
+};
+
+/** Messages received by a rank on a communicator. Receives are matched in the order they were posted. */
+struct MPIMailbox {
+    uint32_t receiver;
+    uint32_t communicator;
+    /** One queue per (sender, tag), in the order they were first seen. */
+    std::vector<MPISendQueue> queues;
+    /** Index in queues of each (sender, tag). */
+    std::unordered_map<uint64_t, size_t> queue_index;
+    /** Receives as (rank, index in that rank's endpoints). */
+    std::vector<std::pair<uint32_t, size_t>> recvs;
+
+    MPISendQueue& getQueue(uint32_t sender, uint32_t tag) {
+        auto [it, inserted] = queue_index.try_emplace((uint64_t(sender) << 32) | tag, queues.size());
+        if (inserted) {
+            queues.push_back({sender, tag, {}, 0});
+        }
+        return queues[it->second];
+    }
+};
+
+/** A send paired with its receive. */
+struct MPIMatchedMessage {
+    const MPIEndpoint* send;
+    const MPIEndpoint* recv;
+    uint32_t sender;
+    uint32_t receiver;
+};
+
+MPIMessageColumns match_mpi_messages(pallas::GlobalArchive& trace, size_t nb_workers) {
+    // Archives are loaded first, since loading them modifies the GlobalArchive.
+    std::vector<pallas::Archive*> archives;
+    for (auto& location_group : trace.location_groups) {
+        auto* archive = trace.getArchive(location_group.id);
+        if (archive != nullptr) {
+            archives.push_back(archive);
+        }
+    }
+
+    std::vector<MPIRankEndpoints> endpoints(archives.size());
+    pallas::parallelFor(archives.size(), nb_workers, [&](size_t i) {
+        endpoints[i] = collect_endpoints(archives[i]);
+    });
+
+    // Group the endpoints by receiver and communicator. Within a rank, the endpoints are in the order of the calls.
+    std::vector<MPIMailbox> mailboxes;
+    std::unordered_map<uint64_t, size_t> mailbox_index;
+    auto get_mailbox = [&](uint32_t receiver, uint32_t communicator) -> MPIMailbox& {
+        auto [it, inserted] = mailbox_index.try_emplace((uint64_t(receiver) << 32) | communicator, mailboxes.size());
+        if (inserted) {
+            mailboxes.emplace_back();
+            mailboxes.back().receiver = receiver;
+            mailboxes.back().communicator = communicator;
+        }
+        return mailboxes[it->second];
+    };
+    for (size_t r = 0; r < archives.size(); r++) {
+        uint32_t rank = archives[r]->id;
+        auto& rank_endpoints = endpoints[r];
+        for (size_t i = 0; i < rank_endpoints.sends.size(); i++) {
+            auto& e = rank_endpoints.sends[i];
+            get_mailbox(e.peer, e.communicator).getQueue(rank, e.tag).sends.emplace_back(r, i);
+        }
+        for (size_t i = 0; i < rank_endpoints.recvs.size(); i++) {
+            auto& e = rank_endpoints.recvs[i];
+            get_mailbox(rank, e.communicator).recvs.emplace_back(r, i);
+        }
+    }
+
+    auto send_of = [&](const std::pair<uint32_t, size_t>& s) -> const MPIEndpoint& {
+        return endpoints[s.first].sends[s.second];
+    };
+    auto recv_of = [&](const std::pair<uint32_t, size_t>& r) -> const MPIEndpoint& {
+        return endpoints[r.first].recvs[r.second];
+    };
+
+    // Mailboxes are independent from one another.
+    std::vector<std::vector<MPIMatchedMessage>> mailbox_messages(mailboxes.size());
+    std::vector<size_t> mailbox_unmatched_recvs(mailboxes.size(), 0);
+    pallas::parallelFor(mailboxes.size(), nb_workers, [&](size_t m) {
+        auto& mailbox = mailboxes[m];
+        // A rank may have several threads: sort the calls chronologically.
+        for (auto& queue : mailbox.queues) {
+            std::stable_sort(queue.sends.begin(), queue.sends.end(), [&](const auto& a, const auto& b) {
+                return send_of(a).call_ts < send_of(b).call_ts;
+            });
+        }
+        std::stable_sort(mailbox.recvs.begin(), mailbox.recvs.end(), [&](const auto& a, const auto& b) {
+            return recv_of(a).call_ts < recv_of(b).call_ts;
+        });
+
+        for (auto& r : mailbox.recvs) {
+            auto& recv = recv_of(r);
+            MPISendQueue* match = nullptr;
+            if (recv.peer != PALLAS_MPI_ANY && recv.tag != PALLAS_MPI_ANY) {
+                auto it = mailbox.queue_index.find((uint64_t(recv.peer) << 32) | recv.tag);
+                if (it != mailbox.queue_index.end() && mailbox.queues[it->second].next < mailbox.queues[it->second].sends.size()) {
+                    match = &mailbox.queues[it->second];
+                }
+            } else {
+                // A wildcard receive matches the earliest pending send among the streams it accepts.
+                for (auto& queue : mailbox.queues) {
+                    if (queue.next == queue.sends.size()) {
+                        continue;
+                    }
+                    if (recv.peer != PALLAS_MPI_ANY && recv.peer != queue.sender) {
+                        continue;
+                    }
+                    if (recv.tag != PALLAS_MPI_ANY && recv.tag != queue.tag) {
+                        continue;
+                    }
+                    if (match == nullptr || send_of(queue.sends[queue.next]).call_ts < send_of(match->sends[match->next]).call_ts) {
+                        match = &queue;
+                    }
+                }
+            }
+            if (match == nullptr) {
+                mailbox_unmatched_recvs[m]++;
+                continue;
+            }
+            auto& send = send_of(match->sends[match->next++]);
+            mailbox_messages[m].push_back({&send, &recv, match->sender, mailbox.receiver});
+        }
+    });
+
+    MPIMessageColumns output;
+    std::vector<MPIMatchedMessage> messages;
+    for (size_t m = 0; m < mailboxes.size(); m++) {
+        messages.insert(messages.end(), mailbox_messages[m].begin(), mailbox_messages[m].end());
+        output.nb_unmatched_recvs += mailbox_unmatched_recvs[m];
+        for (auto& queue : mailboxes[m].queues) {
+            output.nb_unmatched_sends += queue.sends.size() - queue.next;
+        }
+    }
+    std::sort(messages.begin(), messages.end(), [](const MPIMatchedMessage& a, const MPIMatchedMessage& b) {
+        if (a.send->call_ts != b.send->call_ts)
+            return a.send->call_ts < b.send->call_ts;
+        if (a.sender != b.sender)
+            return a.sender < b.sender;
+        return a.recv->call_ts < b.recv->call_ts;
+    });
+
+    size_t n = messages.size();
+    output.sender.reserve(n);
+    output.receiver.reserve(n);
+    output.tag.reserve(n);
+    output.communicator.reserve(n);
+    output.msg_length.reserve(n);
+    output.isend_ts.reserve(n);
+    output.start_swait_ts.reserve(n);
+    output.end_swait_ts.reserve(n);
+    output.irecv_ts.reserve(n);
+    output.start_rwait_ts.reserve(n);
+    output.end_rwait_ts.reserve(n);
+    for (auto& m : messages) {
+        output.sender.push_back(m.sender);
+        output.receiver.push_back(m.receiver);
+        output.tag.push_back(m.send->tag);
+        output.communicator.push_back(m.send->communicator);
+        output.msg_length.push_back(m.send->msg_length);
+        output.isend_ts.push_back(m.send->call_ts);
+        output.start_swait_ts.push_back(m.send->start_wait_ts);
+        output.end_swait_ts.push_back(m.send->end_wait_ts);
+        output.irecv_ts.push_back(m.recv->call_ts);
+        output.start_rwait_ts.push_back(m.recv->start_wait_ts);
+        output.end_rwait_ts.push_back(m.recv->end_wait_ts);
+    }
+    return output;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
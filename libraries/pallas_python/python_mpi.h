@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+#pragma once
+#include <pallas/pallas.h>
+#include <pallas/pallas_archive.h>
+
+#include <vector>
+
+/** Source or tag of a receive posted with MPI_ANY_SOURCE or MPI_ANY_TAG. */
+#define PALLAS_MPI_ANY UINT32_MAX
+
+/** MPI messages reconstructed from a trace, stored one column per field. */
+struct MPIMessageColumns {
+    /** Rank of the sender. */
+    std::vector<uint32_t> sender;
+    /** Rank of the receiver. */
+    std::vector<uint32_t> receiver;
+    /** Tag of the message. */
+    std::vector<uint32_t> tag;
+    /** Communicator of the message. */
+    std::vector<uint32_t> communicator;
+    /** Message length ( bytes ). */
+    std::vector<uint64_t> msg_length;
+    /** Timestamp of the Send/ISend call. */
+    std::vector<pallas_timestamp_t> isend_ts;
+    /** Start of the Wait call of the sender. */
+    std::vector<pallas_timestamp_t> start_swait_ts;
+    /** End of the Wait call of the sender. */
+    std::vector<pallas_timestamp_t> end_swait_ts;
+    /** Timestamp of the Recv/IRecv call. */
+    std::vector<pallas_timestamp_t> irecv_ts;
+    /** Start of the Wait call of the receiver. */
+    std::vector<pallas_timestamp_t> start_rwait_ts;
+    /** End of the Wait call of the receiver. */
+    std::vector<pallas_timestamp_t> end_rwait_ts;
+    /** Number of sends that didn't match any receive. */
+    size_t nb_unmatched_sends = 0;
+    /** Number of receives that didn't match any send. */
+    size_t nb_unmatched_recvs = 0;
+
+    [[nodiscard]] size_t size() const { return sender.size(); }
+};
+
+/**
+ * Reconstructs the MPI messages of a trace.
+ *
+ * Each rank ( Archive ) is read independently on a pool of workers. The receives of each rank and communicator
+ * are then matched in the order they were posted: MPI messages are non-overtaking, so a receive from A with a
+ * given tag matches the earliest send from A with that tag that is not matched yet. A receive posted with
+ * MPI_ANY_SOURCE or MPI_ANY_TAG ( PALLAS_MPI_ANY ) matches the earliest pending send among the ones it accepts.
+ * The messages are sorted by Send/ISend timestamp. This function keeps no state between calls.
+ * @param trace Trace to read.
+ * @param nb_workers Number of workers. 0 means one per hardware thread.
+ */
+MPIMessageColumns match_mpi_messages(pallas::GlobalArchive& trace, size_t nb_workers = 0);
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
@@ -78,10 +78,17 @@ std::map<pallas::RegionRef, PyRegion> Trace_get_regions(pallas::GlobalArchive& t
 }
 
 py::list* Trace_get_archives(pallas::GlobalArchive& trace) {
-    auto* list = new py::list(trace.location_groups.size());
-    int i = 0;
-    for (auto& locationGroup : trace.location_groups) {
-        list->operator[](i++) = trace.getArchive(locationGroup.id);
+    std::vector<pallas::Archive*> archives;
+    {
+        // Loading the archives reads files: let the other Python threads run meanwhile.
+        py::gil_scoped_release release;
+        for (auto& locationGroup : trace.location_groups) {
+            archives.push_back(trace.getArchive(locationGroup.id));
+        }
+    }
+    auto* list = new py::list(archives.size());
+    for (size_t i = 0; i < archives.size(); i++) {
+        list->operator[](i) = archives[i];
     }
     return list;
 }
@@ -94,6 +101,7 @@ pallas::GlobalArchive* open_trace(const std::string& path) {
 std::vector<PySequence> threadGetSequences(pallas::Thread& self) {
     auto output = std::vector<PySequence>(self.nb_sequences);
     for (size_t i = 0; i < self.nb_sequences; i++) {
+        self.loadSequence(i);
         output[i].self = &self.sequences[i];
         output[i].thread = &self;
     }
@@ -112,6 +120,7 @@ std::vector<PyLoop> threadGetLoops(pallas::Thread& self) {
 std::vector<PyEvent> threadGetEvents(pallas::Thread& self) {
     auto output = std::vector<PyEvent>(self.nb_events);
     for (size_t i = 0; i < self.nb_events; i++) {
+        self.loadEvent(i);
         output[i].self = &self.events[i];
         output[i].thread = &self;
     }
@@ -166,6 +175,7 @@ bool doesSequenceContains(const PySequence& self, pallas::Token t) {
 std::vector<PyEvent> threadGetEventsMatching(pallas::Thread& t, pallas::Record record) {
     auto output = std::vector<PyEvent>();
     for (size_t i = 0; i < t.nb_events; i++) {
+        t.loadEvent(i);
         if (t.events[i].data.record == record) {
             output.push_back({&t.events[i], &t});
         }
@@ -177,6 +187,7 @@ std::vector<PyEvent> threadGetEventsMatching(pallas::Thread& t, pallas::Record r
 std::vector<PyEvent> threadGetEventsMatchingList(pallas::Thread& t, std::vector<pallas::Record> records) {
     auto output = std::vector<PyEvent>();
     for (size_t i = 0; i < t.nb_events; i++) {
+        t.loadEvent(i);
         for (auto record : records) {
             if (t.events[i].data.record == record) {
                 output.push_back({&t.events[i], &t});
@@ -222,24 +233,46 @@ py::tuple makePyObjectFromToken(pallas::Token t, pallas::ThreadReader& thread_re
 }
 
 py::array_t<uint64_t> linked_vector_to_numpy(PyLinkedVector& self) {
-    py::capsule free_when_done(&self, [](void* f) {
+    size_t size = self.linked_vector ? self.linked_vector->size : self.linked_duration_vector->size;
+    py::array_t<uint64_t> output(size);
+    uint64_t* data = output.mutable_data();
+    {
+        // Loading the subvectors may take a while, other Python threads can run meanwhile.
+        py::gil_scoped_release release;
+        if (self.linked_vector)
+            self.linked_vector->copy_to_array(data);
+        else
+            self.linked_duration_vector->copy_to_array(data);
+    }
+    return output;
+}
 
-    });
+/** What the NumPy views of a Vector point to. It is freed with the last of them. */
+struct PyPinnedVector {
+    /** The subvectors pinned by pin_data: they stay allocated even if the Thread of the vector is freed. */
+    std::vector<std::pair<uint64_t*, size_t>> sub_arrays;
+    /** The Python Vector the views were taken from. */
+    py::object owner;
+    ~PyPinnedVector() { pallas::unpinSubArrayData(sub_arrays); }
+};
 
-    if (self.linked_vector)
-        return py::array_t<uint64_t>(
-                {self.linked_vector->size},
-                {sizeof(uint64_t)},
-                &self.linked_vector->at(0),
-                free_when_done
-                );
-    else
-        return py::array_t<uint64_t>(
-                {self.linked_duration_vector->size},
-                {sizeof(uint64_t)},
-                &self.linked_duration_vector->at(0),
-                free_when_done
-                );
+py::list linked_vector_to_numpy_views(py::object self_object) {
+    auto& self = self_object.cast<PyLinkedVector&>();
+    auto* pinned = new PyPinnedVector{{}, self_object};
+    {
+        py::gil_scoped_release release;
+        pinned->sub_arrays = self.linked_vector ? self.linked_vector->pin_data() : self.linked_duration_vector->pin_data();
+    }
+    // The views share the pins, which are released when the last one is garbage collected.
+    py::capsule owner(pinned, [](void* p) { delete static_cast<PyPinnedVector*>(p); });
+    py::list output(pinned->sub_arrays.size());
+    for (size_t i = 0; i < pinned->sub_arrays.size(); i++) {
+        auto& [data, size] = pinned->sub_arrays[i];
+        auto view = py::array_t<uint64_t>({size}, {sizeof(uint64_t)}, data, owner);
+        view.attr("setflags")(py::arg("write") = false);
+        output[i] = view;
+    }
+    return output;
 }
 
 std::vector<py::tuple> thread_reader_get_callstack(pallas::ThreadReader& self) {
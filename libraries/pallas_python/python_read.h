@@ -98,6 +98,8 @@ py::tuple makePyObjectFromToken(pallas::Token t, pallas::ThreadReader& thread_re
 
 py::array_t<uint64_t> linked_vector_to_numpy(PyLinkedVector& self);
 
+py::list linked_vector_to_numpy_views(py::object self);
+
 std::vector<py::tuple> thread_reader_get_callstack(pallas::ThreadReader& self);
 
 int get_read_flags_from_bools(bool enter_sequence, bool enter_loop);
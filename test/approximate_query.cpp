@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Checks the approximate queries over the durations of a Sequence:
+ * nb_calls calls to a function whose durations are known are recorded, and for several time frames,
+ * the approximate summaries must be within their error bounds of the exact ones,
+ * while only reading the SubArrays at the edges of the time frames.
+ */
+
+#include <string>
+
+#include "pallas/pallas.h"
+#include "pallas/pallas_archive.h"
+#include "pallas/pallas_record.h"
+#include "pallas/pallas_write.h"
+
+#include "pallas/utils/pallas_log.h"
+#include "pallas/utils/pallas_storage.h"
+
+using namespace pallas;
+
+static const RegionRef function = 1;
+
+static uint64_t call_duration(size_t i) {
+    return 10 + (i * 7919) % 1000 * ((i % 4 == 0) ? 100 : 1);
+}
+
+/** Checks that an approximate summary is within its bounds of the exact one. */
+static void check_summary(const DurationSummary& approximate, const DurationSummary& exact) {
+    pallas_assert_always(exact.isExact());
+    pallas_assert_equals_always(approximate.count, exact.count);
+    pallas_assert_equals_always(approximate.min, exact.min);
+    pallas_assert_equals_always(approximate.max, exact.max);
+    pallas_assert_inferior_equal_always(approximate.sum, exact.sum);
+    pallas_assert_inferior_equal_always(exact.sum, approximate.sum + approximate.sum_error);
+    if (exact.count == 0)
+        return;
+    double mean_error = approximate.sum_error / 2. / approximate.count;
+    if (std::abs(approximate.mean() - exact.mean()) > mean_error + 1e-9)
+        pallas_error("Mean %f is not within %f of %f\n", approximate.mean(), mean_error, exact.mean());
+    for (double q : {0., .1, .5, .9, .99, 1.}) {
+        uint64_t error;
+        uint64_t value = approximate.quantile(q, &error);
+        uint64_t expected = exact.quantile(q);
+        uint64_t difference = value > expected ? value - expected : expected - value;
+        if (difference > error)
+            pallas_error("Quantile %f: %lu is not within %lu of %lu\n", q, value, error, expected);
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t nb_calls = argc > 1 ? std::stoul(argv[1]) : 20000;
+    const char* trace_name = argc > 2 ? argv[2] : "approximate_query_trace";
+
+    GlobalArchive trace(trace_name, "main");
+    trace.addString(0, "thread");
+    trace.addString(function, "function");
+    trace.addRegion(function, function);
+    Archive archive(trace, 0);
+    archive.global_archive = &trace;
+    trace.defineLocationGroup(0, 0, PALLAS_LOCATION_GROUP_ID_INVALID);
+    archive.defineLocation(0, 0, 0);
+
+    pallas_timestamp_t ts = 1;
+    ThreadWriter writer(archive, 0);
+    for (size_t i = 0; i < nb_calls; i++) {
+        pallas_record_enter(&writer, nullptr, ts, function);
+        ts += call_duration(i);
+        pallas_record_leave(&writer, nullptr, ts, function);
+        ts += 5;
+    }
+    writer.threadClose();
+    archive.store();
+    trace.store();
+
+    auto* read_trace = pallas_open_trace((std::string(trace_name) + "/main.pallas").c_str());
+    if (read_trace == nullptr) {
+        pallas_error("Cannot open %s\n", trace_name);
+    }
+    auto* thread = read_trace->getThreadList().front();
+    Sequence* sequence = nullptr;
+    for (size_t i = 0; i < thread->nb_sequences; i++) {
+        if (thread->sequences[i].guessName(thread) == "function")
+            sequence = &thread->sequences[i];
+    }
+    pallas_assert_always(sequence != nullptr);
+    pallas_assert_equals_always(sequence->durations->size, nb_calls);
+
+    pallas_timestamp_t first = thread->getFirstTimestamp();
+    pallas_timestamp_t duration = thread->getDuration();
+    // Time frames that start and end in the middle of SubArrays, at their edges, or span the whole thread.
+    const double frames[][2] = {{0, 1}, {.1, .9}, {.33, .34}, {.5, .5}, {.05, .95}, {-1, 2}};
+    auto* parameter_handler = read_trace->parameter_handler;
+    for (auto& frame : frames) {
+        pallas_timestamp_t start = first + static_cast<int64_t>(frame[0] * duration);
+        pallas_timestamp_t end = first + static_cast<int64_t>(frame[1] * duration);
+        if (frame[0] < 0) {
+            start = 0;
+            end = PALLAS_TIMESTAMP_INVALID;
+        }
+        sequence->durations->free_data();
+        sequence->timestamps->free_data();
+        size_t loaded_before = parameter_handler->loaded_durations_size;
+        auto approximate = sequence->summarizeDurations(start, end, true);
+        // At most two SubArrays of timestamps and two of durations, at the edges of the time frame.
+        size_t loaded = parameter_handler->loaded_durations_size - loaded_before;
+        pallas_assert_inferior_equal_always(loaded, 4 * DEFAULT_VECTOR_SIZE * sizeof(uint64_t));
+        if (frame[1] - frame[0] > .5)
+            pallas_assert_always(!approximate.isExact());
+        auto exact = sequence->summarizeDurations(start, end, false);
+        check_summary(approximate, exact);
+    }
+    pallas_assert_equals_always(sequence->summarizeDurations(0, PALLAS_TIMESTAMP_INVALID, false).count, nb_calls);
+
+    // The approximate snapshot is within the rounding of the means of the SubArrays of the exact one.
+    pallas_timestamp_t start = first + duration / 10;
+    pallas_timestamp_t end = first + duration / 10 * 9;
+    auto exact_view = thread->getSnapshotViewByLabel(start, end, false);
+    auto approximate_view = thread->getSnapshotViewByLabel(start, end, true);
+    pallas_assert_equals_always(exact_view.size(), approximate_view.size());
+    for (size_t label = 0; label < exact_view.size(); label++) {
+        pallas_assert_inferior_equal_always(approximate_view[label], exact_view[label]);
+        pallas_assert_inferior_equal_always(exact_view[label], approximate_view[label] + nb_calls);
+    }
+    delete read_trace;
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
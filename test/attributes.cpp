@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Checks that the attributes of the events are read back as they were recorded, once stored by column:
+ * a counter, a constant, an attribute that is only set on some occurrences, and occurrences without attributes.
+ * The attributes are looked up in a random order, which the occurrence index allows.
+ */
+
+#include <string>
+
+#include "pallas/pallas.h"
+#include "pallas/pallas_archive.h"
+#include "pallas/pallas_attribute.h"
+#include "pallas/pallas_read.h"
+#include "pallas/pallas_record.h"
+#include "pallas/pallas_write.h"
+
+#include "pallas/utils/pallas_log.h"
+#include "pallas/utils/pallas_storage.h"
+
+using namespace pallas;
+
+static const AttributeRef counter_ref = 1;
+static const AttributeRef constant_ref = 2;
+static const AttributeRef sparse_ref = 3;
+
+static bool has_attributes(size_t i) {
+    return i % 3 != 0;
+}
+
+static bool has_sparse_attribute(size_t i) {
+    return i % 5 == 0;
+}
+
+/** Checks the AttributeList of the occurrence i. */
+static void check_attributes(const AttributeList* l, size_t i) {
+    if (!has_attributes(i)) {
+        if (l != nullptr)
+            pallas_error("Occurrence %zu shouldn't have attributes\n", i);
+        return;
+    }
+    if (l == nullptr)
+        pallas_error("Occurrence %zu should have attributes\n", i);
+    pallas_assert_equals_always(l->index, static_cast<int>(i));
+    int nb_values = has_sparse_attribute(i) ? 3 : 2;
+    pallas_assert_equals_always(l->nb_values, nb_values);
+    uint16_t pos = 0;
+    AttributeData data;
+    pallas_attribute_list_pop_data(l, &data, &pos);
+    pallas_assert_equals_always(data.ref, counter_ref);
+    pallas_assert_equals_always(data.value.uint64, 1000 + 3 * i);
+    pallas_attribute_list_pop_data(l, &data, &pos);
+    pallas_assert_equals_always(data.ref, constant_ref);
+    pallas_assert_equals_always(data.value.uint32, 42);
+    if (has_sparse_attribute(i)) {
+        pallas_attribute_list_pop_data(l, &data, &pos);
+        pallas_assert_equals_always(data.ref, sparse_ref);
+        pallas_assert_equals_always(data.value.int8, static_cast<int8_t>(-(i % 100)));
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t nb_occurrences = argc > 1 ? std::stoul(argv[1]) : 10000;
+    const char* trace_name = argc > 2 ? argv[2] : "attributes_trace";
+
+    GlobalArchive trace(trace_name, "main");
+    trace.addString(0, "event");
+    trace.addString(1, "counter");
+    trace.addString(2, "constant");
+    trace.addString(3, "sparse");
+    trace.addAttribute(counter_ref, 1, 1, PALLAS_TYPE_UINT64);
+    trace.addAttribute(constant_ref, 2, 2, PALLAS_TYPE_UINT32);
+    trace.addAttribute(sparse_ref, 3, 3, PALLAS_TYPE_INT8);
+    Archive archive(trace, 0);
+    archive.global_archive = &trace;
+    trace.defineLocationGroup(0, 0, PALLAS_LOCATION_GROUP_ID_INVALID);
+    archive.defineLocation(0, 0, 0);
+
+    ThreadWriter writer(archive, 0);
+    for (size_t i = 0; i < nb_occurrences; i++) {
+        if (!has_attributes(i)) {
+            pallas_record_generic(&writer, nullptr, i + 1, 0);
+            continue;
+        }
+        AttributeList list;
+        pallas_attribute_list_init(&list);
+        AttributeValue value;
+        value.uint64 = 1000 + 3 * i;
+        pallas_attribute_list_add_attribute(&list, counter_ref, sizeof(value.uint64), value);
+        value.uint32 = 42;
+        pallas_attribute_list_add_attribute(&list, constant_ref, sizeof(value.uint32), value);
+        if (has_sparse_attribute(i)) {
+            value.int8 = static_cast<int8_t>(-(i % 100));
+            pallas_attribute_list_add_attribute(&list, sparse_ref, sizeof(value.int8), value);
+        }
+        pallas_record_generic(&writer, &list, i + 1, 0);
+    }
+    // The attributes can be looked up while recording.
+    Event* recorded = writer.thread->getEvent(PALLAS_EVENT_ID(0));
+    check_attributes(recorded->getAttributeList(1), 1);
+    writer.threadClose();
+    archive.store();
+    trace.store();
+
+    auto* read_trace = pallas_open_trace((std::string(trace_name) + "/main.pallas").c_str());
+    if (read_trace == nullptr) {
+        pallas_error("Cannot open %s\n", trace_name);
+    }
+    auto* thread = read_trace->getThreadList().front();
+    {
+        // The reader frees the thread when it is destroyed.
+        ThreadReader reader(thread->archive, thread->id, PALLAS_READ_FLAG_UNROLL_ALL);
+        size_t nb_read = 0;
+        Token event_id = INVALID_TOKEN;
+        for (auto token = reader.pollCurToken(); token != INVALID_TOKEN; token = reader.getNextToken()) {
+            if (token.type != TypeEvent)
+                continue;
+            event_id = token;
+            size_t occurrence = reader.getCurrentTokenCount(token);
+            check_attributes(reader.getEventOccurrence(token, occurrence).attributes, occurrence);
+            nb_read++;
+        }
+        pallas_assert_equals_always(nb_read, nb_occurrences);
+
+        pallas_assert_always(thread->getEvent(event_id)->attribute_offsets != nullptr);
+        uint32_t state = 1;
+        for (size_t n = 0; n < nb_occurrences; n++) {
+            state = state * 1103515245 + 12345;
+            size_t occurrence = (state >> 8) % nb_occurrences;
+            check_attributes(reader.getEventAttributeList(event_id, occurrence), occurrence);
+        }
+        pallas_assert_always(reader.getEventAttributeList(event_id, nb_occurrences) == nullptr);
+    }
+    delete read_trace;
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
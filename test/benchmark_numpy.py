@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+# Compares the ways of getting the durations / timestamps of a trace as NumPy arrays:
+#  - iterating over the Vector (one Python call per element)
+#  - Vector.as_numpy_array (one memcpy per subvector)
+#  - Vector.as_numpy_views (no copy at all), optionally followed by numpy.concatenate
+#
+# Usage: benchmark_numpy.py trace/main.pallas
+import sys
+import time
+
+import numpy as np
+import pallas_trace as pallas
+
+
+def vectors(trace):
+    for archive in trace.archives:
+        for thread in archive.threads:
+            for sequence in thread.sequences:
+                yield sequence.timestamps
+                yield sequence.durations
+
+
+def bench(name, trace_file, convert):
+    # Re-open the trace every time, so that every method has to load the data.
+    trace = pallas.open_trace(trace_file)
+    nb_values = 0
+    start = time.perf_counter()
+    for vector in vectors(trace):
+        nb_values += convert(vector)
+    duration = time.perf_counter() - start
+    print(f"{name:<28}{nb_values:>14}{duration:>12.4f}{nb_values / duration / 1e6:>14.2f}")
+
+
+def by_iteration(vector):
+    return len(np.fromiter(vector, dtype=np.uint64, count=vector.size))
+
+
+def by_copy(vector):
+    return len(vector.as_numpy_array())
+
+
+def by_views(vector):
+    return sum(len(view) for view in vector.as_numpy_views())
+
+
+def by_views_concatenate(vector):
+    views = vector.as_numpy_views()
+    return len(np.concatenate(views)) if views else 0
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print(f"Usage: {sys.argv[0]} trace/main.pallas")
+        sys.exit(1)
+    trace_file = sys.argv[1]
+    print(f"{'Method':<28}{'Values':>14}{'Time (s)':>12}{'MValues/s':>14}")
+    bench("iteration", trace_file, by_iteration)
+    bench("as_numpy_array", trace_file, by_copy)
+    bench("as_numpy_views", trace_file, by_views)
+    bench("as_numpy_views+concatenate", trace_file, by_views_concatenate)
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Checks the checksums of a trace: a trace that was just stored must be verified without any error,
+ * then a byte is flipped in a data file and in a thread file, and each corruption must be reported.
+ * Reading a corrupted block with the checksums verified must stop with a checksum error before the block is decoded.
+ */
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "pallas/pallas.h"
+#include "pallas/pallas_archive.h"
+#include "pallas/pallas_record.h"
+#include "pallas/pallas_write.h"
+
+#include "pallas/utils/pallas_log.h"
+#include "pallas/utils/pallas_storage.h"
+
+using namespace pallas;
+
+static const RegionRef function = 1;
+
+/** Records nb_calls calls to a function, and stores the trace. */
+static void record_trace(const char* trace_name, size_t nb_calls) {
+    GlobalArchive trace(trace_name, "main");
+    trace.addString(0, "thread");
+    trace.addString(function, "function");
+    trace.addRegion(function, function);
+    Archive archive(trace, 0);
+    archive.global_archive = &trace;
+    trace.defineLocationGroup(0, 0, PALLAS_LOCATION_GROUP_ID_INVALID);
+    archive.defineLocation(0, 0, 0);
+
+    ThreadWriter writer(archive, 0);
+    for (size_t i = 0; i < nb_calls; i++) {
+        pallas_record_enter(&writer, nullptr, 10 * i + i % 3, function);
+        pallas_record_leave(&writer, nullptr, 10 * i + 5, function);
+    }
+    writer.threadClose();
+    archive.store();
+    trace.store();
+}
+
+/** Flips the bits of the byte at offset in a file. A negative offset is from the end of the file. */
+static void flip_byte(const std::filesystem::path& path, long offset) {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    pallas_assert_always(file.is_open());
+    file.seekg(offset, offset < 0 ? std::ios::end : std::ios::beg);
+    auto position = file.tellg();
+    char byte = 0;
+    file.read(&byte, 1);
+    byte = static_cast<char>(~byte);
+    file.seekp(position);
+    file.write(&byte, 1);
+}
+
+/** Verifies the trace, and checks that it finds nb_errors errors, that all mention the given file. */
+static void check_errors(const std::string& main_file, size_t nb_errors, const std::string& corrupted_file) {
+    auto report = pallasVerifyTrace(main_file.c_str(), 2);
+    for (const auto& error : report.errors) {
+        pallas_log(DebugLevel::Normal, "%s\n", error.c_str());
+        pallas_assert_always(error.find(corrupted_file) != std::string::npos);
+    }
+    pallas_assert_equals_always(report.errors.size(), nb_errors);
+    pallas_assert_always(report.nb_files > 0);
+}
+
+/** Writes a size_t at offset in a file. */
+static void write_size(const std::filesystem::path& path, long offset, size_t size) {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    pallas_assert_always(file.is_open());
+    file.seekp(offset);
+    file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+}
+
+/**
+ * Reads every timestamp of the trace, with the checksums verified, in a child process.
+ * Checks that it stops with a Pallas error that contains the given message, instead of failing in a decoder.
+ */
+static void check_read_error(const std::string& main_file, const char* message) {
+    int output[2];
+    pallas_assert_always(pipe(output) == 0);
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    pallas_assert_always(pid >= 0);
+    if (pid == 0) {
+        dup2(output[1], STDERR_FILENO);
+        close(output[0]);
+        auto* trace = pallas_open_trace(main_file.c_str());
+        trace->parameter_handler->verifyChecksums = true;
+        uint64_t sum = 0;
+        for (auto* thread : trace->getThreadList()) {
+            for (size_t i = 0; i < thread->nb_events; i++) {
+                auto* timestamps = thread->events[i].timestamps;
+                for (size_t j = 0; j < timestamps->size; j++)
+                    sum += timestamps->at(j);
+            }
+        }
+        _exit(sum == 0 ? 2 : 0);
+    }
+    close(output[1]);
+    std::string errors;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(output[0], buffer, sizeof(buffer))) > 0)
+        errors.append(buffer, n);
+    close(output[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    pallas_log(DebugLevel::Normal, "%s", errors.c_str());
+    // pallas_error aborts.
+    pallas_assert_always(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+    pallas_assert_always(errors.find("Pallas error") != std::string::npos);
+    pallas_assert_always(errors.find(message) != std::string::npos);
+}
+
+int main(int argc, char** argv) {
+    size_t nb_calls = argc > 1 ? std::stoul(argv[1]) : 10000;
+    const char* trace_name = argc > 2 ? argv[2] : "checksums_trace";
+    std::filesystem::remove_all(trace_name);
+    record_trace(trace_name, nb_calls);
+
+    std::string main_file = std::string(trace_name) + "/main.pallas";
+    auto report = pallasVerifyTrace(main_file.c_str(), 2);
+    pallas_assert_always(report.errors.empty());
+    // The thread has at least the timestamps of two Events, and the timestamps and durations of a Sequence.
+    pallas_assert_always(report.nb_blocks >= 5);
+    pallas_log(DebugLevel::Normal, "Verified %zu files and %zu blocks\n", report.nb_files, report.nb_blocks);
+
+    // The data files don't have a trailer: their last byte belongs to the last block.
+    auto thread_dir = std::filesystem::path(trace_name) / "archive_0" / "thread_0";
+    flip_byte(thread_dir / "event_durations.dat", -1);
+    check_errors(main_file, 1, "event_durations.dat");
+    flip_byte(thread_dir / "event_durations.dat", -1);
+    check_errors(main_file, 0, "");
+
+    // Flips a byte of the data of the first block, then its size, and reads it.
+    size_t first_block_size = 0;
+    {
+        std::ifstream file(thread_dir / "event_durations.dat", std::ios::binary);
+        file.read(reinterpret_cast<char*>(&first_block_size), sizeof(first_block_size));
+    }
+    pallas_assert_always(first_block_size > 1);
+    flip_byte(thread_dir / "event_durations.dat", sizeof(size_t) + first_block_size / 2);
+    check_read_error(main_file, "checksum mismatch");
+    flip_byte(thread_dir / "event_durations.dat", sizeof(size_t) + first_block_size / 2);
+    write_size(thread_dir / "event_durations.dat", 0, SIZE_MAX / 2);
+    check_read_error(main_file, "invalid block size");
+    write_size(thread_dir / "event_durations.dat", 0, first_block_size);
+    check_errors(main_file, 0, "");
+
+    flip_byte(thread_dir / "thread.pallas", 16);
+    check_errors(main_file, 1, "thread.pallas");
+    flip_byte(thread_dir / "thread.pallas", 16);
+
+    flip_byte(main_file, -1);
+    check_errors(main_file, 1, "main.pallas");
+    flip_byte(main_file, -1);
+    check_errors(main_file, 0, "");
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
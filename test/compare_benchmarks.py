@@ -0,0 +1,47 @@
+#!/usr/bin/env python3
+# Compares two runs of a microbenchmark suite (write_microbenchmark, ...), written with -o.
+# Prints the change of the median time per operation of every benchmark found in both runs,
+# and exits with 1 if one of them is slower than the threshold.
+#
+# Usage: compare_benchmarks.py before.jsonl after.jsonl [threshold_percent, default: 10]
+import json
+import sys
+
+
+def load(path):
+    results = {}
+    with open(path) as f:
+        for line in f:
+            if line.strip():
+                result = json.loads(line)
+                key = (result["benchmark"], tuple(sorted(result["parameters"].items())))
+                results[key] = result["median_ns_per_op"]
+    return results
+
+
+def main():
+    if len(sys.argv) < 3:
+        print(f"Usage: {sys.argv[0]} before.jsonl after.jsonl [threshold_percent]")
+        return 2
+    before = load(sys.argv[1])
+    after = load(sys.argv[2])
+    threshold = float(sys.argv[3]) if len(sys.argv) > 3 else 10.0
+
+    nb_regressions = 0
+    for key in before:
+        if key not in after:
+            continue
+        name, parameters = key
+        change = (after[key] - before[key]) * 100 / before[key] if before[key] else 0
+        flag = ""
+        if change > threshold:
+            flag = "  <-- REGRESSION"
+            nb_regressions += 1
+        params = ", ".join(f"{k}={v}" for k, v in parameters)
+        print(f"{name:28} {params:40} {before[key]:12.1f} ns -> {after[key]:12.1f} ns  {change:+7.1f}%{flag}")
+    print(f"{nb_regressions} benchmarks slower by more than {threshold}%")
+    return 1 if nb_regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Microbenchmarks of the lookups of definitions, in memory, with nb_regions Regions and as many Strings.
+ * The refs are either dense (0, 1, 2, ...) or sparse (spread over the whole range of refs), and are looked up in a
+ * pseudo-random order, like the Enter and Leave of a trace.
+ *  - region_string: GlobalArchive::getRegion then GlobalArchive::getString of its name, as when printing an Event.
+ *  - definition_region_string: the same lookups in the Definition, without the lock of the GlobalArchive.
+ *  - map_region_string: the same lookups in std::maps, as the definitions used to be stored, for comparison.
+ *  - attribute: GlobalArchive::getAttribute, as when printing the attributes of an Event.
+ */
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "pallas/pallas.h"
+#include "pallas/pallas_archive.h"
+#include "pallas/pallas_attribute.h"
+#include "pallas_benchmark.h"
+
+using namespace pallas;
+using namespace pallas_benchmark;
+
+static const char* description = "Microbenchmarks of the lookups of definitions. Prints one JSON object per benchmark and parameter set.";
+static const char* dir_name = "definition_microbenchmark_trace";
+/** Keeps the compiler from optimizing the benchmarked calls away. */
+static volatile uint64_t sink;
+
+/** Returns the ref of the i-th definition. The sparse refs are spread over the whole range of uint32_t. */
+static uint32_t makeRef(size_t i, bool sparse) {
+    return sparse ? static_cast<uint32_t>(i * 2654435761u) | 1u : static_cast<uint32_t>(i);
+}
+
+/** Returns nb_lookups indices of definitions in [0, n), in a pseudo-random order. */
+static std::vector<uint32_t> makeLookups(size_t n, size_t nb_lookups) {
+    std::vector<uint32_t> lookups(nb_lookups);
+    uint32_t seed = 12345;
+    for (auto& lookup : lookups) {
+        seed = seed * 1103515245 + 12345;
+        lookup = (seed >> 8) % n;
+    }
+    return lookups;
+}
+
+int main(int argc, char** argv) {
+    parseOptions(argc, argv, description);
+    const size_t nb_lookups = options.quick ? 10000 : 1000000;
+
+    for (long long sparse : sweep<long long>({0, 1})) {
+        for (long long n : sweep<long long>({100, 10000, 1000000})) {
+            if (options.quick && n > 10000)
+                continue;
+            Parameters parameters{{"sparse", sparse}, {"nb_regions", n}};
+            GlobalArchive archive(dir_name, "main");
+            std::map<StringRef, const String*> map_strings;
+            std::map<RegionRef, Region> map_regions;
+            std::vector<RegionRef> refs(n);
+            for (long long i = 0; i < n; i++) {
+                // The Strings are numbered after the Regions, as in the traces recorded by EZTrace.
+                StringRef string_ref = makeRef(n + i, sparse);
+                refs[i] = makeRef(i, sparse);
+                std::string name = "function_" + std::to_string(i);
+                archive.addString(string_ref, name.c_str());
+                archive.addRegion(refs[i], string_ref);
+                archive.addAttribute(refs[i], string_ref, string_ref, PALLAS_TYPE_UINT64);
+                map_strings[string_ref] = archive.getString(string_ref);
+                map_regions[refs[i]] = *archive.getRegion(refs[i]);
+            }
+            // Before timing them, checks that the lookups find the same definitions as in the std::maps.
+            for (auto& [ref, region] : map_regions) {
+                const Region* found = archive.getRegion(ref);
+                pallas_assert_always(found != nullptr);
+                pallas_assert_equals_always(found->region_ref, region.region_ref);
+                pallas_assert_equals_always(found->string_ref, region.string_ref);
+                pallas_assert_always(archive.getString(found->string_ref) == map_strings.at(region.string_ref));
+                pallas_assert_equals_always(archive.getAttribute(ref)->name, region.string_ref);
+            }
+            pallas_assert_equals_always(archive.definitions.regions.size(), map_regions.size());
+            pallas_assert_equals_always(archive.definitions.strings.size(), map_strings.size());
+            auto map_it = map_regions.begin();
+            for (const auto& [ref, region] : archive.definitions.regions) {
+                pallas_assert_equals_always(ref, (map_it++)->first);
+            }
+
+            auto lookups = makeLookups(n, nb_lookups);
+            for (auto& lookup : lookups)
+                lookup = refs[lookup];
+
+            run("region_string", parameters, nb_lookups, [&](Timer& timer) {
+                uint64_t sum = 0;
+                timer.start();
+                for (auto ref : lookups)
+                    sum += archive.getString(archive.getRegion(ref)->string_ref)->length;
+                timer.stop();
+                sink = sum;
+            });
+            run("definition_region_string", parameters, nb_lookups, [&](Timer& timer) {
+                const Definition& definitions = archive.definitions;
+                uint64_t sum = 0;
+                timer.start();
+                for (auto ref : lookups)
+                    sum += definitions.getString(definitions.getRegion(ref)->string_ref)->length;
+                timer.stop();
+                sink = sum;
+            });
+            run("map_region_string", parameters, nb_lookups, [&](Timer& timer) {
+                uint64_t sum = 0;
+                timer.start();
+                for (auto ref : lookups)
+                    sum += map_strings.find(map_regions.find(ref)->second.string_ref)->second->length;
+                timer.stop();
+                sink = sum;
+            });
+            run("attribute", parameters, nb_lookups, [&](Timer& timer) {
+                uint64_t sum = 0;
+                timer.start();
+                for (auto ref : lookups)
+                    sum += archive.getAttribute(ref)->type;
+                timer.stop();
+                sink = sum;
+            });
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Checks that a DefinitionTable holds the same definitions as a std::map, in the same order.
+ * Refs are added in an order that makes the table put some of them in its sparse index first, then take them into
+ * its dense index when it grows: every ref must still be found, with its definition, after each addition.
+ */
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "pallas/utils/pallas_definition_table.h"
+#include "pallas/utils/pallas_log.h"
+
+using namespace pallas;
+
+using Table = DefinitionTable<uint32_t, std::string>;
+using Map = std::map<uint32_t, std::string>;
+
+/** Checks that the table and the map hold the same definitions, and that they are iterated over in the same order. */
+static void check(const Table& table, const Map& map) {
+    pallas_assert_equals_always(table.size(), map.size());
+    for (const auto& [ref, value] : map) {
+        pallas_assert_equals_always(table.count(ref), 1);
+        pallas_assert_always(table.get(ref) != nullptr);
+        pallas_assert_always(*table.get(ref) == value);
+        pallas_assert_always(table.at(ref) == value);
+    }
+    auto it = map.begin();
+    for (const auto& [ref, value] : table) {
+        pallas_assert_always(it != map.end());
+        pallas_assert_equals_always(ref, it->first);
+        pallas_assert_always(value == it->second);
+        ++it;
+    }
+    pallas_assert_always(it == map.end());
+}
+
+/** Adds a definition to both the table and the map, and checks them. */
+static void add(Table& table, Map& map, uint32_t ref) {
+    std::string value = "definition_" + std::to_string(ref);
+    table[ref] = value;
+    map[ref] = value;
+    check(table, map);
+    // Refs that weren't added are not found.
+    for (uint32_t missing : {ref + 1, ref / 2 + 1, UINT32_MAX - 1}) {
+        if (map.count(missing) == 0) {
+            pallas_assert_equals_always(table.count(missing), 0);
+            pallas_assert_always(table.get(missing) == nullptr);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t nb_refs = argc > 1 ? std::stoul(argv[1]) : 3000;
+    Table table;
+    Map map;
+
+    // Refs too far from the others to be in the dense index yet, added in decreasing order.
+    std::vector<uint32_t> sparse_refs;
+    for (size_t i = 0; i < 8; i++) {
+        sparse_refs.push_back(static_cast<uint32_t>(2 * nb_refs - 100 * i));
+    }
+    sparse_refs.push_back(UINT32_MAX);
+    for (auto ref : sparse_refs) {
+        add(table, map, ref);
+    }
+    // Consecutive refs: the dense index grows until it takes in the sparse ones but the last one.
+    for (uint32_t ref = 0; ref < nb_refs; ref++) {
+        add(table, map, ref);
+    }
+    // Refs added in no particular order, between the ones that are already there.
+    for (uint32_t ref = nb_refs + 1; ref < 2 * nb_refs; ref += 37) {
+        add(table, map, ref);
+    }
+    // Adding a definition that exists doesn't add another one.
+    table[0] = "redefined";
+    map[0] = "redefined";
+    check(table, map);
+
+    // A copy is ordered the same way.
+    Table copy(table);
+    check(copy, map);
+    Table moved(std::move(copy));
+    check(moved, map);
+
+    table.clear();
+    map.clear();
+    check(table, map);
+    add(table, map, 42);
+    pallas_log(DebugLevel::Normal, "The DefinitionTable matches the std::map for %zu refs\n", moved.size());
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Checks where the readers see the end of a trace. The main sequence of the first thread holds several
+ * tokens, so the trace must not end when the reader comes back to the main sequence after the first one.
+ * The second thread is empty: its reader must be at the end of the trace right away.
+ */
+
+#include <filesystem>
+#include <string>
+
+#include "pallas/pallas.h"
+#include "pallas/pallas_archive.h"
+#include "pallas/pallas_read.h"
+#include "pallas/pallas_record.h"
+#include "pallas/pallas_write.h"
+
+#include "pallas/utils/pallas_log.h"
+#include "pallas/utils/pallas_storage.h"
+
+using namespace pallas;
+
+/** Number of functions called one after the other by the first thread. Each is a token of the main sequence. */
+static const int nb_functions = 3;
+
+static void record_trace(const char* trace_name) {
+    GlobalArchive trace(trace_name, "main");
+    for (int f = 0; f < nb_functions; f++) {
+        trace.addString(f, ("function_" + std::to_string(f)).c_str());
+        trace.addRegion(f, f);
+    }
+    trace.addString(nb_functions, "rank_0");
+    trace.addString(nb_functions + 1, "thread_0");
+    trace.addString(nb_functions + 2, "thread_1");
+    trace.defineLocationGroup(0, nb_functions, PALLAS_LOCATION_GROUP_ID_INVALID);
+
+    Archive archive(trace, 0);
+    archive.global_archive = &trace;
+    archive.defineLocation(0, nb_functions + 1, 0);
+    archive.defineLocation(1, nb_functions + 2, 0);
+    {
+        ThreadWriter writer(archive, 0);
+        for (int f = 0; f < nb_functions; f++) {
+            pallas_record_enter(&writer, nullptr, 10 * f, f);
+            pallas_record_leave(&writer, nullptr, 10 * f + 5, f);
+        }
+        writer.threadClose();
+    }
+    {
+        ThreadWriter writer(archive, 1);
+        writer.threadClose();
+    }
+    archive.store();
+    trace.store();
+}
+
+int main(int argc, char** argv) {
+    const char* trace_name = argc > 1 ? argv[1] : "end_of_trace_trace";
+    std::filesystem::remove_all(trace_name);
+    record_trace(trace_name);
+
+    auto* trace = pallas_open_trace((std::string(trace_name) + "/main.pallas").c_str());
+    auto* archive = trace->getArchive(0);
+
+    // Every Event of the first thread is read, and the end is only reached after the last one.
+    {
+        ThreadReader reader(archive, 0, PALLAS_READ_FLAG_UNROLL_ALL);
+        size_t nb_events = 0;
+        Cursor last_event;
+        while (!reader.isEndOfTrace()) {
+            if (reader.pollCurToken().type == TypeEvent) {
+                nb_events++;
+                last_event = reader.createCheckpoint();
+            }
+            reader.moveToNextToken(PALLAS_READ_FLAG_UNROLL_ALL);
+        }
+        pallas_assert_equals_always(nb_events, 2 * nb_functions);
+
+        // A copy of the Cursor keeps the end of the trace, and a valid current frame.
+        Cursor end = reader.createCheckpoint();
+        pallas_assert_always(end.current_frame_index < 0);
+        pallas_assert_always(end.currentFrame == &end.callstack[0]);
+        reader.loadCheckpoint(&last_event);
+        pallas_assert_always(!reader.isEndOfTrace());
+        reader.loadCheckpoint(&end);
+        pallas_assert_always(reader.isEndOfTrace());
+    }
+
+    // Same with getNextToken, as pallas_print reads a thread.
+    {
+        ThreadReader reader(archive, 0, PALLAS_READ_FLAG_UNROLL_ALL);
+        size_t nb_events = 0;
+        for (auto t = reader.pollCurToken(); t != INVALID_TOKEN; t = reader.getNextToken()) {
+            if (t.type == TypeEvent) {
+                nb_events++;
+            }
+        }
+        pallas_assert_equals_always(nb_events, 2 * nb_functions);
+        pallas_assert_always(reader.isEndOfTrace());
+    }
+
+    // The empty thread ends right away.
+    {
+        ThreadReader reader(archive, 1, PALLAS_READ_FLAG_UNROLL_ALL);
+        pallas_assert_always(reader.isEndOfTrace());
+    }
+
+    // The MultiThreadReader reads every Event of both threads.
+    {
+        MultiThreadReader reader(*trace);
+        size_t nb_events = 0;
+        for (auto t = reader.pollCurToken(); t != INVALID_TOKEN; t = reader.getNextToken()) {
+            if (t.type == TypeEvent) {
+                nb_events++;
+            }
+        }
+        pallas_assert_equals_always(nb_events, 2 * nb_functions);
+    }
+    delete trace;
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
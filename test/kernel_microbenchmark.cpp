@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Microbenchmarks of the kernels, with each instruction set that is supported.
+ *  - value_statistics: computeValueStatistics, as when a SubArray of durations is full.
+ *  - histogram_bins: computeHistogramBins, as in the Histogram compression.
+ *  - lower_bound: lowerBound in sorted timestamps, as when looking for the occurrence before a timestamp.
+ *  - crc32c: crc32c of the values, as when a block of them is stored or loaded.
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include "pallas/utils/pallas_kernels.h"
+#include "pallas_benchmark.h"
+
+using namespace pallas;
+using namespace pallas_benchmark;
+
+static const char* description = "Microbenchmarks of the kernels. Prints one JSON object per benchmark and parameter set.";
+/** Keeps the compiler from optimizing the benchmarked calls away. */
+static volatile uint64_t sink;
+
+/** Returns n increasing timestamps, with pseudo-random intervals. */
+static std::vector<uint64_t> makeTimestamps(size_t n) {
+    std::vector<uint64_t> values(n);
+    uint32_t seed = 12345;
+    uint64_t ts = 0;
+    for (auto& value : values) {
+        seed = seed * 1103515245 + 12345;
+        ts += 1 + (seed >> 16) % 1000;
+        value = ts;
+    }
+    return values;
+}
+
+static void benchKernels(KernelISA isa) {
+    setKernelISA(isa);
+    const size_t nb_calls = options.quick ? 10 : 1000;
+    const size_t nb_lookups = options.quick ? 10000 : 1000000;
+    for (long long n : sweep<long long>({1000, 100000})) {
+        Parameters parameters{{"isa", static_cast<long long>(isa)}, {"nb_values", n}};
+        auto timestamps = makeTimestamps(n);
+        std::vector<uint64_t> durations(n);
+        for (long long i = 0; i < n; i++)
+            durations[i] = timestamps[i] - (i ? timestamps[i - 1] : 0);
+
+        run("value_statistics", parameters, nb_calls * n, [&](Timer& timer) {
+            uint64_t sum = 0;
+            timer.start();
+            for (size_t i = 0; i < nb_calls; i++)
+                sum += computeValueStatistics(durations.data(), n).sum;
+            timer.stop();
+            sink = sum;
+        });
+        run("histogram_bins", parameters, nb_calls * n, [&](Timer& timer) {
+            std::vector<uint8_t> bins(n);
+            auto statistics = computeValueStatistics(durations.data(), n);
+            double step = static_cast<double>(statistics.max - statistics.min) / 255.;
+            timer.start();
+            for (size_t i = 0; i < nb_calls; i++)
+                computeHistogramBins(durations.data(), n, statistics.min, step, bins.data());
+            timer.stop();
+            sink = bins[n / 2];
+        });
+        run("lower_bound", parameters, nb_lookups, [&](Timer& timer) {
+            uint64_t sum = 0;
+            uint64_t last = timestamps.back();
+            timer.start();
+            for (size_t i = 0; i < nb_lookups; i++)
+                sum += lowerBound(timestamps.data(), n, (i * 7919) % last);
+            timer.stop();
+            sink = sum;
+        });
+        run("crc32c", parameters, nb_calls * n * sizeof(uint64_t), [&](Timer& timer) {
+            uint32_t crc = 0;
+            timer.start();
+            for (size_t i = 0; i < nb_calls; i++)
+                crc = crc32c(timestamps.data(), n * sizeof(uint64_t), crc);
+            timer.stop();
+            sink = crc;
+        });
+    }
+}
+
+int main(int argc, char** argv) {
+    parseOptions(argc, argv, description);
+    KernelISA default_isa = getKernelISA();
+    for (auto isa : {KernelISA::Scalar, KernelISA::AVX2, KernelISA::AVX512}) {
+        if (isKernelISASupported(isa))
+            benchKernels(isa);
+    }
+    setKernelISA(default_isa);
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
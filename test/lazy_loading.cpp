@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Checks that a trace read lazily holds the same Events and Sequences as when it's read eagerly.
+ * The trace is opened lazily twice: deleting the second one must not disturb the reads of the first one.
+ * The records of each Thread are loaded from several workers at once, and the Threads in parallel.
+ * The parallel snapshot must give the same result when its workers keep unloading the durations of each other.
+ *
+ * Usage: lazy_loading trace/main.pallas
+ */
+
+#include <cstdint>
+#include <cstring>
+
+#include "pallas/pallas.h"
+#include "pallas/pallas_archive.h"
+
+#include "pallas/utils/pallas_log.h"
+#include "pallas/utils/pallas_parallel.h"
+#include "pallas/utils/pallas_storage.h"
+
+using namespace pallas;
+
+static const size_t nb_workers = 4;
+
+static GlobalArchive* open_trace(const char* trace_name, bool lazy) {
+    auto* trace = pallas_open_trace(trace_name);
+    pallas_assert_always(trace != nullptr);
+    trace->parameter_handler->lazyLoading = lazy;
+    return trace;
+}
+
+template <class Vector>
+static void check_vector(Vector* expected, Vector* actual) {
+    pallas_assert_always((expected == nullptr) == (actual == nullptr));
+    if (expected == nullptr)
+        return;
+    pallas_assert_equals_always(actual->size, expected->size);
+    for (size_t i = 0; i < expected->size; i++) {
+        pallas_assert_equals_always(actual->at(i), expected->at(i));
+    }
+}
+
+static void check_thread(const Thread& expected, const Thread& actual) {
+    pallas_assert_always(expected.lazy_index == nullptr);
+    pallas_assert_always(actual.lazy_index != nullptr);
+    pallas_assert_equals_always(actual.nb_events, expected.nb_events);
+    pallas_assert_equals_always(actual.nb_sequences, expected.nb_sequences);
+    pallas_assert_equals_always(actual.nb_loops, expected.nb_loops);
+
+    // The workers load the records of the same Thread in different orders.
+    parallelFor(nb_workers, nb_workers, [&](size_t worker) {
+        for (size_t i = 0; i < actual.nb_sequences; i++) {
+            actual.loadSequence(worker % 2 ? i : actual.nb_sequences - 1 - i);
+        }
+        for (size_t i = 0; i < actual.nb_events; i++) {
+            actual.loadEvent(worker % 2 ? i : actual.nb_events - 1 - i);
+        }
+    });
+
+    for (size_t i = 0; i < expected.nb_events; i++) {
+        auto& e = expected.events[i];
+        auto& a = actual.events[i];
+        pallas_assert_equals_always(a.id, e.id);
+        pallas_assert_equals_always(a.data.record, e.data.record);
+        pallas_assert_equals_always(a.data.event_size, e.data.event_size);
+        pallas_assert_always(memcmp(a.data.event_data, e.data.event_data, sizeof(e.data.event_data)) == 0);
+        pallas_assert_equals_always(a.nb_occurrences, e.nb_occurrences);
+        check_vector(e.timestamps, a.timestamps);
+    }
+    for (size_t i = 0; i < expected.nb_sequences; i++) {
+        auto& e = expected.sequences[i];
+        auto& a = actual.sequences[i];
+        pallas_assert_always(a.id == e.id);
+        pallas_assert_always(a.tokens == e.tokens);
+        check_vector(e.timestamps, a.timestamps);
+        check_vector(e.durations, a.durations);
+        check_vector(e.exclusive_durations, a.exclusive_durations);
+    }
+    for (size_t i = 0; i < expected.nb_loops; i++) {
+        pallas_assert_always(actual.loops[i].self_id == expected.loops[i].self_id);
+        pallas_assert_always(actual.loops[i].repeated_token == expected.loops[i].repeated_token);
+        pallas_assert_equals_always(actual.loops[i].nb_iterations, expected.loops[i].nb_iterations);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        pallas_log(DebugLevel::Normal, "Usage: %s trace/main.pallas\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    auto* eager = open_trace(argv[1], false);
+    auto* lazy = open_trace(argv[1], true);
+    auto* other_lazy = open_trace(argv[1], true);
+
+    auto expected = eager->getThreadList();
+    auto actual = lazy->getThreadList();
+    pallas_assert_always(!actual.empty());
+    pallas_assert_equals_always(actual.size(), expected.size());
+    // The threads of the other trace use their own files, which are closed when it's deleted.
+    auto others = other_lazy->getThreadList();
+    for (auto* thread : others) {
+        thread->loadEvent(0);
+    }
+    delete other_lazy;
+
+    parallelFor(actual.size(), nb_workers, [&](size_t i) { check_thread(*expected[i], *actual[i]); });
+    pallas_log(DebugLevel::Normal, "%zu threads are read the same way lazily\n", actual.size());
+
+    // With almost no memory for the durations, the workers of the snapshot unload the SubArrays of each other.
+    auto* constrained = open_trace(argv[1], true);
+    constrained->parameter_handler->max_memory_durations = 1;
+    auto expected_snapshot = eager->getSnapshotViewByName(0, UINT64_MAX, 1, false);
+    auto actual_snapshot = constrained->getSnapshotViewByName(0, UINT64_MAX, nb_workers, false);
+    pallas_assert_always(!expected_snapshot.empty());
+    pallas_assert_always(actual_snapshot == expected_snapshot);
+    delete constrained;
+    delete lazy;
+    delete eager;
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Checks that a trace can be read while it is recorded: nb_calls calls to a function that contains a generic event
+ * are recorded in several steps, and after each one, a LiveThreadReader must get the Events that were recorded since
+ * the previous step, in order, including the ones of the function being recorded, and the attributes of the generic
+ * events.
+ * Without PALLAS_LIVE_PERIOD, the snapshots are published explicitly after each step.
+ * With it, they are published periodically by a background thread, so the reader only gets a prefix of the Events
+ * before the thread is closed.
+ */
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+#include "pallas/pallas.h"
+#include "pallas/pallas_archive.h"
+#include "pallas/pallas_read.h"
+#include "pallas/pallas_record.h"
+#include "pallas/pallas_write.h"
+
+#include "pallas/utils/pallas_log.h"
+#include "pallas/utils/pallas_parameter_handler.h"
+
+using namespace pallas;
+
+static const RegionRef function = 1;
+static const StringRef generic_event = 2;
+static const AttributeRef timestamp_ref = 3;
+
+/** Records a generic event, whose attribute is its timestamp. */
+static void record_generic(ThreadWriter& writer, pallas_timestamp_t ts) {
+    AttributeList list;
+    pallas_attribute_list_init(&list);
+    AttributeValue value;
+    value.uint64 = ts;
+    pallas_attribute_list_add_attribute(&list, timestamp_ref, sizeof(value.uint64), value);
+    pallas_record_generic(&writer, &list, ts, generic_event);
+}
+
+/**
+ * Reads the new Events of the live trace, and checks that the timestamp of the n-th Event is n.
+ * The generic events are the ones whose timestamp is 2 modulo 3: their attribute must be their timestamp.
+ */
+static size_t read_events(LiveThreadReader& reader) {
+    size_t nb_read = 0;
+    EventOccurrence occurrence;
+    while (reader.getNextEvent(&occurrence)) {
+        nb_read++;
+        pallas_assert_equals_always(occurrence.timestamp, reader.nb_events_read);
+        if (occurrence.timestamp % 3 != 2) {
+            pallas_assert_always(occurrence.attributes == nullptr);
+            continue;
+        }
+        pallas_assert_always(occurrence.attributes != nullptr);
+        uint16_t pos = 0;
+        AttributeData data;
+        pallas_attribute_list_pop_data(occurrence.attributes, &data, &pos);
+        pallas_assert_equals_always(data.ref, timestamp_ref);
+        pallas_assert_equals_always(data.value.uint64, occurrence.timestamp);
+    }
+    return nb_read;
+}
+
+int main(int argc, char** argv) {
+    size_t nb_calls = argc > 1 ? std::stoul(argv[1]) : 10000;
+    const char* trace_name = argc > 2 ? argv[2] : "live_reader_trace";
+    // The snapshots of a previous run would be read before the first publication.
+    std::filesystem::remove_all(trace_name);
+
+    GlobalArchive trace(trace_name, "main");
+    trace.addString(0, "thread");
+    trace.addString(function, "function");
+    trace.addString(generic_event, "generic_event");
+    trace.addString(timestamp_ref, "timestamp");
+    trace.addRegion(function, function);
+    trace.addAttribute(timestamp_ref, timestamp_ref, timestamp_ref, PALLAS_TYPE_UINT64);
+    Archive archive(trace, 0);
+    archive.global_archive = &trace;
+    trace.defineLocationGroup(0, 0, PALLAS_LOCATION_GROUP_ID_INVALID);
+    archive.defineLocation(0, 0, 0);
+
+    ThreadWriter writer(archive, 0);
+    bool periodic = writer.parameter_handler->livePeriod > 0;
+    LiveThreadReader reader((std::string(trace_name) + "/main.pallas").c_str(), 0);
+    if (!periodic) {
+        // Nothing was published yet.
+        pallas_assert_always(!reader.refresh());
+    }
+
+    // Each call holds 3 Events, and the n-th Event is recorded at timestamp n.
+    pallas_timestamp_t ts = 1;
+    size_t nb_read = 0;
+    size_t nb_steps = 4;
+    for (size_t step = 0; step < nb_steps; step++) {
+        for (size_t i = step * nb_calls / nb_steps; i < (step + 1) * nb_calls / nb_steps; i++) {
+            pallas_record_enter(&writer, nullptr, ts++, function);
+            record_generic(writer, ts++);
+            pallas_record_leave(&writer, nullptr, ts++, function);
+        }
+        // The function that is being recorded is published too.
+        pallas_record_enter(&writer, nullptr, ts++, function);
+        record_generic(writer, ts++);
+        if (periodic) {
+            if (reader.refresh())
+                nb_read += read_events(reader);
+        } else {
+            writer.publish();
+            pallas_assert_always(reader.refresh());
+            nb_read += read_events(reader);
+            pallas_assert_equals_always(nb_read, ts - 1);
+            // There is nothing new until the next publication.
+            pallas_assert_always(!reader.refresh());
+        }
+        pallas_record_leave(&writer, nullptr, ts++, function);
+    }
+    if (periodic) {
+        // The background thread publishes the first snapshot without being asked to.
+        for (int i = 0; i < 10000 && nb_read == 0; i++) {
+            if (reader.refresh())
+                nb_read += read_events(reader);
+            else
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        pallas_assert_always(nb_read > 0);
+    }
+    writer.threadClose();
+    archive.store();
+    trace.store();
+
+    // The thread is published a last time when it's closed.
+    pallas_assert_always(reader.refresh());
+    nb_read += read_events(reader);
+    pallas_assert_equals_always(nb_read, ts - 1);
+    pallas_assert_equals_always(nb_read, 3 * (nb_calls + nb_steps));
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Checks the memory accounting of the ThreadWriter and of the ThreadReader:
+ * the usage of the writer grows with the trace it records, and the reader accounts for its cursors.
+ */
+
+#include <string>
+
+#include "pallas/pallas.h"
+#include "pallas/pallas_archive.h"
+#include "pallas/pallas_read.h"
+#include "pallas/pallas_record.h"
+#include "pallas/pallas_write.h"
+
+#include "pallas/utils/pallas_log.h"
+#include "pallas/utils/pallas_memory.h"
+#include "pallas/utils/pallas_storage.h"
+
+using namespace pallas;
+
+static const char* trace_name = "memory_usage_trace";
+
+/** Records nb_iter calls to function, each with nb_events different generic events. */
+static void record(ThreadWriter& writer, pallas_timestamp_t& ts, RegionRef function, int nb_events, int nb_iter) {
+    for (int i = 0; i < nb_iter; i++) {
+        pallas_record_enter(&writer, nullptr, ts++, function);
+        for (int eid = 0; eid < nb_events; eid++) {
+            pallas_record_generic(&writer, nullptr, ts++, eid + (i % nb_events));
+        }
+        pallas_record_leave(&writer, nullptr, ts++, function);
+    }
+}
+
+int main(int argc, char** argv) {
+    int nb_events = argc > 1 ? std::stoi(argv[1]) : 10;
+    int nb_iter = argc > 2 ? std::stoi(argv[2]) : 1000;
+    const RegionRef function = 2 * nb_events;
+
+    GlobalArchive trace(trace_name, "main");
+    for (int eid = 0; eid <= 2 * nb_events; eid++) {
+        trace.addString(eid, ("event_" + std::to_string(eid)).c_str());
+    }
+    trace.addRegion(function, function);
+    Archive archive(trace, 0);
+    archive.global_archive = &trace;
+    trace.defineLocationGroup(0, 0, PALLAS_LOCATION_GROUP_ID_INVALID);
+    archive.defineLocation(0, 0, 0);
+
+    pallas_timestamp_t ts = 1;
+    ThreadWriter writer(archive, 0);
+    record(writer, ts, function, nb_events, nb_iter);
+    MemoryUsage first = writer.getMemoryUsage();
+    pallas_log(DebugLevel::Normal, "After %d iterations: %s\n", nb_iter, first.toString().c_str());
+    record(writer, ts, function, nb_events, nb_iter);
+    MemoryUsage second = writer.getMemoryUsage();
+    pallas_log(DebugLevel::Normal, "After %d iterations: %s\n", 2 * nb_iter, second.toString().c_str());
+
+    for (auto category : {PALLAS_MEMORY_EVENTS, PALLAS_MEMORY_SEQUENCES, PALLAS_MEMORY_ID_MAPS, PALLAS_MEMORY_HASH_MAPS,
+                          PALLAS_MEMORY_TIMESTAMPS, PALLAS_MEMORY_DURATIONS, PALLAS_MEMORY_WRITER_STACKS}) {
+        if (first[category] == 0)
+            pallas_error("The writer doesn't account for its %s\n", toString(category));
+    }
+    pallas_assert_equals_always(first[PALLAS_MEMORY_READER_CURSORS], 0);
+    // The timestamps of the first iterations are still in memory.
+    pallas_assert_always(second[PALLAS_MEMORY_TIMESTAMPS] > first[PALLAS_MEMORY_TIMESTAMPS]);
+    pallas_assert_always(second.total() > first.total());
+    pallas_assert_equals_always(pallas_thread_writer_get_memory_usage(&writer), second.total());
+    pallas_assert_always(archive.getMemoryUsage()[PALLAS_MEMORY_DEFINITIONS] > 0);
+    pallas_assert_always(trace.getMemoryUsage()[PALLAS_MEMORY_DEFINITIONS] > 0);
+
+    writer.threadClose();
+    archive.store();
+    trace.store();
+
+    auto* read_trace = pallas_open_trace((std::string(trace_name) + "/main.pallas").c_str());
+    if (read_trace == nullptr) {
+        pallas_error("Cannot open %s\n", trace_name);
+    }
+    auto* thread = read_trace->getThreadList().front();
+    MemoryUsage loaded = thread->getMemoryUsage();
+    pallas_assert_always(loaded[PALLAS_MEMORY_EVENTS] > 0);
+    pallas_assert_always(read_trace->getMemoryUsage().total() >= loaded.total());
+    {
+        // The reader frees the thread when it is destroyed.
+        ThreadReader reader(thread->archive, thread->id, PALLAS_READ_FLAG_UNROLL_ALL);
+        for (auto token = reader.pollCurToken(); token != INVALID_TOKEN; token = reader.getNextToken()) {
+        }
+        MemoryUsage read = reader.getMemoryUsage();
+        pallas_log(DebugLevel::Normal, "After reading: %s\n", read.toString().c_str());
+        pallas_assert_always(read[PALLAS_MEMORY_READER_CURSORS] > 0);
+        pallas_assert_equals_always(read[PALLAS_MEMORY_WRITER_STACKS], 0);
+        pallas_assert_always(read[PALLAS_MEMORY_TIMESTAMPS] > 0);
+    }
+    delete read_trace;
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
@@ -0,0 +1,54 @@
+#!/bin/bash
+
+# Checks the traces built by pallas_merge:
+# - each thread of the trace merged in time must contain the events of the first part, then the ones of the second part,
+#   or only the ones of the second part if it isn't in the first one.
+# - the trace merged by ranks must contain the threads of both traces, unchanged.
+
+CUR_PATH=$(dirname  $(realpath $0))
+source "$CUR_PATH/test_utils.sh" "$1"
+
+first_part="$2"
+second_part="$3"
+other_ranks="$4"
+merged_in_time="$5"
+merged_by_ranks="$6"
+nb_threads="$7"
+
+# Prints a thread of the first part, followed by the events of the same thread in the second part.
+function print_concatenation {
+  first=$("$PALLAS_PRINT_PATH" -T --thread "$1" "$first_part" 2>/dev/null)
+  if [ -z "$first" ]; then
+    "$PALLAS_PRINT_PATH" -T --thread "$1" "$second_part" 2>/dev/null
+  else
+    echo "$first"
+    "$PALLAS_PRINT_PATH" -T --thread "$1" "$second_part" 2>/dev/null | tail -n +2
+  fi
+}
+
+ret=0
+for thread in $(seq 0 $((nb_threads - 1))); do
+  if ! diff -q <("$PALLAS_PRINT_PATH" -T --thread "$thread" "$merged_in_time" 2>/dev/null) \
+               <(print_concatenation "$thread") > /dev/null; then
+    print_error "Thread $thread of $merged_in_time isn't the concatenation of the two parts"
+    ret=1
+  fi
+done
+if [ $ret -eq 0 ]; then
+  print_ok "$merged_in_time is the concatenation of $first_part and $second_part"
+fi
+
+if diff -q <("$PALLAS_PRINT_PATH" -T "$merged_by_ranks" 2>/dev/null) \
+           <("$PALLAS_PRINT_PATH" -T "$first_part" 2>/dev/null; "$PALLAS_PRINT_PATH" -T "$other_ranks" 2>/dev/null) > /dev/null; then
+  print_ok "$merged_by_ranks contains the threads of $first_part and $other_ranks"
+else
+  print_error "$merged_by_ranks differs from $first_part and $other_ranks"
+  ret=1
+fi
+
+if [ $ret -eq 0 ]; then
+  for trace in "$first_part" "$second_part" "$other_ranks" "$merged_in_time" "$merged_by_ranks"; do
+    rm -rf "$(dirname -- "$trace")"
+  done
+fi
+exit $ret
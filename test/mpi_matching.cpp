@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Checks the matching of MPI messages used by the Python library ( match_mpi_messages ) on a small trace of three ranks.
+ * Rank 2 receives a message with MPI_ANY_SOURCE before it receives one from rank 1, then receives a message
+ * with MPI_ANY_TAG through an IRecv called outside of any function. Matching twice must give the same messages.
+ */
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "pallas/pallas.h"
+#include "pallas/pallas_archive.h"
+#include "pallas/pallas_record.h"
+#include "pallas/pallas_write.h"
+
+#include "pallas/utils/pallas_log.h"
+#include "pallas/utils/pallas_storage.h"
+
+#include "python_mpi.h"
+
+using namespace pallas;
+
+static const RegionRef mpi_send = 0;
+static const RegionRef mpi_recv = 1;
+static const CommRef comm_world = 0;
+static const int nb_ranks = 3;
+
+static void record_rank(ThreadWriter& writer, int rank) {
+    switch (rank) {
+    case 0:
+        pallas_record_enter(&writer, nullptr, 10, mpi_send);
+        pallas_record_mpi_send(&writer, nullptr, 11, 2, comm_world, 5, 100);
+        pallas_record_leave(&writer, nullptr, 15, mpi_send);
+        // Non-blocking send, outside of any function.
+        pallas_record_mpi_isend(&writer, nullptr, 20, 2, comm_world, 7, 300, 42);
+        pallas_record_mpi_isend_complete(&writer, nullptr, 30, 42);
+        break;
+    case 1:
+        pallas_record_enter(&writer, nullptr, 40, mpi_send);
+        pallas_record_mpi_send(&writer, nullptr, 41, 2, comm_world, 5, 200);
+        pallas_record_leave(&writer, nullptr, 45, mpi_send);
+        break;
+    case 2:
+        // Posted before the receive from rank 1: gets the earliest message, from rank 0.
+        pallas_record_enter(&writer, nullptr, 5, mpi_recv);
+        pallas_record_mpi_recv(&writer, nullptr, 6, PALLAS_MPI_ANY, comm_world, 5, 100);
+        pallas_record_leave(&writer, nullptr, 50, mpi_recv);
+        pallas_record_enter(&writer, nullptr, 60, mpi_recv);
+        pallas_record_mpi_recv(&writer, nullptr, 61, 1, comm_world, 5, 200);
+        pallas_record_leave(&writer, nullptr, 65, mpi_recv);
+        pallas_record_mpi_irecv_request(&writer, nullptr, 70, 43);
+        pallas_record_mpi_irecv(&writer, nullptr, 80, 0, comm_world, PALLAS_MPI_ANY, 300, 43);
+        break;
+    }
+}
+
+static void record_trace(const char* trace_name) {
+    GlobalArchive trace(trace_name, "main");
+    StringRef next_string = 0;
+    trace.addString(next_string, "MPI_Send");
+    trace.addRegion(mpi_send, next_string++);
+    trace.addString(next_string, "MPI_Recv");
+    trace.addRegion(mpi_recv, next_string++);
+    std::vector<uint64_t> ranks{0, 1, 2};
+    trace.addString(next_string, "MPI_COMM_WORLD");
+    trace.addGroup(0, next_string, GROUP_TYPE_COMM_GROUP, PARADIGM_MPI, ranks.size(), ranks.data());
+    trace.addComm(comm_world, next_string++, 0, PALLAS_COMMREF_INVALID);
+
+    std::vector<Archive*> archives;
+    for (int r = 0; r < nb_ranks; r++) {
+        trace.addString(next_string, ("rank_" + std::to_string(r)).c_str());
+        trace.defineLocationGroup(r, next_string++, PALLAS_LOCATION_GROUP_ID_INVALID);
+        auto* archive = new Archive(trace, r);
+        archive->global_archive = &trace;
+        archives.push_back(archive);
+        trace.addString(next_string, ("thread_" + std::to_string(r)).c_str());
+        archive->defineLocation(r, next_string++, r);
+        ThreadWriter writer(*archive, r);
+        record_rank(writer, r);
+        writer.threadClose();
+        archive->store();
+    }
+    trace.store();
+    for (auto* archive : archives) {
+        delete archive;
+    }
+}
+
+/** Checks one matched message. */
+static void check_message(const MPIMessageColumns& messages,
+                          size_t i,
+                          uint32_t sender,
+                          uint32_t tag,
+                          uint64_t msg_length,
+                          pallas_timestamp_t isend_ts,
+                          pallas_timestamp_t end_swait_ts,
+                          pallas_timestamp_t irecv_ts,
+                          pallas_timestamp_t start_rwait_ts,
+                          pallas_timestamp_t end_rwait_ts) {
+    pallas_log(DebugLevel::Normal, "Message %zu: %u -> %u, tag %u, %lu bytes\n", i, messages.sender[i],
+               messages.receiver[i], messages.tag[i], messages.msg_length[i]);
+    pallas_assert_equals_always(messages.sender[i], sender);
+    pallas_assert_equals_always(messages.receiver[i], 2);
+    pallas_assert_equals_always(messages.tag[i], tag);
+    pallas_assert_equals_always(messages.communicator[i], comm_world);
+    pallas_assert_equals_always(messages.msg_length[i], msg_length);
+    pallas_assert_equals_always(messages.isend_ts[i], isend_ts);
+    pallas_assert_equals_always(messages.end_swait_ts[i], end_swait_ts);
+    pallas_assert_equals_always(messages.irecv_ts[i], irecv_ts);
+    pallas_assert_equals_always(messages.start_rwait_ts[i], start_rwait_ts);
+    pallas_assert_equals_always(messages.end_rwait_ts[i], end_rwait_ts);
+}
+
+static void check_messages(const MPIMessageColumns& messages) {
+    pallas_assert_equals_always(messages.size(), 3);
+    pallas_assert_equals_always(messages.nb_unmatched_sends, 0);
+    pallas_assert_equals_always(messages.nb_unmatched_recvs, 0);
+    // Sorted by Send/ISend timestamp.
+    check_message(messages, 0, 0, 5, 100, 11, 15, 6, 6, 50);
+    // The ISend and the IRecv are at depth 0: their wait starts at the completion event.
+    check_message(messages, 1, 0, 7, 300, 20, 30, 70, 80, 80);
+    check_message(messages, 2, 1, 5, 200, 41, 45, 61, 61, 65);
+}
+
+int main(int argc, char** argv) {
+    const char* trace_name = argc > 1 ? argv[1] : "mpi_matching_trace";
+    std::filesystem::remove_all(trace_name);
+    record_trace(trace_name);
+
+    auto* trace = pallas_open_trace((std::string(trace_name) + "/main.pallas").c_str());
+    check_messages(match_mpi_messages(*trace, 2));
+    // The matching keeps no state from one call to the next.
+    check_messages(match_mpi_messages(*trace, 1));
+    delete trace;
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
@@ -0,0 +1,377 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Writes a small OTF2 archive byte by byte, without the OTF2 library, to test otf2_to_pallas.
+ * The files are split in small chunks, and the events are mixed with attribute lists and records
+ * that the converter doesn't know. Odd locations use local region and attribute ids, that are mapped to the global ones.
+ * For each location, <dir>/<location>.expected lists the events that the converted thread must contain,
+ * followed by their attributes as pallas_print shows them.
+ * The chunks may be smaller than OTF2 allows (OTF2_CHUNK_SIZE_MIN), so that the records cross many chunk boundaries.
+ * When the OTF2 library is installed, otf2_reference.sh checks that its reader sees the same events.
+ */
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+static int nb_locations = 4;
+static int nb_locations_per_group = 2;
+static int nb_regions = 4;
+static int nb_iter = 200;
+static size_t chunk_size = 1024;
+static std::string archive_name = "otf2_archive";
+
+static const uint64_t timer_resolution = 2000000000;
+static const uint64_t global_offset = 1000;
+
+enum : uint8_t {
+    END_OF_CHUNK = 0,
+    END_OF_FILE = 1,
+    TIMESTAMP = 2,
+    ATTRIBUTE_LIST = 3,
+    CHUNK_HEADER = 4,
+    SUBSTRATE_POSIX = 1,
+    COMPRESSION_NONE = 1,
+    DEF_CLOCK_PROPERTIES = 5,
+    DEF_STRING = 10,
+    DEF_ATTRIBUTE = 11,
+    DEF_LOCATION_GROUP = 13,
+    DEF_LOCATION = 14,
+    DEF_REGION = 15,
+    DEF_GROUP = 18,
+    DEF_COMM = 22,
+    DEF_MAPPING_TABLE = 5,
+    MAPPING_ATTRIBUTE = 1,
+    MAPPING_REGION = 3,
+    EVENT_ENTER = 12,
+    EVENT_LEAVE = 13,
+    EVENT_MPI_SEND = 14,
+    EVENT_UNKNOWN = 200,
+    TYPE_UINT8 = 1,
+    TYPE_UINT16 = 2,
+    TYPE_UINT32 = 3,
+    TYPE_INT64 = 8,
+    TYPE_DOUBLE = 10,
+    TYPE_REGION = 14,
+};
+
+/** Attributes of the archive: their global id is their index. */
+static const struct {
+    const char* name;
+    uint8_t type;
+} attributes[] = {
+    {"iteration", TYPE_UINT32}, {"delta", TYPE_INT64}, {"weight", TYPE_DOUBLE},
+    {"flags", TYPE_UINT16},     {"caller", TYPE_REGION}, {"level", TYPE_UINT8},
+};
+static const uint32_t nb_attributes = sizeof(attributes) / sizeof(attributes[0]);
+
+/** A record being encoded. Integers are compressed, strings are null-terminated. */
+struct Record {
+    std::vector<uint8_t> bytes;
+
+    Record& u8(uint8_t v) {
+        bytes.push_back(v);
+        return *this;
+    }
+    Record& compressed(uint64_t v) {
+        uint8_t n = 0;
+        for (uint64_t x = v; x != 0; x >>= 8)
+            n++;
+        bytes.push_back(n);
+        for (uint8_t i = 0; i < n; i++)
+            bytes.push_back(v >> (8 * i));
+        return *this;
+    }
+    Record& full(uint64_t v) {
+        for (int i = 0; i < 8; i++)
+            bytes.push_back(v >> (8 * i));
+        return *this;
+    }
+    Record& str(const std::string& s) {
+        bytes.insert(bytes.end(), s.begin(), s.end());
+        bytes.push_back(0);
+        return *this;
+    }
+    Record& fixed16(uint16_t v) {
+        bytes.push_back(v);
+        bytes.push_back(v >> 8);
+        return *this;
+    }
+    Record& padding(size_t n) {
+        bytes.insert(bytes.end(), n, 0xab);
+        return *this;
+    }
+};
+
+/** Writes the records of a file in chunks of chunk_size bytes. */
+class ChunkedFile {
+   public:
+    explicit ChunkedFile(const std::string& path) : path(path) {
+        chunkHeader();
+    }
+
+    void timestamp(uint64_t ts) {
+        std::vector<uint8_t> raw{TIMESTAMP};
+        for (int i = 0; i < 8; i++)
+            raw.push_back(ts >> (8 * i));
+        append(raw);
+    }
+
+    void record(uint8_t type, const Record& r) {
+        std::vector<uint8_t> raw{type};
+        if (r.bytes.size() < 0xff) {
+            raw.push_back(r.bytes.size());
+        } else {
+            raw.push_back(0xff);
+            for (int i = 0; i < 8; i++)
+                raw.push_back(static_cast<uint64_t>(r.bytes.size()) >> (8 * i));
+        }
+        raw.insert(raw.end(), r.bytes.begin(), r.bytes.end());
+        append(raw);
+    }
+
+    /** Number of records written so far. */
+    uint64_t nbRecords() const {
+        return nb_records;
+    }
+
+    void close() {
+        data.push_back(END_OF_FILE);
+        FILE* file = fopen(path.c_str(), "wb");
+        if (file == nullptr) {
+            perror(path.c_str());
+            exit(EXIT_FAILURE);
+        }
+        fwrite(data.data(), 1, data.size(), file);
+        fclose(file);
+    }
+
+   private:
+    std::string path;
+    std::vector<uint8_t> data;
+    uint64_t nb_records = 0;
+
+    void chunkHeader() {
+        data.push_back(CHUNK_HEADER);
+        data.push_back('L');
+        for (int i = 0; i < 16; i++)
+            data.push_back(i < 8 ? nb_records >> (8 * i) : 0);
+    }
+
+    void append(const std::vector<uint8_t>& raw) {
+        // Keep one byte for END_OF_CHUNK or END_OF_FILE.
+        if (data.size() % chunk_size + raw.size() + 1 > chunk_size) {
+            data.push_back(END_OF_CHUNK);
+            data.resize((data.size() + chunk_size - 1) / chunk_size * chunk_size, 0);
+            chunkHeader();
+        }
+        data.insert(data.end(), raw.begin(), raw.end());
+        nb_records++;
+    }
+};
+
+/**
+ * Writes the anchor file. It isn't split in chunks, so its header is only a CHUNK_HEADER and the endianness.
+ * Then come the version of OTF2, the trace format, the sizes of the event and definition chunks, the file substrate,
+ * the compression, the number of locations and of global definitions, and a description of the archive.
+ */
+static void write_anchor(uint64_t nb_global_defs) {
+    Record anchor;
+    anchor.u8(CHUNK_HEADER).u8('L');
+    anchor.u8(3).u8(0).u8(0).u8(1);
+    anchor.full(chunk_size).full(chunk_size);
+    anchor.u8(SUBSTRATE_POSIX).u8(COMPRESSION_NONE);
+    anchor.compressed(nb_locations).compressed(nb_global_defs);
+    anchor.str("localhost").str("otf2_archive_generator").str("Test archive of otf2_to_pallas");
+    anchor.compressed(0);
+    anchor.u8(END_OF_FILE);
+    FILE* file = fopen((archive_name + ".otf2").c_str(), "wb");
+    if (file == nullptr) {
+        perror(archive_name.c_str());
+        exit(EXIT_FAILURE);
+    }
+    fwrite(anchor.bytes.data(), 1, anchor.bytes.size(), file);
+    fclose(file);
+}
+
+void usage(const char* prog_name) {
+    printf("Usage: %s [OPTION]\n", prog_name);
+    printf("\t-l n  Number of locations (default: %d)\n", nb_locations);
+    printf("\t-g n  Number of locations per location group (default: %d)\n", nb_locations_per_group);
+    printf("\t-n n  Number of iterations (default: %d)\n", nb_iter);
+    printf("\t-c n  Size of the chunks (default: %zu)\n", chunk_size);
+    printf("\t-o d  Name of the archive, without .otf2 (default: %s)\n", archive_name.c_str());
+    printf("\t-?    Show this help and exit\n");
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-l") && i + 1 < argc) {
+            nb_locations = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-g") && i + 1 < argc) {
+            nb_locations_per_group = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            nb_iter = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-c") && i + 1 < argc) {
+            chunk_size = strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+            archive_name = argv[++i];
+        } else if (!strcmp(argv[i], "-?") || !strcmp(argv[i], "-h")) {
+            usage(argv[0]);
+            return EXIT_SUCCESS;
+        } else {
+            fprintf(stderr, "invalid option: %s\n", argv[i]);
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    int nb_groups = (nb_locations + nb_locations_per_group - 1) / nb_locations_per_group;
+    std::filesystem::remove_all(archive_name);
+    std::filesystem::create_directories(archive_name);
+    // Strings: the regions, then the attributes, then the location groups, then the locations, then the communicator.
+    ChunkedFile global_defs(archive_name + ".def");
+    global_defs.record(DEF_CLOCK_PROPERTIES, Record().compressed(timer_resolution).compressed(global_offset).compressed(UINT32_MAX));
+    uint32_t next_string = 0;
+    for (int r = 0; r < nb_regions; r++) {
+        global_defs.record(DEF_STRING, Record().compressed(next_string).str("function_" + std::to_string(r)));
+        global_defs.record(DEF_REGION, Record()
+                                           .compressed(r)
+                                           .compressed(next_string)
+                                           .compressed(next_string)
+                                           .compressed(next_string)
+                                           .u8(1)
+                                           .u8(1)
+                                           .compressed(0)
+                                           .compressed(next_string)
+                                           .compressed(0)
+                                           .compressed(0));
+        next_string++;
+    }
+    for (uint32_t a = 0; a < nb_attributes; a++) {
+        global_defs.record(DEF_STRING, Record().compressed(next_string).str(attributes[a].name));
+        global_defs.record(DEF_ATTRIBUTE, Record().compressed(a).compressed(next_string).u8(attributes[a].type).compressed(next_string));
+        next_string++;
+    }
+    for (int g = 0; g < nb_groups; g++) {
+        global_defs.record(DEF_STRING, Record().compressed(next_string).str("process_" + std::to_string(g)));
+        global_defs.record(DEF_LOCATION_GROUP, Record().compressed(g).compressed(next_string++).u8(1).compressed(0).compressed(UINT32_MAX).u8(0));
+    }
+    for (int l = 0; l < nb_locations; l++) {
+        global_defs.record(DEF_STRING, Record().compressed(next_string).str("thread_" + std::to_string(l)));
+        global_defs.record(DEF_LOCATION, Record()
+                                             .compressed(l)
+                                             .compressed(next_string++)
+                                             .u8(1)
+                                             .compressed(nb_iter * 3)
+                                             .compressed(l / nb_locations_per_group));
+    }
+    Record group = Record().compressed(0).compressed(next_string).u8(2).u8(4).compressed(0).compressed(nb_groups);
+    for (int g = 0; g < nb_groups; g++)
+        group.compressed(g);
+    global_defs.record(DEF_STRING, Record().compressed(next_string).str("MPI_COMM_WORLD"));
+    global_defs.record(DEF_GROUP, group);
+    global_defs.record(DEF_COMM, Record().compressed(0).compressed(next_string).compressed(0).compressed(UINT32_MAX));
+    global_defs.close();
+    write_anchor(global_defs.nbRecords());
+
+    for (int l = 0; l < nb_locations; l++) {
+        std::string path = archive_name + "/" + std::to_string(l);
+        // Odd locations number their regions and their attributes backwards.
+        bool mapped = l % 2 == 1;
+        if (mapped) {
+            ChunkedFile local_defs(path + ".def");
+            Record mapping = Record().u8(MAPPING_REGION).u8(0).compressed(nb_regions);
+            for (int r = 0; r < nb_regions; r++)
+                mapping.compressed(nb_regions - 1 - r);
+            local_defs.record(DEF_MAPPING_TABLE, mapping);
+            Record attribute_mapping = Record().u8(MAPPING_ATTRIBUTE).u8(0).compressed(nb_attributes);
+            for (uint32_t a = 0; a < nb_attributes; a++)
+                attribute_mapping.compressed(nb_attributes - 1 - a);
+            local_defs.record(DEF_MAPPING_TABLE, attribute_mapping);
+            local_defs.close();
+        }
+        auto local_attribute = [&](uint32_t a) { return mapped ? nb_attributes - 1 - a : a; };
+
+        ChunkedFile events(path + ".evt");
+        FILE* expected = fopen((path + ".expected").c_str(), "w");
+        uint64_t ts = global_offset + 2 * l;
+        for (int i = 0; i < nb_iter; i++) {
+            uint32_t region = (i + l) % nb_regions;
+            uint32_t local_region = mapped ? nb_regions - 1 - region : region;
+
+            events.timestamp(ts);
+            if (i % 4 == 0) {
+                uint8_t level = i % 256;
+                events.record(ATTRIBUTE_LIST, Record().compressed(1).compressed(local_attribute(5)).u8(TYPE_UINT8).u8(level));
+                events.record(EVENT_ENTER, Record().compressed(local_region));
+                fprintf(expected, "%" PRIu64 " Enter %u { level <5>: %u }\n", (ts - global_offset) / 2, region, level);
+            } else {
+                events.record(EVENT_ENTER, Record().compressed(local_region));
+                fprintf(expected, "%" PRIu64 " Enter %u\n", (ts - global_offset) / 2, region);
+            }
+            ts += 2 * (1 + i % 3);
+
+            // Integers are compressed, except the 8-bit and 16-bit ones, doubles are stored as they are.
+            events.timestamp(ts);
+            int64_t delta = -i;
+            double weight = i * 0.5;
+            uint64_t weight_bits;
+            memcpy(&weight_bits, &weight, sizeof(weight));
+            uint16_t flags = i * 7;
+            Record attribute_list = Record()
+                                        .compressed(5)
+                                        .compressed(local_attribute(0))
+                                        .u8(TYPE_UINT32)
+                                        .compressed(i)
+                                        .compressed(local_attribute(1))
+                                        .u8(TYPE_INT64)
+                                        .compressed(static_cast<uint64_t>(delta))
+                                        .compressed(local_attribute(2))
+                                        .u8(TYPE_DOUBLE)
+                                        .full(weight_bits)
+                                        .compressed(local_attribute(3))
+                                        .u8(TYPE_UINT16)
+                                        .fixed16(flags)
+                                        .compressed(local_attribute(4))
+                                        .u8(TYPE_REGION)
+                                        .compressed(local_region);
+            events.record(ATTRIBUTE_LIST, attribute_list);
+            events.record(EVENT_MPI_SEND, Record().compressed((l + 1) % nb_locations).compressed(0).compressed(i).compressed(i * 8));
+            fprintf(expected,
+                    "%" PRIu64 " MPI_SEND { iteration <0>: %d, delta <1>: %" PRId64 ", weight <2>: %f, flags <3>: %u, caller <4>: region <%u> }\n",
+                    (ts - global_offset) / 2, i, delta, weight, flags, region);
+            ts += 2;
+
+            // Skipped by the converter, but they must not shift the following records.
+            // Their attributes must not be given to the next event either.
+            events.record(ATTRIBUTE_LIST, Record().compressed(1).compressed(local_attribute(0)).u8(TYPE_UINT32).compressed(i));
+            events.record(EVENT_UNKNOWN, Record().u8(1).u8(2).u8(3));
+            if (i % 10 == 0)
+                events.record(EVENT_UNKNOWN, Record().padding(300));
+
+            events.timestamp(ts);
+            events.record(EVENT_LEAVE, Record().compressed(local_region));
+            fprintf(expected, "%" PRIu64 " Leave %u\n", (ts - global_offset) / 2, region);
+            ts += 2;
+        }
+        events.close();
+        fclose(expected);
+    }
+    printf("Generated %d locations in %d location groups in %s.otf2\n", nb_locations, nb_groups, archive_name.c_str());
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Records a trace through the OTF2 API while switching the measurement on and off,
+ * then reads it back and checks that only the events recorded while the measurement was on are in the trace.
+ * The regions entered before the measurement is turned off can still be left while it is off,
+ * and the ones entered while it is off are not left once it is back on.
+ * Everything is recorded in a main region, which is never dropped.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <otf2/otf2.h>
+
+#define TRACE_DIR "otf2_measurement_trace"
+#define NB_ITER 100
+
+enum { STRING_PROCESS, STRING_THREAD, STRING_KEPT, STRING_DROPPED, STRING_MAIN };
+enum { REGION_KEPT, REGION_DROPPED, REGION_MAIN };
+
+static char expected[NB_ITER * 64 * 8];
+static char actual[NB_ITER * 64 * 8];
+static size_t actual_len = 0;
+static int ret = EXIT_SUCCESS;
+
+#define CHECK(cond)                                                                  \
+  do {                                                                               \
+    if (!(cond)) {                                                                   \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);      \
+      ret = EXIT_FAILURE;                                                            \
+    }                                                                                \
+  } while (0)
+
+static void check_nb_events(OTF2_EvtWriter* writer, uint64_t expected_nb_events) {
+  uint64_t nb_events;
+  CHECK(OTF2_EvtWriter_GetNumberOfEvents(writer, &nb_events) == OTF2_SUCCESS);
+  CHECK(nb_events == expected_nb_events);
+}
+
+static void write_trace() {
+  OTF2_Archive* archive = OTF2_Archive_Open(TRACE_DIR, "main", OTF2_FILEMODE_WRITE, 1024 * 1024, 4 * 1024 * 1024,
+                                            OTF2_SUBSTRATE_POSIX, OTF2_COMPRESSION_NONE);
+  OTF2_GlobalDefWriter* global_def_writer = OTF2_Archive_GetGlobalDefWriter(archive);
+  OTF2_GlobalDefWriter_WriteString(global_def_writer, STRING_PROCESS, "process");
+  OTF2_GlobalDefWriter_WriteString(global_def_writer, STRING_THREAD, "thread");
+  OTF2_GlobalDefWriter_WriteString(global_def_writer, STRING_KEPT, "kept");
+  OTF2_GlobalDefWriter_WriteString(global_def_writer, STRING_DROPPED, "dropped");
+  OTF2_GlobalDefWriter_WriteString(global_def_writer, STRING_MAIN, "main");
+  OTF2_GlobalDefWriter_WriteRegion(global_def_writer, REGION_KEPT, STRING_KEPT, STRING_KEPT, STRING_KEPT,
+                                   OTF2_REGION_ROLE_FUNCTION, OTF2_PARADIGM_USER, OTF2_REGION_FLAG_NONE,
+                                   STRING_KEPT, 0, 0);
+  OTF2_GlobalDefWriter_WriteRegion(global_def_writer, REGION_DROPPED, STRING_DROPPED, STRING_DROPPED, STRING_DROPPED,
+                                   OTF2_REGION_ROLE_FUNCTION, OTF2_PARADIGM_USER, OTF2_REGION_FLAG_NONE,
+                                   STRING_DROPPED, 0, 0);
+  OTF2_GlobalDefWriter_WriteRegion(global_def_writer, REGION_MAIN, STRING_MAIN, STRING_MAIN, STRING_MAIN,
+                                   OTF2_REGION_ROLE_FUNCTION, OTF2_PARADIGM_USER, OTF2_REGION_FLAG_NONE,
+                                   STRING_MAIN, 0, 0);
+  OTF2_GlobalDefWriter_WriteLocationGroup(global_def_writer, 0, STRING_PROCESS, OTF2_LOCATION_GROUP_TYPE_PROCESS,
+                                          OTF2_UNDEFINED_SYSTEM_TREE_NODE, OTF2_UNDEFINED_LOCATION_GROUP);
+
+  OTF2_DefWriter* def_writer = OTF2_Archive_GetDefWriter(archive, 0);
+  OTF2_DefWriter_WriteLocation(def_writer, 0, STRING_THREAD, OTF2_LOCATION_TYPE_CPU_THREAD, 0, 0);
+  OTF2_EvtWriter* writer = OTF2_Archive_GetEvtWriter(archive, 0);
+
+  size_t expected_len = 0;
+  uint64_t nb_events = 0;
+  OTF2_TimeStamp ts = 0;
+  OTF2_EvtWriter_Enter(writer, NULL, ts, REGION_MAIN);
+  expected_len += sprintf(&expected[expected_len], "ENTER %d %" PRIu64 "\n", REGION_MAIN, ts++);
+  nb_events++;
+  for (int i = 0; i < NB_ITER; i++) {
+    OTF2_EvtWriter_Enter(writer, NULL, ts, REGION_KEPT);
+    expected_len += sprintf(&expected[expected_len], "ENTER %d %" PRIu64 "\n", REGION_KEPT, ts++);
+    OTF2_EvtWriter_MeasurementOnOff(writer, NULL, ts, OTF2_MEASUREMENT_OFF);
+    expected_len += sprintf(&expected[expected_len], "OFF %" PRIu64 "\n", ts++);
+    nb_events += 2;
+    check_nb_events(writer, nb_events);
+
+    /* Dropped, the measurement is off. */
+    OTF2_EvtWriter_Enter(writer, NULL, ts++, REGION_DROPPED);
+    OTF2_EvtWriter_Leave(writer, NULL, ts++, REGION_DROPPED);
+    OTF2_EvtWriter_MeasurementOnOff(writer, NULL, ts++, OTF2_MEASUREMENT_OFF);
+    check_nb_events(writer, nb_events);
+
+    /* Recorded, the region was entered while the measurement was on. */
+    OTF2_EvtWriter_Leave(writer, NULL, ts, REGION_KEPT);
+    expected_len += sprintf(&expected[expected_len], "LEAVE %d %" PRIu64 "\n", REGION_KEPT, ts++);
+    nb_events++;
+    check_nb_events(writer, nb_events);
+
+    /* Dropped, even if the region and the ones it calls are left once the measurement is back on. */
+    OTF2_EvtWriter_Enter(writer, NULL, ts++, REGION_DROPPED);
+    OTF2_EvtWriter_MeasurementOnOff(writer, NULL, ts, OTF2_MEASUREMENT_ON);
+    expected_len += sprintf(&expected[expected_len], "ON %" PRIu64 "\n", ts++);
+    OTF2_EvtWriter_Enter(writer, NULL, ts++, REGION_KEPT);
+    OTF2_EvtWriter_Leave(writer, NULL, ts++, REGION_KEPT);
+    OTF2_EvtWriter_Leave(writer, NULL, ts++, REGION_DROPPED);
+    nb_events++;
+    check_nb_events(writer, nb_events);
+
+    OTF2_EvtWriter_BufferFlush(writer, NULL, ts, ts + 1);
+    expected_len += sprintf(&expected[expected_len], "FLUSH %" PRIu64 " %" PRIu64 "\n", ts, ts + 1);
+    ts += 2;
+    nb_events++;
+    check_nb_events(writer, nb_events);
+  }
+  OTF2_EvtWriter_Leave(writer, NULL, ts, REGION_MAIN);
+  expected_len += sprintf(&expected[expected_len], "LEAVE %d %" PRIu64 "\n", REGION_MAIN, ts++);
+  nb_events++;
+  check_nb_events(writer, nb_events);
+
+  OTF2_Archive_CloseEvtWriter(archive, writer);
+  OTF2_Archive_CloseDefWriter(archive, def_writer);
+  OTF2_Archive_Close(archive);
+  OTF2_Archive_CloseGlobalDefWriter(archive, global_def_writer);
+}
+
+static OTF2_CallbackCode read_enter(OTF2_LocationRef location, OTF2_TimeStamp time, void* user_data,
+                                    OTF2_AttributeList* attributes, OTF2_RegionRef region) {
+  actual_len += sprintf(&actual[actual_len], "ENTER %u %" PRIu64 "\n", region, time);
+  return OTF2_CALLBACK_SUCCESS;
+}
+
+static OTF2_CallbackCode read_leave(OTF2_LocationRef location, OTF2_TimeStamp time, void* user_data,
+                                    OTF2_AttributeList* attributes, OTF2_RegionRef region) {
+  actual_len += sprintf(&actual[actual_len], "LEAVE %u %" PRIu64 "\n", region, time);
+  return OTF2_CALLBACK_SUCCESS;
+}
+
+static OTF2_CallbackCode read_measurement_on_off(OTF2_LocationRef location, OTF2_TimeStamp time, void* user_data,
+                                                 OTF2_AttributeList* attributes, OTF2_MeasurementMode mode) {
+  actual_len += sprintf(&actual[actual_len], "%s %" PRIu64 "\n", mode == OTF2_MEASUREMENT_ON ? "ON" : "OFF", time);
+  return OTF2_CALLBACK_SUCCESS;
+}
+
+static OTF2_CallbackCode read_buffer_flush(OTF2_LocationRef location, OTF2_TimeStamp time, void* user_data,
+                                           OTF2_AttributeList* attributes, OTF2_TimeStamp stop_time) {
+  actual_len += sprintf(&actual[actual_len], "FLUSH %" PRIu64 " %" PRIu64 "\n", time, stop_time);
+  return OTF2_CALLBACK_SUCCESS;
+}
+
+static void read_trace() {
+  OTF2_Reader* reader = OTF2_Reader_Open(TRACE_DIR "/main.pallas");
+  CHECK(reader != NULL);
+  if (reader == NULL)
+    return;
+  OTF2_Reader_SelectLocation(reader, 0);
+  CHECK(OTF2_Reader_GetEvtReader(reader, 0) != NULL);
+
+  OTF2_GlobalEvtReaderCallbacks* callbacks = OTF2_GlobalEvtReaderCallbacks_New();
+  OTF2_GlobalEvtReaderCallbacks_SetEnterCallback(callbacks, read_enter);
+  OTF2_GlobalEvtReaderCallbacks_SetLeaveCallback(callbacks, read_leave);
+  OTF2_GlobalEvtReaderCallbacks_SetMeasurementOnOffCallback(callbacks, read_measurement_on_off);
+  OTF2_GlobalEvtReaderCallbacks_SetBufferFlushCallback(callbacks, read_buffer_flush);
+  OTF2_GlobalEvtReader* global_evt_reader = OTF2_Reader_GetGlobalEvtReader(reader);
+  OTF2_Reader_RegisterGlobalEvtCallbacks(reader, global_evt_reader, callbacks, NULL);
+  OTF2_GlobalEvtReaderCallbacks_Delete(callbacks);
+
+  uint64_t nb_read;
+  OTF2_Reader_ReadAllGlobalEvents(reader, global_evt_reader, &nb_read);
+  OTF2_Reader_CloseGlobalEvtReader(reader, global_evt_reader);
+  OTF2_Reader_Close(reader);
+}
+
+int main(int argc __attribute__((unused)), char** argv __attribute__((unused))) {
+  write_trace();
+  read_trace();
+  if (strcmp(expected, actual) != 0) {
+    fprintf(stderr, "Expected events:\n%s\nEvents in the trace:\n%s\n", expected, actual);
+    ret = EXIT_FAILURE;
+  }
+  if (ret == EXIT_SUCCESS)
+    printf("%d iterations recorded with the measurement switched on and off\n", NB_ITER);
+  return ret;
+}
+
+/* -*-
+   mode: c;
+   c-file-style: "k&r";
+   c-basic-offset 2;
+   tab-width 2 ;
+   indent-tabs-mode nil
+   -*- */
@@ -0,0 +1,23 @@
+#!/bin/bash
+
+# Checks that the prefetching global event reader of the OTF2 layer calls the callbacks
+# in the same order as the default one: otf2-print must give the same output with and without it.
+
+CUR_PATH=$(dirname  $(realpath $0))
+source "$CUR_PATH/test_utils.sh" "$1"
+
+[ -n "$OTF2_PRINT_PATH" ]    || export OTF2_PRINT_PATH=$BUILD_DIR/libraries/otf2/otf2-print
+
+trace="$2"
+nb_workers="$3"
+
+ret=0
+if diff -q <("$OTF2_PRINT_PATH" "$trace" 2>/dev/null) \
+           <(PALLAS_OTF2_PREFETCH="$nb_workers" "$OTF2_PRINT_PATH" "$trace" 2>/dev/null) > /dev/null; then
+  print_ok "Prefetching with $nb_workers workers reads the events of $trace in the same order"
+  rm -rf "$(dirname -- "$trace")"
+else
+  print_error "Prefetching with $nb_workers workers changes the order of the events of $trace"
+  ret=1
+fi
+exit $ret
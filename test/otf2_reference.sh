@@ -0,0 +1,40 @@
+#!/bin/bash
+
+# Checks an archive written by otf2_archive_generator with otf2-print, the reader of the OTF2 library:
+# each location must contain the events listed in <archive>/<location>.expected, with the same timestamps.
+# This makes sure that the generator, and thus otf2_to_pallas, read and write the OTF2 format as the OTF2 library does.
+#
+# Usage: otf2_reference.sh build_dir otf2-print archive
+
+CUR_PATH=$(dirname  $(realpath $0))
+source "$CUR_PATH/test_utils.sh" "$1"
+
+otf2_print="$2"
+archive="$3"
+
+# The generator uses a timer resolution of 2 GHz and a global offset of 1000 ticks.
+events=$("$otf2_print" "$archive.otf2" 2>&1 |
+         awk '$1 == "ENTER" || $1 == "LEAVE" || $1 == "MPI_SEND" {
+                ts = ($3 - 1000) / 2
+                if ($1 == "MPI_SEND") { print $2, ts, "MPI_SEND"; next }
+                match($0, /<[0-9]+>/)
+                print $2, ts, ($1 == "ENTER" ? "Enter" : "Leave"), substr($0, RSTART + 1, RLENGTH - 2)
+              }')
+if [ -z "$events" ]; then
+  print_error "otf2-print can't read $archive.otf2"
+  exit 1
+fi
+
+ret=0
+for expected in "$archive"/*.expected; do
+  location=$(basename "$expected" .expected)
+  # otf2-print shows the attributes on their own lines: only the events are compared.
+  if ! diff -q <(sed 's/ {.*//' "$expected") <(echo "$events" | awk -v l="$location" '$1 == l { $1 = ""; sub(/^ /, ""); print }') > /dev/null; then
+    print_error "otf2-print doesn't read the events of location $location as $expected lists them"
+    ret=1
+  fi
+done
+if [ $ret -eq 0 ]; then
+  print_ok "otf2-print reads $archive.otf2 as expected"
+fi
+exit $ret
@@ -0,0 +1,29 @@
+#!/bin/bash
+
+# Checks a trace converted by otf2_to_pallas from an archive written by otf2_archive_generator:
+# each thread must contain the events listed in <archive>/<location>.expected, with the same timestamps and attributes.
+
+CUR_PATH=$(dirname  $(realpath $0))
+source "$CUR_PATH/test_utils.sh" "$1"
+
+archive="$2"
+trace="$3"
+
+ret=0
+for expected in "$archive"/*.expected; do
+  thread=$(basename "$expected" .expected)
+  if ! diff -q "$expected" \
+               <("$PALLAS_PRINT_PATH" -T --thread "$thread" "$trace" 2>/dev/null |
+                 awk 'NR == 1 { next }
+                      { ts = int($1 * 1e9 + 0.5)
+                        attributes = match($0, / \{ .* \}$/) ? substr($0, RSTART) : ""
+                        if ($2 == "Enter" || $2 == "Leave") print ts, $2, $3 attributes; else { sub(/\(.*/, "", $2); print ts, $2 attributes } }') > /dev/null; then
+    print_error "Thread $thread of $trace doesn't match $expected"
+    ret=1
+  fi
+done
+if [ $ret -eq 0 ]; then
+  print_ok "$trace contains the events of $archive.otf2"
+  rm -rf "$archive" "$archive.otf2" "$archive.def" "$(dirname -- "$trace")"
+fi
+exit $ret
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Minimal harness for the microbenchmarks: each benchmark is repeated, and its best and median times
+ * are printed as one JSON object per line, so that the results of two versions can be compared with
+ * compare_benchmarks.py.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pallas_benchmark {
+
+/** Parameters of a benchmark, in the order they are printed. */
+using Parameters = std::vector<std::pair<std::string, long long>>;
+
+/** Options shared by all the benchmarks of a suite. */
+struct Options {
+    /** Number of times each benchmark is run. */
+    int repetitions = 5;
+    /** Only run the benchmarks whose name contains this string. */
+    std::string filter;
+    /** Run smaller sweeps, to check that the benchmarks work. */
+    bool quick = false;
+    /** Where the results are written. */
+    FILE* output = stdout;
+    /** Arguments that are not options, such as the traces to read. */
+    std::vector<std::string> arguments;
+};
+
+/** Measures the part of a repetition that is benchmarked, excluding its setup. */
+class Timer {
+   public:
+    void start() {
+        begin = std::chrono::steady_clock::now();
+    }
+    void stop() {
+        elapsed += std::chrono::steady_clock::now() - begin;
+    }
+    [[nodiscard]] double seconds() const {
+        return std::chrono::duration<double>(elapsed).count();
+    }
+
+   private:
+    std::chrono::steady_clock::time_point begin;
+    std::chrono::steady_clock::duration elapsed{0};
+};
+
+inline Options options;
+/** Describes the arguments expected by the suite, if any. */
+inline const char* arguments_usage = "";
+
+inline void usage(const char* prog_name, const char* description) {
+    printf("Usage: %s [OPTION] %s\n", prog_name, arguments_usage);
+    printf("%s\n", description);
+    printf("\t-r n       Number of repetitions of each benchmark (default: %d)\n", options.repetitions);
+    printf("\t-f name    Only run the benchmarks whose name contains name\n");
+    printf("\t-q         Quick mode: small sweeps, to check that the benchmarks work\n");
+    printf("\t-o file    Write the results to file (default: stdout)\n");
+    printf("\t-?         Show this help and exit\n");
+}
+
+/** Parses the options common to all the benchmarks. Exits on an invalid option. */
+inline void parseOptions(int argc, char** argv, const char* description) {
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+            options.repetitions = std::max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "-f") && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (!strcmp(argv[i], "-q")) {
+            options.quick = true;
+        } else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+            options.output = fopen(argv[++i], "w");
+            if (options.output == nullptr) {
+                perror(argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        } else if (!strcmp(argv[i], "-?") || !strcmp(argv[i], "-h")) {
+            usage(argv[0], description);
+            exit(EXIT_SUCCESS);
+        } else if (argv[i][0] != '-' && *arguments_usage) {
+            options.arguments.emplace_back(argv[i]);
+        } else {
+            fprintf(stderr, "invalid option: %s\n", argv[i]);
+            usage(argv[0], description);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+/** Returns true if the benchmark called name has to be run. */
+inline bool selected(const std::string& name) {
+    return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+/** Returns the full sweep, or only its first values in quick mode. */
+template <class T>
+std::vector<T> sweep(std::vector<T> values, size_t nb_quick_values = 2) {
+    if (options.quick && values.size() > nb_quick_values)
+        values.resize(nb_quick_values);
+    return values;
+}
+
+/**
+ * Runs a benchmark options.repetitions times and prints its results.
+ * @param name Name of the benchmark.
+ * @param parameters Parameters of this run of the benchmark.
+ * @param nb_operations Number of operations done by each repetition: the times are given per operation.
+ * @param repetition Runs one repetition, and only times the part that is benchmarked.
+ */
+inline void run(const std::string& name, const Parameters& parameters, size_t nb_operations, const std::function<void(Timer&)>& repetition) {
+    if (!selected(name))
+        return;
+    std::vector<double> times;
+    for (int r = 0; r < options.repetitions; r++) {
+        Timer timer;
+        repetition(timer);
+        times.push_back(timer.seconds());
+    }
+    std::sort(times.begin(), times.end());
+    double median = times[times.size() / 2];
+    double best = times.front();
+    fprintf(options.output, "{\"benchmark\": \"%s\", \"parameters\": {", name.c_str());
+    for (size_t i = 0; i < parameters.size(); i++) {
+        fprintf(options.output, "%s\"%s\": %lld", i ? ", " : "", parameters[i].first.c_str(), parameters[i].second);
+    }
+    fprintf(options.output, "}, \"operations\": %zu, \"repetitions\": %zu, \"median_ns_per_op\": %.3f, \"min_ns_per_op\": %.3f, \"ops_per_s\": %.1f}\n",
+            nb_operations, times.size(), median * 1e9 / nb_operations, best * 1e9 / nb_operations, median > 0 ? nb_operations / median : 0);
+    fflush(options.output);
+}
+
+}  // namespace pallas_benchmark
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Checks the partial flush of the ThreadWriter: nb_calls calls to a function that contains a generic event are recorded,
+ * and the memory taken by their timestamps and durations is measured halfway and at the end.
+ * With PALLAS_PARTIAL_FLUSH, it must barely grow, since the full SubArrays are written to the data files.
+ * Without it, it grows with the number of values. In both cases, the stored trace must hold every value,
+ * and the statistics of the durations must account for all of them.
+ */
+
+#include <filesystem>
+#include <string>
+
+#include "pallas/pallas.h"
+#include "pallas/pallas_archive.h"
+#include "pallas/pallas_read.h"
+#include "pallas/pallas_record.h"
+#include "pallas/pallas_write.h"
+
+#include "pallas/utils/pallas_log.h"
+#include "pallas/utils/pallas_memory.h"
+#include "pallas/utils/pallas_parameter_handler.h"
+#include "pallas/utils/pallas_storage.h"
+
+using namespace pallas;
+
+static const RegionRef function = 1;
+static const StringRef generic_event = 2;
+
+/** Timestamp of the n-th Event, so that the intervals differ from one to the next. */
+static pallas_timestamp_t event_timestamp(size_t n) {
+    return 3 * n + n % 7;
+}
+
+/** Returns the number of bytes taken by the timestamps and durations. */
+static size_t vector_memory(const ThreadWriter& writer) {
+    MemoryUsage usage = writer.getMemoryUsage();
+    return usage[PALLAS_MEMORY_TIMESTAMPS] + usage[PALLAS_MEMORY_DURATIONS];
+}
+
+/** Records the calls in [start, end[. Each call holds 3 Events. */
+static void record(ThreadWriter& writer, size_t start, size_t end) {
+    for (size_t i = start; i < end; i++) {
+        pallas_record_enter(&writer, nullptr, event_timestamp(3 * i + 1), function);
+        pallas_record_generic(&writer, nullptr, event_timestamp(3 * i + 2), generic_event);
+        pallas_record_leave(&writer, nullptr, event_timestamp(3 * i + 3), function);
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t nb_calls = argc > 1 ? std::stoul(argv[1]) : 100000;
+    const char* trace_name = argc > 2 ? argv[2] : "partial_flush_trace";
+    std::filesystem::remove_all(trace_name);
+
+    GlobalArchive trace(trace_name, "main");
+    trace.addString(0, "thread");
+    trace.addString(function, "function");
+    trace.addString(generic_event, "generic_event");
+    trace.addRegion(function, function);
+    Archive archive(trace, 0);
+    archive.global_archive = &trace;
+    trace.defineLocationGroup(0, 0, PALLAS_LOCATION_GROUP_ID_INVALID);
+    archive.defineLocation(0, 0, 0);
+
+    ThreadWriter writer(archive, 0);
+    bool partial_flush = writer.parameter_handler->partialFlush;
+    record(writer, 0, nb_calls / 2);
+    size_t first = vector_memory(writer);
+    record(writer, nb_calls / 2, nb_calls);
+    size_t second = vector_memory(writer);
+    pallas_log(DebugLevel::Normal, "Timestamps and durations: %zu bytes, then %zu bytes\n", first, second);
+
+    // Each call adds 3 timestamps to the Events, and a timestamp and two durations to the function.
+    size_t added = (nb_calls - nb_calls / 2) * 6 * sizeof(uint64_t);
+    if (partial_flush) {
+        pallas_assert_always(second - first < added / 10);
+    } else {
+        pallas_assert_always(second - first > added / 2);
+    }
+    writer.threadClose();
+    archive.store();
+    trace.store();
+
+    auto* read_trace = pallas_open_trace((std::string(trace_name) + "/main.pallas").c_str());
+    if (read_trace == nullptr) {
+        pallas_error("Cannot open %s\n", trace_name);
+    }
+    auto* thread = read_trace->getThreadList().front();
+    // The Sequences are walked directly: with PALLAS_LAZY_LOADING, they must be loaded first.
+    thread->loadAll();
+    Sequence* call = nullptr;
+    for (size_t i = 0; i < thread->nb_sequences; i++) {
+        if (thread->sequences[i].size() == 3)
+            call = &thread->sequences[i];
+    }
+    pallas_assert_always(call != nullptr);
+    pallas_assert_equals_always(call->durations->size, nb_calls);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < nb_calls; i++) {
+        pallas_assert_equals_always(call->timestamps->at(i), event_timestamp(3 * i + 1));
+        pallas_assert_equals_always(call->durations->at(i), event_timestamp(3 * i + 3) - event_timestamp(3 * i + 1));
+        sum += call->durations->at(i);
+    }
+    // The statistics of the SubArrays that were spilled were taken before they were released.
+    const auto& statistics = thread->getSequenceStatistics(call->id);
+    pallas_assert_equals_always(statistics.count, nb_calls);
+    pallas_assert_equals_always(statistics.sum, sum);
+    {
+        // The reader frees the thread when it is destroyed.
+        ThreadReader reader(thread->archive, thread->id, PALLAS_READ_FLAG_UNROLL_ALL);
+        size_t nb_read = 0;
+        for (auto token = reader.pollCurToken(); token != INVALID_TOKEN; token = reader.getNextToken()) {
+            if (token.type != TypeEvent)
+                continue;
+            nb_read++;
+            size_t occurrence = reader.getCurrentTokenCount(token);
+            pallas_assert_equals_always(reader.getEventOccurrence(token, occurrence).timestamp, event_timestamp(nb_read));
+        }
+        pallas_assert_equals_always(nb_read, 3 * nb_calls);
+    }
+    delete read_trace;
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
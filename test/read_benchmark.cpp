@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Benchmarks of the read path, on a trace written by trace_generator (or any other trace).
+ *  - open_trace: opens the trace and loads all its threads, with nb_workers workers.
+ *  - cold_open: opens the trace, loads all its threads, and reads the first events of each one, with or without
+ *    the lazy loading of their Events and Sequences.
+ *  - replay_cold: replays every thread with a ThreadReader right after the trace was opened,
+ *    so that the timestamps and durations are loaded from the LinkedVectors files on the fly.
+ *  - replay_warm: the same replay, once everything has already been loaded.
+ *  - replay_multithread: replays the whole trace in chronological order with a MultiThreadReader.
+ *  - seek: jumps to checkpoints spread over a thread, and reads a few tokens from there.
+ *  - snapshot, snapshot_fast, snapshot_exact: the Thread snapshot views, over nb_windows windows per thread.
+ *  - snapshot_by_name: the trace-level snapshot over the whole trace, with nb_workers workers.
+ * The operations are events for the replays, seeks for seek, and windows for the snapshots.
+ */
+
+#include <string>
+#include <vector>
+
+#include "pallas/pallas.h"
+#include "pallas/pallas_archive.h"
+#include "pallas/pallas_read.h"
+#include "pallas/utils/pallas_storage.h"
+#include "pallas_benchmark.h"
+
+using namespace pallas;
+using namespace pallas_benchmark;
+
+static const char* description = "Benchmarks of the read path. Prints one JSON object per benchmark and parameter set.";
+static std::string trace_name;
+/** Keeps the compiler from optimizing the benchmarked calls away. */
+static volatile pallas_timestamp_t sink;
+
+/** Opens the trace, and exits if it can't be read. */
+static GlobalArchive* openTrace() {
+    auto* trace = pallas_open_trace(trace_name.c_str());
+    if (trace == nullptr) {
+        pallas_error("Cannot open %s\n", trace_name.c_str());
+    }
+    return trace;
+}
+
+/** Reads all the events of a thread from the current position of reader, and returns how many there are. */
+static size_t replayThread(ThreadReader& reader) {
+    size_t nb_events = 0;
+    pallas_timestamp_t last_timestamp = 0;
+    for (auto token = reader.pollCurToken(); token != INVALID_TOKEN; token = reader.getNextToken()) {
+        if (token.type == TypeEvent) {
+            auto event = reader.getEventOccurrence(token, reader.getCurrentTokenCount(token));
+            last_timestamp = event.timestamp;
+            nb_events++;
+        }
+    }
+    sink = last_timestamp;
+    return nb_events;
+}
+
+static void benchOpen(const Parameters& trace_parameters) {
+    for (long long nb_workers : sweep<long long>({1, 2, 4, 0})) {
+        Parameters parameters = trace_parameters;
+        parameters.emplace_back("nb_workers", nb_workers);
+        run("open_trace", parameters, 1, [&](Timer& timer) {
+            timer.start();
+            auto* trace = openTrace();
+            sink = trace->getThreadList(nb_workers).size();
+            timer.stop();
+            delete trace;
+        });
+    }
+}
+
+static void benchColdOpen(const Parameters& trace_parameters) {
+    const size_t nb_tokens_read = 16;
+    for (long long lazy : sweep<long long>({0, 1})) {
+        Parameters parameters = trace_parameters;
+        parameters.emplace_back("lazy", lazy);
+        parameters.emplace_back("nb_tokens_read", nb_tokens_read);
+        run("cold_open", parameters, 1, [&](Timer& timer) {
+            timer.start();
+            auto* trace = openTrace();
+            trace->parameter_handler->lazyLoading = lazy;
+            for (auto* thread : trace->getThreadList()) {
+                // The reader frees the thread when it is destroyed.
+                ThreadReader reader(thread->archive, thread->id, PALLAS_READ_FLAG_UNROLL_ALL);
+                for (size_t t = 0; t < nb_tokens_read; t++) {
+                    if (reader.getNextToken() == INVALID_TOKEN)
+                        break;
+                }
+            }
+            timer.stop();
+            delete trace;
+        });
+    }
+}
+
+static void benchReplay(const Parameters& parameters, size_t nb_events) {
+    run("replay_cold", parameters, nb_events, [&](Timer& timer) {
+        auto* trace = openTrace();
+        auto threads = trace->getThreadList();
+        timer.start();
+        for (auto* thread : threads) {
+            // The reader frees the thread when it is destroyed.
+            ThreadReader reader(thread->archive, thread->id, PALLAS_READ_FLAG_UNROLL_ALL);
+            replayThread(reader);
+        }
+        timer.stop();
+        delete trace;
+    });
+
+    // The readers are kept, and rewound to their first token between the replays.
+    auto* trace = openTrace();
+    std::vector<ThreadReader*> readers;
+    std::vector<Cursor> beginnings;
+    for (auto* thread : selected("replay_warm") ? trace->getThreadList() : std::vector<Thread*>()) {
+        auto* reader = new ThreadReader(thread->archive, thread->id, PALLAS_READ_FLAG_UNROLL_ALL);
+        beginnings.push_back(reader->createCheckpoint());
+        replayThread(*reader);
+        readers.push_back(reader);
+    }
+    run("replay_warm", parameters, nb_events, [&](Timer& timer) {
+        timer.start();
+        for (size_t i = 0; i < readers.size(); i++) {
+            readers[i]->loadCheckpoint(&beginnings[i]);
+            replayThread(*readers[i]);
+        }
+        timer.stop();
+    });
+    for (auto* reader : readers)
+        delete reader;
+
+    // The MultiThreadReader frees the threads it reads, so they are loaded again by every repetition.
+    run("replay_multithread", parameters, nb_events, [&](Timer& timer) {
+        timer.start();
+        MultiThreadReader reader(*trace);
+        for (auto token = reader.pollCurToken(); token != INVALID_TOKEN; token = reader.getNextToken()) {
+        }
+        timer.stop();
+    });
+    delete trace;
+}
+
+static void benchSeek(const Parameters& trace_parameters) {
+    // Taking the checkpoints replays a whole thread.
+    if (!selected("seek"))
+        return;
+    auto* trace = openTrace();
+    auto* thread = trace->getThreadList().front();
+    size_t nb_events = thread->getEventCount();
+    auto* reader = new ThreadReader(thread->archive, thread->id, PALLAS_READ_FLAG_UNROLL_ALL);
+    Cursor beginning = reader->createCheckpoint();
+    const size_t nb_tokens_read = 16;
+    for (long long nb_checkpoints : sweep<long long>({16, 256})) {
+        // Takes the checkpoints during a first replay.
+        std::vector<Cursor> checkpoints;
+        size_t step = std::max<size_t>(1, nb_events / nb_checkpoints);
+        size_t n = 0;
+        reader->loadCheckpoint(&beginning);
+        for (auto token = reader->pollCurToken(); token != INVALID_TOKEN; token = reader->getNextToken()) {
+            if (token.type == TypeEvent && n++ % step == 0)
+                checkpoints.push_back(reader->createCheckpoint());
+        }
+
+        const size_t nb_seeks = options.quick ? 100 : 1000;
+        Parameters parameters = trace_parameters;
+        parameters.emplace_back("nb_checkpoints", checkpoints.size());
+        parameters.emplace_back("nb_tokens_read", nb_tokens_read);
+        run("seek", parameters, nb_seeks, [&](Timer& timer) {
+            uint32_t state = 1;
+            timer.start();
+            for (size_t s = 0; s < nb_seeks; s++) {
+                state = state * 1103515245 + 12345;
+                reader->loadCheckpoint(&checkpoints[(state >> 16) % checkpoints.size()]);
+                for (size_t t = 0; t < nb_tokens_read; t++) {
+                    if (reader->getNextToken() == INVALID_TOKEN)
+                        break;
+                }
+            }
+            timer.stop();
+        });
+    }
+    // The reader frees the thread, so it must be deleted before the trace.
+    delete reader;
+    delete trace;
+}
+
+static void benchSnapshots(const Parameters& trace_parameters) {
+    if (!selected("snapshot") && !selected("snapshot_fast") && !selected("snapshot_exact") && !selected("snapshot_by_name"))
+        return;
+    auto* trace = openTrace();
+    auto threads = trace->getThreadList();
+    for (long long nb_windows : sweep<long long>({1, 10, 100})) {
+        Parameters parameters = trace_parameters;
+        parameters.emplace_back("nb_windows", nb_windows);
+        size_t nb_operations = nb_windows * threads.size();
+        auto forEachWindow = [&](auto&& snapshot) {
+            for (auto* thread : threads) {
+                pallas_timestamp_t start = thread->getFirstTimestamp();
+                pallas_timestamp_t step = thread->getDuration() / nb_windows;
+                for (long long w = 0; w < nb_windows; w++)
+                    snapshot(thread, start + w * step, start + (w + 1) * step);
+            }
+        };
+        run("snapshot", parameters, nb_operations, [&](Timer& timer) {
+            timer.start();
+            forEachWindow([](Thread* thread, pallas_timestamp_t start, pallas_timestamp_t end) {
+                sink = thread->getSnapshotView(start, end).size();
+            });
+            timer.stop();
+        });
+        run("snapshot_fast", parameters, nb_operations, [&](Timer& timer) {
+            timer.start();
+            forEachWindow([](Thread* thread, pallas_timestamp_t start, pallas_timestamp_t end) {
+                sink = thread->getSnapshotViewFast(start, end).size();
+            });
+            timer.stop();
+        });
+        run("snapshot_exact", parameters, nb_operations, [&](Timer& timer) {
+            timer.start();
+            forEachWindow([](Thread* thread, pallas_timestamp_t start, pallas_timestamp_t end) {
+                sink = thread->getSnapshotViewExact(start, end).size();
+            });
+            timer.stop();
+        });
+    }
+    pallas_timestamp_t start = trace->get_starting_timestamp();
+    pallas_timestamp_t end = trace->get_ending_timestamp();
+    for (long long nb_workers : sweep<long long>({1, 2, 4, 0})) {
+        Parameters parameters = trace_parameters;
+        parameters.emplace_back("nb_workers", nb_workers);
+        run("snapshot_by_name", parameters, 1, [&](Timer& timer) {
+            timer.start();
+            sink = trace->getSnapshotViewByName(start, end, nb_workers).size();
+            timer.stop();
+        });
+    }
+    delete trace;
+}
+
+int main(int argc, char** argv) {
+    arguments_usage = "trace.pallas";
+    parseOptions(argc, argv, description);
+    if (options.arguments.size() != 1) {
+        usage(argv[0], description);
+        return EXIT_FAILURE;
+    }
+    trace_name = options.arguments[0];
+
+    // The size of the trace is part of the parameters, so that results on different traces are not compared.
+    auto* trace = openTrace();
+    auto threads = trace->getThreadList();
+    size_t nb_events = 0;
+    for (auto* thread : threads)
+        nb_events += thread->getEventCount();
+    Parameters trace_parameters{{"nb_threads", threads.size()}, {"nb_events", nb_events}};
+    delete trace;
+
+    benchOpen(trace_parameters);
+    benchColdOpen(trace_parameters);
+    benchReplay(trace_parameters, nb_events);
+    benchSeek(trace_parameters);
+    benchSnapshots(trace_parameters);
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
@@ -0,0 +1,66 @@
+#!/bin/bash
+
+# Runs the read benchmarks on synthetic traces of increasing size, generated by trace_generator.
+# read_benchmark measures the C++ API; the time of pallas_print and of the Python analysis
+# (benchmark_numpy.py, when the pallas_trace module is installed) is measured on the same traces.
+# The opening of a trace is also measured on a trace of 10000 threads, for the lazy loading of the threads.
+# The results are printed as JSON lines, like the ones of read_benchmark, and can be compared with compare_benchmarks.py.
+#
+# Usage: read_benchmark.sh build_dir [output.jsonl]
+
+CUR_PATH=$(dirname  $(realpath $0))
+source "$CUR_PATH/test_utils.sh" "$1"
+
+output="${2:-/dev/stdout}"
+work_dir=$(mktemp -d)
+trap 'rm -rf "$work_dir"' EXIT
+
+# name: options of trace_generator
+configs=(
+  "small:-r 2 -t 2 -d 2 -n 100 -l 10 -m ring"
+  "deep:-r 2 -t 2 -d 8 -n 100 -l 10 -i 7 -m ring"
+  "alltoall:-r 8 -t 1 -d 3 -n 200 -l 5 -m alltoall"
+  "zstd:-r 4 -t 4 -d 3 -n 500 -l 20 -m collective -c ZSTD"
+)
+# Traces on which only the opening is measured (open_trace and cold_open): replaying them would take too long.
+open_configs=(
+  "many_threads:-r 100 -t 100 -d 3 -n 20 -l 5 -m ring"
+)
+
+# Prints the time taken by a command as a JSON line.
+function time_command {
+  name=$1; shift
+  start=$(date +%s%N)
+  "$@" > /dev/null 2>&1 || print_error "$name failed" >&2
+  end=$(date +%s%N)
+  echo "{\"benchmark\": \"$name\", \"parameters\": {\"trace\": \"$config\"}, \"operations\": 1, \"repetitions\": 1, \"median_ns_per_op\": $((end - start)), \"min_ns_per_op\": $((end - start))}"
+}
+
+# Generates the trace of a config in $trace.
+function generate {
+  config=${1%%:*}
+  trace="$work_dir/$config"
+  "$BUILD_DIR/test/trace_generator" ${1#*:} -o "$trace" > /dev/null 2>&1
+  if [ ! -f "$trace/main.pallas" ]; then
+    print_error "Cannot generate trace $config" >&2
+    exit 1
+  fi
+}
+
+: > "$output"
+for entry in "${open_configs[@]}"; do
+  generate "$entry"
+  "$BUILD_DIR/test/read_benchmark" -r 3 -f open "$trace/main.pallas" 2>/dev/null >> "$output"
+  rm -rf "$trace"
+  print_info "Benchmarked $config" >&2
+done
+for entry in "${configs[@]}"; do
+  generate "$entry"
+  "$BUILD_DIR/test/read_benchmark" -r 3 "$trace/main.pallas" 2>/dev/null >> "$output"
+  time_command pallas_print "$PALLAS_PRINT_PATH" "$trace/main.pallas" >> "$output"
+  time_command pallas_print_per_thread "$PALLAS_PRINT_PATH" -T "$trace/main.pallas" >> "$output"
+  if python3 -c "import pallas_trace" 2>/dev/null; then
+    time_command python_numpy python3 "$CUR_PATH/benchmark_numpy.py" "$trace/main.pallas" >> "$output"
+  fi
+  print_info "Benchmarked $config" >&2
+done
@@ -0,0 +1,28 @@
+#!/bin/bash
+
+# Checks a trace built by pallas_slice: each thread of the slice must contain
+# the events of the original thread whose timestamp is within the window, and only them.
+
+CUR_PATH=$(dirname  $(realpath $0))
+source "$CUR_PATH/test_utils.sh" "$1"
+
+trace="$2"
+slice="$3"
+start="$4"
+end="$5"
+threads="$6"
+
+ret=0
+for thread in ${threads//,/ }; do
+  if ! diff -q <("$PALLAS_PRINT_PATH" -T --thread "$thread" "$slice" 2>/dev/null) \
+               <("$PALLAS_PRINT_PATH" -T --thread "$thread" "$trace" 2>/dev/null |
+                 awk -v start="$start" -v end="$end" 'NR == 1 { print; next } { ts = int($1 * 1e9 + 0.5); if (ts >= start && ts <= end) print }') > /dev/null; then
+    print_error "Thread $thread of $slice doesn't match the window [$start, $end] of $trace"
+    ret=1
+  fi
+done
+if [ $ret -eq 0 ]; then
+  print_ok "$slice is the window [$start, $end] of $trace"
+  rm -rf "$(dirname -- "$trace")" "$(dirname -- "$slice")"
+fi
+exit $ret
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Checks the statistics of the durations that are computed when a Thread is stored:
+ * nb_calls calls to a function whose durations are known are recorded, and the statistics of its Sequence
+ * are compared with the exact ones, once read back from the sidecar of the trace.
+ * The quantiles must be within the accuracy of the sketch, and merging statistics must give the same result
+ * as adding all the values. The sidecars of a Thread must be ignored once its Sequences are renumbered.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "pallas/pallas.h"
+#include "pallas/pallas_archive.h"
+#include "pallas/pallas_record.h"
+#include "pallas/pallas_write.h"
+
+#include "pallas/utils/pallas_log.h"
+#include "pallas/utils/pallas_statistics.h"
+#include "pallas/utils/pallas_storage.h"
+
+using namespace pallas;
+
+static const RegionRef function = 1;
+
+/** Duration of the i-th call: spread over four orders of magnitude. */
+static uint64_t call_duration(size_t i) {
+    return 10 + (i * 7919) % 1000 * ((i % 4 == 0) ? 100 : 1);
+}
+
+static void check_close(double value, double expected, double accuracy, const char* what) {
+    if (std::abs(value - expected) > accuracy * std::abs(expected))
+        pallas_error("Wrong %s: %f instead of %f\n", what, value, expected);
+}
+
+/** Checks the statistics of a set of values against the exact ones. */
+static void check_statistics(const DurationStatistics& stats, std::vector<uint64_t> values) {
+    std::sort(values.begin(), values.end());
+    pallas_assert_equals_always(stats.count, values.size());
+    uint64_t sum = 0;
+    for (auto v : values)
+        sum += v;
+    double mean = static_cast<double>(sum) / values.size();
+    double m2 = 0;
+    for (auto v : values)
+        m2 += (v - mean) * (v - mean);
+    pallas_assert_equals_always(stats.sum, sum);
+    pallas_assert_equals_always(stats.min, values.front());
+    pallas_assert_equals_always(stats.max, values.back());
+    check_close(stats.mean, mean, 1e-9, "mean");
+    check_close(stats.variance(), m2 / values.size(), 1e-9, "variance");
+
+    uint64_t histogram_count = 0;
+    for (auto bucket_count : stats.histogram)
+        histogram_count += bucket_count;
+    pallas_assert_equals_always(histogram_count, values.size());
+
+    for (double q : {0., .1, .25, .5, .75, .9, .99, 1.}) {
+        uint64_t expected = values[static_cast<size_t>(q * (values.size() - 1))];
+        check_close(stats.quantile(q), expected, PALLAS_STATISTICS_SKETCH_ACCURACY, "quantile");
+    }
+}
+
+static void check_merge(const std::vector<uint64_t>& values) {
+    DurationStatistics all, first_half, second_half;
+    for (size_t i = 0; i < values.size(); i++) {
+        all.add(values[i]);
+        (i < values.size() / 2 ? first_half : second_half).add(values[i]);
+    }
+    first_half.merge(second_half);
+    pallas_assert_equals_always(first_half.count, all.count);
+    pallas_assert_equals_always(first_half.sum, all.sum);
+    pallas_assert_equals_always(first_half.min, all.min);
+    pallas_assert_equals_always(first_half.max, all.max);
+    check_close(first_half.mean, all.mean, 1e-9, "merged mean");
+    check_close(first_half.variance(), all.variance(), 1e-9, "merged variance");
+    for (double q : {.5, .9, .99})
+        pallas_assert_equals_always(first_half.quantile(q), all.quantile(q));
+}
+
+int main(int argc, char** argv) {
+    size_t nb_calls = argc > 1 ? std::stoul(argv[1]) : 10000;
+    const char* trace_name = argc > 2 ? argv[2] : "statistics_trace";
+
+    GlobalArchive trace(trace_name, "main");
+    trace.addString(0, "thread");
+    trace.addString(function, "function");
+    trace.addRegion(function, function);
+    Archive archive(trace, 0);
+    archive.global_archive = &trace;
+    trace.defineLocationGroup(0, 0, PALLAS_LOCATION_GROUP_ID_INVALID);
+    archive.defineLocation(0, 0, 0);
+
+    std::vector<uint64_t> durations;
+    std::vector<uint64_t> enter_intervals;
+    pallas_timestamp_t ts = 1;
+    ThreadWriter writer(archive, 0);
+    for (size_t i = 0; i < nb_calls; i++) {
+        if (i > 0)
+            enter_intervals.push_back(durations.back() + 5);
+        durations.push_back(call_duration(i));
+        pallas_record_enter(&writer, nullptr, ts, function);
+        ts += durations.back();
+        pallas_record_leave(&writer, nullptr, ts, function);
+        ts += 5;
+    }
+    writer.threadClose();
+    archive.store();
+    trace.store();
+
+    std::string thread_path = std::string(trace_name) + "/archive_0/thread_0/statistics.dat";
+    pallas_assert_always(std::filesystem::exists(thread_path));
+
+    auto* read_trace = pallas_open_trace((std::string(trace_name) + "/main.pallas").c_str());
+    if (read_trace == nullptr) {
+        pallas_error("Cannot open %s\n", trace_name);
+    }
+    auto* thread = read_trace->getThreadList().front();
+    // The statistics come from the sidecar: none of the durations are loaded.
+    thread->buildStatistics();
+    pallas_assert_equals_always(read_trace->parameter_handler->loaded_durations_size, 0);
+
+    bool found = false;
+    for (size_t i = 0; i < thread->nb_sequences; i++) {
+        if (thread->sequences[i].guessName(thread) == "function") {
+            check_statistics(thread->getSequenceStatistics(thread->sequences[i].id), durations);
+            found = true;
+        }
+    }
+    pallas_assert_always(found);
+    for (size_t i = 0; i < thread->nb_events; i++) {
+        auto& event = thread->events[i];
+        if (event.data.record == PALLAS_EVENT_ENTER)
+            check_statistics(thread->getEventStatistics(PALLAS_EVENT_ID(event.id)), enter_intervals);
+    }
+
+    // The vectors take the stored statistics: storing the Thread again doesn't read their values.
+    thread->loadAll();
+    thread->updateStatistics();
+    pallas_assert_equals_always(read_trace->parameter_handler->loaded_durations_size, 0);
+    for (size_t i = 0; i < thread->nb_sequences; i++)
+        pallas_assert_always(thread->sequences[i].durations->hasStatistics());
+    for (size_t i = 0; i < thread->nb_events; i++)
+        pallas_assert_always(thread->events[i].timestamps->hasStatistics());
+
+    // Statistics computed from the loaded vectors are the same as the stored ones.
+    auto stored = thread->sequence_statistics;
+    thread->computeStatistics();
+    for (size_t i = 0; i < thread->nb_sequences; i++) {
+        pallas_assert_equals_always(thread->sequence_statistics[i].count, stored[i].count);
+        pallas_assert_equals_always(thread->sequence_statistics[i].sum, stored[i].sum);
+        pallas_assert_equals_always(thread->sequence_statistics[i].quantile(.5), stored[i].quantile(.5));
+    }
+
+    // The sidecars are ignored once the Sequences are renumbered, even though their number did not change.
+    // A Thread only caches its labels when it is stored after being read, as pallas_sync and pallas_merge do.
+    std::string copy_name = std::string(trace_name) + "_copy";
+    thread->store(copy_name.c_str(), read_trace->parameter_handler, true);
+    std::filesystem::copy_file(copy_name + "/archive_0/thread_0/labels.dat",
+                               std::string(trace_name) + "/archive_0/thread_0/labels.dat",
+                               std::filesystem::copy_options::overwrite_existing);
+    std::filesystem::remove_all(copy_name);
+    pallas_assert_always(pallasLoadThreadStatistics(thread));
+    pallas_assert_always(pallasLoadThreadLabels(thread));
+    pallas_assert_always(thread->sequence_id_map.size() >= 2);
+    std::swap(thread->sequence_id_map[0], thread->sequence_id_map[1]);
+    pallas_assert_always(!pallasLoadThreadStatistics(thread));
+    pallas_assert_always(!pallasLoadThreadLabels(thread));
+    std::swap(thread->sequence_id_map[0], thread->sequence_id_map[1]);
+    delete read_trace;
+
+    check_merge(durations);
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
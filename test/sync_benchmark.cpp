@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Generates a trace with many threads, whose local ids differ from one thread to another,
+ * so that pallas_sync has something to unify.
+ * Thread i calls the functions in an order rotated by i, and one thread out of three calls an extra function.
+ * The first timestamp and the first process can be changed, to generate parts of a trace for pallas_merge.
+ * With a per-thread clock, all the threads share the same timestamps, which tests how readers order ties.
+ */
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "pallas/pallas.h"
+#include "pallas/pallas_archive.h"
+#include "pallas/pallas_record.h"
+#include "pallas/pallas_write.h"
+
+using namespace pallas;
+
+static int nb_threads = 1024;
+static int nb_threads_per_archive = 16;
+static int nb_functions = 8;
+static int nb_iter = 20;
+static const char* dir_name = "sync_benchmark_trace";
+static pallas_timestamp_t first_timestamp = 0;
+static int first_process = 0;
+static bool per_thread_clock = false;
+
+void usage(const char* prog_name) {
+    printf("Usage: %s [OPTION]\n", prog_name);
+    printf("\t-t n  Number of threads (default: %d)\n", nb_threads);
+    printf("\t-a n  Number of threads per archive (default: %d)\n", nb_threads_per_archive);
+    printf("\t-f n  Number of functions (default: %d)\n", nb_functions);
+    printf("\t-n n  Number of iterations (default: %d)\n", nb_iter);
+    printf("\t-o d  Directory of the trace (default: %s)\n", dir_name);
+    printf("\t-s n  First timestamp (default: %" PRIu64 ")\n", first_timestamp);
+    printf("\t-p n  Id of the first process, the ids of the threads follow (default: %d)\n", first_process);
+    printf("\t-l    Use a per-thread clock: every thread starts at the first timestamp\n");
+    printf("\t-?    Show this help and exit\n");
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            nb_threads = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-a") && i + 1 < argc) {
+            nb_threads_per_archive = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-f") && i + 1 < argc) {
+            nb_functions = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            nb_iter = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+            dir_name = argv[++i];
+        } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            first_timestamp = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "-p") && i + 1 < argc) {
+            first_process = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-l")) {
+            per_thread_clock = true;
+        } else if (!strcmp(argv[i], "-?") || !strcmp(argv[i], "-h")) {
+            usage(argv[0]);
+            return EXIT_SUCCESS;
+        } else {
+            fprintf(stderr, "invalid option: %s\n", argv[i]);
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    int nb_archives = (nb_threads + nb_threads_per_archive - 1) / nb_threads_per_archive;
+
+    auto start = std::chrono::steady_clock::now();
+    GlobalArchive trace(dir_name, "main");
+    int first_thread = first_process * nb_threads_per_archive;
+    // Name the locations first, so that the ids of the function names depend on the number of threads.
+    StringRef next_string = 0;
+    for (int a = 0; a < nb_archives; a++) {
+        trace.addString(next_string, ("process_" + std::to_string(first_process + a)).c_str());
+        trace.defineLocationGroup(first_process + a, next_string++, first_process + a);
+    }
+    StringRef first_thread_string = next_string;
+    for (int t = 0; t < nb_threads; t++) {
+        trace.addString(next_string++, ("thread_" + std::to_string(first_thread + t)).c_str());
+    }
+    // One extra function, only called by some threads.
+    for (int f = 0; f <= nb_functions; f++) {
+        trace.addString(next_string, ("function_" + std::to_string(f)).c_str());
+        trace.addRegion(f, next_string++);
+    }
+
+    pallas_timestamp_t ts = first_timestamp;
+    for (int a = 0; a < nb_archives; a++) {
+        Archive archive(trace, first_process + a);
+        archive.global_archive = &trace;
+        for (int t = a * nb_threads_per_archive; t < nb_threads && t < (a + 1) * nb_threads_per_archive; t++) {
+            ThreadId thread_id = first_thread + t;
+            archive.defineLocation(thread_id, first_thread_string + t, first_process + a);
+
+            ThreadWriter writer(archive, thread_id);
+            if (per_thread_clock) {
+                ts = first_timestamp;
+            }
+            for (int i = 0; i < nb_iter; i++) {
+                for (int j = 0; j < nb_functions; j++) {
+                    RegionRef region = (j + thread_id) % nb_functions;
+                    pallas_record_enter(&writer, nullptr, ts++, region);
+                    pallas_record_leave(&writer, nullptr, ts++, region);
+                }
+                if (thread_id % 3 == 0) {
+                    pallas_record_enter(&writer, nullptr, ts++, nb_functions);
+                    pallas_record_leave(&writer, nullptr, ts++, nb_functions);
+                }
+            }
+            writer.threadClose();
+        }
+        archive.store();
+    }
+    trace.store();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    printf("Generated %d threads in %d archives in %lf s\n", nb_threads, nb_archives, elapsed.count());
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
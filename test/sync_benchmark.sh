@@ -0,0 +1,32 @@
+#!/bin/bash
+
+# Checks that pallas_sync only renamed the definitions of the threads:
+# every thread must still contain the same events, in the same order.
+# Checks that the ids were actually unified: each Event, Sequence and Loop must have the same id in every thread,
+# whereas the original trace, whose threads number them differently, must not pass this check.
+
+CUR_PATH=$(dirname  $(realpath $0))
+source "$CUR_PATH/test_utils.sh" "$1"
+
+original_trace="$2"
+synced_trace="$3"
+sync_ids="$BUILD_DIR/test/sync_ids"
+
+if ! diff -q <("$PALLAS_PRINT_PATH" -T "$original_trace" 2>/dev/null) \
+             <("$PALLAS_PRINT_PATH" -T "$synced_trace" 2>/dev/null) > /dev/null; then
+  print_error "$synced_trace differs from $original_trace"
+  exit 1
+fi
+print_ok "$synced_trace has the same content as $original_trace"
+
+if "$sync_ids" "$original_trace" > /dev/null 2>&1; then
+  print_error "The ids of $original_trace are already global: there is nothing to check"
+  exit 1
+fi
+if ! "$sync_ids" "$synced_trace"; then
+  print_error "The ids of $synced_trace are not global"
+  exit 1
+fi
+print_ok "Every definition of $synced_trace has the same id in all the threads"
+rm -rf "$(dirname -- "$original_trace")" "$(dirname -- "$synced_trace")"
+exit 0
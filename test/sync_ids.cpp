@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Checks whether the ids of a trace are global: an Event, Sequence or Loop must have the same id in every thread
+ * that defines it, and different ones must have different ids.
+ * Prints the number of definitions that have several ids, and of ids that are given to several definitions.
+ *
+ * Usage: sync_ids trace/main.pallas
+ * Returns EXIT_SUCCESS if the ids are global.
+ */
+
+#include <map>
+#include <set>
+#include <string>
+
+#include "pallas/pallas.h"
+#include "pallas/pallas_archive.h"
+#include "pallas/utils/pallas_log.h"
+#include "pallas/utils/pallas_storage.h"
+#include "../apps/pallas_grammar_keys.h"
+
+using namespace pallas;
+
+/** Ids given to each key, and keys given to each id. */
+template <typename Key>
+struct Ids {
+    std::map<Key, std::set<uint32_t>> ids_of_key;
+    std::map<uint32_t, std::set<Key>> keys_of_id;
+
+    void add(const Key& key, uint32_t id) {
+        ids_of_key[key].insert(id);
+        keys_of_id[id].insert(key);
+    }
+
+    /** Returns the number of keys with several ids, plus the number of ids with several keys. */
+    size_t nb_conflicts(const char* kind) const {
+        size_t nb_keys = 0;
+        for (const auto& [key, ids] : ids_of_key)
+            nb_keys += ids.size() > 1;
+        size_t nb_ids = 0;
+        for (const auto& [id, keys] : keys_of_id)
+            nb_ids += keys.size() > 1;
+        pallas_log(DebugLevel::Normal, "%zu %s: %zu with several ids, %zu ids given to several of them\n",
+                   ids_of_key.size(), kind, nb_keys, nb_ids);
+        return nb_keys + nb_ids;
+    }
+};
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        pallas_log(DebugLevel::Normal, "Usage: %s trace/main.pallas\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    auto* trace = pallas_open_trace(argv[1]);
+    pallas_assert_always(trace != nullptr);
+
+    Ids<std::string> events;
+    Ids<std::string> sequences;
+    Ids<uint64_t> loops;
+    for (auto* t : trace->getThreadList()) {
+        for (uint32_t logi_id = 0; logi_id < t->event_id_map.size(); logi_id++) {
+            uint32_t phys_id = t->event_id_map[logi_id];
+            if (phys_id == PALLAS_INDEX_INVALID)
+                continue;
+            t->loadEvent(phys_id);
+            events.add(event_key(t->events[phys_id]), logi_id);
+        }
+        // The tokens of the Sequences and Loops are global once the trace is synchronized, so they are keys.
+        for (uint32_t logi_id = 0; logi_id < t->sequence_id_map.size(); logi_id++) {
+            uint32_t phys_id = t->sequence_id_map[logi_id];
+            if (phys_id == PALLAS_INDEX_INVALID)
+                continue;
+            t->loadSequence(phys_id);
+            sequences.add(sequence_key(t->sequences[phys_id].tokens), logi_id);
+        }
+        for (uint32_t logi_id = 0; logi_id < t->loop_id_map.size(); logi_id++) {
+            uint32_t phys_id = t->loop_id_map[logi_id];
+            if (phys_id == PALLAS_INDEX_INVALID)
+                continue;
+            const auto& loop = t->loops[phys_id];
+            loops.add(loop_key(loop.repeated_token, loop.nb_iterations), logi_id);
+        }
+    }
+    size_t nb_conflicts = events.nb_conflicts("events") + sequences.nb_conflicts("sequences") + loops.nb_conflicts("loops");
+    delete trace;
+    return nb_conflicts == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
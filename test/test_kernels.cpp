@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Checks that the kernels of each supported instruction set give exactly the same results as the scalar ones,
+ * for every size up to nb_values (so that every remainder is handled), and for small values, values whose differences
+ * don't fit in the mantissa of a double, and values close to UINT64_MAX.
+ * The CRC32C is also checked against its reference value, and on buffers that don't start on a word boundary.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "pallas/utils/pallas_dbg.h"
+#include "pallas/utils/pallas_kernels.h"
+#include "pallas/utils/pallas_log.h"
+
+using namespace pallas;
+
+/** Deterministic pseudo-random generator, so that a failure can be reproduced. */
+static uint64_t next_random(uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+/** Returns n values in [base, base + range[, or any values if range is 0. */
+static std::vector<uint64_t> make_values(size_t n, uint64_t base, uint64_t range, uint64_t& state) {
+    std::vector<uint64_t> values(n);
+    for (auto& value : values) {
+        uint64_t offset = next_random(state);
+        value = range ? base + offset % range : offset;
+    }
+    return values;
+}
+
+/** Computes every kernel on values with the current instruction set. */
+struct Results {
+    ValueStatistics statistics;
+    std::vector<uint8_t> bins;
+    std::vector<size_t> bounds;
+    std::vector<uint32_t> checksums;
+
+    Results(const std::vector<uint64_t>& values, const std::vector<uint64_t>& sorted, uint64_t min, double step)
+        : bins(values.size()) {
+        statistics = computeValueStatistics(values.data(), values.size());
+        computeHistogramBins(values.data(), values.size(), min, step, bins.data());
+        // Every value of the array, and the ones around them.
+        for (auto value : sorted) {
+            for (uint64_t searched : {value - 1, value, value + 1})
+                bounds.push_back(lowerBound(sorted.data(), sorted.size(), searched));
+        }
+        bounds.push_back(lowerBound(sorted.data(), sorted.size(), 0));
+        bounds.push_back(lowerBound(sorted.data(), sorted.size(), UINT64_MAX));
+        // Every suffix of the first bytes, and the whole array checksummed in two parts.
+        const auto* bytes = reinterpret_cast<const uint8_t*>(values.data());
+        size_t size = values.size() * sizeof(uint64_t);
+        for (size_t start = 0; start < std::min<size_t>(size, 16); start++)
+            checksums.push_back(crc32c(bytes + start, size - start));
+        checksums.push_back(crc32c(bytes + size / 3, size - size / 3, crc32c(bytes, size / 3)));
+    }
+};
+
+static void check(const std::vector<uint64_t>& values, KernelISA isa) {
+    std::vector<uint64_t> sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+    uint64_t min = sorted.empty() ? 0 : sorted.front();
+    uint64_t max = sorted.empty() ? 0 : sorted.back();
+    // Same step as the Histogram compression, and a smaller one so that some bins are clamped.
+    for (double step : {static_cast<double>(max - min) / 255., static_cast<double>(max - min) / 1000., 1.}) {
+        if (step <= 0)
+            step = 1;
+        setKernelISA(KernelISA::Scalar);
+        Results expected(values, sorted, min, step);
+        setKernelISA(isa);
+        Results actual(values, sorted, min, step);
+        pallas_assert_equals_always(actual.statistics.min, expected.statistics.min);
+        pallas_assert_equals_always(actual.statistics.max, expected.statistics.max);
+        pallas_assert_equals_always(actual.statistics.sum, expected.statistics.sum);
+        pallas_assert_always(actual.bins == expected.bins);
+        pallas_assert_always(actual.bounds == expected.bounds);
+        pallas_assert_always(actual.checksums == expected.checksums);
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t nb_values = argc > 1 ? std::stoul(argv[1]) : 300;
+    KernelISA default_isa = getKernelISA();
+    uint64_t state = 88172645463325252ull;
+    for (auto isa : {KernelISA::Scalar, KernelISA::AVX2, KernelISA::AVX512}) {
+        if (!isKernelISASupported(isa)) {
+            pallas_log(DebugLevel::Normal, "The %s kernels aren't supported, skipping them\n", toString(isa));
+            continue;
+        }
+        setKernelISA(isa);
+        const char* reference = "123456789";
+        pallas_assert_equals_always(crc32c(reference, 9), UINT32_C(0xE3069283));
+        pallas_assert_equals_always(crc32c(reference + 4, 5, crc32c(reference, 4)), UINT32_C(0xE3069283));
+        pallas_assert_equals_always(crc32c(reference, 0), UINT32_C(0));
+        for (size_t n = 0; n <= nb_values; n++) {
+            check(make_values(n, 0, 1000, state), isa);
+            check(make_values(n, 1000000, UINT64_C(1) << 40, state), isa);
+            check(make_values(n, 0, UINT64_C(1) << 60, state), isa);
+            check(make_values(n, UINT64_MAX - 1000, 1001, state), isa);
+            check(make_values(n, 0, 0, state), isa);
+        }
+        pallas_log(DebugLevel::Normal, "The %s kernels give the same results as the scalar ones\n", toString(isa));
+    }
+    setKernelISA(default_isa);
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
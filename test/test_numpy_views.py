@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+# Checks that the NumPy views given by Vector.as_numpy_views stay valid after the reader of their thread,
+# then the trace itself, are deleted: they must still hold the same values as the copies made beforehand.
+# Exits with 77 (skipped) when the pallas_trace module is not installed.
+#
+# Usage: test_numpy_views.py trace/main.pallas
+import gc
+import sys
+
+try:
+    import numpy as np
+    import pallas_trace as pallas
+except ImportError:
+    print("pallas_trace is not installed: skipping")
+    sys.exit(77)
+
+
+def check(views, copies, step):
+    for vector_views, copy in zip(views, copies):
+        values = np.concatenate(vector_views) if vector_views else np.array([], dtype=np.uint64)
+        if not np.array_equal(values, copy):
+            print(f"The views don't match the copies after {step}")
+            sys.exit(1)
+
+
+def main(trace_file):
+    trace = pallas.open_trace(trace_file)
+    thread = trace.archives[0].threads[0]
+    # The reader frees the thread when it is deleted.
+    reader = thread.reader()
+    views = []
+    copies = []
+    for sequence in thread.sequences:
+        for vector in (sequence.timestamps, sequence.durations):
+            views.append(vector.as_numpy_views())
+            copies.append(vector.as_numpy_array())
+    if not any(len(vector_views) for vector_views in views):
+        print("The thread has no values")
+        sys.exit(1)
+    del sequence, vector, thread
+    check(views, copies, "reading them")
+
+    del reader
+    gc.collect()
+    check(views, copies, "deleting the reader")
+
+    del trace
+    gc.collect()
+    # Reuses the memory that was freed, so that reading it through a dangling view would show.
+    garbage = [np.full(1000, 0xdeadbeef, dtype=np.uint64) for _ in range(1000)]
+    check(views, copies, "deleting the trace")
+    del garbage
+
+    # Releasing the views releases the data they pinned.
+    del views
+    gc.collect()
+    print("The views outlived the trace")
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print(f"Usage: {sys.argv[0]} trace/main.pallas")
+        sys.exit(1)
+    main(sys.argv[1])
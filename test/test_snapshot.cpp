@@ -7,6 +7,7 @@
 #include <pallas/pallas.h>
 #include <pallas/pallas_archive.h>
 
+#include <pallas/utils/pallas_parallel.h>
 #include <pallas/utils/pallas_storage.h>
 
 static int id_width = 8;
@@ -90,4 +91,68 @@ int main(int argc, char** argv) {
     mape_fast /= counter;
     std::cout << "MAPE getSnapshotView:     " << std::setprecision(3) << mape_normal << std::endl;
     std::cout << "MAPE getSnapshotViewFast: " << std::setprecision(3) << mape_fast << std::endl;
+
+    // Sequences with the same name should share the same label.
+    for (auto* thread : trace->getThreadList()) {
+        std::map<std::string, uint32_t> label_ids;
+        for (size_t j = 0; j < thread->nb_sequences; j++) {
+            uint32_t label_id = thread->getSequenceLabelId(thread->sequences[j].id);
+            if (label_id >= thread->getLabelCount()) {
+                pallas_error("Invalid label id %u for Sequence %zu\n", label_id, j);
+            }
+            auto [it, inserted] = label_ids.try_emplace(thread->getLabel(label_id), label_id);
+            if (it->second != label_id) {
+                pallas_error("Label %s has two ids: %u and %u\n", it->first.c_str(), it->second, label_id);
+            }
+        }
+        if (label_ids.size() != thread->getLabelCount()) {
+            pallas_error("Thread %u has unused labels\n", thread->id);
+        }
+    }
+
+    // The trace-level snapshot should be the sum of the Threads' snapshots.
+    // We re-open the trace so that the Threads are loaded by the workers.
+    auto* parallel_trace = pallas_open_trace(trace_name);
+    pallas_timestamp_t start = trace->get_starting_timestamp();
+    pallas_timestamp_t end = trace->get_ending_timestamp();
+    auto parallel_snapshot = parallel_trace->getSnapshotViewByName(start, end, 4);
+    std::map<std::string, pallas_duration_t> sequential_snapshot;
+    for (auto* thread : trace->getThreadList()) {
+        for (auto& [name, duration] : thread->getSnapshotViewByName(start, end)) {
+            sequential_snapshot[name] += duration;
+        }
+    }
+    if (parallel_snapshot != sequential_snapshot) {
+        pallas_error("GlobalArchive::getSnapshotViewByName does not match the Threads' snapshots\n");
+    }
+    std::cout << "Trace-level snapshot matches (" << parallel_snapshot.size() << " regions)" << std::endl;
+    delete parallel_trace;
+
+    // An empty time frame still lists the regions that overlap it, with a duration of 0.
+    pallas_timestamp_t middle = start + (end - start) / 2;
+    auto instant_snapshot = trace->getSnapshotViewByName(middle, middle);
+    if (instant_snapshot.empty() && !parallel_snapshot.empty()) {
+        pallas_error("The snapshot of an instant doesn't list any region\n");
+    }
+    for (auto& [name, duration] : instant_snapshot) {
+        if (duration != 0) {
+            pallas_error("Region %s lasts %lu ticks in an instant\n", name.c_str(), duration);
+        }
+    }
+
+    // Loading the same Archive / Thread from several threads at once should give a single object.
+    auto* concurrent_trace = pallas_open_trace(trace_name);
+    auto location_group_id = concurrent_trace->location_groups[0].id;
+    std::vector<pallas::Thread*> loaded(8);
+    pallas::parallelFor(loaded.size(), loaded.size(), [&](size_t i) {
+        auto* archive = concurrent_trace->getArchive(location_group_id);
+        loaded[i] = archive->getThreadAt(0);
+    });
+    for (auto* thread : loaded) {
+        if (thread == nullptr || thread != loaded[0]) {
+            pallas_error("Concurrent loads of the same Thread returned different objects\n");
+        }
+    }
+    delete concurrent_trace;
+    delete trace;
 }
@@ -28,6 +28,39 @@ int main(int argc, char** argv) {
   pallas_assert_always(vector.max == TEST_SIZE - 1);
   // This is actually because the statistics are computed "one index late"
   // Because as always the fault lies in the fact we have to compute durations.
+
+  // Flat copies and views of the subvectors should give back the same values.
+  auto* flat = new uint64_t[TEST_SIZE];
+  vector.copy_to_array(flat);
+  size_t index = 0;
+  auto pinned = vector.pin_data();
+  for (auto& [array, size] : pinned) {
+    for (size_t i = 0; i < size; i++, index++) {
+      pallas_assert_always(array[i] == index);
+      pallas_assert_always(flat[index] == index);
+    }
+  }
+  pallas_assert_always(index == TEST_SIZE);
+  pallas::unpinSubArrayData(pinned);
+
+  // The pinned data must outlive the vector, until the last pin is released.
+  auto* copy = new pallas::LinkedVector(parameter_handler);
+  for (size_t i = 0; i < TEST_SIZE; i++) {
+    copy->add(i);
+  }
+  auto first_pins = copy->pin_data();
+  auto second_pins = copy->pin_data();
+  delete copy;
+  pallas::unpinSubArrayData(first_pins);
+  index = 0;
+  for (auto& [array, size] : second_pins) {
+    for (size_t i = 0; i < size; i++, index++) {
+      pallas_assert_always(array[i] == flat[index]);
+    }
+  }
+  pallas_assert_always(index == TEST_SIZE);
+  pallas::unpinSubArrayData(second_pins);
+  delete[] flat;
   return EXIT_SUCCESS;
 }
 
@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Generates a synthetic trace, for the read benchmarks.
+ * Each thread runs nb_iter iterations of a call stack of the given depth. The innermost function calls
+ * compute loop_iter times, and communicates with the other ranks following an MPI pattern.
+ * Every irregularity-th iteration calls an extra function, which breaks the loops of the outer levels.
+ * The durations are drawn by a generator seeded by the rank and the thread, so that the trace only
+ * depends on the options, and not on the order in which the threads are recorded.
+ */
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "pallas/pallas.h"
+#include "pallas/pallas_archive.h"
+#include "pallas/pallas_record.h"
+#include "pallas/pallas_write.h"
+#include "pallas/utils/pallas_parallel.h"
+
+using namespace pallas;
+
+/** Communication patterns of the innermost function. */
+enum class MpiPattern { None, Ring, AllToAll, Collective };
+
+static int nb_ranks = 4;
+static int nb_threads_per_rank = 2;
+static int depth = 3;
+static int nb_iter = 100;
+static int loop_iter = 10;
+static int irregularity = 0;
+static MpiPattern mpi_pattern = MpiPattern::Ring;
+static CompressionAlgorithm compression = CompressionAlgorithmDefault;
+static EncodingAlgorithm encoding = EncodingAlgorithmDefault;
+static uint32_t seed = 1;
+static const char* dir_name = "trace_generator_trace";
+static size_t nb_workers = 0;
+
+/* Regions: one function per depth, then compute and extra. */
+static RegionRef regionOfDepth(int d) {
+    return d;
+}
+static RegionRef computeRegion() {
+    return depth;
+}
+static RegionRef extraRegion() {
+    return depth + 1;
+}
+static const CommRef comm_world = 0;
+static const uint32_t mpi_allreduce = 10;
+
+/** Records the events of one thread. */
+class ThreadGenerator {
+   public:
+    ThreadGenerator(ThreadWriter& writer, int rank) : writer(writer), rank(rank), state(seed * 2654435761u ^ (writer.thread->id + 1)) {
+    }
+
+    void run() {
+        for (int i = 0; i < nb_iter; i++) {
+            callLevel(0, i);
+        }
+    }
+
+   private:
+    ThreadWriter& writer;
+    int rank;
+    uint32_t state;
+    pallas_timestamp_t ts = 0;
+
+    /** Returns a duration between 1 and max, drawn by a linear congruential generator. */
+    pallas_timestamp_t duration(uint32_t max) {
+        state = state * 1103515245 + 12345;
+        return 1 + (state >> 16) % max;
+    }
+
+    void callLevel(int d, int iteration) {
+        if (d == depth) {
+            innermost(iteration);
+            return;
+        }
+        pallas_record_enter(&writer, nullptr, ts += duration(10), regionOfDepth(d));
+        callLevel(d + 1, iteration);
+        if (d == 0 && irregularity > 0 && iteration % irregularity == 0) {
+            pallas_record_enter(&writer, nullptr, ts += duration(10), extraRegion());
+            pallas_record_leave(&writer, nullptr, ts += duration(100), extraRegion());
+        }
+        pallas_record_leave(&writer, nullptr, ts += duration(10), regionOfDepth(d));
+    }
+
+    void innermost(int iteration) {
+        for (int l = 0; l < loop_iter; l++) {
+            pallas_record_enter(&writer, nullptr, ts += duration(10), computeRegion());
+            pallas_record_leave(&writer, nullptr, ts += duration(1000), computeRegion());
+        }
+        uint32_t tag = iteration;
+        uint64_t length = 1024;
+        switch (mpi_pattern) {
+        case MpiPattern::None:
+            break;
+        case MpiPattern::Ring:
+            pallas_record_mpi_send(&writer, nullptr, ts += duration(50), (rank + 1) % nb_ranks, comm_world, tag, length);
+            pallas_record_mpi_recv(&writer, nullptr, ts += duration(50), (rank + nb_ranks - 1) % nb_ranks, comm_world, tag, length);
+            break;
+        case MpiPattern::AllToAll: {
+            uint64_t request = 0;
+            for (int peer = 0; peer < nb_ranks; peer++) {
+                if (peer == rank)
+                    continue;
+                pallas_record_mpi_isend(&writer, nullptr, ts += duration(10), peer, comm_world, tag, length, request++);
+                pallas_record_mpi_irecv_request(&writer, nullptr, ts += duration(10), request++);
+            }
+            request = 0;
+            for (int peer = 0; peer < nb_ranks; peer++) {
+                if (peer == rank)
+                    continue;
+                pallas_record_mpi_isend_complete(&writer, nullptr, ts += duration(10), request++);
+                pallas_record_mpi_irecv(&writer, nullptr, ts += duration(10), peer, comm_world, tag, length, request++);
+            }
+            break;
+        }
+        case MpiPattern::Collective:
+            pallas_record_mpi_collective_begin(&writer, nullptr, ts += duration(10));
+            pallas_record_mpi_collective_end(&writer, nullptr, ts += duration(200), mpi_allreduce, comm_world, 0, length, length);
+            break;
+        }
+    }
+};
+
+void usage(const char* prog_name) {
+    printf("Usage: %s [OPTION]\n", prog_name);
+    printf("\t-r n    Number of ranks (default: %d)\n", nb_ranks);
+    printf("\t-t n    Number of threads per rank (default: %d)\n", nb_threads_per_rank);
+    printf("\t-d n    Depth of the call stack (default: %d)\n", depth);
+    printf("\t-n n    Number of iterations (default: %d)\n", nb_iter);
+    printf("\t-l n    Number of iterations of the innermost loop (default: %d)\n", loop_iter);
+    printf("\t-i n    Call an extra function every n iterations, 0 for never (default: %d)\n", irregularity);
+    printf("\t-m p    MPI pattern: none, ring, alltoall or collective (default: ring)\n");
+    printf("\t-c alg  Compression algorithm (default: %s)\n", toString(compression).c_str());
+    printf("\t-e alg  Encoding algorithm (default: %s)\n", toString(encoding).c_str());
+    printf("\t-s n    Seed of the durations (default: %u)\n", seed);
+    printf("\t-j n    Number of threads recorded concurrently (default: one per hardware thread)\n");
+    printf("\t-o d    Directory of the trace (default: %s)\n", dir_name);
+    printf("\t-?      Show this help and exit\n");
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+            nb_ranks = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            nb_threads_per_rank = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-d") && i + 1 < argc) {
+            depth = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            nb_iter = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-l") && i + 1 < argc) {
+            loop_iter = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-i") && i + 1 < argc) {
+            irregularity = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-m") && i + 1 < argc) {
+            std::string pattern = argv[++i];
+            if (pattern == "none")
+                mpi_pattern = MpiPattern::None;
+            else if (pattern == "ring")
+                mpi_pattern = MpiPattern::Ring;
+            else if (pattern == "alltoall")
+                mpi_pattern = MpiPattern::AllToAll;
+            else if (pattern == "collective")
+                mpi_pattern = MpiPattern::Collective;
+            else {
+                fprintf(stderr, "invalid MPI pattern: %s\n", pattern.c_str());
+                return EXIT_FAILURE;
+            }
+        } else if (!strcmp(argv[i], "-c") && i + 1 < argc) {
+            compression = compressionAlgorithmFromString(argv[++i]);
+        } else if (!strcmp(argv[i], "-e") && i + 1 < argc) {
+            encoding = encodingAlgorithmFromString(argv[++i]);
+        } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            seed = strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+            nb_workers = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+            dir_name = argv[++i];
+        } else if (!strcmp(argv[i], "-?") || !strcmp(argv[i], "-h")) {
+            usage(argv[0]);
+            return EXIT_SUCCESS;
+        } else {
+            fprintf(stderr, "invalid option: %s\n", argv[i]);
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    GlobalArchive trace(dir_name, "main");
+    StringRef next_string = 0;
+    for (int d = 0; d < depth; d++) {
+        trace.addString(next_string, ("function_" + std::to_string(d)).c_str());
+        trace.addRegion(regionOfDepth(d), next_string++);
+    }
+    trace.addString(next_string, "compute");
+    trace.addRegion(computeRegion(), next_string++);
+    trace.addString(next_string, "extra");
+    trace.addRegion(extraRegion(), next_string++);
+
+    std::vector<uint64_t> ranks;
+    for (int r = 0; r < nb_ranks; r++) {
+        ranks.push_back(r);
+    }
+    trace.addString(next_string, "MPI_COMM_WORLD");
+    trace.addGroup(0, next_string, GROUP_TYPE_COMM_GROUP, PARADIGM_MPI, ranks.size(), ranks.data());
+    trace.addComm(comm_world, next_string++, 0, PALLAS_COMMREF_INVALID);
+
+    std::vector<Archive*> archives;
+    for (int r = 0; r < nb_ranks; r++) {
+        trace.addString(next_string, ("rank_" + std::to_string(r)).c_str());
+        trace.defineLocationGroup(r, next_string++, PALLAS_LOCATION_GROUP_ID_INVALID);
+        auto* archive = new Archive(trace, r);
+        archive->global_archive = &trace;
+        archives.push_back(archive);
+        for (int t = 0; t < nb_threads_per_rank; t++) {
+            ThreadId thread_id = r * nb_threads_per_rank + t;
+            trace.addString(next_string, ("thread_" + std::to_string(thread_id)).c_str());
+            archive->defineLocation(thread_id, next_string++, r);
+        }
+    }
+
+    parallelFor(nb_ranks * nb_threads_per_rank, nb_workers, [&](size_t i) {
+        int rank = i / nb_threads_per_rank;
+        {
+            ThreadWriter writer(*archives[rank], i);
+            writer.parameter_handler->compressionAlgorithm = compression;
+            writer.parameter_handler->encodingAlgorithm = encoding;
+            ThreadGenerator(writer, rank).run();
+            writer.threadClose();
+        }
+        // threadClose stored the Thread: it is freed, so that the memory doesn't grow with the number of threads.
+        archives[rank]->freeThread(i);
+    });
+    for (auto* archive : archives) {
+        archive->store();
+    }
+    trace.store();
+    for (auto* archive : archives) {
+        delete archive;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    printf("Generated %d ranks of %d threads in %lf s\n", nb_ranks, nb_threads_per_rank, elapsed.count());
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Microbenchmarks of the write path, in memory: nothing is stored on disk.
+ *  - linked_vector_add / linked_duration_vector_add: LinkedVector::add and LinkedDurationVector::add.
+ *  - get_event_id: ThreadWriter::getEventId on events that are already defined, depending on the number of events.
+ *  - store_event: ThreadWriter::storeEvent without any loop finding, depending on the number of events.
+ *  - find_loop: storeEvent with the default loop finding, on a loop of loop_length events.
+ *    The difference with store_event is the time spent in findSequence and findLoopBasic.
+ *  - find_sequence: blocks of nb_events events called in a pseudo-random order, depending on the number of blocks,
+ *    so that each Leave looks the Sequence up and each block is then found by findSequence.
+ *  - threads: find_loop recorded by nb_threads threads at the same time, in the same Archive.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "pallas/pallas.h"
+#include "pallas/pallas_archive.h"
+#include "pallas/pallas_write.h"
+#include "pallas/utils/pallas_linked_vector.h"
+#include "pallas_benchmark.h"
+
+using namespace pallas;
+using namespace pallas_benchmark;
+
+static const char* description = "Microbenchmarks of the write path. Prints one JSON object per benchmark and parameter set.";
+static const char* dir_name = "write_microbenchmark_trace";
+/** Keeps the compiler from optimizing the benchmarked calls away. */
+static volatile TokenId sink;
+
+/** Returns the EventData of an Enter (block start) or Leave (block end) in region, or of a generic event named region. */
+static EventData makeEvent(Record record, uint32_t region) {
+    EventData e;
+    memset(&e, 0, sizeof(e));
+    e.record = record;
+    e.event_size = offsetof(EventData, event_data) + sizeof(region);
+    memcpy(e.event_data, &region, sizeof(region));
+    return e;
+}
+
+/** Archive with a single ThreadWriter, that is freed (without being stored) when the repetition ends. */
+struct WriterFixture {
+    Archive archive{dir_name, 0};
+    ThreadWriter* writer;
+    pallas_timestamp_t ts = 1;
+
+    explicit WriterFixture(LoopFindingAlgorithm algorithm = LoopFindingAlgorithmDefault) {
+        writer = new ThreadWriter(archive, 0);
+        writer->parameter_handler->loopFindingAlgorithm = algorithm;
+    }
+    ~WriterFixture() {
+        delete writer;
+    }
+
+    /** Defines nb_events generic events, and returns their ids. */
+    std::vector<TokenId> defineEvents(Record record, size_t nb_events, uint32_t first = 0) {
+        std::vector<TokenId> ids;
+        for (size_t i = 0; i < nb_events; i++) {
+            EventData e = makeEvent(record, first + i);
+            ids.push_back(writer->getEventId(&e));
+        }
+        return ids;
+    }
+};
+
+static void benchLinkedVector() {
+    for (long long n : sweep<long long>({10000, 100000, 1000000})) {
+        run("linked_vector_add", {{"nb_values", n}}, n, [&](Timer& timer) {
+            ParameterHandler parameter_handler;
+            LinkedVector vector(parameter_handler);
+            timer.start();
+            for (long long i = 0; i < n; i++)
+                vector.add(i);
+            timer.stop();
+        });
+        run("linked_duration_vector_add", {{"nb_values", n}}, n, [&](Timer& timer) {
+            ParameterHandler parameter_handler;
+            LinkedDurationVector vector(parameter_handler);
+            timer.start();
+            for (long long i = 0; i < n; i++)
+                vector.add(i % 1000);
+            timer.stop();
+        });
+    }
+}
+
+static void benchGetEventId() {
+    const size_t nb_lookups = options.quick ? 10000 : 1000000;
+    for (long long nb_events : sweep<long long>({1, 16, 256, 4096})) {
+        run("get_event_id", {{"nb_events", nb_events}}, nb_lookups, [&](Timer& timer) {
+            WriterFixture fixture;
+            fixture.defineEvents(PALLAS_EVENT_GENERIC, nb_events);
+            std::vector<EventData> events;
+            for (long long i = 0; i < nb_events; i++)
+                events.push_back(makeEvent(PALLAS_EVENT_GENERIC, i));
+            TokenId sum = 0;
+            timer.start();
+            for (size_t i = 0; i < nb_lookups; i++)
+                sum += fixture.writer->getEventId(&events[i % nb_events]);
+            timer.stop();
+            sink = sum;
+        });
+    }
+}
+
+static void benchStoreEvent() {
+    const size_t nb_stored = options.quick ? 10000 : 1000000;
+    for (long long nb_events : sweep<long long>({1, 16, 256})) {
+        run("store_event", {{"nb_events", nb_events}}, nb_stored, [&](Timer& timer) {
+            WriterFixture fixture(LoopFindingAlgorithm::None);
+            auto ids = fixture.defineEvents(PALLAS_EVENT_GENERIC, nb_events);
+            timer.start();
+            for (size_t i = 0; i < nb_stored; i++)
+                fixture.writer->storeEvent(PALLAS_SINGLETON, ids[i % nb_events], fixture.ts++, nullptr);
+            timer.stop();
+        });
+    }
+}
+
+/** Stores nb_stored events, that repeat a loop of loop_length events. */
+static void recordLoop(WriterFixture& fixture, const std::vector<TokenId>& ids, size_t nb_stored) {
+    for (size_t i = 0; i < nb_stored; i++)
+        fixture.writer->storeEvent(PALLAS_SINGLETON, ids[i % ids.size()], fixture.ts++, nullptr);
+}
+
+static void benchFindLoop() {
+    const size_t nb_stored = options.quick ? 10000 : 200000;
+    for (long long loop_length : sweep<long long>({1, 4, 16, 64})) {
+        Parameters parameters{{"loop_length", loop_length}, {"max_loop_length", maxLoopLengthDefault}};
+        run("find_loop", parameters, nb_stored, [&](Timer& timer) {
+            WriterFixture fixture;
+            auto ids = fixture.defineEvents(PALLAS_EVENT_GENERIC, loop_length);
+            timer.start();
+            recordLoop(fixture, ids, nb_stored);
+            timer.stop();
+        });
+    }
+}
+
+static void benchFindSequence() {
+    const size_t nb_blocks = options.quick ? 2000 : 100000;
+    const size_t nb_events_per_block = 4;
+    for (long long nb_sequences : sweep<long long>({1, 16, 256})) {
+        Parameters parameters{{"nb_sequences", nb_sequences}, {"nb_events", nb_events_per_block}};
+        run("find_sequence", parameters, nb_blocks * (nb_events_per_block + 2), [&](Timer& timer) {
+            WriterFixture fixture;
+            auto enter = fixture.defineEvents(PALLAS_EVENT_ENTER, nb_sequences);
+            auto leave = fixture.defineEvents(PALLAS_EVENT_LEAVE, nb_sequences);
+            auto body = fixture.defineEvents(PALLAS_EVENT_GENERIC, nb_events_per_block);
+            // Deterministic pseudo-random order of the blocks, so that they are found by findSequence rather than in a Loop.
+            uint32_t seed = 12345;
+            timer.start();
+            for (size_t b = 0; b < nb_blocks; b++) {
+                seed = seed * 1103515245 + 12345;
+                size_t s = (seed >> 16) % nb_sequences;
+                fixture.writer->storeEvent(PALLAS_BLOCK_START, enter[s], fixture.ts++, nullptr);
+                for (size_t e = 0; e < nb_events_per_block; e++)
+                    fixture.writer->storeEvent(PALLAS_SINGLETON, body[(s + e) % nb_events_per_block], fixture.ts++, nullptr);
+                fixture.writer->storeEvent(PALLAS_BLOCK_END, leave[s], fixture.ts++, nullptr);
+            }
+            timer.stop();
+        });
+    }
+}
+
+static void benchThreads() {
+    const size_t nb_stored = options.quick ? 10000 : 200000;
+    const long long loop_length = 16;
+    for (long long nb_threads : sweep<long long>({1, 2, 4, 8})) {
+        run("threads", {{"nb_threads", nb_threads}, {"loop_length", loop_length}}, nb_stored * nb_threads, [&](Timer& timer) {
+            Archive archive(dir_name, 0);
+            std::vector<std::thread> threads;
+            timer.start();
+            for (long long t = 0; t < nb_threads; t++) {
+                threads.emplace_back([&, t]() {
+                    ThreadWriter writer(archive, t);
+                    std::vector<TokenId> ids;
+                    for (long long i = 0; i < loop_length; i++) {
+                        EventData e = makeEvent(PALLAS_EVENT_GENERIC, i);
+                        ids.push_back(writer.getEventId(&e));
+                    }
+                    pallas_timestamp_t ts = 1;
+                    for (size_t i = 0; i < nb_stored; i++)
+                        writer.storeEvent(PALLAS_SINGLETON, ids[i % ids.size()], ts++, nullptr);
+                });
+            }
+            for (auto& thread : threads)
+                thread.join();
+            timer.stop();
+        });
+    }
+}
+
+int main(int argc, char** argv) {
+    parseOptions(argc, argv, description);
+    benchLinkedVector();
+    benchGetEventId();
+    benchStoreEvent();
+    benchFindLoop();
+    benchFindSequence();
+    benchThreads();
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) Telecom SudParis
+ * See LICENSE in top-level directory.
+ */
+
+/*
+ * Checks the self-instrumentation counters of the ThreadWriter on a trace whose structure is known:
+ * nb_iter calls to a function that contains a loop of nb_events generic events.
+ * Without ENABLE_WRITER_STATS, checks that the counters are all 0.
+ */
+
+#include <string>
+
+#include "pallas/pallas.h"
+#include "pallas/pallas_archive.h"
+#include "pallas/pallas_record.h"
+#include "pallas/pallas_write.h"
+
+#include "pallas/utils/pallas_log.h"
+#include "pallas/utils/pallas_writer_stats.h"
+
+using namespace pallas;
+
+static const char* trace_name = "writer_stats_trace";
+
+int main(int argc, char** argv) {
+    int nb_events = argc > 1 ? std::stoi(argv[1]) : 4;
+    int nb_iter = argc > 2 ? std::stoi(argv[2]) : 100;
+    const RegionRef function = nb_events;
+
+    GlobalArchive trace(trace_name, "main");
+    for (int eid = 0; eid <= nb_events; eid++) {
+        trace.addString(eid, ("event_" + std::to_string(eid)).c_str());
+    }
+    trace.addRegion(function, function);
+    Archive archive(trace, 0);
+    archive.global_archive = &trace;
+    trace.defineLocationGroup(0, 0, PALLAS_LOCATION_GROUP_ID_INVALID);
+    archive.defineLocation(0, 0, 0);
+
+    pallas_timestamp_t ts = 1;
+    ThreadWriter writer(archive, 0);
+    for (int i = 0; i < nb_iter; i++) {
+        pallas_record_enter(&writer, nullptr, ts++, function);
+        // Twice the same events, so that they are found as a loop.
+        for (int repeat = 0; repeat < 2; repeat++) {
+            for (int eid = 0; eid < nb_events; eid++) {
+                pallas_record_generic(&writer, nullptr, ts++, eid);
+            }
+        }
+        pallas_record_leave(&writer, nullptr, ts++, function);
+    }
+    writer.threadClose();
+    WriterStats stats = writer.getStats();
+    pallas_log(DebugLevel::Normal, "%s\n", stats.toString().c_str());
+
+#ifdef PALLAS_WRITER_STATS
+    uint64_t nb_stored = nb_iter * (2 * nb_events + 2);
+    pallas_assert_equals_always(stats.nb_events_stored, nb_stored);
+    pallas_assert_equals_always(stats.nb_event_lookups, nb_stored);
+    // nb_events generic events, one Enter and one Leave.
+    pallas_assert_equals_always(stats.nb_events_created, nb_events + 2);
+    pallas_assert_always(stats.nb_event_hash_probes >= nb_stored - stats.nb_events_created);
+    // The loop body and the function, then the loop is found in every following call.
+    pallas_assert_always(stats.nb_sequences_created >= 2);
+    pallas_assert_always(stats.nb_sequences_found > 0);
+    pallas_assert_always(stats.nb_sequence_hash_probes >= stats.nb_sequences_found);
+    pallas_assert_always(stats.nb_loop_candidates > 0);
+    pallas_assert_always(stats.nb_loops_created >= static_cast<uint64_t>(nb_iter));
+    // Each call creates a Loop identical to the previous ones.
+    pallas_assert_equals_always(stats.nb_loops_squashed, nb_iter - 1);
+    pallas_assert_always(stats.nb_tokens_stored >= nb_stored);
+    pallas_assert_always(stats.nb_subarrays_compressed > 0);
+    pallas_assert_always(stats.nb_raw_bytes > 0);
+    pallas_assert_always(stats.nb_bytes_written > 0);
+    for (int phase = 0; phase < PALLAS_PHASE_COUNT; phase++) {
+        if (stats.phase_ticks[phase] == 0)
+            pallas_error("Phase %s wasn't timed\n", toString(static_cast<WriterPhase>(phase)));
+    }
+    pallas_assert_always(stats.phase_ticks[PALLAS_PHASE_STORE_EVENT] >= stats.phase_ticks[PALLAS_PHASE_FIND_LOOP]);
+    pallas_assert_always(stats.phase_ticks[PALLAS_PHASE_STORE] >= stats.phase_ticks[PALLAS_PHASE_COMPRESSION]);
+    pallas_assert_equals_always(stats.running_phases, 0);
+    pallas_assert_always(archive.metadata.count("writer_stats.thread_0") == 1);
+#else
+    pallas_assert_equals_always(stats.nb_events_stored, 0);
+    pallas_assert_equals_always(stats.nb_bytes_written, 0);
+    pallas_assert_equals_always(stats.phase_ticks[PALLAS_PHASE_STORE_EVENT], 0);
+#endif
+    archive.store();
+    trace.store();
+    return EXIT_SUCCESS;
+}
+
+/* -*-
+   mode: c++;
+   c-file-style: "k&r";
+   c-basic-offset 4;
+   tab-width 4 ;
+   indent-tabs-mode nil
+   -*- */